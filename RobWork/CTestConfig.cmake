@@ -0,0 +1,18 @@
+## This file should be placed in the root directory of your project.
+## Then modify the CMakeLists.txt file in the root directory of your
+## project to incorporate the testing dashboard.
+## # The following are required to uses Dart and the Cdash dashboard
+##   ENABLE_TESTING()
+##   INCLUDE(CTest)
+
+set(CTEST_NIGHTLY_START_TIME "23:00:00 CEST")
+set(NIGHTLY_START_TIME "23:00:00 CEST")
+
+set(CTEST_PROJECT_NAME "RobWork")
+
+set(CTEST_DROP_METHOD "http")
+set(CTEST_DROP_SITE "www.robwork.dk/cdash")
+set(CTEST_DROP_LOCATION "/submit.php?project=RobWork")
+set(CTEST_DROP_SITE_CDASH TRUE)
+
+SET (UPDATE_TYPE "svn")
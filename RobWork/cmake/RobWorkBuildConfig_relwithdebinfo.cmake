@@ -0,0 +1,82 @@
+
+# perhaps something with relative install directories
+#SET(RW_RUNTIME_OUT_DIR /root/repo/RobWork/bin/relwithdebinfo)
+#SET(RW_LIBRARY_OUT_DIR /root/repo/RobWork/libs/relwithdebinfo)
+#SET(RW_ARCHIVE_OUT_DIR /root/repo/RobWork/libs/relwithdebinfo)
+
+#IF()
+#  FILE(TO_CMAKE_PATH "$ENV{RW_ROOT}/." RW_ROOT)
+#ENDIF()
+
+# Version of RobWork
+SET(RW_BUILD_WITH_VERSION 0.7.0)
+SET(RW_BUILD_WITH_VERSION_MAJOR 0)
+SET(RW_BUILD_WITH_VERSION_MINOR 7)
+SET(RW_BUILD_WITH_VERSION_PATCH 0)
+
+# this is the optional packages
+SET(RW_BUILD_WITH_OPENGL TRUE)
+SET(RW_BUILD_WITH_XERCES False)
+SET(RW_BUILD_WITH_PQP True)
+SET(RW_BUILD_WITH_YAOBI True)
+SET(RW_BUILD_WITH_LUA False)
+SET(RW_BUILD_WITH_SWIG False)
+SET(RW_BUILD_WITH_ASSIMP FALSE)
+SET(RW_BUILD_WITH_ZLIB FALSE)
+SET(RW_BUILD_WITH_MINIZIP FALSE)
+SET(RW_BUILD_WITH_SANDBOX OFF)
+SET(RW_BUILD_WITH_CALIBRATION )
+SET(RW_BUILD_WITH_MATHEMATICA FALSE)
+
+SET(RW_BUILD_WITH_TESTS ON)
+SET(RW_BUILD_WITH_GTEST TRUE)
+IF(RW_BUILD_WITH_GTEST)
+	SET(RW_BUILD_WITH_GTEST_SHARED_LIBS ON)
+ENDIF()
+
+# flags and definitions
+SET(RW_BUILD_WITH_RW_ASSERT ON)
+SET(RW_BUILD_WITH_C_FLAGS " -fPIC")
+SET(RW_BUILD_WITH_CXX_FLAGS "-Wall -Wno-strict-aliasing -Wno-unused-function -Wno-pragmas -fPIC -fopenmp")
+SET(RW_BUILD_WITH_DEFINITIONS -DBOOST_DISABLE_ASSERTS)
+SET(RW_BUILD_WITH_LINKER_FLAGS )
+
+SET(RW_BUILD_WITH_RW_ROOT "/root/repo/RobWork")
+SET(RW_BUILD_WITH_SWIG_CMD "SWIG_EXECUTABLE-NOTFOUND")
+SET(RW_BUILD_WITH_LUA_INCLUDE_DIR "")
+SET(RW_BUILD_WITH_PQP_INCLUDE_DIR "/root/repo/RobWork/ext/rwpqp")
+SET(RW_BUILD_WITH_YAOBI_INCLUDE_DIR "/root/repo/RobWork/ext/rwyaobi")
+SET(RW_BUILD_WITH_ASSIMP_INCLUDE_DIR "")
+SET(RW_BUILD_WITH_ZLIB_INCLUDE_DIR "")
+SET(RW_BUILD_WITH_MINIZIP_INCLUDE_DIR "")
+SET(RW_BUILD_WITH_XERCES_INCLUDE_DIR "")
+SET(RW_BUILD_WITH_XERCES_LIB_DIR "")
+SET(RW_BUILD_WITH_GTEST_INCLUDE_DIRS /usr/include)
+SET(RW_BUILD_WITH_BOOST_ROOT "")
+SET(RW_BUILD_WITH_BOOST_INCLUDE_DIR "/usr/include")
+SET(RW_BUILD_WITH_BOOST_LIBRARY_DIR "/usr/lib/x86_64-linux-gnu")
+SET(RW_BUILD_WITH_BOOST_STATIC_TEST_LIBS on)
+
+SET(RW_BUILD_WITH_INTERNAL_PQP ON )
+SET(RW_BUILD_WITH_INTERNAL_YAOBI ON )
+SET(RW_BUILD_WITH_INTERNAL_FCL ON )
+SET(RW_BUILD_WITH_INTERNAL_LUA )
+SET(RW_BUILD_WITH_INTERNAL_TOLUA )
+SET(RW_BUILD_WITH_INTERNAL_ASSIMP )
+SET(RW_BUILD_WITH_INTERNAL_ZLIB )
+SET(RW_BUILD_WITH_INTERNAL_MINIZIP )
+
+# and libraries
+SET(RW_BUILD_WITH_LIBRARIES_BOOST ${Boost_LIBRARIES})
+SET(RW_BUILD_WITH_LIBRARIES_BLAS ${BLAS_LIBRARIES})
+SET(RW_BUILD_WITH_LIBRARIES_LAPACK ${LAPACK_LIBRARIES})
+SET(RW_BUILD_WITH_LIBRARIES_XERCESC ${XERCESC_LIBRARIES})
+SET(RW_BUILD_WITH_LIBRARIES_GTEST gtest;gtest_main;)
+
+SET(RW_BUILD_WITH_LIBRARIES /root/repo/RobWork/libs/relwithdebinfo/librw_algorithms.so;/root/repo/RobWork/libs/relwithdebinfo/librw_pathplanners.so;/root/repo/RobWork/libs/relwithdebinfo/librw_pathoptimization.so;/root/repo/RobWork/libs/relwithdebinfo/librw_simulation.so;/root/repo/RobWork/libs/relwithdebinfo/librw_opengl.so;/root/repo/RobWork/libs/relwithdebinfo/librw_assembly.so;/root/repo/RobWork/libs/relwithdebinfo/librw_task.so;/root/repo/RobWork/libs/relwithdebinfo/librw_calibration.so;/root/repo/RobWork/libs/relwithdebinfo/librw_csg.so;/root/repo/RobWork/libs/relwithdebinfo/librw_control.so;/root/repo/RobWork/libs/relwithdebinfo/librw_proximitystrategies.so;/root/repo/RobWork/libs/relwithdebinfo/libyaobi.so;/root/repo/RobWork/libs/relwithdebinfo/libpqp.so;/root/repo/RobWork/libs/relwithdebinfo/libfcl.so;/root/repo/RobWork/libs/relwithdebinfo/librw.so;/usr/lib/x86_64-linux-gnu/libGL.so;/usr/lib/x86_64-linux-gnu/libGLU.so;Boost::filesystem;Boost::regex;Boost::serialization;Boost::system;Boost::thread;Boost::program_options;Boost::test_exec_monitor;Boost::unit_test_framework;/root/repo/RobWork/libs/relwithdebinfo/librw_qhull.a;/root/repo/RobWork/libs/relwithdebinfo/librw_csgjs.a;/usr/lib/x86_64-linux-gnu/libdl.a)
+
+# todo: version of packages, which compiler was used, and other related stuff
+
+SET(RW_BUILD_WITH_LIBRARY_DIRS /root/repo/RobWork/libs/relwithdebinfo;/root/repo/RobWork/libs/relwithdebinfo;/usr/lib/x86_64-linux-gnu)
+SET(RW_BUILD_WITH_INCLUDE_DIR /root/repo/RobWork/ext/boostbindings;/usr/include/eigen3;/root/repo/RobWork/src;/usr/include;/usr/include;/root/repo/RobWork/ext/rwyaobi;/root/repo/RobWork/ext/rwpqp;/root/repo/RobWork/ext/qhull/src;/root/repo/RobWork/ext/csgjs/src)
+#SET(RW_BUILD_WITH_COMPILER )
@@ -78,8 +78,6 @@ PQP_Model::PQP_Model()
   num_tris = 0;
   num_tris_alloced = 0;
 
-  last_tri = 0;
-
   build_state = PQP_BUILD_STATE_EMPTY;
 }
 
@@ -245,8 +243,6 @@ PQP_Model::EndModel()
   build_model(this);
   build_state = PQP_BUILD_STATE_PROCESSED;
 
-  last_tri = tris;
-
   return PQP_OK;
 }
 
@@ -863,8 +859,8 @@ DistanceRecurse(PQP_DistanceResult *res,
       VcV(res->p1, p);         // p already in c.s. 1
       VcV(res->p2, q);         // q must be transformed
                                // into c.s. 2 later
-      o1->last_tri = t1;
-      o2->last_tri = t2;
+      res->last_tri1 = t1;
+      res->last_tri2 = t2;
     }
 
     return;
@@ -1000,8 +996,8 @@ DistanceQueueRecurse(PQP_DistanceResult *res,
         VcV(res->p1, p);         // p already in c.s. 1
         VcV(res->p2, q);         // q must be transformed
                                  // into c.s. 2 later
-        o1->last_tri = t1;
-        o2->last_tri = t2;
+        res->last_tri1 = t1;
+        res->last_tri2 = t2;
       }
     }
     else if (bvtq.GetNumTests() == bvtq.GetSize() - 1)
@@ -1141,11 +1137,16 @@ PQP_Distance(PQP_DistanceResult *res,
   VmV(Ttemp, T2, T1);
   MTxV(res->T, R1, Ttemp);
 
-  // establish initial upper bound using last triangles which
-  // provided the minimum distance
+  // establish initial upper bound using the triangles which provided
+  // the minimum distance in the last query, or the first triangles
 
+  if (res->last_tri1 == 0 || res->last_tri2 == 0)
+  {
+    res->last_tri1 = o1->tris;
+    res->last_tri2 = o2->tris;
+  }
   PQP_REAL p[3],q[3];
-  res->distance = TriDistance(res->R,res->T,o1->last_tri,o2->last_tri,p,q);
+  res->distance = TriDistance(res->R,res->T,res->last_tri1,res->last_tri2,p,q);
   VcV(res->p1,p);
   VcV(res->p2,q);
 
@@ -1237,8 +1238,8 @@ DistanceThresholdRecurse(PQP_DistanceResult *res,
       VcV(res->p1, p);         // p already in c.s. 1
       VcV(res->p2, q);         // q must be transformed
                                // into c.s. 2 later
-      o1->last_tri = t1;
-      o2->last_tri = t2;
+      res->last_tri1 = t1;
+      res->last_tri2 = t2;
     }
 
     return;
@@ -1386,8 +1387,8 @@ DistanceThresholdQueueRecurse(PQP_DistanceResult *res,
         VcV(res->p1, p);         // p already in c.s. 1
         VcV(res->p2, q);         // q must be transformed
                                  // into c.s. 2 later
-        o1->last_tri = t1;
-        o2->last_tri = t2;
+        res->last_tri1 = t1;
+        res->last_tri2 = t2;
       }
     }
     else if (bvtq.GetNumTests() == bvtq.GetSize() - 1)
@@ -1530,11 +1531,16 @@ PQP_DistanceThreshold(PQP_DistanceResult *res,
   VmV(Ttemp, T2, T1);
   MTxV(res->T, R1, Ttemp);
 
-  // establish initial upper bound using last triangles which
-  // provided the minimum distance
+  // establish initial upper bound using the triangles which provided
+  // the minimum distance in the last query, or the first triangles
 
+  if (res->last_tri1 == 0 || res->last_tri2 == 0)
+  {
+    res->last_tri1 = o1->tris;
+    res->last_tri2 = o2->tris;
+  }
   PQP_REAL p[3],q[3];
-  res->distance = TriDistance(res->R,res->T,o1->last_tri,o2->last_tri,p,q);
+  res->distance = TriDistance(res->R,res->T,res->last_tri1,res->last_tri2,p,q);
   VcV(res->p1,p);
   VcV(res->p2,q);
 
@@ -1632,8 +1638,6 @@ DistanceMultiThresholdRecurse(PQP_MultiDistanceResult *res,
 		res->id1s.push_back(t1->id);
 		res->id2s.push_back(t2->id);
                                // into c.s. 2 later
-      o1->last_tri = t1;
-      o2->last_tri = t2;
     }
 
     return;
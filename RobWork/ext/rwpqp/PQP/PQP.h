@@ -305,6 +305,13 @@ TriContact(PQP_REAL *P1, PQP_REAL *P2, PQP_REAL *P3,
 //    PQP_REAL Distance();
 //    const PQP_REAL *P1();  // pointers to three PQP_REALs
 //    const PQP_REAL *P2();
+//
+//    // The tris which established the minimum distance. A query starts
+//    // with these tris, so set them to tris of the models of the query
+//    // (or 0) before reusing the result for other models.
+//
+//    Tri *last_tri1;
+//    Tri *last_tri2;
 //  };
 
 //----------------------------------------------------------------------------
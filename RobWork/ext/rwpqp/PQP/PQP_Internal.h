@@ -61,8 +61,6 @@ public:
   int num_bvs;
   int num_bvs_alloced;
 
-  Tri *last_tri;       // closest tri on this model in last distance test
-  
   BV *child(int n) { return &b[n]; }
 
   PQP_Model();
@@ -130,6 +128,8 @@ struct PQP_CollideResult
 
 struct PQP_DistanceResult 
 {
+  PQP_DistanceResult() : last_tri1(0), last_tri2(0) {}
+
   // stats
 
   int num_bv_tests;
@@ -148,6 +148,13 @@ struct PQP_DistanceResult
   PQP_REAL p1[3]; 
   PQP_REAL p2[3];
   int qsize;
+
+  // closest tris of the models in the last distance test. A query
+  // starts with these tris, so they must belong to the models of the
+  // query, or be 0 to start with the first tris of the models.
+
+  Tri *last_tri1;
+  Tri *last_tri2;
   
   // statistics
 
@@ -0,0 +1,3 @@
+
+/* #undef HAVE_MALLOC_H */
+/* #undef HAVE_SYS_MOUNT_H */
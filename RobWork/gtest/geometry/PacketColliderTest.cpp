@@ -0,0 +1,90 @@
+/********************************************************************************
+ * Copyright 2017 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <rw/geometry/OBBCollider.hpp>
+#include <rw/geometry/OBBPacketCollider.hpp>
+#include <rw/geometry/TriTriIntersectDeviller.hpp>
+#include <rw/geometry/TriTriPacketIntersect.hpp>
+#include <rw/math/Math.hpp>
+#include <rw/math/RPY.hpp>
+
+using namespace rw::geometry;
+using namespace rw::math;
+
+namespace {
+Vector3D<> ranVector(double max) {
+	return Vector3D<>(Math::ran(-max,max),Math::ran(-max,max),Math::ran(-max,max));
+}
+
+Transform3D<> ranTransform(double max) {
+	return Transform3D<>(ranVector(max),RPY<>(Math::ran(-Pi,Pi),Math::ran(-Pi,Pi),Math::ran(-Pi,Pi)).toRotation3D());
+}
+
+Triangle<> ranTriangle() {
+	return Triangle<>(ranVector(1),ranVector(1),ranVector(1));
+}
+}
+
+TEST(PacketCollider, sameAsScalar) {
+	static const OBBPacketCollider::InstructionSet sets[] = { OBBPacketCollider::Scalar, OBBPacketCollider::SSE2, OBBPacketCollider::AVX };
+	OBBCollider<> obbCollider;
+	TriTriIntersectDeviller<> triCollider;
+
+	Math::seed(0);
+	for (std::size_t s = 0; s < 3; s++) {
+		OBBPacketCollider obbPacketCollider;
+		TriTriPacketIntersect triPacketCollider;
+		obbPacketCollider.setInstructionSet(sets[s]);
+		triPacketCollider.setInstructionSet(sets[s]);
+		EXPECT_LE(obbPacketCollider.getInstructionSet(), OBBPacketCollider::getSupportedInstructionSet());
+
+		std::size_t nrOfCollisions = 0;
+		for (std::size_t i = 0; i < 1000; i++) {
+			OBBPacketCollider::Packet obbs;
+			TriTriPacketIntersect::Packet tris;
+			std::vector<bool> obbsExpected, trisExpected;
+			const std::size_t n = 1 + i%OBBPacketCollider::MaxSize;
+			for (std::size_t j = 0; j < n; j++) {
+				const OBB<> obbA(ranTransform(1), Vector3D<>(Math::ran(0,1),Math::ran(0,1),Math::ran(0,1)));
+				const OBB<> obbB(ranTransform(1), Vector3D<>(Math::ran(0,1),Math::ran(0,1),Math::ran(0,1)));
+				const Transform3D<> aTb = ranTransform(2);
+				obbs.add(obbA, obbB, aTb);
+				obbsExpected.push_back(obbCollider.collides(obbA, obbB, aTb));
+
+				const Triangle<> triP = ranTriangle();
+				const Triangle<> triQ = ranTriangle();
+				const Transform3D<> pTq = ranTransform(0.5);
+				tris.add(triP, triQ, pTq);
+				trisExpected.push_back(triCollider.inCollision(triP, triQ, pTq));
+			}
+
+			const unsigned int obbsResult = obbPacketCollider.collides(obbs);
+			const unsigned int trisResult = triPacketCollider.inCollision(tris);
+			EXPECT_EQ(0u, obbsResult >> n);
+			EXPECT_EQ(0u, trisResult >> n);
+			for (std::size_t j = 0; j < n; j++) {
+				EXPECT_EQ(obbsExpected[j], ((obbsResult >> j) & 1) == 1);
+				EXPECT_EQ(trisExpected[j], ((trisResult >> j) & 1) == 1);
+				if (trisExpected[j])
+					nrOfCollisions++;
+			}
+		}
+		EXPECT_GT(nrOfCollisions, 0u);
+	}
+}
@@ -17,13 +17,21 @@
 
 #include <gtest/gtest.h>
 
+#include <rw/common/ThreadPool.hpp>
 #include <rw/invkin/ClosedFormIKSolverKukaIIWA.hpp>
+#include <rw/invkin/ReachabilityMap.hpp>
 #include <rw/kinematics/FixedFrame.hpp>
+#include <rw/math/Math.hpp>
+#include <rw/models/JointDeviceBatchFK.hpp>
 #include <rw/models/SerialDevice.hpp>
 #include <rw/models/RevoluteJoint.hpp>
 
+#include <algorithm>
+
 using rw::common::ownedPtr;
+using rw::common::ThreadPool;
 using rw::invkin::ClosedFormIKSolverKukaIIWA;
+using rw::invkin::ReachabilityMap;
 using namespace rw::kinematics;
 using namespace rw::math;
 using namespace rw::models;
@@ -94,3 +102,106 @@ TEST(ClosedFormIKSolver, KukaIIWA) {
 		}
 	}
 }
+
+TEST(ClosedFormIKSolver, KukaIIWABatch) {
+	static const std::size_t N = 100;
+
+	StateStructure stateStructure;
+	const SerialDevice::Ptr device = getKukaIIWA(stateStructure);
+	const State state = stateStructure.getDefaultState();
+	ClosedFormIKSolverKukaIIWA solver(device,state);
+	solver.setCheckJointLimits(true);
+
+	Math::seed(1);
+	Eigen::MatrixXd qs(N, 7);
+	Eigen::Array<double, Eigen::Dynamic, 3> dir4(N, 3);
+	for (std::size_t i = 0; i < N; i++) {
+		qs.row(i) = Math::ranQ(device->getBounds()).e().transpose();
+		const Vector3D<> dir = normalize(Vector3D<>(Math::ran(-1,1),Math::ran(-1,1),Math::ran(-1,1)));
+		dir4.row(i) << dir[0], dir[1], dir[2];
+	}
+	const JointDeviceBatchFK fk(device, state);
+	const ClosedFormIKSolverKukaIIWA::TransformArray targets = fk.compute(qs)[0];
+
+	Eigen::ArrayXXd solutions;
+	ClosedFormIKSolverKukaIIWA::BranchArray valid;
+	solver.solveBatch(targets, state, dir4, solutions, valid);
+	ASSERT_EQ((Eigen::Index)N, solutions.rows());
+	ASSERT_EQ(56, solutions.cols());
+	ASSERT_EQ(8, valid.cols());
+
+	// The valid branches must be the solutions of the scalar solver, in the same order
+	for (std::size_t i = 0; i < N; i++) {
+		const Transform3D<> T = JointDeviceBatchFK::getTransform(targets, i);
+		const std::vector<Q> expected = solver.solve(T, state, Vector3D<>(dir4(i,0),dir4(i,1),dir4(i,2)));
+		std::vector<Q> found;
+		for (int b = 0; b < 8; b++) {
+			if (valid(i,b))
+				found.push_back(Q(solutions.row(i).segment(7*b,7).transpose().matrix()));
+		}
+		ASSERT_EQ(expected.size(), found.size());
+		for (std::size_t k = 0; k < found.size(); k++)
+			EXPECT_NEAR(0, (found[k]-expected[k]).normInf(), 1e-9);
+	}
+
+	// With random directions all valid branches must reach the targets
+	solver.solveBatch(targets, state, solutions, valid);
+	State tmpState = state;
+	for (std::size_t i = 0; i < N; i++) {
+		const Transform3D<> T = JointDeviceBatchFK::getTransform(targets, i);
+		for (int b = 0; b < 8; b++) {
+			if (!valid(i,b))
+				continue;
+			device->setQ(Q(solutions.row(i).segment(7*b,7).transpose().matrix()),tmpState);
+			const Transform3D<> Tfound = device->baseTend(tmpState);
+			EXPECT_NEAR(0,(Tfound.P()-T.P()).normInf(),1e-12);
+			EXPECT_TRUE(T.R().equal(Tfound.R(),1e-12));
+		}
+	}
+}
+
+TEST(ClosedFormIKSolver, KukaIIWAReachabilityMap) {
+	StateStructure stateStructure;
+	const SerialDevice::Ptr device = getKukaIIWA(stateStructure);
+	State state = stateStructure.getDefaultState();
+	const ClosedFormIKSolverKukaIIWA::Ptr solver = ownedPtr(new ClosedFormIKSolverKukaIIWA(device,state));
+	solver->setCheckJointLimits(true);
+
+	ReachabilityMap::Grid grid;
+	grid.radius = 1.0;
+	grid.resolution = 0.25;
+	grid.directionResolution = 1;
+	grid.rollBins = 4;
+	const ReachabilityMap::Ptr map = ReachabilityMap::build(device, solver, state, grid);
+	ASSERT_GT(map->getReachableCount(), 0u);
+
+	// The elbow angles are not random, so building on a pool gives the same map
+	const ThreadPool::Ptr pool = ownedPtr(new ThreadPool(4));
+	const ReachabilityMap::Ptr pooled = ReachabilityMap::build(device, solver, state, grid,
+		std::vector<rw::common::Ptr<rw::pathplanning::QConstraint> >(), pool);
+	ASSERT_EQ(map->getReachableCount(), pooled->getReachableCount());
+	for (std::size_t v = 0; v < map->getVoxelCount(); v++) {
+		const std::vector<std::size_t> bins = map->getReachableBins(v);
+		ASSERT_TRUE(bins == pooled->getReachableBins(v)) << "voxel " << v;
+		for (std::size_t k = 0; k < bins.size(); k++) {
+			const Transform3D<> T = map->getCellTransform(v, bins[k]);
+			Q seed, pooledSeed;
+			ASSERT_TRUE(map->getSeed(T, seed));
+			ASSERT_TRUE(pooled->getSeed(T, pooledSeed));
+			EXPECT_TRUE(seed == pooledSeed);
+			device->setQ(seed, state);
+			EXPECT_TRUE(device->baseTend(state).equal(T, 1e-5));
+		}
+	}
+
+	// More elbow angles find cells that a single angle misses
+	grid.elbowAngles = 1;
+	const ReachabilityMap::Ptr single = ReachabilityMap::build(device, solver, state, grid);
+	EXPECT_LT(single->getReachableCount(), map->getReachableCount());
+	for (std::size_t v = 0; v < single->getVoxelCount(); v++) {
+		const std::vector<std::size_t> bins = single->getReachableBins(v);
+		const std::vector<std::size_t> all = map->getReachableBins(v);
+		for (std::size_t k = 0; k < bins.size(); k++)
+			EXPECT_TRUE(std::find(all.begin(), all.end(), bins[k]) != all.end());
+	}
+}
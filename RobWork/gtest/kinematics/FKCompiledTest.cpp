@@ -0,0 +1,157 @@
+/********************************************************************************
+ * Copyright 2017 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include <gtest/gtest.h>
+#include <rw/kinematics/FKCompiled.hpp>
+#include <rw/kinematics/FKTable.hpp>
+#include <rw/kinematics/MovableFrame.hpp>
+#include <rw/kinematics/FixedFrame.hpp>
+#include <rw/math/RPY.hpp>
+#include <rw/models/WorkCell.hpp>
+#include <boost/foreach.hpp>
+
+using namespace rw::math;
+using namespace rw::kinematics;
+using namespace rw::models;
+
+namespace {
+struct FKCompiledTestFrames {
+	MovableFrame* mframe1;
+	MovableFrame* mframe2;
+	FixedFrame* fframe;
+	MovableFrame* daf;
+};
+
+FKCompiledTestFrames addTestFrames(WorkCell& world) {
+	FKCompiledTestFrames frames;
+	frames.mframe1 = new MovableFrame("Frame1");
+	frames.mframe2 = new MovableFrame("Frame2");
+	frames.fframe = new FixedFrame("Frame3",Transform3D<>(Vector3D<>(0.1,0.2,0.3),RPY<>(0.3,0.2,0.1)));
+	frames.daf = new MovableFrame("Frame4");
+
+	world.addFrame(frames.mframe1);
+	world.addFrame(frames.fframe,frames.mframe1);
+	world.addFrame(frames.mframe2,frames.fframe);
+	world.addDAF(frames.daf,world.getWorldFrame());
+	return frames;
+}
+
+void expectSameAsFKTable(const FKCompiled& fk, const State& state) {
+	const FKTable table(state);
+	BOOST_FOREACH(const Frame* frame, fk.getFrames()) {
+		ASSERT_TRUE(fk.has(*frame));
+		const Transform3D<> expected = table.get(*frame);
+		EXPECT_TRUE(fk.get(*frame).equal(expected, 1e-12)) << frame->getName();
+	}
+}
+}
+
+TEST(FKCompiled, update) {
+	WorkCell world("The World");
+	const FKCompiledTestFrames frames = addTestFrames(world);
+	State state = world.getDefaultState();
+
+	FKCompiled fk(state);
+	ASSERT_EQ(5u, fk.getFrames().size());
+	EXPECT_EQ(world.getWorldFrame(), fk.getFrames()[0]);
+
+	frames.mframe1->setTransform(Transform3D<>(Vector3D<>(1,2,3),RPY<>(0.1,0.2,0.3)),state);
+	frames.mframe2->setTransform(Transform3D<>(Vector3D<>(-1,0,1),RPY<>(-0.5,0.2,0)),state);
+	frames.daf->setTransform(Transform3D<>(Vector3D<>(0,0,1),RPY<>(0,0,1)),state);
+	fk.update(state);
+	expectSameAsFKTable(fk, state);
+
+	// The same object is reused for a new configuration.
+	frames.mframe1->setTransform(Transform3D<>(Vector3D<>(0,1,0),RPY<>(1,0,0)),state);
+	fk.update(state);
+	expectSameAsFKTable(fk, state);
+}
+
+TEST(FKCompiled, recompileOnAttach) {
+	WorkCell world("The World");
+	const FKCompiledTestFrames frames = addTestFrames(world);
+	State state = world.getDefaultState();
+	frames.mframe2->setTransform(Transform3D<>(Vector3D<>(0,0,2),RPY<>(0,1,0)),state);
+
+	FKCompiled fk(state);
+	EXPECT_TRUE(fk.isCompiledFor(state));
+
+	frames.daf->attachTo(frames.mframe2, state);
+	EXPECT_FALSE(fk.isCompiledFor(state));
+	fk.update(state);
+	EXPECT_TRUE(fk.isCompiledFor(state));
+	expectSameAsFKTable(fk, state);
+}
+
+TEST(FKCompiled, updateSubset) {
+	WorkCell world("The World");
+	const FKCompiledTestFrames frames = addTestFrames(world);
+	State state = world.getDefaultState();
+	frames.mframe1->setTransform(Transform3D<>(Vector3D<>(1,2,3),RPY<>(0.1,0.2,0.3)),state);
+
+	FKCompiled fk;
+	std::vector<const Frame*> subset(1, frames.mframe2);
+	fk.update(state, subset);
+
+	EXPECT_TRUE(fk.has(*world.getWorldFrame()));
+	EXPECT_TRUE(fk.has(*frames.mframe1));
+	EXPECT_TRUE(fk.has(*frames.fframe));
+	EXPECT_TRUE(fk.has(*frames.mframe2));
+	EXPECT_FALSE(fk.has(*frames.daf));
+
+	const FKTable table(state);
+	EXPECT_TRUE(fk.get(*frames.mframe2).equal(table.get(*frames.mframe2), 1e-12));
+}
+
+TEST(FKCompiled, updateIncremental) {
+	WorkCell world("The World");
+	const FKCompiledTestFrames frames = addTestFrames(world);
+	State state = world.getDefaultState();
+
+	FKCompiled fk;
+	fk.updateIncremental(state);
+	EXPECT_EQ(5u, fk.getNoOfUpdatedFrames());
+	expectSameAsFKTable(fk, state);
+
+	// Nothing changed
+	fk.updateIncremental(state);
+	EXPECT_EQ(0u, fk.getNoOfUpdatedFrames());
+
+	// Leaf frame changed
+	frames.mframe2->setTransform(Transform3D<>(Vector3D<>(-1,0,1),RPY<>(-0.5,0.2,0)),state);
+	fk.updateIncremental(state);
+	EXPECT_EQ(1u, fk.getNoOfUpdatedFrames());
+	expectSameAsFKTable(fk, state);
+
+	// Frame with children changed
+	frames.mframe1->setTransform(Transform3D<>(Vector3D<>(1,2,3),RPY<>(0.1,0.2,0.3)),state);
+	fk.updateIncremental(state);
+	EXPECT_EQ(3u, fk.getNoOfUpdatedFrames());
+	expectSameAsFKTable(fk, state);
+
+	// A partial update means that the next incremental update is complete
+	fk.update(state, std::vector<const Frame*>(1, frames.fframe));
+	fk.updateIncremental(state);
+	EXPECT_EQ(5u, fk.getNoOfUpdatedFrames());
+	expectSameAsFKTable(fk, state);
+
+	// Changes outside the state are only picked up after invalidate
+	frames.fframe->setTransform(Transform3D<>(Vector3D<>(0,0,1)));
+	fk.invalidate();
+	fk.updateIncremental(state);
+	expectSameAsFKTable(fk, state);
+}
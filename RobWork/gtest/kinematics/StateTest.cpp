@@ -0,0 +1,75 @@
+/********************************************************************************
+ * Copyright 2017 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include <gtest/gtest.h>
+#include <rw/kinematics/MovableFrame.hpp>
+#include <rw/kinematics/StateStructure.hpp>
+#include <rw/math/RPY.hpp>
+#include <rw/models/WorkCell.hpp>
+
+using namespace rw::math;
+using namespace rw::kinematics;
+using namespace rw::models;
+
+namespace {
+void testCopies(WorkCell& world, bool copyOnWrite) {
+	MovableFrame* const frame = new MovableFrame("Frame1");
+	MovableFrame* const daf = new MovableFrame("DAF");
+	world.addFrame(frame);
+	world.addDAF(daf,world.getWorldFrame());
+	world.getStateStructure()->setCopyOnWrite(copyOnWrite);
+	EXPECT_EQ(copyOnWrite, world.getStateStructure()->isCopyOnWrite());
+
+	const Transform3D<> T1(Vector3D<>(1,2,3),RPY<>(0.1,0.2,0.3));
+	const Transform3D<> T2(Vector3D<>(-1,0,1),RPY<>(-0.5,0.2,0));
+
+	State state = world.getDefaultState();
+	frame->setTransform(T1,state);
+
+	// Modifying a copy must not change the original, and the other way around.
+	State copy = state;
+	EXPECT_TRUE(frame->getTransform(copy).equal(T1));
+	frame->setTransform(T2,copy);
+	EXPECT_TRUE(frame->getTransform(state).equal(T1));
+	EXPECT_TRUE(frame->getTransform(copy).equal(T2));
+
+	State assigned;
+	assigned = state;
+	frame->setTransform(T2,state);
+	EXPECT_TRUE(frame->getTransform(assigned).equal(T1));
+	EXPECT_TRUE(frame->getTransform(state).equal(T2));
+	assigned[0] = 5;
+	EXPECT_EQ(5, assigned[0]);
+	EXPECT_NE(5, state[0]);
+
+	// The tree structure is also shared until modified.
+	copy = state;
+	daf->attachTo(frame, copy);
+	EXPECT_EQ(world.getWorldFrame(), daf->getParent(state));
+	EXPECT_EQ(frame, daf->getParent(copy));
+}
+}
+
+TEST(State, copy) {
+	WorkCell world("The World");
+	testCopies(world, false);
+}
+
+TEST(State, copyOnWrite) {
+	WorkCell world("The World");
+	testCopies(world, true);
+}
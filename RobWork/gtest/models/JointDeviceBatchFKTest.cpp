@@ -0,0 +1,117 @@
+/********************************************************************************
+ * Copyright 2017 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <rw/common/ThreadPool.hpp>
+#include <rw/kinematics/FixedFrame.hpp>
+#include <rw/kinematics/Kinematics.hpp>
+#include <rw/kinematics/StateStructure.hpp>
+#include <rw/math/Function.hpp>
+#include <rw/math/RPY.hpp>
+#include <rw/models/JointDeviceBatchFK.hpp>
+#include <rw/models/PrismaticJoint.hpp>
+#include <rw/models/RevoluteJoint.hpp>
+#include <rw/models/SerialDevice.hpp>
+
+using rw::common::ownedPtr;
+using rw::common::ThreadPool;
+using namespace rw::kinematics;
+using namespace rw::math;
+using namespace rw::models;
+
+namespace {
+class ScaleMapping: public Function1Diff<> {
+public:
+	double f(double q) { return 2*q+0.1; }
+	double df(double) { return 2; }
+};
+
+SerialDevice::Ptr makeDevice(StateStructure& stateStructure) {
+	const Frame::Ptr base = ownedPtr(new FixedFrame("Base",Transform3D<>(Vector3D<>(0.1,0.2,0.3),RPY<>(0.5,0,0))));
+	const Joint::Ptr joint1 = ownedPtr(new RevoluteJoint("Joint1",Transform3D<>(Vector3D<>(0, 0, 0.2))));
+	const Joint::Ptr joint2 = ownedPtr(new PrismaticJoint("Joint2",Transform3D<>(Vector3D<>(0, 0.1, 0.2),RPY<>(0,0,-Pi/2.))));
+	const Frame::Ptr link = ownedPtr(new FixedFrame("Link",Transform3D<>(Vector3D<>(0.3, 0, 0),RPY<>(0.2,0.3,0.4))));
+	const Joint::Ptr joint3 = ownedPtr(new RevoluteJoint("Joint3",Transform3D<>(Vector3D<>(0,-0.2,0),RPY<>(0,0, Pi/2.))));
+	const Frame::Ptr end = ownedPtr(new FixedFrame("TCP",Transform3D<>(Vector3D<>(0,0,0.1))));
+
+	stateStructure.addFrame(base);
+	stateStructure.addFrame(joint1,base);
+	stateStructure.addFrame(joint2,joint1);
+	stateStructure.addFrame(link,joint2);
+	stateStructure.addFrame(joint3,link);
+	stateStructure.addFrame(end,joint3);
+
+	const State state = stateStructure.getDefaultState();
+	return ownedPtr(new SerialDevice(base.get(),end.get(),"TestDevice",state));
+}
+
+void expectSameAsDevice(const SerialDevice& device, const JointDeviceBatchFK& fk, State state, const Frame* root) {
+	const Eigen::MatrixXd qs = Eigen::MatrixXd::Random(50, device.getDOF());
+	const std::vector<JointDeviceBatchFK::TransformArray> result = fk.compute(qs);
+	ASSERT_EQ(fk.getFrames().size(), result.size());
+	for (std::size_t f = 0; f < result.size(); f++) {
+		ASSERT_EQ(qs.rows(), result[f].rows());
+		for (Eigen::Index i = 0; i < qs.rows(); i++) {
+			device.setQ(Q(qs.row(i).transpose()), state);
+			const Transform3D<> expected = Kinematics::frameTframe(root, fk.getFrames()[f], state);
+			EXPECT_TRUE(JointDeviceBatchFK::getTransform(result[f], i).equal(expected, 1e-12));
+		}
+	}
+}
+}
+
+TEST(JointDeviceBatchFK, baseTend) {
+	StateStructure stateStructure;
+	const SerialDevice::Ptr device = makeDevice(stateStructure);
+	const State state = stateStructure.getDefaultState();
+
+	const JointDeviceBatchFK fk(device, state);
+	EXPECT_TRUE(fk.isVectorized());
+	ASSERT_EQ(1u, fk.getFrames().size());
+	EXPECT_EQ(device->getEnd(), fk.getFrames()[0]);
+	expectSameAsDevice(*device, fk, state, device->getBase());
+}
+
+TEST(JointDeviceBatchFK, worldTframes) {
+	StateStructure stateStructure;
+	const SerialDevice::Ptr device = makeDevice(stateStructure);
+	const State state = stateStructure.getDefaultState();
+
+	std::vector<const Frame*> frames;
+	for (std::size_t i = 1; i < device->frames().size(); i++)
+		frames.push_back(device->frames()[i]);
+	JointDeviceBatchFK fk(device, frames, NULL, state);
+	expectSameAsDevice(*device, fk, state, stateStructure.getRoot());
+
+	// Process the configurations in chunks on a thread pool
+	fk.setThreadPool(ownedPtr(new ThreadPool(2)));
+	fk.setChunkSize(7);
+	expectSameAsDevice(*device, fk, state, stateStructure.getRoot());
+}
+
+TEST(JointDeviceBatchFK, jointMapping) {
+	StateStructure stateStructure;
+	const SerialDevice::Ptr device = makeDevice(stateStructure);
+	const State state = stateStructure.getDefaultState();
+
+	// A joint mapping can not be vectorized and is evaluated through a State
+	device->getJoints()[0]->setJointMapping(ownedPtr(new ScaleMapping()));
+	const JointDeviceBatchFK fk(device, state);
+	EXPECT_FALSE(fk.isVectorized());
+	expectSameAsDevice(*device, fk, state, device->getBase());
+}
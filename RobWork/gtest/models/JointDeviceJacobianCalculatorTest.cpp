@@ -0,0 +1,165 @@
+/********************************************************************************
+ * Copyright 2017 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <rw/kinematics/FixedFrame.hpp>
+#include <rw/kinematics/Kinematics.hpp>
+#include <rw/kinematics/MovableFrame.hpp>
+#include <rw/kinematics/StateStructure.hpp>
+#include <rw/math/RPY.hpp>
+#include <rw/models/JointDeviceJacobianCalculator.hpp>
+#include <rw/models/PrismaticJoint.hpp>
+#include <rw/models/RevoluteJoint.hpp>
+#include <rw/models/TreeDevice.hpp>
+
+using rw::common::ownedPtr;
+using namespace rw::kinematics;
+using namespace rw::math;
+using namespace rw::models;
+
+namespace {
+struct TreeFrames {
+	Frame* base;
+	Joint* joint1;
+	Joint* joint2a;
+	Joint* joint2b;
+	Joint* joint3b;
+	Frame* endA;
+	Frame* endB;
+	MovableFrame* daf;
+	MovableFrame* other;
+};
+
+// A tree with a common joint and two branches:
+// base - joint1 - joint2a - endA
+//               \ joint2b - joint3b - endB
+// The base is mounted on a DAF.
+TreeDevice::Ptr makeDevice(StateStructure& stateStructure, TreeFrames& frames) {
+	frames.daf = new MovableFrame("DAF");
+	frames.other = new MovableFrame("Other");
+	frames.base = new FixedFrame("Base",Transform3D<>(Vector3D<>(0.1,0.2,0.3),RPY<>(0.5,0.1,0)));
+	frames.joint1 = new RevoluteJoint("Joint1",Transform3D<>(Vector3D<>(0, 0, 0.2)));
+	frames.joint2a = new RevoluteJoint("Joint2a",Transform3D<>(Vector3D<>(0, 0.1, 0.2),RPY<>(0,0,-Pi/2.)));
+	frames.endA = new FixedFrame("EndA",Transform3D<>(Vector3D<>(0.3,0,0.1)));
+	frames.joint2b = new PrismaticJoint("Joint2b",Transform3D<>(Vector3D<>(0.2, 0, 0),RPY<>(0.2,0.3,0.4)));
+	frames.joint3b = new RevoluteJoint("Joint3b",Transform3D<>(Vector3D<>(0,-0.2,0),RPY<>(0,0, Pi/2.)));
+	frames.endB = new FixedFrame("EndB",Transform3D<>(Vector3D<>(0,0,0.1)));
+
+	stateStructure.addFrame(ownedPtr(frames.other));
+	stateStructure.addDAF(ownedPtr(frames.daf),stateStructure.getRoot());
+	stateStructure.addFrame(ownedPtr(frames.base),frames.daf);
+	stateStructure.addFrame(ownedPtr(frames.joint1),frames.base);
+	stateStructure.addFrame(ownedPtr(frames.joint2a),frames.joint1);
+	stateStructure.addFrame(ownedPtr(frames.endA),frames.joint2a);
+	stateStructure.addFrame(ownedPtr(frames.joint2b),frames.joint1);
+	stateStructure.addFrame(ownedPtr(frames.joint3b),frames.joint2b);
+	stateStructure.addFrame(ownedPtr(frames.endB),frames.joint3b);
+
+	std::vector<Frame*> ends;
+	ends.push_back(frames.endA);
+	ends.push_back(frames.endB);
+	const State state = stateStructure.getDefaultState();
+	return ownedPtr(new TreeDevice(frames.base,ends,"TestDevice",state));
+}
+
+// Central differences of the end-effector poses relative to the base
+Jacobian numericJacobian(const TreeDevice& device, const std::vector<Frame*>& ends, State state) {
+	const double h = 1e-5;
+	const Q q = device.getQ(state);
+	Jacobian jacobian = Jacobian::zero(6*ends.size(), device.getDOF());
+	for (std::size_t i = 0; i < ends.size(); i++) {
+		device.setQ(q, state);
+		const Rotation3D<> R = Kinematics::frameTframe(device.getBase(), ends[i], state).R();
+		for (std::size_t j = 0; j < device.getDOF(); j++) {
+			Q qp = q;
+			Q qm = q;
+			qp[j] += h;
+			qm[j] -= h;
+			device.setQ(qp, state);
+			const Transform3D<> Tp = Kinematics::frameTframe(device.getBase(), ends[i], state);
+			device.setQ(qm, state);
+			const Transform3D<> Tm = Kinematics::frameTframe(device.getBase(), ends[i], state);
+			// dR/dq * R^T is the skew-symmetric matrix of the angular velocity
+			const Eigen::Matrix3d W = (Tp.R().e() - Tm.R().e())/(2*h)*R.e().transpose();
+			const Vector3D<> dp = (Tp.P() - Tm.P())/(2*h);
+			for (std::size_t k = 0; k < 3; k++)
+				jacobian(6*i+k, j) = dp[k];
+			jacobian(6*i+3, j) = W(2,1);
+			jacobian(6*i+4, j) = W(0,2);
+			jacobian(6*i+5, j) = W(1,0);
+		}
+	}
+	return jacobian;
+}
+
+std::size_t column(const TreeDevice& device, const Joint* joint) {
+	std::size_t col = 0;
+	for (std::size_t j = 0; device.getJoints()[j] != joint; j++)
+		col += device.getJoints()[j]->getDOF();
+	return col;
+}
+}
+
+TEST(JointDeviceJacobianCalculator, TreeDevice) {
+	StateStructure stateStructure;
+	TreeFrames frames;
+	const TreeDevice::Ptr device = makeDevice(stateStructure, frames);
+	State state = stateStructure.getDefaultState();
+	frames.daf->setTransform(Transform3D<>(Vector3D<>(1,2,3),RPY<>(0.3,0.2,0.1)), state);
+
+	std::vector<Frame*> ends;
+	ends.push_back(frames.endA);
+	ends.push_back(frames.endB);
+	const JointDeviceJacobianCalculator calculator(device, device->getBase(), ends, state);
+
+	// Each end-effector only depends on the joints on its branch
+	const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic>& dependencies = calculator.getDependencies();
+	ASSERT_EQ(2, dependencies.rows());
+	ASSERT_EQ(4, dependencies.cols());
+	EXPECT_EQ(2, dependencies.row(0).count());
+	EXPECT_EQ(3, dependencies.row(1).count());
+	EXPECT_TRUE(dependencies(0, column(*device, frames.joint1)));
+	EXPECT_TRUE(dependencies(1, column(*device, frames.joint1)));
+	EXPECT_TRUE(dependencies(0, column(*device, frames.joint2a)));
+	EXPECT_FALSE(dependencies(1, column(*device, frames.joint2a)));
+	EXPECT_TRUE(dependencies(1, column(*device, frames.joint2b)));
+	EXPECT_TRUE(dependencies(1, column(*device, frames.joint3b)));
+
+	Jacobian inPlace(0, 0);
+	Eigen::SparseMatrix<double> sparse;
+	for (std::size_t n = 0; n < 10; n++) {
+		device->setQ(Q(Eigen::VectorXd::Random(4)), state);
+
+		const Jacobian jacobian = calculator.get(state);
+		ASSERT_EQ(12u, jacobian.size1());
+		ASSERT_EQ(4u, jacobian.size2());
+		EXPECT_TRUE(jacobian.e().isApprox(numericJacobian(*device, ends, state).e(), 1e-8));
+
+		calculator.get(state, inPlace);
+		EXPECT_EQ(jacobian.e(), inPlace.e());
+
+		calculator.getSparse(state, sparse);
+		EXPECT_EQ(6*(2+3), sparse.nonZeros());
+		EXPECT_EQ(jacobian.e(), Eigen::MatrixXd(sparse));
+	}
+
+	// Falls back to the full forward kinematics when the DAF is moved
+	frames.daf->attachTo(frames.other, state);
+	frames.other->setTransform(Transform3D<>(Vector3D<>(-1,0,1),RPY<>(0.1,-0.2,0.3)), state);
+	EXPECT_TRUE(calculator.get(state).e().isApprox(numericJacobian(*device, ends, state).e(), 1e-8));
+}
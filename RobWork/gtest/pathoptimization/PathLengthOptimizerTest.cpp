@@ -17,9 +17,14 @@
 
 #include <gtest/gtest.h>
 
+#include <rw/common/ThreadPool.hpp>
+#include <rw/math/MetricFactory.hpp>
+#include <rw/math/Random.hpp>
+#include <rw/pathplanning/PathAnalyzer.hpp>
 #include <rwlibs/pathoptimization/pathlength/PathLengthOptimizer.hpp>
 
 using rw::common::ownedPtr;
+using rw::common::ThreadPool;
 using namespace rw::math;
 using namespace rw::pathplanning;
 using rw::trajectory::QPath;
@@ -50,6 +55,24 @@ namespace {
                     return false;
             }
     };
+
+    // Wall at x = 0.5 that ends at y = 0.8
+    class WallQConstraint: public QConstraint
+    {
+        protected:
+            virtual bool doInCollision(const Q& q) const
+            {
+                return std::fabs(q[0] - 0.5) < 0.05 && q[1] < 0.8;
+            }
+
+            virtual void doSetLog(rw::common::Log::Ptr log) {}
+    };
+
+    PlannerConstraint makeWallConstraint(QMetric::CPtr metric)
+    {
+        const QConstraint::Ptr constraint = ownedPtr(new WallQConstraint());
+        return PlannerConstraint::make(constraint, QEdgeConstraint::make(constraint, metric, 0.005));
+    }
 }
 
 TEST(PathLengthOptimizer, pathPruning) {
@@ -74,3 +97,46 @@ TEST(PathLengthOptimizer, pathPruning) {
     EXPECT_TRUE(pathAfter[0] == q1);
     EXPECT_TRUE(pathAfter[1] == q5);
 }
+
+TEST(PathLengthOptimizer, shortCutParallel) {
+    const QMetric::CPtr metric = MetricFactory::makeEuclidean<Q>();
+    std::vector<PlannerConstraint> constraints;
+    for (int i = 0; i < 3; i++)
+        constraints.push_back(makeWallConstraint(metric));
+
+    // A detour over the wall with wiggles
+    QPath path;
+    for (int i = 0; i <= 100; i++) {
+        const double t = i / 100.0;
+        const double y = 0.9 * std::sin(t * Pi) + 0.02 * std::sin(t * 40 * Pi);
+        path.push_back(Q(2, t, std::max(0.0, y)));
+    }
+    for (std::size_t i = 1; i < path.size(); i++)
+        ASSERT_FALSE(constraints[0].inCollision(path[i-1], path[i]));
+
+    PathLengthOptimizer optimizer(constraints, metric);
+    const ThreadPool::Ptr pool = ownedPtr(new ThreadPool(2));
+    QPath results[2];
+    for (int k = 0; k < 2; k++) {
+        optimizer.setThreadPool(k == 0 ? NULL : pool);
+        Random::seed(1);
+        results[k] = optimizer.shortCutParallel(path, 400, 0, 0.05);
+    }
+    EXPECT_TRUE(results[0] == results[1]);
+
+    const QPath& result = results[0];
+    ASSERT_GE(result.size(), 2u);
+    EXPECT_TRUE(result.front() == path.front());
+    EXPECT_TRUE(result.back() == path.back());
+    EXPECT_LT(PathAnalyzer::pathLength(result.begin(), result.end(), *metric), 0.9 * PathAnalyzer::pathLength(path.begin(), path.end(), *metric));
+    for (std::size_t i = 1; i < result.size(); i++)
+        EXPECT_FALSE(constraints[0].inCollision(result[i-1], result[i]));
+
+    // The partial shortcuts keep the number of configurations
+    Random::seed(1);
+    const QPath partial = optimizer.partialShortCutParallel(result, 200, 0, 0);
+    EXPECT_EQ(result.size(), partial.size());
+    EXPECT_LE(PathAnalyzer::pathLength(partial.begin(), partial.end(), *metric), PathAnalyzer::pathLength(result.begin(), result.end(), *metric) + 1e-12);
+    for (std::size_t i = 1; i < partial.size(); i++)
+        EXPECT_FALSE(constraints[0].inCollision(partial[i-1], partial[i]));
+}
@@ -0,0 +1,256 @@
+/********************************************************************************
+ * Copyright 2016 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include <gtest/gtest.h>
+#include "../TestEnvironment.hpp"
+
+#include <rw/common/ThreadPool.hpp>
+#include <rw/geometry/OBBPacketCollider.hpp>
+#include <rw/kinematics/MovableFrame.hpp>
+#include <rw/kinematics/State.hpp>
+#include <rw/loaders/WorkCellLoader.hpp>
+#include <rw/math/Math.hpp>
+#include <rw/math/RPY.hpp>
+#include <rw/models/Device.hpp>
+#include <rw/models/WorkCell.hpp>
+#include <rw/proximity/CollisionDetector.hpp>
+#include <rw/proximity/DynamicAABBTreeFilterStrategy.hpp>
+#include <rw/proximity/rwstrategy/ProximityStrategyRW.hpp>
+#include <rwlibs/proximitystrategies/ProximityStrategyPQP.hpp>
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+
+using namespace rw::common;
+using namespace rw::geometry;
+using namespace rw::kinematics;
+using namespace rw::loaders;
+using namespace rw::math;
+using namespace rw::models;
+using namespace rw::proximity;
+using namespace rwlibs::proximitystrategies;
+
+namespace {
+class CollisionDetectorTest: public ::testing::Test {
+protected:
+	virtual void SetUp() {
+		wc = WorkCellLoader::Factory::load(TestEnvironment::testfilesDir() + "simple/workcell.wc.xml");
+		ASSERT_FALSE(wc.isNull());
+		device = wc->findDevice("PA10");
+		ASSERT_FALSE(device.isNull());
+		item = wc->findFrame<MovableFrame>("Item");
+		ASSERT_TRUE(item != NULL);
+		}
+
+	// Place the movable item (a long thin cylinder) at a random pose in the reach of the robot
+	void placeItem(State& state) const {
+		const Vector3D<> pos(Math::ran(-0.5,0.5), Math::ran(-0.5,0.5), Math::ran(0.6,1.0));
+		const RPY<> rpy(Math::ran(-Pi,Pi), Math::ran(-Pi/2,Pi/2), Math::ran(-Pi,Pi));
+		item->setTransform(Transform3D<>(pos,rpy), state);
+	}
+
+	// States with a random configuration of the robot and a random pose of the item
+	std::vector<State> randomStates(std::size_t n) const {
+		std::vector<State> states(n, wc->getDefaultState());
+		BOOST_FOREACH(State& state, states) {
+			device->setQ(Math::ranQ(device->getBounds()), state);
+			placeItem(state);
+		}
+		return states;
+	}
+
+	WorkCell::Ptr wc;
+	Device::Ptr device;
+	MovableFrame* item;
+};
+}
+
+TEST_F(CollisionDetectorTest, threadPool) {
+	const CollisionDetector sequential(wc, ownedPtr(new ProximityStrategyRW()));
+	CollisionDetector parallel(wc, ownedPtr(new ProximityStrategyRW()));
+	parallel.setThreadPool(ownedPtr(new ThreadPool(2)));
+
+	State state = wc->getDefaultState();
+	std::size_t nrOfCollisions = 0;
+	for (int i = 0; i < 50; i++) {
+		device->setQ(Math::ranQ(device->getBounds()), state);
+		placeItem(state);
+
+		CollisionDetector::QueryResult expected;
+		CollisionDetector::QueryResult result;
+		const bool col = sequential.inCollision(state, &expected);
+		EXPECT_EQ(col, parallel.inCollision(state, &result));
+		EXPECT_TRUE(expected.collidingFrames == result.collidingFrames);
+		EXPECT_EQ(col, parallel.inCollision(state));
+		if (col)
+			nrOfCollisions++;
+
+		// the first contact must be the same as for the sequential query
+		CollisionDetector::QueryResult expectedFirst;
+		CollisionDetector::QueryResult resultFirst;
+		EXPECT_EQ(col, sequential.inCollision(state, &expectedFirst, true));
+		EXPECT_EQ(col, parallel.inCollision(state, &resultFirst, true));
+		EXPECT_TRUE(expectedFirst.collidingFrames == resultFirst.collidingFrames);
+	}
+	EXPECT_GT(nrOfCollisions, 0u);
+}
+
+TEST_F(CollisionDetectorTest, instructionSets) {
+	// PQP is the reference for the packet tests of the RW strategy
+	const CollisionDetector reference(wc, ownedPtr(new ProximityStrategyPQP()));
+	const std::vector<State> states = randomStates(100);
+	std::vector<CollisionDetector::QueryResult> expected(states.size());
+	std::vector<bool> expectedBits;
+	for (std::size_t i = 0; i < states.size(); i++)
+		expectedBits.push_back(reference.inCollision(states[i], &expected[i]));
+	ASSERT_TRUE(std::find(expectedBits.begin(), expectedBits.end(), true) != expectedBits.end());
+
+	// an instruction set that the CPU does not support is replaced by the best supported one
+	static const OBBPacketCollider::InstructionSet sets[] = { OBBPacketCollider::Scalar, OBBPacketCollider::SSE2, OBBPacketCollider::AVX };
+	BOOST_FOREACH(const OBBPacketCollider::InstructionSet set, sets) {
+		const ProximityStrategyRW::Ptr strategy = ownedPtr(new ProximityStrategyRW());
+		strategy->setInstructionSet(set);
+		const CollisionDetector detector(wc, strategy);
+		for (std::size_t i = 0; i < states.size(); i++) {
+			CollisionDetector::QueryResult result;
+			EXPECT_EQ(expectedBits[i], detector.inCollision(states[i], &result)) << "instruction set " << set << ", state " << i;
+			EXPECT_TRUE(expected[i].collidingFrames == result.collidingFrames) << "instruction set " << set << ", state " << i;
+			EXPECT_EQ(expectedBits[i], detector.inCollision(states[i], NULL, true)) << "instruction set " << set << ", state " << i;
+		}
+	}
+}
+
+TEST_F(CollisionDetectorTest, dynamicAABBTreeFilter) {
+	const CollisionDetector basic(wc, ownedPtr(new ProximityStrategyRW()));
+	const DynamicAABBTreeFilterStrategy::Ptr filter = ownedPtr(new DynamicAABBTreeFilterStrategy(wc));
+	const CollisionDetector tree(wc, ownedPtr(new ProximityStrategyRW()), filter);
+
+	State state = wc->getDefaultState();
+	for (int i = 0; i < 50; i++) {
+		device->setQ(Math::ranQ(device->getBounds()), state);
+		placeItem(state);
+
+		CollisionDetector::QueryResult expected;
+		CollisionDetector::QueryResult result;
+		EXPECT_EQ(basic.inCollision(state, &expected), tree.inCollision(state, &result));
+		EXPECT_TRUE(expected.collidingFrames == result.collidingFrames);
+	}
+
+	// nothing moved, so nothing is reinserted
+	tree.inCollision(state);
+	EXPECT_EQ(0u, filter->getNoOfReinserted());
+}
+
+TEST_F(CollisionDetectorTest, batch) {
+	CollisionDetector detector(wc, ownedPtr(new ProximityStrategyRW()));
+
+	// The robot rarely collides with the static obstacles, so the item is moved
+	// as well. The configurations are also checked with the item in its default place.
+	const State state = wc->getDefaultState();
+	std::vector<Q> qs;
+	std::vector<State> states;
+	std::vector<CollisionDetector::QueryResult> expected(50);
+	std::vector<bool> expectedBits;
+	std::vector<bool> expectedQBits;
+	for (int i = 0; i < 50; i++) {
+		qs.push_back(Math::ranQ(device->getBounds()));
+		states.push_back(state);
+		device->setQ(qs.back(), states.back());
+		expectedQBits.push_back(detector.inCollision(states.back()));
+		placeItem(states.back());
+		expectedBits.push_back(detector.inCollision(states.back(), &expected[i]));
+	}
+	ASSERT_TRUE(std::find(expectedBits.begin(), expectedBits.end(), true) != expectedBits.end());
+	const std::size_t first = std::find(expectedBits.begin(), expectedBits.end(), true) - expectedBits.begin();
+
+	for (int threads = 0; threads <= 2; threads += 2) {
+		if (threads > 0)
+			detector.setThreadPool(ownedPtr(new ThreadPool(threads)));
+
+		std::vector<CollisionDetector::QueryResult> results;
+		const boost::dynamic_bitset<> bits = detector.inCollisionBatch(states, &results);
+		const boost::dynamic_bitset<> qbits = detector.inCollisionBatch(device, qs, state);
+		ASSERT_EQ(qs.size(), bits.size());
+		ASSERT_EQ(qs.size(), qbits.size());
+		ASSERT_EQ(qs.size(), results.size());
+		for (std::size_t i = 0; i < qs.size(); i++) {
+			EXPECT_EQ(expectedBits[i], bits[i]);
+			EXPECT_EQ(expectedQBits[i], qbits[i]);
+			EXPECT_TRUE(expected[i].collidingFrames == results[i].collidingFrames);
+		}
+
+		// only the first state in collision is reported
+		const boost::dynamic_bitset<> firstBits = detector.inCollisionBatch(states, NULL, true, true);
+		EXPECT_EQ(1u, firstBits.count());
+		EXPECT_EQ(first, firstBits.find_first());
+	}
+}
+
+TEST_F(CollisionDetectorTest, batchThreadPoolStrategies) {
+	const std::vector<State> states = randomStates(200);
+
+	// the strategy is shared by all threads of the pool
+	const ProximityStrategyPQP::Ptr pqp = ownedPtr(new ProximityStrategyPQP());
+	const ProximityStrategyRW::Ptr rw = ownedPtr(new ProximityStrategyRW());
+	const CollisionStrategy::Ptr strategies[2] = { pqp, rw };
+	BOOST_FOREACH(const CollisionStrategy::Ptr& strategy, strategies) {
+		CollisionDetector detector(wc, strategy);
+		pqp->clearStats();
+		const boost::dynamic_bitset<> expected = detector.inCollisionBatch(states);
+		const int expectedBVTests = pqp->getNrOfBVTests();
+		EXPECT_TRUE(expected.any());
+
+		detector.setThreadPool(ownedPtr(new ThreadPool(4)));
+		for (int i = 0; i < 5; i++) {
+			pqp->clearStats();
+			EXPECT_TRUE(expected == detector.inCollisionBatch(states));
+			// no tests are lost when the counters are updated from several threads
+			EXPECT_EQ(expectedBVTests, pqp->getNrOfBVTests());
+		}
+	}
+}
+
+TEST_F(CollisionDetectorTest, temporalCoherence) {
+	const CollisionDetector detector(wc, ownedPtr(new ProximityStrategyRW()));
+	CollisionDetector coherent(wc, ownedPtr(new ProximityStrategyRW()));
+	coherent.setTemporalCoherence(true);
+	EXPECT_TRUE(coherent.isTemporalCoherence());
+
+	// Small steps between random configurations, such that consecutive queries are nearly identical
+	State state = wc->getDefaultState();
+	std::size_t nrOfCollisions = 0;
+	Q from = Math::ranQ(device->getBounds());
+	for (int i = 0; i < 10; i++) {
+		const Q to = Math::ranQ(device->getBounds());
+		placeItem(state);
+		for (int j = 0; j <= 20; j++) {
+			device->setQ(from + (to - from)*(j/20.), state);
+
+			CollisionDetector::QueryResult expected;
+			CollisionDetector::QueryResult result;
+			const bool col = detector.inCollision(state, &expected);
+			EXPECT_EQ(col, coherent.inCollision(state, &result));
+			EXPECT_TRUE(expected.collidingFrames == result.collidingFrames);
+			EXPECT_EQ(col, coherent.inCollision(state, NULL, true));
+			if (col)
+				nrOfCollisions++;
+		}
+		from = to;
+	}
+	EXPECT_GT(nrOfCollisions, 0u);
+}
@@ -19,6 +19,7 @@
 #include "../TestEnvironment.hpp"
 
 #include <rw/common/Ptr.hpp>
+#include <rw/common/ThreadPool.hpp>
 #include <rw/kinematics/State.hpp>
 #include <rw/loaders/WorkCellLoader.hpp>
 #include <rw/models/WorkCell.hpp>
@@ -58,6 +59,8 @@ public:
 
 		strategy = DistanceStrategy::Factory::makeStrategy(GetParam());
 		ASSERT_FALSE(strategy.isNull());
+		// the factory returns the same strategy instance for every test
+		strategy->clear();
         distCalc = new DistanceCalculator(wc, strategy);
     }
 
@@ -103,3 +106,60 @@ TEST_P (DistanceCalculatorTest, SimpleGeometry)
 
 }
 
+
+TEST_P (DistanceCalculatorTest, TemporalCoherence)
+{
+    vector<DistanceStrategy::Result> expected;
+    const DistanceStrategy::Result expectedMin = distCalc->distance(initialState, &expected);
+
+    // The results must not depend on the data kept from the previous query
+    distCalc->setTemporalCoherence(true);
+    EXPECT_TRUE(distCalc->isTemporalCoherence());
+    for (int i = 0; i < 2; i++) {
+        vector<DistanceStrategy::Result> result;
+        EXPECT_NEAR(expectedMin.distance, distCalc->distance(initialState, &result).distance, 1e-12);
+        ASSERT_EQ(expected.size(), result.size());
+        for (size_t j = 0; j < expected.size(); j++)
+            EXPECT_NEAR(expected[j].distance, result[j].distance, 1e-12);
+    }
+}
+
+TEST_P (DistanceCalculatorTest, PruningAndThreadPool)
+{
+    vector<DistanceStrategy::Result> expected;
+    const DistanceStrategy::Result expectedMin = distCalc->distance(initialState, &expected);
+    EXPECT_NEAR(0.8, expectedMin.distance, 0.001);
+
+    // Only the shortest distance is requested, so pairs can be skipped
+    DistanceStrategy::Result min = distCalc->distance(initialState);
+    EXPECT_NEAR(expectedMin.distance, min.distance, 1e-12);
+    EXPECT_EQ(expectedMin.f1, min.f1);
+    EXPECT_EQ(expectedMin.f2, min.f2);
+
+    distCalc->setThreadPool(ownedPtr(new ThreadPool(2)));
+    min = distCalc->distance(initialState);
+    EXPECT_NEAR(expectedMin.distance, min.distance, 1e-12);
+    EXPECT_EQ(expectedMin.f1, min.f1);
+
+    vector<DistanceStrategy::Result> result;
+    min = distCalc->distance(initialState, &result);
+    EXPECT_NEAR(expectedMin.distance, min.distance, 1e-12);
+    ASSERT_EQ(expected.size(), result.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(expected[i].f1, result[i].f1);
+        EXPECT_EQ(expected[i].f2, result[i].f2);
+        EXPECT_NEAR(expected[i].distance, result[i].distance, 1e-12);
+    }
+
+    // the queries of the pool share the models of the strategy
+    for (int i = 0; i < 10; i++) {
+        result.clear();
+        distCalc->distance(initialState, &result);
+        ASSERT_EQ(expected.size(), result.size());
+        for (size_t j = 0; j < expected.size(); j++)
+            EXPECT_NEAR(expected[j].distance, result[j].distance, 1e-12);
+    }
+
+    min = distCalc->distance(initialState, initialFrame);
+    EXPECT_NEAR(1.7, min.distance, 0.001);
+}
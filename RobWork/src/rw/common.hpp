@@ -45,6 +45,7 @@
 #include "./common/StringUtil.hpp"
 #include "./common/ThreadPool.hpp"
 #include "./common/ThreadTask.hpp"
+#include "./common/FunctionTask.hpp"
 #include "./common/Timer.hpp"
 #include "./common/TimerUtil.hpp"
 #include "./common/VectorIterator.hpp"
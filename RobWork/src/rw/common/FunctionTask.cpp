@@ -0,0 +1,53 @@
+/********************************************************************************
+ * Copyright 2014 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include "FunctionTask.hpp"
+#include "Exception.hpp"
+#include "ThreadPool.hpp"
+
+#include <boost/foreach.hpp>
+
+using namespace rw::common;
+
+FunctionTask::FunctionTask(ThreadTask::Ptr parent, boost::function<void()> work):
+	ThreadTask(parent),
+	_work(work)
+{
+}
+
+FunctionTask::~FunctionTask() {
+}
+
+void FunctionTask::run() {
+	try {
+		_work();
+	} catch(const Exception& e) {
+		registerFailure(e);
+	}
+}
+
+void FunctionTask::runAll(rw::common::Ptr<ThreadPool> pool, const std::vector<boost::function<void()> >& work) {
+	ThreadTask task(pool);
+	BOOST_FOREACH(const boost::function<void()>& function, work) {
+		task.addSubTask(ownedPtr(new FunctionTask(&task, function)));
+	}
+	task.execute();
+	task.waitUntilDone();
+	const std::list<Exception> exceptions = task.getExceptions();
+	if (exceptions.size() > 0)
+		throw exceptions.front();
+}
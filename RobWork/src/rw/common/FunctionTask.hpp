@@ -0,0 +1,84 @@
+/********************************************************************************
+ * Copyright 2014 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#ifndef RW_COMMON_FUNCTIONTASK_HPP_
+#define RW_COMMON_FUNCTIONTASK_HPP_
+
+/**
+ * @file FunctionTask.hpp
+ *
+ * \copydoc rw::common::FunctionTask
+ */
+
+#include "ThreadTask.hpp"
+
+#include <boost/function.hpp>
+
+#include <vector>
+
+namespace rw {
+namespace common {
+
+//! @addtogroup common
+
+//! @{
+/**
+ * @brief A ThreadTask that runs a single function.
+ *
+ * An rw::common::Exception thrown by the function is registered as a failure
+ * of the task with ThreadTask::registerFailure.
+ *
+ * The task is used for splitting work into independent pieces, typically with
+ * runAll(), which runs the functions in a ThreadPool and rethrows the first
+ * failure in the calling thread.
+ */
+class FunctionTask: public ThreadTask {
+public:
+	//! @brief smart pointer type to this class
+	typedef rw::common::Ptr<FunctionTask> Ptr;
+
+	/**
+	 * @brief Create task that runs a function.
+	 * @param parent [in] the parent task to take the thread pool from.
+	 * @param work [in] the function to run.
+	 */
+	FunctionTask(ThreadTask::Ptr parent, boost::function<void()> work);
+
+	//! @brief Destructor.
+	virtual ~FunctionTask();
+
+	//! @brief Run the function and register a failure if it throws.
+	void run();
+
+	/**
+	 * @brief Run functions as subtasks in a thread pool and wait until all have finished.
+	 *
+	 * If the pool is NULL or has no threads, the functions are run in the calling thread.
+	 *
+	 * @param pool [in] the thread pool to use.
+	 * @param work [in] the functions to run.
+	 * @throws Exception the first failure registered by the functions.
+	 */
+	static void runAll(rw::common::Ptr<ThreadPool> pool, const std::vector<boost::function<void()> >& work);
+
+private:
+	const boost::function<void()> _work;
+};
+//! @}
+} /* namespace common */
+} /* namespace rw */
+#endif /* RW_COMMON_FUNCTIONTASK_HPP_ */
@@ -72,11 +72,12 @@ public:
 	 * @param var [in] the new value.
 	 */
 	void setVariable(const T var) {
+		// The waiters are notified while holding the lock, as a waiter might destroy the variable as soon as it sees the change.
+		boost::mutex::scoped_lock lock1(_changedMutex);
+		while(_changed)
+			_waitingCond.wait(lock1);
 		bool notifyChange = false;
 		{
-			boost::mutex::scoped_lock lock1(_changedMutex);
-			while(_changed)
-				_waitingCond.wait(lock1);
 			boost::unique_lock<boost::shared_mutex> lock2(_mutex);
 			if (_waiting > 0) {
 				_changed = true;
@@ -139,6 +139,9 @@ void ThreadTask::waitUntilDone() {
 	while (state != DONE) {
 		state = wait(state);
 	}
+	// finish() sets the state while holding the mutex. Wait for it to release the mutex, as the task might
+	// be destroyed as soon as this function returns.
+	boost::mutex::scoped_lock lock(_mutex);
 }
 
 ThreadTask::TaskState ThreadTask::getState() {
@@ -237,27 +240,36 @@ void ThreadTask::runWrap(ThreadPool* pool) {
 		RW_THROW("Please catch boost::thread_interrupted exception thrown in ThreadTask run funtion!");
 	}
 	// State is set to CHILDREN causing children to try to move to IDLE when they finish (if keep alive is disabled).
+	// If subtasks are still running, the last one to finish moves the task on. The task must not be touched after
+	// that, as it might be done and destroyed already.
+	bool childrenDone;
 	{
 		boost::mutex::scoped_lock lock(_mutex);
 		_state->setVariable(CHILDREN);
+		childrenDone = _childrenMissing->getVariable() == 0;
 	}
 	// Now check if task should change to IDLE (if there is no subtasks for instance)
-	tryIdle();
+	if (childrenDone)
+		tryIdle();
 }
 
 void ThreadTask::callbackParent(ThreadTask* task) {
 	// Notify the parent that the subtask has now finished
 	subTaskDone(task);
 	// Decrement children counter
+	bool lastChild;
 	{
 		// Lock the mutex to be sure that:
 		// 1. no other children are trying to decrement counter at the same time
 		// 2. addSubTasks() is not trying to increment counter at the same time
+		// 3. only one of this function and runWrap() moves the task on (it might be destroyed right after)
 		boost::mutex::scoped_lock lock(_mutex);
 		_childrenMissing->setVariable(_childrenMissing->getVariable()-1);
+		lastChild = _childrenMissing->getVariable() == 0 && _state->getVariable() == CHILDREN;
 	}
 	// Now check if task should change to IDLE
-	tryIdle();
+	if (lastChild)
+		tryIdle();
 }
 
 void ThreadTask::tryIdle() {
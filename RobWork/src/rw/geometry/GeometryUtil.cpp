@@ -526,7 +526,7 @@ std::pair<rw::math::Vector3D<>, rw::math::Vector3D<> > GeometryUtil::getExtremum
 	for (size_t i = 0; i<trimesh->size(); i++) {
 		trimesh->getTriangle(i, tri);
 		for (size_t j = 0; j<3; j++) {
-			const Vector3D<>& p = tri.getVertex(j);
+			const Vector3D<> p = t3d*tri.getVertex(j);
 			for (size_t k = 0; k<3; k++) {
 				if (p(k) < minimum(k))
 					minimum(k) = p(k);
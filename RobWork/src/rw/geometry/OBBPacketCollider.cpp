@@ -0,0 +1,82 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include "OBBPacketCollider.hpp"
+#include "PacketKernels.hpp"
+
+#include <cstring>
+
+using namespace rw::geometry;
+using namespace rw::geometry::packet;
+
+namespace {
+	OBBPacketCollider::InstructionSet detectInstructionSet()
+	{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+		if (hasAVXKernels() && __builtin_cpu_supports("avx"))
+			return OBBPacketCollider::AVX;
+#endif
+#ifdef RW_GEOMETRY_PACKET_SSE2
+		return OBBPacketCollider::SSE2;
+#else
+		return OBBPacketCollider::Scalar;
+#endif
+	}
+}
+
+OBBPacketCollider::Packet::Packet():
+	size(0)
+{
+	// lanes beyond size are evaluated as well, so they are kept initialized
+	std::memset(a, 0, sizeof(a));
+	std::memset(b, 0, sizeof(b));
+	std::memset(R, 0, sizeof(R));
+	std::memset(P, 0, sizeof(P));
+}
+
+OBBPacketCollider::OBBPacketCollider():
+	_set(getSupportedInstructionSet())
+{
+	RW_ASSERT(MaxSize == packet::MaxSize);
+}
+
+unsigned int OBBPacketCollider::collides(const Packet& pairs) const
+{
+	switch (_set) {
+	case AVX:
+		return obbAVX(pairs.a, pairs.b, pairs.R, pairs.P, pairs.size);
+#ifdef RW_GEOMETRY_PACKET_SSE2
+	case SSE2:
+		return obbKernel<packet::SSE2>(pairs.a, pairs.b, pairs.R, pairs.P, pairs.size);
+#endif
+	default:
+		return obbKernel<packet::Scalar>(pairs.a, pairs.b, pairs.R, pairs.P, pairs.size);
+	}
+}
+
+void OBBPacketCollider::setInstructionSet(InstructionSet set)
+{
+	const InstructionSet supported = getSupportedInstructionSet();
+	_set = set > supported ? supported : set;
+}
+
+OBBPacketCollider::InstructionSet OBBPacketCollider::getSupportedInstructionSet()
+{
+	static const InstructionSet supported = detectInstructionSet();
+	return supported;
+}
@@ -0,0 +1,132 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#ifndef RW_GEOMETRY_OBBPACKETCOLLIDER_HPP_
+#define RW_GEOMETRY_OBBPACKETCOLLIDER_HPP_
+
+#include <rw/common/macros.hpp>
+#include <rw/math/Transform3D.hpp>
+#include <rw/geometry/OBB.hpp>
+
+#include <cstddef>
+
+namespace rw {
+namespace geometry {
+
+	/**
+	 * @brief tests up to eight pairs of Oriented Bounding Boxes (OBBs) for overlap at once.
+	 *
+	 * The 15 axes separating axis test of OBBCollider is evaluated for all pairs in a
+	 * packet with SSE2 or AVX instructions. The instruction set is selected at runtime
+	 * depending on what the CPU supports, and falls back to scalar code otherwise.
+	 * All instruction sets give the same result as OBBCollider<double>.
+	 *
+	 * Testing one box against several others is done by adding the same box to
+	 * several pairs of the packet.
+	 */
+	class OBBPacketCollider {
+	public:
+		//! @brief the maximum number of pairs in a packet
+		static const std::size_t MaxSize = 8;
+
+		//! @brief the instruction sets the packet tests can be evaluated with
+		typedef enum {
+			Scalar, //!< plain C++
+			SSE2,   //!< two pairs per instruction
+			AVX     //!< four pairs per instruction
+		} InstructionSet;
+
+		/**
+		 * @brief pairs of boxes in structure-of-arrays layout.
+		 */
+		struct Packet {
+			//! @brief constructor for an empty packet
+			Packet();
+
+			/**
+			 * @brief add a pair of boxes to the packet.
+			 * @param obbA [in] the first box.
+			 * @param obbB [in] the second box.
+			 * @param aTb [in] the transform of \b obbB relative to \b obbA
+			 */
+			template<class T>
+			void add(const OBB<T>& obbA, const OBB<T>& obbB, const rw::math::Transform3D<T>& aTb) {
+				RW_ASSERT(size < MaxSize);
+				const rw::math::Vector3D<T>& ha = obbA.getHalfLengths();
+				const rw::math::Vector3D<T>& hb = obbB.getHalfLengths();
+				for (std::size_t i = 0; i < 3; i++) {
+					a[i][size] = ha[i];
+					b[i][size] = hb[i];
+					P[i][size] = aTb.P()[i];
+					for (std::size_t j = 0; j < 3; j++)
+						R[3*i+j][size] = aTb.R()(i,j);
+				}
+				size++;
+			}
+
+			//! @brief remove all pairs from the packet
+			void clear() { size = 0; }
+
+			//! @brief true if no more pairs can be added
+			bool isFull() const { return size == MaxSize; }
+
+			//! @brief half lengths of the first boxes
+			double a[3][MaxSize];
+			//! @brief half lengths of the second boxes
+			double b[3][MaxSize];
+			//! @brief rotation of the second boxes relative to the first (row major)
+			double R[9][MaxSize];
+			//! @brief position of the second boxes relative to the first
+			double P[3][MaxSize];
+			//! @brief the number of pairs
+			std::size_t size;
+		};
+
+		//! @brief constructor. The best instruction set supported by the CPU is used.
+		OBBPacketCollider();
+
+		/**
+		 * @brief test the pairs of a packet.
+		 * @param packet [in] the pairs.
+		 * @return bit i is set if pair i overlaps.
+		 */
+		unsigned int collides(const Packet& packet) const;
+
+		/**
+		 * @brief select the instruction set. An instruction set that is not
+		 * supported is replaced by the best supported one.
+		 * @param set [in] the instruction set.
+		 */
+		void setInstructionSet(InstructionSet set);
+
+		//! @brief get the instruction set used.
+		InstructionSet getInstructionSet() const { return _set; }
+
+		/**
+		 * @brief get the best instruction set supported by the CPU (and compiled in).
+		 * @return the instruction set.
+		 */
+		static InstructionSet getSupportedInstructionSet();
+
+	private:
+		InstructionSet _set;
+	};
+
+}
+}
+
+#endif /* RW_GEOMETRY_OBBPACKETCOLLIDER_HPP_ */
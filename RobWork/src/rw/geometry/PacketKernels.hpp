@@ -0,0 +1,293 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#ifndef RW_GEOMETRY_PACKETKERNELS_HPP_
+#define RW_GEOMETRY_PACKETKERNELS_HPP_
+
+/**
+ * @file PacketKernels.hpp
+ *
+ * @brief SIMD kernels used by OBBPacketCollider and TriTriPacketIntersect.
+ *
+ * The kernels are written once as templates over a vector type, and are
+ * instantiated for plain doubles, SSE2 and AVX. This header is only included
+ * by source files. It must not include other RobWork headers, as it is also
+ * included by PacketKernelsAVX.cpp which is compiled with AVX enabled.
+ */
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RW_GEOMETRY_PACKET_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace rw {
+namespace geometry {
+namespace packet {
+
+    //! @brief the maximum number of pairs in a packet
+    const std::size_t MaxSize = 8;
+
+    /**
+     * @brief check if the AVX kernels were compiled.
+     * @return true if obbAVX and triTriAVX can be called on a CPU with AVX.
+     */
+    bool hasAVXKernels();
+
+    //! @brief obbKernel instantiated for AVX.
+    unsigned int obbAVX(const double (*a)[MaxSize], const double (*b)[MaxSize],
+                        const double (*R)[MaxSize], const double (*P)[MaxSize], std::size_t n);
+
+    //! @brief triTriKernel instantiated for AVX.
+    unsigned int triTriAVX(const double (*p)[3][MaxSize], const double (*q)[3][MaxSize], std::size_t n);
+
+namespace {
+
+    struct Scalar {
+        typedef bool Mask;
+        static const std::size_t Width = 1;
+
+        Scalar() {}
+        Scalar(double x): v(x) {}
+        static Scalar load(const double* ptr) { return *ptr; }
+        static Scalar set(double x) { return x; }
+
+        double v;
+    };
+
+    inline Scalar operator+(Scalar a, Scalar b) { return a.v + b.v; }
+    inline Scalar operator-(Scalar a, Scalar b) { return a.v - b.v; }
+    inline Scalar operator*(Scalar a, Scalar b) { return a.v * b.v; }
+    inline Scalar vabs(Scalar a) { return a.v < 0 ? -a.v : a.v; }
+    inline Scalar vmax(Scalar a, Scalar b) { return b.v > a.v ? b.v : a.v; }
+    inline Scalar vmin(Scalar a, Scalar b) { return b.v < a.v ? b.v : a.v; }
+    inline bool le(Scalar a, Scalar b) { return a.v <= b.v; }
+    inline bool ngt(Scalar a, Scalar b) { return !(a.v > b.v); }
+    inline bool land(bool a, bool b) { return a && b; }
+    inline unsigned int movemask(bool m) { return m ? 1 : 0; }
+
+#ifdef RW_GEOMETRY_PACKET_SSE2
+    struct SSE2 {
+        typedef __m128d Mask;
+        static const std::size_t Width = 2;
+
+        SSE2() {}
+        SSE2(__m128d x): v(x) {}
+        static SSE2 load(const double* ptr) { return _mm_loadu_pd(ptr); }
+        static SSE2 set(double x) { return _mm_set1_pd(x); }
+
+        __m128d v;
+    };
+
+    inline SSE2 operator+(SSE2 a, SSE2 b) { return _mm_add_pd(a.v, b.v); }
+    inline SSE2 operator-(SSE2 a, SSE2 b) { return _mm_sub_pd(a.v, b.v); }
+    inline SSE2 operator*(SSE2 a, SSE2 b) { return _mm_mul_pd(a.v, b.v); }
+    inline SSE2 vabs(SSE2 a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+    inline SSE2 vmax(SSE2 a, SSE2 b) { return _mm_max_pd(a.v, b.v); }
+    inline SSE2 vmin(SSE2 a, SSE2 b) { return _mm_min_pd(a.v, b.v); }
+    inline __m128d le(SSE2 a, SSE2 b) { return _mm_cmple_pd(a.v, b.v); }
+    inline __m128d ngt(SSE2 a, SSE2 b) { return _mm_cmpngt_pd(a.v, b.v); }
+    inline __m128d land(__m128d a, __m128d b) { return _mm_and_pd(a, b); }
+    inline unsigned int movemask(__m128d m) { return (unsigned int)_mm_movemask_pd(m); }
+#endif
+
+#ifdef __AVX__
+    struct AVX {
+        typedef __m256d Mask;
+        static const std::size_t Width = 4;
+
+        AVX() {}
+        AVX(__m256d x): v(x) {}
+        static AVX load(const double* ptr) { return _mm256_loadu_pd(ptr); }
+        static AVX set(double x) { return _mm256_set1_pd(x); }
+
+        __m256d v;
+    };
+
+    inline AVX operator+(AVX a, AVX b) { return _mm256_add_pd(a.v, b.v); }
+    inline AVX operator-(AVX a, AVX b) { return _mm256_sub_pd(a.v, b.v); }
+    inline AVX operator*(AVX a, AVX b) { return _mm256_mul_pd(a.v, b.v); }
+    inline AVX vabs(AVX a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+    inline AVX vmax(AVX a, AVX b) { return _mm256_max_pd(a.v, b.v); }
+    inline AVX vmin(AVX a, AVX b) { return _mm256_min_pd(a.v, b.v); }
+    inline __m256d le(AVX a, AVX b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+    inline __m256d ngt(AVX a, AVX b) { return _mm256_cmp_pd(a.v, b.v, _CMP_NGT_UQ); }
+    inline __m256d land(__m256d a, __m256d b) { return _mm256_and_pd(a, b); }
+    inline unsigned int movemask(__m256d m) { return (unsigned int)_mm256_movemask_pd(m); }
+#endif
+
+    /**
+     * @brief separating axis test of pairs of OBBs, with the same arithmetic as
+     * OBBCollider::collides.
+     *
+     * @param a [in] half lengths of the first boxes.
+     * @param b [in] half lengths of the second boxes.
+     * @param R [in] rotation of the second boxes relative to the first (row major).
+     * @param P [in] position of the second boxes relative to the first.
+     * @param n [in] the number of pairs.
+     * @return bit i is set if pair i overlaps.
+     */
+    template<class V>
+    unsigned int obbKernel(const double (*a)[MaxSize], const double (*b)[MaxSize],
+                           const double (*R)[MaxSize], const double (*P)[MaxSize], std::size_t n)
+    {
+        typedef typename V::Mask Mask;
+        const V reps = V::set(1e-6);
+        unsigned int result = 0;
+        for (std::size_t i = 0; i < n; i += V::Width) {
+            const V a0 = V::load(&a[0][i]), a1 = V::load(&a[1][i]), a2 = V::load(&a[2][i]);
+            const V b0 = V::load(&b[0][i]), b1 = V::load(&b[1][i]), b2 = V::load(&b[2][i]);
+            const V P0 = V::load(&P[0][i]), P1 = V::load(&P[1][i]), P2 = V::load(&P[2][i]);
+            const V R00 = V::load(&R[0][i]), R01 = V::load(&R[1][i]), R02 = V::load(&R[2][i]);
+            const V R10 = V::load(&R[3][i]), R11 = V::load(&R[4][i]), R12 = V::load(&R[5][i]);
+            const V R20 = V::load(&R[6][i]), R21 = V::load(&R[7][i]), R22 = V::load(&R[8][i]);
+            const V F00 = vabs(R00) + reps, F01 = vabs(R01) + reps, F02 = vabs(R02) + reps;
+            const V F10 = vabs(R10) + reps, F11 = vabs(R11) + reps, F12 = vabs(R12) + reps;
+            const V F20 = vabs(R20) + reps, F21 = vabs(R21) + reps, F22 = vabs(R22) + reps;
+
+            // the face normals of A and B
+            Mask m = le(vabs(P0), a0 + b0*F00 + b1*F01 + b2*F02);
+            m = land(m, le(vabs(P0*R00 + P1*R10 + P2*R20), b0 + a0*F00 + a1*F10 + a2*F20));
+            m = land(m, le(vabs(P1), a1 + b0*F10 + b1*F11 + b2*F12));
+            m = land(m, le(vabs(P2), a2 + b0*F20 + b1*F21 + b2*F22));
+            m = land(m, le(vabs(P0*R01 + P1*R11 + P2*R21), b1 + a0*F01 + a1*F11 + a2*F21));
+            m = land(m, le(vabs(P0*R02 + P1*R12 + P2*R22), b2 + a0*F02 + a1*F12 + a2*F22));
+            if (movemask(m) == 0)
+                continue;
+
+            // the cross products of the edges
+            m = land(m, le(vabs(P2*R10 - P1*R20), a1*F20 + a2*F10 + b1*F02 + b2*F01));
+            m = land(m, le(vabs(P2*R11 - P1*R21), a1*F21 + a2*F11 + b0*F02 + b2*F00));
+            m = land(m, le(vabs(P2*R12 - P1*R22), a1*F22 + a2*F12 + b0*F01 + b1*F00));
+            m = land(m, le(vabs(P0*R20 - P2*R00), a0*F20 + a2*F00 + b1*F12 + b2*F11));
+            m = land(m, le(vabs(P0*R21 - P2*R01), a0*F21 + a2*F01 + b0*F12 + b2*F10));
+            m = land(m, le(vabs(P0*R22 - P2*R02), a0*F22 + a2*F02 + b0*F11 + b1*F10));
+            m = land(m, le(vabs(P1*R00 - P0*R10), a0*F10 + a1*F00 + b1*F22 + b2*F21));
+            m = land(m, le(vabs(P1*R01 - P0*R11), a0*F11 + a1*F01 + b0*F22 + b2*F20));
+            m = land(m, le(vabs(P1*R02 - P0*R12), a0*F12 + a1*F02 + b0*F21 + b1*F20));
+            result |= movemask(m) << i;
+        }
+        return n < 32 ? result & ((1u << n) - 1) : result;
+    }
+
+    template<class V>
+    struct Vec3 {
+        V x, y, z;
+        Vec3() {}
+        Vec3(const V& x_, const V& y_, const V& z_): x(x_), y(y_), z(z_) {}
+    };
+
+    template<class V>
+    inline Vec3<V> operator-(const Vec3<V>& a, const Vec3<V>& b) { return Vec3<V>(a.x - b.x, a.y - b.y, a.z - b.z); }
+
+    template<class V>
+    inline Vec3<V> cross(const Vec3<V>& a, const Vec3<V>& b) {
+        return Vec3<V>(a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x);
+    }
+
+    template<class V>
+    inline V dot(const Vec3<V>& a, const Vec3<V>& b) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+
+    template<class V>
+    inline Vec3<V> load3(const double (*v)[MaxSize], std::size_t i) {
+        return Vec3<V>(V::load(&v[0][i]), V::load(&v[1][i]), V::load(&v[2][i]));
+    }
+
+    // overlap of the projections of the two triangles on the axis ax
+    template<class V>
+    inline typename V::Mask project6(const Vec3<V>& ax,
+                                     const Vec3<V>& p1, const Vec3<V>& p2, const Vec3<V>& p3,
+                                     const Vec3<V>& q1, const Vec3<V>& q2, const Vec3<V>& q3)
+    {
+        const V P1 = dot(ax, p1), P2 = dot(ax, p2), P3 = dot(ax, p3);
+        const V Q1 = dot(ax, q1), Q2 = dot(ax, q2), Q3 = dot(ax, q3);
+        const V mx1 = vmax(vmax(P1, P2), P3);
+        const V mn1 = vmin(vmin(P1, P2), P3);
+        const V mx2 = vmax(vmax(Q1, Q2), Q3);
+        const V mn2 = vmin(vmin(Q1, Q2), Q3);
+        return land(ngt(mn1, mx2), ngt(mn2, mx1));
+    }
+
+    /**
+     * @brief triangle-triangle intersection test of pairs of triangles, with the
+     * same arithmetic as TriTriIntersectDeviller::inCollision.
+     *
+     * @param p [in] vertices of the first triangles, p[vertex][coordinate][pair].
+     * @param q [in] vertices of the second triangles, in the same frame as \b p.
+     * @param n [in] the number of pairs.
+     * @return bit i is set if pair i intersects.
+     */
+    template<class V>
+    unsigned int triTriKernel(const double (*p)[3][MaxSize], const double (*q)[3][MaxSize], std::size_t n)
+    {
+        typedef typename V::Mask Mask;
+        unsigned int result = 0;
+        for (std::size_t i = 0; i < n; i += V::Width) {
+            // p1 is moved to the origin
+            const Vec3<V> P1 = load3<V>(p[0], i);
+            const Vec3<V> p1 = P1 - P1;
+            const Vec3<V> p2 = load3<V>(p[1], i) - P1;
+            const Vec3<V> p3 = load3<V>(p[2], i) - P1;
+            const Vec3<V> q1 = load3<V>(q[0], i) - P1;
+            const Vec3<V> q2 = load3<V>(q[1], i) - P1;
+            const Vec3<V> q3 = load3<V>(q[2], i) - P1;
+
+            const Vec3<V> e1 = p2 - p1, e2 = p3 - p2, e3 = p1 - p3;
+            const Vec3<V> f1 = q2 - q1, f2 = q3 - q2, f3 = q1 - q3;
+            const Vec3<V> n1 = cross(e1, e2);
+            const Vec3<V> m1 = cross(f1, f2);
+
+            Mask m = project6(n1, p1, p2, p3, q1, q2, q3);
+            m = land(m, project6(m1, p1, p2, p3, q1, q2, q3));
+            if (movemask(m) == 0)
+                continue;
+
+            m = land(m, project6(cross(e1, f1), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e1, f2), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e1, f3), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e2, f1), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e2, f2), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e2, f3), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e3, f1), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e3, f2), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e3, f3), p1, p2, p3, q1, q2, q3));
+            if (movemask(m) == 0)
+                continue;
+
+            m = land(m, project6(cross(e1, n1), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e2, n1), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(e3, n1), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(f1, m1), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(f2, m1), p1, p2, p3, q1, q2, q3));
+            m = land(m, project6(cross(f3, m1), p1, p2, p3, q1, q2, q3));
+            result |= movemask(m) << i;
+        }
+        return n < 32 ? result & ((1u << n) - 1) : result;
+    }
+
+} // end anonymous namespace
+
+}
+}
+}
+
+#endif /* RW_GEOMETRY_PACKETKERNELS_HPP_ */
@@ -0,0 +1,62 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+// This file is compiled with AVX enabled (see src/rw/CMakeLists.txt). It must
+// only include PacketKernels.hpp, such that no code shared with other files is
+// compiled with AVX instructions.
+
+#include "PacketKernels.hpp"
+
+using namespace rw::geometry::packet;
+
+#ifdef __AVX__
+
+bool rw::geometry::packet::hasAVXKernels()
+{
+    return true;
+}
+
+unsigned int rw::geometry::packet::obbAVX(const double (*a)[MaxSize], const double (*b)[MaxSize],
+                                          const double (*R)[MaxSize], const double (*P)[MaxSize], std::size_t n)
+{
+    return obbKernel<AVX>(a, b, R, P, n);
+}
+
+unsigned int rw::geometry::packet::triTriAVX(const double (*p)[3][MaxSize], const double (*q)[3][MaxSize], std::size_t n)
+{
+    return triTriKernel<AVX>(p, q, n);
+}
+
+#else
+
+bool rw::geometry::packet::hasAVXKernels()
+{
+    return false;
+}
+
+unsigned int rw::geometry::packet::obbAVX(const double (*a)[MaxSize], const double (*b)[MaxSize],
+                                          const double (*R)[MaxSize], const double (*P)[MaxSize], std::size_t n)
+{
+    return obbKernel<Scalar>(a, b, R, P, n);
+}
+
+unsigned int rw::geometry::packet::triTriAVX(const double (*p)[3][MaxSize], const double (*q)[3][MaxSize], std::size_t n)
+{
+    return triTriKernel<Scalar>(p, q, n);
+}
+
+#endif
@@ -0,0 +1,57 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include "TriTriPacketIntersect.hpp"
+#include "PacketKernels.hpp"
+
+#include <cstring>
+
+using namespace rw::geometry;
+using namespace rw::geometry::packet;
+
+TriTriPacketIntersect::Packet::Packet():
+	size(0)
+{
+	// lanes beyond size are evaluated as well, so they are kept initialized
+	std::memset(p, 0, sizeof(p));
+	std::memset(q, 0, sizeof(q));
+}
+
+TriTriPacketIntersect::TriTriPacketIntersect():
+	_set(OBBPacketCollider::getSupportedInstructionSet())
+{
+}
+
+unsigned int TriTriPacketIntersect::inCollision(const Packet& pairs) const
+{
+	switch (_set) {
+	case OBBPacketCollider::AVX:
+		return triTriAVX(pairs.p, pairs.q, pairs.size);
+#ifdef RW_GEOMETRY_PACKET_SSE2
+	case OBBPacketCollider::SSE2:
+		return triTriKernel<packet::SSE2>(pairs.p, pairs.q, pairs.size);
+#endif
+	default:
+		return triTriKernel<packet::Scalar>(pairs.p, pairs.q, pairs.size);
+	}
+}
+
+void TriTriPacketIntersect::setInstructionSet(OBBPacketCollider::InstructionSet set)
+{
+	const OBBPacketCollider::InstructionSet supported = OBBPacketCollider::getSupportedInstructionSet();
+	_set = set > supported ? supported : set;
+}
@@ -0,0 +1,112 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#ifndef RW_GEOMETRY_TRITRIPACKETINTERSECT_HPP_
+#define RW_GEOMETRY_TRITRIPACKETINTERSECT_HPP_
+
+#include <rw/common/macros.hpp>
+#include <rw/math/Transform3D.hpp>
+#include <rw/geometry/Triangle.hpp>
+
+#include "OBBPacketCollider.hpp"
+
+#include <cstddef>
+
+namespace rw {
+namespace geometry {
+
+	/**
+	 * @brief tests up to eight pairs of triangles for intersection at once.
+	 *
+	 * The separating axis test of TriTriIntersectDeviller is evaluated for all pairs
+	 * in a packet with SSE2 or AVX instructions, selected at runtime as in
+	 * OBBPacketCollider. All instruction sets give the same result as
+	 * TriTriIntersectDeviller<double>.
+	 */
+	class TriTriPacketIntersect {
+	public:
+		//! @brief the maximum number of pairs in a packet
+		static const std::size_t MaxSize = OBBPacketCollider::MaxSize;
+
+		/**
+		 * @brief pairs of triangles in structure-of-arrays layout.
+		 */
+		struct Packet {
+			//! @brief constructor for an empty packet
+			Packet();
+
+			/**
+			 * @brief add a pair of triangles to the packet.
+			 * @param triP [in] the first triangle.
+			 * @param triQ [in] the second triangle.
+			 * @param pTq [in] the transform of \b triQ relative to \b triP.
+			 */
+			template<class T>
+			void add(const Triangle<T>& triP, const Triangle<T>& triQ, const rw::math::Transform3D<T>& pTq) {
+				RW_ASSERT(size < MaxSize);
+				for (std::size_t v = 0; v < 3; v++) {
+					const rw::math::Vector3D<T> qv = pTq*triQ[v];
+					for (std::size_t i = 0; i < 3; i++) {
+						p[v][i][size] = triP[v][i];
+						q[v][i][size] = qv[i];
+					}
+				}
+				size++;
+			}
+
+			//! @brief remove all pairs from the packet
+			void clear() { size = 0; }
+
+			//! @brief true if no more pairs can be added
+			bool isFull() const { return size == MaxSize; }
+
+			//! @brief vertices of the first triangles, p[vertex][coordinate][pair]
+			double p[3][3][MaxSize];
+			//! @brief vertices of the second triangles, relative to the first
+			double q[3][3][MaxSize];
+			//! @brief the number of pairs
+			std::size_t size;
+		};
+
+		//! @brief constructor. The best instruction set supported by the CPU is used.
+		TriTriPacketIntersect();
+
+		/**
+		 * @brief test the pairs of a packet.
+		 * @param packet [in] the pairs.
+		 * @return bit i is set if the triangles of pair i intersect.
+		 */
+		unsigned int inCollision(const Packet& packet) const;
+
+		/**
+		 * @brief select the instruction set. An instruction set that is not
+		 * supported is replaced by the best supported one.
+		 * @param set [in] the instruction set.
+		 */
+		void setInstructionSet(OBBPacketCollider::InstructionSet set);
+
+		//! @brief get the instruction set used.
+		OBBPacketCollider::InstructionSet getInstructionSet() const { return _set; }
+
+	private:
+		OBBPacketCollider::InstructionSet _set;
+	};
+
+}
+}
+
+#endif /* RW_GEOMETRY_TRITRIPACKETINTERSECT_HPP_ */
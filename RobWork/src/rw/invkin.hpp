@@ -33,5 +33,6 @@
 #include "./invkin/PieperSolver.hpp"
 #include "./invkin/JacobianIKSolver.hpp"
 #include "./invkin/JacobianIKSolverM.hpp"
+#include "./invkin/ReachabilityMap.hpp"
 
 #endif /* INVKIN_HPP_ */
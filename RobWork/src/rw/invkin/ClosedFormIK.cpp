@@ -26,6 +26,8 @@
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+
 using namespace rw::invkin;
 using namespace rw::models;
 using namespace rw::kinematics;
@@ -80,3 +82,29 @@ ClosedFormIK::Ptr ClosedFormIK::make(const Device& device,
 
     return ownedPtr(new PieperSolver(dhs, lastToEnd));
 }
+
+void ClosedFormIK::solveBatch(const TransformArray& baseTend, const State& state,
+                              Eigen::ArrayXXd& solutions, BranchArray& valid) const
+{
+    const Eigen::Index n = baseTend.rows();
+    std::vector<std::vector<Q> > all(n);
+    std::size_t branches = 0;
+    std::size_t dof = 0;
+    for (Eigen::Index i = 0; i < n; i++) {
+        all[i] = solve(JointDeviceBatchFK::getTransform(baseTend, i), state);
+        branches = std::max(branches, all[i].size());
+        if (!all[i].empty())
+            dof = all[i].front().size();
+    }
+
+    solutions.resize(n, branches*dof);
+    valid.resize(n, branches);
+    valid.setConstant(false);
+    for (Eigen::Index i = 0; i < n; i++) {
+        for (std::size_t b = 0; b < all[i].size(); b++) {
+            for (std::size_t j = 0; j < dof; j++)
+                solutions(i, b*dof + j) = all[i][b](j);
+            valid(i, b) = true;
+        }
+    }
+}
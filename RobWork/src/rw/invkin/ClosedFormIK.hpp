@@ -24,6 +24,9 @@
  */
 #include "InvKinSolver.hpp"
 #include <rw/common/Ptr.hpp>
+#include <rw/models/JointDeviceBatchFK.hpp>
+
+#include <Eigen/Core>
 
 namespace rw { namespace models { class Device; } }
 
@@ -51,6 +54,18 @@ namespace rw { namespace invkin {
 		//! @brief smart pointer type to this class
 		typedef rw::common::Ptr<ClosedFormIK> Ptr;
 
+		/**
+		 * @brief Target poses for batch solvers, with one pose per row in the
+		 * layout of rw::models::JointDeviceBatchFK::TransformArray.
+		 */
+		typedef rw::models::JointDeviceBatchFK::TransformArray TransformArray;
+
+		/**
+		 * @brief Validity of the solution branches of batch solvers, with one
+		 * row per target and one column per branch.
+		 */
+		typedef Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> BranchArray;
+
 		/**
            @brief Closed-form IK solver for a device.
 
@@ -74,6 +89,28 @@ namespace rw { namespace invkin {
         */
         virtual ~ClosedFormIK() {}
 
+        /**
+         * @brief Solve the inverse kinematics for a batch of target poses.
+         *
+         * The solutions of each target are stored in a number of branches
+         * of the solver. Branch \f$b\f$ of target \f$i\f$ is stored in row
+         * \f$i\f$ and columns \f$bD,\ldots,bD+D-1\f$ of \b solutions, where
+         * \f$D\f$ is the number of degrees of freedom, and it is only a
+         * solution if \b valid(i,b) is true.
+         *
+         * The default implementation calls solve() for each target and
+         * stores the solutions of a target in the first branches, such that
+         * the number of branches is the largest number of solutions found.
+         * Solvers with a fixed set of branches can solve all targets at once.
+         *
+         * @param baseTend [in] the desired base to end transforms, one per row.
+         * @param state [in] the state to solve the targets in.
+         * @param solutions [out] the solutions.
+         * @param valid [out] the validity of each branch.
+         */
+        virtual void solveBatch(const TransformArray& baseTend, const kinematics::State& state,
+                                Eigen::ArrayXXd& solutions, BranchArray& valid) const;
+
     protected:
         /**
            @brief Constructor
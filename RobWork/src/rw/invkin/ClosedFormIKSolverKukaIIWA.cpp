@@ -22,12 +22,71 @@
 #include <rw/math/Rotation2D.hpp>
 #include <rw/models/SerialDevice.hpp>
 #include <rw/models/Joint.hpp>
+#include <rw/models/RevoluteJoint.hpp>
 
+#include <typeinfo>
+
+using rw::invkin::ClosedFormIK;
 using rw::invkin::ClosedFormIKSolverKukaIIWA;
 using namespace rw::kinematics;
 using namespace rw::math;
 using namespace rw::models;
 
+namespace {
+	typedef Eigen::ArrayXd Array;
+	typedef Eigen::Array<bool, Eigen::Dynamic, 1> Mask;
+
+	// Vectors for a batch of targets, with one array per coordinate
+	struct Vectors {
+		Array x, y, z;
+	};
+
+	Vectors getColumn(const ClosedFormIK::TransformArray& t, int col) {
+		Vectors v;
+		v.x = t.col(col);
+		v.y = t.col(3+col);
+		v.z = t.col(6+col);
+		return v;
+	}
+
+	// v = R*v
+	void rotate(const Rotation3D<>& R, Vectors& v) {
+		const Array x = v.x;
+		const Array y = v.y;
+		v.x = R(0,0)*x + R(0,1)*y + R(0,2)*v.z;
+		v.y = R(1,0)*x + R(1,1)*y + R(1,2)*v.z;
+		v.z = R(2,0)*x + R(2,1)*y + R(2,2)*v.z;
+	}
+
+	// v = T*v
+	void transform(const Transform3D<>& T, Vectors& v) {
+		rotate(T.R(), v);
+		v.x += T.P()[0];
+		v.y += T.P()[1];
+		v.z += T.P()[2];
+	}
+
+	// v = Rz(-q)*v, where c and s are the cosine and sine of q
+	void rotateInverseZ(const Array& c, const Array& s, Vectors& v) {
+		const Array x = v.x;
+		v.x = c*x + s*v.y;
+		v.y = c*v.y - s*x;
+	}
+
+	// Eigen has no element-wise atan2 for arrays
+	Array atan2(const Array& y, const Array& x) {
+		Array res(y.size());
+		for (Eigen::Index i = 0; i < y.size(); i++)
+			res[i] = std::atan2(y[i], x[i]);
+		return res;
+	}
+
+	// The other angle with the same axis (see findBaseAngles)
+	Array opposite(const Array& angle) {
+		return (angle > 0.).select(angle - Pi, angle + Pi);
+	}
+}
+
 ClosedFormIKSolverKukaIIWA::ClosedFormIKSolverKukaIIWA(const rw::common::Ptr<const rw::models::SerialDevice> device, const State& state):
 	_device(device),
 	_checkJointLimits(true),
@@ -61,6 +120,19 @@ ClosedFormIKSolverKukaIIWA::ClosedFormIKSolverKukaIIWA(const rw::common::Ptr<con
 	_fkRange4_0 = FKRange(_frames[4], _frames[0], state);
 	_fkRange5_0 = FKRange(_frames[5], _frames[0], state);
 	_fkRange6_0 = FKRange(_frames[6], _frames[0], state);
+
+	// The batch solver evaluates each joint as its fixed transform followed by a rotation around z.
+	bool plainJoints = true;
+	for(const Joint* const joint : _device->getJoints()) {
+		if (typeid(*joint) != typeid(RevoluteJoint) || static_cast<const RevoluteJoint*>(joint)->hasJointMapping())
+			plainJoints = false;
+	}
+	if (plainJoints) {
+		State zeroState = state;
+		_device->setQ(Q::zero(7), zeroState);
+		for (std::size_t i = 0; i < 7; i++)
+			_jointTransforms.push_back(Kinematics::frameTframe(_frames[i], _frames[i+1], zeroState));
+	}
 }
 
 ClosedFormIKSolverKukaIIWA::~ClosedFormIKSolverKukaIIWA() {
@@ -109,6 +181,179 @@ std::vector<Q> ClosedFormIKSolverKukaIIWA::solve(const Transform3D<>& baseTend,
 	return results;
 }
 
+void ClosedFormIKSolverKukaIIWA::solveBatch(const TransformArray& baseTend, const State& state, Eigen::ArrayXXd& solutions, BranchArray& valid) const {
+	Eigen::ArrayXd angles(baseTend.rows());
+	for (Eigen::Index i = 0; i < baseTend.rows(); i++)
+		angles[i] = Random::ran(0,2*Pi);
+	solveBatchAngles(baseTend, state, angles, solutions, valid);
+}
+
+void ClosedFormIKSolverKukaIIWA::solveBatch(const TransformArray& baseTend, const State& state, double angle, Eigen::ArrayXXd& solutions, BranchArray& valid) const {
+	solveBatchAngles(baseTend, state, Eigen::ArrayXd::Constant(baseTend.rows(), angle), solutions, valid);
+}
+
+void ClosedFormIKSolverKukaIIWA::solveBatchAngles(const TransformArray& baseTend, const State& state, const Eigen::ArrayXd& angles, Eigen::ArrayXXd& solutions, BranchArray& valid) const {
+	Eigen::Array<double, Eigen::Dynamic, 3> dir4(baseTend.rows(), 3);
+	for (Eigen::Index i = 0; i < baseTend.rows(); i++) {
+		const Vector3D<> tcpZ(baseTend(i,2), baseTend(i,5), baseTend(i,8));
+		const Vector3D<> baseP6 = Vector3D<>(baseTend(i,9), baseTend(i,10), baseTend(i,11))-tcpZ*_lTcp;
+		const Vector3D<> dir = perpendicularVector(normalize(baseP6-_baseP2), angles[i]);
+		dir4.row(i) << dir[0], dir[1], dir[2];
+	}
+	solveBatch(baseTend, state, dir4, solutions, valid);
+}
+
+void ClosedFormIKSolverKukaIIWA::solveBatch(const TransformArray& baseTend, const State& state, const Eigen::Array<double, Eigen::Dynamic, 3>& dir4, Eigen::ArrayXXd& solutions, BranchArray& valid) const {
+	if (_jointTransforms.empty())
+		RW_THROW("ClosedFormIKSolverKukaIIWA: solveBatch requires revolute joints without joint mapping.");
+	if (dir4.rows() != baseTend.rows())
+		RW_THROW("ClosedFormIKSolverKukaIIWA: " << dir4.rows() << " directions given for " << baseTend.rows() << " targets.");
+
+	const Eigen::Index n = baseTend.rows();
+	solutions.resize(n, 8*7);
+	valid.resize(n, 8);
+
+	std::vector<Transform3D<> > jointTransformsInv(6);
+	std::vector<Rotation3D<> > jointRotationsInv(6);
+	for (std::size_t i = 0; i < 6; i++) {
+		jointTransformsInv[i] = inverse(_jointTransforms[i]);
+		jointRotationsInv[i] = inverse(_jointTransforms[i].R());
+	}
+
+	// Position of the last joint, and the circle where joint 4 must be (see solve)
+	const Vectors tcpX = getColumn(baseTend, 0);
+	const Vectors tcpZ = getColumn(baseTend, 2);
+	Vectors baseP6;
+	baseP6.x = baseTend.col(9) - tcpZ.x*_lTcp;
+	baseP6.y = baseTend.col(10) - tcpZ.y*_lTcp;
+	baseP6.z = baseTend.col(11) - tcpZ.z*_lTcp;
+	Vectors diff6;
+	diff6.x = baseP6.x - _baseP2[0];
+	diff6.y = baseP6.y - _baseP2[1];
+	diff6.z = baseP6.z - _baseP2[2];
+	const Array dist = (diff6.x.square() + diff6.y.square() + diff6.z.square()).sqrt();
+	const Mask reachable = dist <= _lJ2J4*2;
+	const Array radius4 = (4*dist.square()*_lJ2J4*_lJ2J4 - dist.square().square()).sqrt()/(2*dist);
+
+	// targetP4 relative to joint 2
+	const Array dir4n = (dir4.col(0)*diff6.x + dir4.col(1)*diff6.y + dir4.col(2)*diff6.z)/dist.square();
+	Vectors dir;
+	dir.x = dir4.col(0) - dir4n*diff6.x;
+	dir.y = dir4.col(1) - dir4n*diff6.y;
+	dir.z = dir4.col(2) - dir4n*diff6.z;
+	const Array scale = radius4/(dir.x.square() + dir.y.square() + dir.z.square()).sqrt();
+	Vectors diff4;
+	diff4.x = diff6.x/2 + dir.x*scale;
+	diff4.y = diff6.y/2 + dir.y*scale;
+	diff4.z = diff6.z/2 + dir.z*scale;
+
+	// The two base angles (see findBaseAngles)
+	const double qcurrent = _device->getQ(state)(0);
+	const Array targetP4x = diff4.x + _baseP2[0];
+	const Array targetP4y = diff4.y + _baseP2[1];
+	Array baseAngles[2];
+	baseAngles[0] = (targetP4x != 0. || targetP4y != 0.).select(atan2(targetP4y, targetP4x), qcurrent);
+	baseAngles[1] = opposite(baseAngles[0]);
+
+	for (int k = 0; k < 2; k++) {
+		const Array& q0 = baseAngles[k];
+		Mask ok0 = reachable;
+		if (_checkJointLimits)
+			ok0 = ok0 && q0 >= _qLow[0] && q0 <= _qHigh[0];
+		const Array c0 = q0.cos();
+		const Array s0 = q0.sin();
+
+		const Array q1 = atan2(c0*diff4.x + s0*diff4.y, diff4.z);
+		if (_checkJointLimits)
+			ok0 = ok0 && q1 >= _qLow[1] && q1 <= _qHigh[1];
+		const Array c1 = q1.cos();
+		const Array s1 = q1.sin();
+
+		// The last joint and the target directions relative to joint 2 with q2=0
+		Vectors j2p6 = baseP6;
+		Vectors z = tcpZ;
+		Vectors x = tcpX;
+		transform(jointTransformsInv[0], j2p6);
+		rotateInverseZ(c0, s0, j2p6);
+		transform(jointTransformsInv[1], j2p6);
+		rotateInverseZ(c1, s1, j2p6);
+		rotate(jointRotationsInv[0], z);
+		rotateInverseZ(c0, s0, z);
+		rotate(jointRotationsInv[1], z);
+		rotateInverseZ(c1, s1, z);
+		rotate(jointRotationsInv[0], x);
+		rotateInverseZ(c0, s0, x);
+		rotate(jointRotationsInv[1], x);
+		rotateInverseZ(c1, s1, x);
+
+		Array theta3[2];
+		theta3[0] = atan2(j2p6.z, j2p6.x);
+		theta3[1] = opposite(theta3[0]);
+		for (int m = 0; m < 2; m++) {
+			const Array& q2 = theta3[m];
+			Mask ok2 = ok0;
+			if (_checkJointLimits)
+				ok2 = ok2 && q2 >= _qLow[2] && q2 <= _qHigh[2];
+			const Array c2 = q2.cos();
+			const Array s2 = q2.sin();
+
+			Vectors j3p6 = j2p6;
+			transform(jointTransformsInv[2], j3p6);
+			rotateInverseZ(c2, s2, j3p6);
+			const Array q3 = -atan2(j3p6.x, j3p6.z-_lJ3J4);
+			if (_checkJointLimits)
+				ok2 = ok2 && q3 >= _qLow[3] && q3 <= _qHigh[3];
+			const Array c3 = q3.cos();
+			const Array s3 = q3.sin();
+
+			Vectors j4z6 = z;
+			Vectors j4x6 = x;
+			rotate(jointRotationsInv[2], j4z6);
+			rotateInverseZ(c2, s2, j4z6);
+			rotate(jointRotationsInv[3], j4z6);
+			rotateInverseZ(c3, s3, j4z6);
+			rotate(jointRotationsInv[2], j4x6);
+			rotateInverseZ(c2, s2, j4x6);
+			rotate(jointRotationsInv[3], j4x6);
+			rotateInverseZ(c3, s3, j4x6);
+
+			Array theta5[2];
+			theta5[0] = atan2(-j4z6.z, j4z6.x);
+			theta5[1] = opposite(theta5[0]);
+			for (int r = 0; r < 2; r++) {
+				const int branch = 4*k + 2*m + r;
+				const Array& q4 = theta5[r];
+				Mask ok = ok2;
+				if (_checkJointLimits)
+					ok = ok && q4 >= _qLow[4] && q4 <= _qHigh[4];
+				const Array c4 = q4.cos();
+				const Array s4 = q4.sin();
+
+				Vectors j5z6 = j4z6;
+				rotate(jointRotationsInv[4], j5z6);
+				rotateInverseZ(c4, s4, j5z6);
+				const Array q5 = atan2(j5z6.x, j5z6.z);
+				if (_checkJointLimits)
+					ok = ok && q5 >= _qLow[5] && q5 <= _qHigh[5];
+
+				Vectors j6x6 = j4x6;
+				rotate(jointRotationsInv[4], j6x6);
+				rotateInverseZ(c4, s4, j6x6);
+				rotate(jointRotationsInv[5], j6x6);
+				rotateInverseZ(q5.cos(), q5.sin(), j6x6);
+				const Array q6 = atan2(j6x6.z, j6x6.x);
+				if (_checkJointLimits)
+					ok = ok && q6 >= _qLow[6] && q6 <= _qHigh[6];
+
+				const Array* const qs[7] = { &q0, &q1, &q2, &q3, &q4, &q5, &q6 };
+				for (int j = 0; j < 7; j++)
+					solutions.col(7*branch + j) = *qs[j];
+				valid.col(branch) = ok;
+			}
+		}
+	}
+}
+
 void ClosedFormIKSolverKukaIIWA::setCheckJointLimits(bool check) {
 	_checkJointLimits = check;
 }
@@ -221,6 +466,10 @@ void ClosedFormIKSolverKukaIIWA::addRotationSolutions(const Rotation3D<>& baseRe
 }
 
 Vector3D<> ClosedFormIKSolverKukaIIWA::randomPerpendicularVector(const Vector3D<>& v) {
+	return perpendicularVector(v,Random::ran(0,2*Pi));
+}
+
+Vector3D<> ClosedFormIKSolverKukaIIWA::perpendicularVector(const Vector3D<>& v, double angle) {
 	Vector3D<> perp;
 	if (v[0] < v[1]) {
 		if (v[0] < v[2])
@@ -233,7 +482,7 @@ Vector3D<> ClosedFormIKSolverKukaIIWA::randomPerpendicularVector(const Vector3D<
 		else
 			perp = normalize(cross(v,Vector3D<>::z()));
 	}
-	return EAA<>(v,Random::ran(0,2*Pi)).toRotation3D()*perp;
+	return EAA<>(v,angle).toRotation3D()*perp;
 }
 
 rw::kinematics::Frame::CPtr ClosedFormIKSolverKukaIIWA::getTCP() const {
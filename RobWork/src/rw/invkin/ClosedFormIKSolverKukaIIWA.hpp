@@ -69,6 +69,67 @@ public:
      */
     std::vector<rw::math::Q> solve(const rw::math::Transform3D<>& baseTend, const rw::kinematics::State& state, const rw::math::Vector3D<>& dir4) const;
 
+    /**
+     * @brief Solve the inverse kinematics for a batch of target poses.
+     *
+     * For each target, joint 4 is placed randomly on its circle as in solve().
+     * The directions are drawn with rw::math::Random, so concurrent calls
+     * are not thread safe. Use one of the overloads with explicit directions
+     * or angles for that.
+     * See solveBatch(const TransformArray&, const rw::kinematics::State&, const Eigen::Array<double, Eigen::Dynamic, 3>&, Eigen::ArrayXXd&, BranchArray&) const
+     * for the layout of the results.
+     * @param baseTend [in] the desired base to end transforms, one per row.
+     * @param state [in] the state used for the base angle if joint 4 is on the axis of the base joint.
+     * @param solutions [out] the solutions (\f$n \times 56\f$).
+     * @param valid [out] the validity of each branch (\f$n \times 8\f$).
+     */
+    virtual void solveBatch(const TransformArray& baseTend, const rw::kinematics::State& state,
+                            Eigen::ArrayXXd& solutions, BranchArray& valid) const;
+
+    /**
+     * @brief Solve the inverse kinematics for a batch of target poses by pulling joint 4 in the given directions.
+     *
+     * All targets are solved at once with array expressions, such that each
+     * step of the solver (including the trigonometric functions) runs over
+     * contiguous arrays with one element per target. No State is used.
+     *
+     * The solutions are stored in the 8 branches of the solver, which are
+     * ordered as the solutions returned by solve(). Branch \f$b\f$ of target
+     * \f$i\f$ is stored in row \f$i\f$ and columns \f$7b,\ldots,7b+6\f$ of
+     * \b solutions. A branch is only a solution if it is flagged as valid,
+     * and the valid branches of a target give the same solutions as solve()
+     * with the same direction.
+     *
+     * @param baseTend [in] the desired base to end transforms, one per row.
+     * @param state [in] the state used for the base angle if joint 4 is on the axis of the base joint.
+     * @param dir4 [in] unit vectors giving the direction to pull joint 4 in (given in base coordinate system), one per row.
+     * @param solutions [out] the solutions (resized to \f$n \times 56\f$ if it does not have this size already).
+     * @param valid [out] the validity of each branch (resized to \f$n \times 8\f$ if it does not have this size already).
+     * @throws rw::common::Exception if the joints of the device are not plain revolute joints (see JointDeviceBatchFK).
+     */
+    void solveBatch(const TransformArray& baseTend, const rw::kinematics::State& state,
+                    const Eigen::Array<double, Eigen::Dynamic, 3>& dir4,
+                    Eigen::ArrayXXd& solutions, BranchArray& valid) const;
+
+    /**
+     * @brief Solve the inverse kinematics for a batch of target poses with
+     * joint 4 at the same angle on its circle for all targets.
+     *
+     * The angle is measured around the axis from joint 2 to joint 6, from a
+     * fixed direction perpendicular to the axis. Solving with a number of
+     * different angles samples the redundancy of the device
+     * deterministically. The results are stored as for
+     * solveBatch(const TransformArray&, const rw::kinematics::State&, const Eigen::Array<double, Eigen::Dynamic, 3>&, Eigen::ArrayXXd&, BranchArray&) const
+     *
+     * @param baseTend [in] the desired base to end transforms, one per row.
+     * @param state [in] the state used for the base angle if joint 4 is on the axis of the base joint.
+     * @param angle [in] the angle of joint 4 on its circle.
+     * @param solutions [out] the solutions (\f$n \times 56\f$).
+     * @param valid [out] the validity of each branch (\f$n \times 8\f$).
+     */
+    void solveBatch(const TransformArray& baseTend, const rw::kinematics::State& state, double angle,
+                    Eigen::ArrayXXd& solutions, BranchArray& valid) const;
+
 	//! @copydoc InvKinSolver::setCheckJointLimits
     void setCheckJointLimits(bool check);
 
@@ -85,6 +146,9 @@ private:
 	void addRotationSolutions(const rw::math::Rotation3D<>& baseRend, rw::kinematics::State& state, double angle1, double angle2, double angle3, double angle4, double angle5, std::vector<rw::math::Q>& res) const;
 
 	static rw::math::Vector3D<> randomPerpendicularVector(const rw::math::Vector3D<>& v);
+	static rw::math::Vector3D<> perpendicularVector(const rw::math::Vector3D<>& v, double angle);
+	void solveBatchAngles(const TransformArray& baseTend, const rw::kinematics::State& state, const Eigen::ArrayXd& angles,
+	                      Eigen::ArrayXXd& solutions, BranchArray& valid) const;
 
 private:
     const rw::common::Ptr<const rw::models::SerialDevice> _device;
@@ -103,6 +167,10 @@ private:
 	rw::kinematics::FKRange _fkRange4_0;
 	rw::kinematics::FKRange _fkRange5_0;
 	rw::kinematics::FKRange _fkRange6_0;
+
+	// fixed transforms of the joints used by solveBatch (empty if the joints
+	// can not be evaluated without a State)
+	std::vector<rw::math::Transform3D<> > _jointTransforms;
 };
 //! @}
 } /* namespace invkin */
@@ -20,6 +20,9 @@
 #include <rw/models/Models.hpp>
 #include <rw/models/SerialDevice.hpp>
 #include <rw/models/Joint.hpp>
+#include <rw/models/RevoluteJoint.hpp>
+
+#include <typeinfo>
 
 using namespace rw::common;
 using namespace rw::math;
@@ -27,6 +30,69 @@ using namespace rw::models;
 using namespace rw::kinematics;
 using namespace rw::invkin;
 
+namespace {
+	typedef Eigen::ArrayXd Array;
+	typedef Eigen::Array<bool, Eigen::Dynamic, 1> Mask;
+
+	// Vectors for a batch of targets, with one array per coordinate
+	struct Vectors {
+		Array x, y, z;
+	};
+
+	Vectors getColumn(const ClosedFormIK::TransformArray& t, int col) {
+		Vectors v;
+		v.x = t.col(col);
+		v.y = t.col(3+col);
+		v.z = t.col(6+col);
+		return v;
+	}
+
+	Array dot(const Vectors& a, const Vectors& b) {
+		return a.x*b.x + a.y*b.y + a.z*b.z;
+	}
+
+	Vectors normalize(const Vectors& v) {
+		const Array norm = dot(v,v).sqrt();
+		Vectors res;
+		res.x = v.x/norm;
+		res.y = v.y/norm;
+		res.z = v.z/norm;
+		return res;
+	}
+
+	// v = R*v
+	void rotate(const Rotation3D<>& R, Vectors& v) {
+		const Array x = v.x;
+		const Array y = v.y;
+		v.x = R(0,0)*x + R(0,1)*y + R(0,2)*v.z;
+		v.y = R(1,0)*x + R(1,1)*y + R(1,2)*v.z;
+		v.z = R(2,0)*x + R(2,1)*y + R(2,2)*v.z;
+	}
+
+	// v = T*v
+	void transform(const Transform3D<>& T, Vectors& v) {
+		rotate(T.R(), v);
+		v.x += T.P()[0];
+		v.y += T.P()[1];
+		v.z += T.P()[2];
+	}
+
+	// v = Rz(-q)*v, where c and s are the cosine and sine of q
+	void rotateInverseZ(const Array& c, const Array& s, Vectors& v) {
+		const Array x = v.x;
+		v.x = c*x + s*v.y;
+		v.y = c*v.y - s*x;
+	}
+
+	// Eigen has no element-wise atan2 for arrays
+	Array atan2(const Array& y, const Array& x) {
+		Array res(y.size());
+		for (Eigen::Index i = 0; i < y.size(); i++)
+			res[i] = std::atan2(y[i], x[i]);
+		return res;
+	}
+}
+
 ClosedFormIKSolverUR::ClosedFormIKSolverUR(const rw::common::Ptr<const SerialDevice> device, const State& state):
 	_device(device),
 	_checkJointLimits(true)
@@ -95,6 +161,16 @@ ClosedFormIKSolverUR::ClosedFormIKSolverUR(const rw::common::Ptr<const SerialDev
 	_qMin = _device->getBounds().first;
 	_qMax = _device->getBounds().second;
 
+	// The batch solver evaluates each joint as its fixed transform followed by a rotation around z.
+	bool plainJoints = true;
+	for(const Joint* const joint : _device->getJoints()) {
+		if (typeid(*joint) != typeid(RevoluteJoint) || static_cast<const RevoluteJoint*>(joint)->hasJointMapping())
+			plainJoints = false;
+	}
+	if (plainJoints) {
+		for (std::size_t i = 0; i < 6; i++)
+			_jointTransforms.push_back(Kinematics::frameTframe(_frames[i], _frames[i+1], tmpState));
+	}
 }
 
 ClosedFormIKSolverUR::~ClosedFormIKSolverUR() {
@@ -121,6 +197,186 @@ std::vector<Q> ClosedFormIKSolverUR::solve(const Transform3D<>& baseTend, const
 	return res;
 }
 
+void ClosedFormIKSolverUR::solveBatch(const TransformArray& baseTend, const State& state, Eigen::ArrayXXd& solutions, BranchArray& valid) const {
+	if (_jointTransforms.empty())
+		RW_THROW("ClosedFormIKSolverUR: solveBatch requires revolute joints without joint mapping.");
+
+	const Eigen::Index n = baseTend.rows();
+	solutions.resize(n, 8*6);
+	valid.resize(n, 8);
+
+	std::vector<Transform3D<> > jointTransformsInv(6);
+	std::vector<Rotation3D<> > jointRotationsInv(6);
+	for (std::size_t i = 0; i < 6; i++) {
+		jointTransformsInv[i] = inverse(_jointTransforms[i]);
+		jointRotationsInv[i] = inverse(_jointTransforms[i].R());
+	}
+
+	// Position of the last joint (see solve)
+	const Vectors tcpX = getColumn(baseTend, 0);
+	const Vectors tcpZ = getColumn(baseTend, 2);
+	Vectors baseTdh5;
+	baseTdh5.x = baseTend.col(9) - tcpZ.x*_lTcp;
+	baseTdh5.y = baseTend.col(10) - tcpZ.y*_lTcp;
+	baseTdh5.z = baseTend.col(11) - tcpZ.z*_lTcp;
+
+	// The two base angles (see findBaseAngle)
+	const Array arg = baseTdh5.x.square() + baseTdh5.y.square() - _baseRadiusSqr;
+	const Array D = arg.max(0.).sqrt();
+	const double qcurrent = _device->getQ(state)(0);
+	Array baseAngles[2];
+	baseAngles[0] = atan2(-D*baseTdh5.x+_baseRadius*baseTdh5.y, D*baseTdh5.y+_baseRadius*baseTdh5.x) + Pi/2;
+	baseAngles[1] = atan2(D*baseTdh5.x+_baseRadius*baseTdh5.y, -D*baseTdh5.y+_baseRadius*baseTdh5.x) + Pi/2;
+	for (int k = 0; k < 2; k++)
+		baseAngles[k] = (baseAngles[k] > Pi).select(baseAngles[k] - 2*Pi, baseAngles[k]);
+	baseAngles[0] = (arg > 0.).select(baseAngles[0], qcurrent);
+	baseAngles[1] = (arg > 0.).select(baseAngles[1], qcurrent > 0 ? qcurrent-Pi : qcurrent+Pi);
+
+	// The circle of possible joint 4 positions (see getJoint4Positions and getPerpendicularVector)
+	const Array ax = tcpZ.x.abs();
+	const Array ay = tcpZ.y.abs();
+	const Array az = tcpZ.z.abs();
+	const Mask perpX = ax < ay && ax < az;
+	const Mask perpY = ay < az;
+	Vectors perp;
+	perp.x = perpX.select(Array::Zero(n), perpY.select(-tcpZ.z, tcpZ.y));
+	perp.y = perpX.select(tcpZ.z, perpY.select(Array::Zero(n), -tcpZ.x));
+	perp.z = perpX.select(-tcpZ.y, perpY.select(tcpZ.x, Array::Zero(n)));
+	const Vectors xDir = normalize(perp);
+	Vectors cr;
+	cr.x = tcpZ.y*xDir.z - tcpZ.z*xDir.y;
+	cr.y = tcpZ.z*xDir.x - tcpZ.x*xDir.z;
+	cr.z = tcpZ.x*xDir.y - tcpZ.y*xDir.x;
+	const Vectors yDir = normalize(cr);
+
+	const Vector3D<> z1 = _jointTransforms[1].R().getCol(2);
+
+	// The z component of EAA(_zaxisJoint6In5, zdes) if zdes is opposite to _zaxisJoint6In5
+	const Vector3D<>& v1 = _zaxisJoint6In5;
+	int idx = 0;
+	if (std::fabs(v1[0]) > std::fabs(v1[1]))
+		idx = 1;
+	if (std::fabs(v1[idx]) > std::fabs(v1[2]))
+		idx = 2;
+	Vector3D<> v3(0,0,0);
+	v3(idx) = 1;
+	const double opposite = normalize(cross(v1,v3))[2]*Pi;
+
+	for (int k = 0; k < 2; k++) {
+		const Array& q0 = baseAngles[k];
+		const Array c0 = q0.cos();
+		const Array s0 = q0.sin();
+
+		// Normal of the plane that joint 4 lies in
+		Vectors dir;
+		dir.x = c0*z1[0] - s0*z1[1];
+		dir.y = s0*z1[0] + c0*z1[1];
+		dir.z = Array::Constant(n, z1[2]);
+		rotate(_jointTransforms[0].R(), dir);
+		const Array t = atan2(-dot(xDir,dir), dot(yDir,dir));
+		const Array ct = _endCircleRadius*t.cos();
+		const Array st = _endCircleRadius*t.sin();
+
+		// The last joint and the target directions relative to joint 1 with q1=0
+		Vectors dh5 = baseTdh5;
+		Vectors z = tcpZ;
+		Vectors x = tcpX;
+		transform(jointTransformsInv[0], dh5);
+		rotateInverseZ(c0, s0, dh5);
+		transform(jointTransformsInv[1], dh5);
+		rotate(jointRotationsInv[0], z);
+		rotateInverseZ(c0, s0, z);
+		rotate(jointRotationsInv[1], z);
+		rotate(jointRotationsInv[0], x);
+		rotateInverseZ(c0, s0, x);
+		rotate(jointRotationsInv[1], x);
+
+		for (int p = 0; p < 2; p++) {
+			// Elbow angles for each of the two joint 4 positions (see getElbowJoints and findTwoBarAngles)
+			const double sign = p == 0 ? 1 : -1;
+			Vectors j4;
+			j4.x = baseTdh5.x + sign*(xDir.x*ct + yDir.x*st);
+			j4.y = baseTdh5.y + sign*(xDir.y*ct + yDir.y*st);
+			j4.z = baseTdh5.z + sign*(xDir.z*ct + yDir.z*st);
+			transform(jointTransformsInv[0], j4);
+			rotateInverseZ(c0, s0, j4);
+			transform(jointTransformsInv[1], j4);
+			rotate(_rotAlignElbowJoint, j4);
+			const Array r2 = j4.x.square() + j4.y.square();
+			const Array elbow = 2.*((Math::sqr(_l1+_l2)-r2)/(r2-Math::sqr(_l1-_l2))).sqrt().atan();
+
+			for (int e = 0; e < 2; e++) {
+				const int branch = 4*k + 2*p + e;
+				const Array q2 = e == 0 ? elbow : Array(-elbow);
+				const Array l2c = _l2*q2.cos();
+				const Array l2s = _l2*q2.sin();
+				const Array q1 = atan2(j4.y*(_l1+l2c)-j4.x*l2s, j4.x*(_l1+l2c)+j4.y*l2s);
+				const Array c1 = q1.cos();
+				const Array s1 = q1.sin();
+				const Array c2 = q2.cos();
+				const Array s2 = q2.sin();
+
+				// Joint 3 (see getOrientationJoints)
+				Vectors dh4Tcenter = dh5;
+				rotateInverseZ(c1, s1, dh4Tcenter);
+				transform(jointTransformsInv[2], dh4Tcenter);
+				rotateInverseZ(c2, s2, dh4Tcenter);
+				transform(jointTransformsInv[3], dh4Tcenter);
+				rotate(_rotAlignDH4, dh4Tcenter);
+				const Array q3 = atan2(dh4Tcenter.y, dh4Tcenter.x);
+				const Array c3 = q3.cos();
+				const Array s3 = q3.sin();
+
+				// Joint 4 from the z axis of the target in joint 4 with q4=0
+				Vectors zdes = z;
+				Vectors xaxis = x;
+				rotateInverseZ(c1, s1, zdes);
+				rotate(jointRotationsInv[2], zdes);
+				rotateInverseZ(c2, s2, zdes);
+				rotate(jointRotationsInv[3], zdes);
+				rotateInverseZ(c3, s3, zdes);
+				rotate(jointRotationsInv[4], zdes);
+
+				// The z component of EAA(_zaxisJoint6In5, zdes)
+				const Array dval = v1[0]*zdes.x + v1[1]*zdes.y + v1[2]*zdes.z;
+				Vectors axis;
+				axis.x = v1[1]*zdes.z - v1[2]*zdes.y;
+				axis.y = v1[2]*zdes.x - v1[0]*zdes.z;
+				axis.z = v1[0]*zdes.y - v1[1]*zdes.x;
+				Array q4 = axis.z/dot(axis,axis).sqrt()*dval.acos();
+				q4 = ((dval+1.).abs() < 1e-15).select(opposite, q4);
+				q4 = ((dval-1.).abs() < 1e-15).select(0., q4);
+
+				// Joint 5 from the x axis of the target in joint 5 with q5=0
+				rotateInverseZ(c1, s1, xaxis);
+				rotate(jointRotationsInv[2], xaxis);
+				rotateInverseZ(c2, s2, xaxis);
+				rotate(jointRotationsInv[3], xaxis);
+				rotateInverseZ(c3, s3, xaxis);
+				rotate(jointRotationsInv[4], xaxis);
+				rotateInverseZ(q4.cos(), q4.sin(), xaxis);
+				rotate(jointRotationsInv[5], xaxis);
+				const Array q5 = atan2(xaxis.y, xaxis.x);
+
+				// Adjust the joints to the joint limits (see adjustJoints) and check the limits
+				Mask ok = q1 == q1 && q2 == q2; // not NaN
+				const Array* const qs[6] = { &q0, &q1, &q2, &q3, &q4, &q5 };
+				for (int j = 0; j < 6; j++) {
+					Array q = *qs[j];
+					for (Mask below = q < _qMin[j]; below.any(); below = q < _qMin[j])
+						q = below.select(q + 2.*Pi, q);
+					for (Mask above = q > _qMax[j]; above.any(); above = q > _qMax[j])
+						q = above.select(q - 2.*Pi, q);
+					if (_checkJointLimits)
+						ok = ok && q > _qMin[j] && q < _qMax[j];
+					solutions.col(6*branch + j) = q;
+				}
+				valid.col(branch) = ok;
+			}
+		}
+	}
+}
+
 Q ClosedFormIKSolverUR::adjustJoints(const Q& q) const {
 	Q qRes;
 	qRes = q;
@@ -51,6 +51,32 @@ public:
 	//! @copydoc InvKinSolver::solve
     std::vector<rw::math::Q> solve(const rw::math::Transform3D<>& baseTend, const rw::kinematics::State& state) const;
 
+	/**
+	 * @brief Solve the inverse kinematics for a batch of target poses.
+	 *
+	 * All targets are solved at once with array expressions, such that each
+	 * step of the solver (including the trigonometric functions) runs over
+	 * contiguous arrays with one element per target. No State is used.
+	 *
+	 * The solutions are stored in the 8 branches of the solver, which are
+	 * ordered as the solutions returned by solve(). Branch \f$b\f$ of target
+	 * \f$i\f$ is stored in row \f$i\f$ and columns \f$6b,\ldots,6b+5\f$ of
+	 * \b solutions. A branch is only a solution if it is flagged as valid,
+	 * and the valid branches of a target give the same solutions as solve().
+	 *
+	 * @param baseTend [in] the desired base to end transforms, one per row.
+	 * @param state [in] the state used for the base angle if the target is
+	 * on the axis of the base joint.
+	 * @param solutions [out] the solutions (resized to \f$n \times 48\f$ if
+	 * it does not have this size already).
+	 * @param valid [out] the validity of each branch (resized to
+	 * \f$n \times 8\f$ if it does not have this size already).
+	 * @throws rw::common::Exception if the joints of the device are not
+	 * plain revolute joints (see JointDeviceBatchFK).
+	 */
+	virtual void solveBatch(const TransformArray& baseTend, const rw::kinematics::State& state,
+	                        Eigen::ArrayXXd& solutions, BranchArray& valid) const;
+
 	//! @copydoc InvKinSolver::setCheckJointLimits
     void setCheckJointLimits(bool check);
 
@@ -95,6 +121,10 @@ private:
 	rw::math::Vector3D<> _zaxisJoint6In5;
 
 	rw::math::Q _qMin, _qMax;
+
+	// fixed transforms of the joints used by solveBatch (empty if the joints
+	// can not be evaluated without a State)
+	std::vector<rw::math::Transform3D<> > _jointTransforms;
 };
 
 } } //End namespaces
@@ -18,43 +18,107 @@
 
 #include "IKMetaSolver.hpp"
 
+#include <rw/common/FunctionTask.hpp>
+#include <rw/common/ThreadPool.hpp>
 #include <rw/math/Math.hpp>
 #include <rw/math/MetricUtil.hpp>
 #include <rw/pathplanning/QConstraint.hpp>
 #include <rw/proximity/CollisionDetector.hpp>
 
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+
 using namespace rw::invkin;
 
+using namespace rw::common;
 using namespace rw::math;
 using namespace rw::proximity;
 using namespace rw::models;
 using namespace rw::kinematics;
 using namespace rw::pathplanning;
 
+struct IKMetaSolver::Query {
+    Query(const Transform3D<>& baseTend,
+          const State& state,
+          size_t cnt,
+          bool stopAtFirst,
+          const SolutionCallback& callback):
+        baseTend(baseTend),
+        state(state),
+        cnt(cnt),
+        stopAtFirst(stopAtFirst),
+        callback(callback),
+        next(0),
+        stopped(false)
+    {}
+
+    const Transform3D<>& baseTend;
+    const State& state;
+    const size_t cnt;
+    const bool stopAtFirst;
+    const SolutionCallback& callback;
+
+    // protects the members below
+    boost::mutex mutex;
+    size_t next;
+    bool stopped;
+    std::vector<Q> result;
+};
 
 IKMetaSolver::IKMetaSolver(IterativeIK::Ptr iksolver,
 						   const Device::Ptr device,
 						   CollisionDetector::Ptr collisionDetector) :
-    _iksolver(iksolver),
-    _collisionDetector(collisionDetector),
-    _constraint(NULL),    
+    _iksolvers(1, iksolver),
     _device(device)
 {
+    if (collisionDetector != NULL)
+        _collisionDetectors.push_back(collisionDetector);
     initialize();
 }
 
 IKMetaSolver::IKMetaSolver(IterativeIK::Ptr iksolver,
 						   const rw::models::Device::Ptr device,
 						   rw::pathplanning::QConstraint::Ptr constraint):
-   _iksolver(iksolver),
-   _collisionDetector(NULL),
-   _constraint(constraint),
+   _iksolvers(1, iksolver),
    _device(device)
 {
+    if (constraint != NULL)
+        _constraints.push_back(constraint);
     initialize();
 }
 
+IKMetaSolver::IKMetaSolver(const std::vector<IterativeIK::Ptr>& iksolvers,
+						   const Device::Ptr device,
+						   const std::vector<CollisionDetector::Ptr>& collisionDetectors,
+						   ThreadPool::Ptr pool):
+    _iksolvers(iksolvers),
+    _collisionDetectors(collisionDetectors),
+    _device(device),
+    _pool(pool)
+{
+    if (iksolvers.empty())
+        RW_THROW("IKMetaSolver needs at least one iterative solver.");
+    if (!collisionDetectors.empty() && collisionDetectors.size() != iksolvers.size())
+        RW_THROW("IKMetaSolver needs a collision detector for each of the " << iksolvers.size() << " solvers, but " << collisionDetectors.size() << " were given.");
+    initialize();
+}
 
+IKMetaSolver::IKMetaSolver(const std::vector<IterativeIK::Ptr>& iksolvers,
+						   const Device::Ptr device,
+						   const std::vector<QConstraint::Ptr>& constraints,
+						   ThreadPool::Ptr pool):
+    _iksolvers(iksolvers),
+    _constraints(constraints),
+    _device(device),
+    _pool(pool)
+{
+    if (iksolvers.empty())
+        RW_THROW("IKMetaSolver needs at least one iterative solver.");
+    if (!constraints.empty() && constraints.size() != iksolvers.size())
+        RW_THROW("IKMetaSolver needs a constraint for each of the " << iksolvers.size() << " solvers, but " << constraints.size() << " were given.");
+    initialize();
+}
 
 void IKMetaSolver::initialize() {
 	_checkForLimits = true;
@@ -107,33 +171,78 @@ std::vector<Q> IKMetaSolver::solve(const Transform3D<>& baseTend,
                                    size_t cnt,
                                    bool stopatfirst) const
 {
-    if (_constraint == NULL && _collisionDetector != NULL) {
-        _constraint = QConstraint::make(_collisionDetector, _device, stateDefault);
+    return solve(baseTend, stateDefault, cnt, stopatfirst, SolutionCallback());
+}
+
+std::vector<Q> IKMetaSolver::solve(const Transform3D<>& baseTend,
+                                   const State& stateDefault,
+                                   size_t cnt,
+                                   bool stopatfirst,
+                                   const SolutionCallback& callback) const
+{
+    if (_constraints.empty()) {
+        BOOST_FOREACH(const CollisionDetector::Ptr& detector, _collisionDetectors) {
+            _constraints.push_back(QConstraint::make(detector, _device, stateDefault));
+        }
     }
-    State state(stateDefault);
-    std::vector<Q> result;
-    while (cnt-- > 0) {
-        std::vector<Q> solutions = _iksolver->solve(baseTend, state);
-        _device->setQ(getRandomConfig(), state);        
-        for (std::vector<Q>::iterator it = solutions.begin(); it != solutions.end(); ++it)
-        {
-            if (!_checkForLimits || betweenLimits(*it)) {
-                if (_constraint != NULL) {
-                    if (_constraint->inCollision(*it)) {
-                        continue;
-                    }
-                }
-                addSolution(*it, result);
-                //result.push_back(*it);
-                if (stopatfirst) {
-                    return result;
-                }
-            } 
 
+    Query query(baseTend, stateDefault, cnt, stopatfirst, callback);
+    const std::size_t workers = _iksolvers.size();
+    if (workers == 1 || _pool == NULL || _pool->getNumberOfThreads() == 0) {
+        runWorker(query, 0);
+        return query.result;
+    }
 
+    std::vector<boost::function<void()> > work;
+    for (std::size_t w = 0; w < workers; w++)
+        work.push_back(boost::bind(&IKMetaSolver::runWorker, this, boost::ref(query), w));
+    FunctionTask::runAll(_pool, work);
+    return query.result;
+}
+
+/*
+ * Take the next attempt. The first attempt starts from the configuration of
+ * the given state and the following from random configurations.
+ */
+bool IKMetaSolver::nextAttempt(Query& query, Q& start) const
+{
+    boost::mutex::scoped_lock lock(query.mutex);
+    if (query.stopped || query.next >= query.cnt)
+        return false;
+    start = query.next == 0 ? _device->getQ(query.state) : getRandomConfig();
+    query.next++;
+    return true;
+}
+
+void IKMetaSolver::runWorker(Query& query, std::size_t worker) const
+{
+    State state(query.state);
+    IterativeIK& iksolver = *_iksolvers[worker];
+    const QConstraint::Ptr constraint = worker < _constraints.size() ? _constraints[worker] : NULL;
+
+    Q start;
+    while (nextAttempt(query, start)) {
+        _device->setQ(start, state);
+        const std::vector<Q> solutions = iksolver.solve(query.baseTend, state);
+        BOOST_FOREACH(const Q& q, solutions) {
+            if (_checkForLimits && !betweenLimits(q))
+                continue;
+            if (constraint != NULL && constraint->inCollision(q))
+                continue;
+
+            boost::mutex::scoped_lock lock(query.mutex);
+            if (query.stopped)
+                return;
+            const std::size_t size = query.result.size();
+            addSolution(q, query.result);
+            if (query.result.size() > size && !query.callback.empty() && !query.callback(q))
+                query.stopped = true;
+            if (query.stopAtFirst)
+                query.stopped = true;
+            if (query.stopped)
+                return;
         }
     }
-    return result;
 }
 
 std::vector<Q> IKMetaSolver::solve(const Transform3D<>& baseTend,
@@ -161,6 +270,10 @@ void IKMetaSolver::setCheckJointLimits(bool check) {
     _checkForLimits = check;
 }
 
+void IKMetaSolver::setThreadPool(ThreadPool::Ptr pool) {
+    _pool = pool;
+}
+
 rw::kinematics::Frame::CPtr IKMetaSolver::getTCP() const {
-    return _iksolver->getTCP();
+    return _iksolvers.front()->getTCP();
 }
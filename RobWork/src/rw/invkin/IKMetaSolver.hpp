@@ -25,6 +25,11 @@
 #include <rw/math/Q.hpp>
 #include <rw/common/Ptr.hpp>
 
+#include <boost/function.hpp>
+
+#include <vector>
+
+namespace rw { namespace common { class ThreadPool; } }
 namespace rw { namespace kinematics { class State; } }
 namespace rw { namespace pathplanning { class QConstraint; } }
 namespace rw { namespace proximity { class CollisionDetector; } }
@@ -59,6 +64,10 @@ namespace rw { namespace invkin {
      * result = mSolver.solve( pose , state, 200, true );
      * \endcode
      *
+     * The attempts can be run in parallel on a ThreadPool. Each worker then
+     * needs its own iterative solver and its own collision detector or
+     * constraint, as these are not safe to use from several threads at once.
+     * Each worker uses its own copy of the state.
      */
 
     class IKMetaSolver: public IterativeIK
@@ -67,6 +76,16 @@ namespace rw { namespace invkin {
 		//! @brief smart pointer type to this class
 		typedef rw::common::Ptr<IKMetaSolver> Ptr;
 
+        /**
+         * @brief Callback for valid solutions as they are found.
+         *
+         * The callback is called once for each distinct solution that
+         * satisfies the joint limits and the collision constraint. Calls are
+         * serialized, but may come from the threads of the pool. Return false
+         * to stop the search.
+         */
+        typedef boost::function<bool(const rw::math::Q&)> SolutionCallback;
+
         /**
          * @brief Constructs IKMetaSolver
          *
@@ -101,6 +120,41 @@ namespace rw { namespace invkin {
 			rw::common::Ptr<rw::pathplanning::QConstraint> constraint);
 
 
+        /**
+         * @brief Constructs IKMetaSolver that runs the attempts in parallel.
+         *
+         * The attempts are distributed on workers that each use one of the
+         * \b iksolvers. The workers run on the threads of \b pool.
+         *
+         * @param iksolvers [in] One solver per worker. The solvers must be
+         * for the same device and must not share state.
+         * @param device [in] Device to solve for
+         * @param collisionDetectors [in] One collision detector per worker,
+         * or an empty vector to skip testing for collisions.
+         * @param pool [in] The pool to run the workers in, or NULL to run the
+         * attempts in the calling thread.
+         */
+		IKMetaSolver(const std::vector<IterativeIK::Ptr>& iksolvers,
+			const rw::common::Ptr<class rw::models::Device> device,
+			const std::vector<rw::common::Ptr<rw::proximity::CollisionDetector> >& collisionDetectors,
+			rw::common::Ptr<rw::common::ThreadPool> pool);
+
+        /**
+         * @brief Constructs IKMetaSolver that runs the attempts in parallel.
+         *
+         * @param iksolvers [in] One solver per worker. The solvers must be
+         * for the same device and must not share state.
+         * @param device [in] Device to solve for
+         * @param constraints [in] One constraint per worker, or an empty
+         * vector if no constraints are applied.
+         * @param pool [in] The pool to run the workers in, or NULL to run the
+         * attempts in the calling thread.
+         */
+		IKMetaSolver(const std::vector<IterativeIK::Ptr>& iksolvers,
+			const rw::common::Ptr<class rw::models::Device> device,
+			const std::vector<rw::common::Ptr<rw::pathplanning::QConstraint> >& constraints,
+			rw::common::Ptr<rw::common::ThreadPool> pool);
+
         /**
          * @brief Descrutor
          */
@@ -165,16 +219,57 @@ namespace rw { namespace invkin {
                                        size_t cnt,
                                        bool stopatfirst) const;
 
+        /**
+         * @brief Solves the inverse kinematics problem and reports each
+         * distinct solution as soon as it is found.
+         *
+         * As solve(const math::Transform3D<>&, const kinematics::State&, size_t, bool) const,
+         * but \b callback is called for every distinct solution that is
+         * added to the result. The search stops when \b stopatfirst is true
+         * and a solution has been found, or when the callback returns false.
+         * Attempts that are running on other workers at that time are
+         * completed, but their solutions are discarded.
+         *
+         * @param baseTend [in] Desired base to end transform
+         * @param state [in] State of the workcell
+         * @param cnt [in] Maximal number of attempts
+         * @param stopatfirst [in] If true the method will return after the
+         * first solution is found.
+         * @param callback [in] Called for each distinct solution.
+         * @return the distinct solutions in the order they were found.
+         */
+        std::vector<rw::math::Q> solve(const math::Transform3D<>& baseTend,
+                                       const kinematics::State& state,
+                                       size_t cnt,
+                                       bool stopatfirst,
+                                       const SolutionCallback& callback) const;
+
+        /**
+         * @brief Set the thread pool that the attempts are run in.
+         *
+         * The attempts are only run in parallel if the IKMetaSolver was
+         * constructed with more than one iterative solver.
+         *
+         * @param pool [in] the pool, or NULL to run the attempts in the
+         * calling thread.
+         */
+        void setThreadPool(rw::common::Ptr<rw::common::ThreadPool> pool);
+
         /**
          * @copydoc InvKinSolver::getTCP
          */
         virtual rw::common::Ptr< const rw::kinematics::Frame > getTCP() const;                      
 
     private:
-		IterativeIK::Ptr _iksolver;
-		rw::common::Ptr<rw::proximity::CollisionDetector> _collisionDetector;
-		mutable rw::common::Ptr<rw::pathplanning::QConstraint> _constraint;
+        // The state of a query shared by the workers.
+        struct Query;
+
+		// one solver, collision detector and constraint per worker
+		std::vector<IterativeIK::Ptr> _iksolvers;
+		std::vector<rw::common::Ptr<rw::proximity::CollisionDetector> > _collisionDetectors;
+		mutable std::vector<rw::common::Ptr<rw::pathplanning::QConstraint> > _constraints;
 		const rw::common::Ptr<class rw::models::Device> _device;
+		rw::common::Ptr<rw::common::ThreadPool> _pool;
 
 
         std::pair<rw::math::Q, rw::math::Q> _bounds;
@@ -193,6 +288,10 @@ namespace rw { namespace invkin {
         void addSolution(const rw::math::Q& q, std::vector<rw::math::Q>& res) const;
 
         rw::math::Q getRandomConfig() const;
+
+        bool nextAttempt(Query& query, rw::math::Q& start) const;
+
+        void runWorker(Query& query, std::size_t worker) const;
     };
 
 	/*@}*/
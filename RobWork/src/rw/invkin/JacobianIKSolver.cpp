@@ -23,11 +23,22 @@
 
 #include <rw/models/Models.hpp>
 #include <rw/models/Device.hpp>
+#include <rw/models/JointDevice.hpp>
+#include <rw/models/PrismaticJoint.hpp>
+#include <rw/models/RevoluteJoint.hpp>
 
 #include <rw/kinematics/Frame.hpp>
+#include <rw/kinematics/Kinematics.hpp>
 
 #include <rw/trajectory/LinearInterpolator.hpp>
 
+#include <boost/foreach.hpp>
+
+#include <Eigen/Cholesky>
+
+#include <map>
+#include <typeinfo>
+
 using namespace boost;
 using namespace boost::numeric;
 using namespace rw::math;
@@ -45,9 +56,11 @@ JacobianIKSolver::JacobianIKSolver(Device::CPtr device, const Frame *foi, const
     _useJointClamping(false),
 	_useInterpolation(false),
     _checkJointLimits(false),
-	_solverType(SVD)
+	_solverType(SVD),
+	_useFixedSize(true)
 {
     setMaxIterations(15);
+    initializeChain(foi, state);
 }
 
 JacobianIKSolver::JacobianIKSolver(Device::CPtr device, const State& state):
@@ -58,9 +71,60 @@ JacobianIKSolver::JacobianIKSolver(Device::CPtr device, const State& state):
     _useJointClamping(false),
 	_useInterpolation(false),
     _checkJointLimits(false),
-    _solverType(SVD)
+    _solverType(SVD),
+    _useFixedSize(true)
 {
     setMaxIterations(15);
+    initializeChain(device->getEnd(), state);
+}
+
+void JacobianIKSolver::initializeChain(const Frame* foi, const State& state)
+{
+    const JointDevice* const device = dynamic_cast<const JointDevice*>(_device.get());
+    if (device == NULL || (device->getDOF() != 6 && device->getDOF() != 7))
+        return;
+
+    // Index of each device joint in the configuration
+    std::map<const Frame*, int> qIndices;
+    int qIndex = 0;
+    BOOST_FOREACH(const Joint* joint, device->getJoints()) {
+        qIndices[joint] = qIndex;
+        qIndex += joint->getDOF();
+    }
+
+    std::vector<ChainLink> chain;
+    const std::vector<Frame*> frames = Kinematics::reverseChildToParentChain(
+        const_cast<Frame*>(foi), const_cast<Frame*>(_device->getBase()), state);
+    BOOST_FOREACH(const Frame* frame, frames) {
+        ChainLink link;
+        link.frame = frame;
+        link.qIndex = -1;
+        link.revolute = false;
+        const std::map<const Frame*, int>::const_iterator it = qIndices.find(frame);
+        if (it != qIndices.end()) {
+            const RevoluteJoint* const revolute = dynamic_cast<const RevoluteJoint*>(frame);
+            const PrismaticJoint* const prismatic = dynamic_cast<const PrismaticJoint*>(frame);
+            if (revolute != NULL && typeid(*frame) == typeid(RevoluteJoint) && !revolute->hasJointMapping()) {
+                link.revolute = true;
+                link.fixed = revolute->getFixedTransform();
+            } else if (prismatic != NULL && typeid(*frame) == typeid(PrismaticJoint) && !prismatic->hasJointMapping()) {
+                link.fixed = prismatic->getFixedTransform();
+            } else {
+                return;
+            }
+            link.qIndex = it->second;
+        } else if (dynamic_cast<const Joint*>(frame) != NULL) {
+            // joints that are not part of the device, such as dependent joints
+            return;
+        }
+        chain.push_back(link);
+    }
+    _chain = chain;
+}
+
+bool JacobianIKSolver::isFixedSize() const
+{
+    return _useFixedSize && (_solverType == DLS || _solverType == SDLS) && !_chain.empty();
 }
 
 std::vector<Q> JacobianIKSolver::solve(const Transform3D<>& bTed,
@@ -102,6 +166,13 @@ bool JacobianIKSolver::solveLocal(const Transform3D<> &bTed,
                               State &state,
                               int maxIter) const
 {
+    if (isFixedSize()) {
+        if (_device->getDOF() == 6)
+            return solveLocalFixed<6>(bTed, maxError, state, maxIter);
+        else
+            return solveLocalFixed<7>(bTed, maxError, state, maxIter);
+    }
+
     Q q = _device->getQ(state);
     const int maxIterations = maxIter;
     Device::QBox bounds = _device->getBounds();
@@ -196,6 +267,117 @@ bool JacobianIKSolver::solveLocal(const Transform3D<> &bTed,
     return false;
 }
 
+template <int DOF>
+bool JacobianIKSolver::solveLocalFixed(const Transform3D<> &bTed,
+                                       double maxError,
+                                       State &state,
+                                       int maxIter) const
+{
+    typedef Eigen::Matrix<double, DOF, 1> VectorQ;
+
+    VectorQ q, lower, upper;
+    {
+        const Q qInit = _device->getQ(state);
+        const Device::QBox bounds = _device->getBounds();
+        for (int i = 0; i < DOF; i++) {
+            q[i] = qInit[i];
+            lower[i] = bounds.first[i];
+            upper[i] = bounds.second[i];
+        }
+    }
+
+    // The transforms of the frames that are not joints of the device are
+    // constant during the search.
+    std::vector<Transform3D<> > transforms(_chain.size());
+    for (std::size_t k = 0; k < _chain.size(); k++) {
+        const ChainLink& link = _chain[k];
+        transforms[k] = link.qIndex < 0 ? link.frame->getTransform(state) : link.fixed;
+    }
+
+    // Workspaces of the iteration
+    Eigen::Matrix<double, 6, DOF> J = Eigen::Matrix<double, 6, DOF>::Zero();
+    Eigen::Matrix<double, 3, DOF> axes, positions;
+    Eigen::Matrix<double, 6, 6> U;
+    Eigen::Matrix<double, 6, 1> dS;
+    VectorQ dTheta;
+    const double lambda = 0.4; // dampening factor, for now a fixed value
+
+    bool found = false;
+    for (int cnt = 0; cnt < maxIter; ++cnt) {
+        // Forward kinematics along the chain, remembering the axis and
+        // position of each joint
+        Transform3D<> bTe = Transform3D<>::identity();
+        for (std::size_t k = 0; k < _chain.size(); k++) {
+            const ChainLink& link = _chain[k];
+            bTe = bTe * transforms[k];
+            if (link.qIndex < 0)
+                continue;
+            const double qk = q[link.qIndex];
+            Rotation3D<>& R = bTe.R();
+            if (link.revolute) {
+                const double c = std::cos(qk);
+                const double s = std::sin(qk);
+                for (int i = 0; i < 3; i++) {
+                    const double x = R(i,0);
+                    R(i,0) = x*c + R(i,1)*s;
+                    R(i,1) = R(i,1)*c - x*s;
+                }
+            } else {
+                bTe.P() += qk * R.getCol(2);
+            }
+            for (int i = 0; i < 3; i++) {
+                axes(i, link.qIndex) = R(i,2);
+                positions(i, link.qIndex) = bTe.P()[i];
+            }
+        }
+
+        const Transform3D<> eTed = inverse(bTe) * bTed;
+        const EAA<> e_eOed(eTed(2,1), eTed(0,2), eTed(1,0));
+        const VelocityScrew6D<> b_eXed = bTe.R() * VelocityScrew6D<>(eTed.P(), e_eOed);
+        if (normInf(b_eXed) <= maxError) {
+            found = true;
+            break;
+        }
+        for (int i = 0; i < 6; i++)
+            dS[i] = b_eXed[i];
+
+        // The Jacobian of the end relative to the base
+        const Eigen::Vector3d end(bTe.P()[0], bTe.P()[1], bTe.P()[2]);
+        BOOST_FOREACH(const ChainLink& link, _chain) {
+            if (link.qIndex < 0)
+                continue;
+            const Eigen::Vector3d z = axes.col(link.qIndex);
+            if (link.revolute) {
+                J.template block<3,1>(0, link.qIndex) = z.cross(end - positions.col(link.qIndex));
+                J.template block<3,1>(3, link.qIndex) = z;
+            } else {
+                J.template block<3,1>(0, link.qIndex) = z;
+                J.template block<3,1>(3, link.qIndex).setZero();
+            }
+        }
+
+        // Damped least squares: dTheta = J^T (J J^T + lambda I)^-1 dS
+        U.noalias() = J * J.transpose();
+        U.diagonal().array() += lambda;
+        dTheta.noalias() = J.transpose() * U.llt().solve(dS);
+
+        // Scale back to not exceed maximum angle changes
+        const double maxChange = dTheta.template lpNorm<Eigen::Infinity>();
+        if (maxChange > 45.0*Deg2Rad)
+            dTheta *= (45.0*Deg2Rad)/maxChange;
+        q += dTheta;
+
+        if (_useJointClamping)
+            q = q.cwiseMax(lower).cwiseMin(upper);
+    }
+
+    Q result(DOF);
+    for (int i = 0; i < DOF; i++)
+        result[i] = q[i];
+    _device->setQ(result, state);
+    return found;
+}
+
 rw::kinematics::Frame::CPtr JacobianIKSolver::getTCP() const {
     return _fkrange.getEnd();
 }
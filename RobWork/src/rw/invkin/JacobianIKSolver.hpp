@@ -26,6 +26,7 @@
 #include <rw/common/Ptr.hpp>
 #include <rw/invkin/IterativeIK.hpp>
 #include <rw/kinematics/FKRange.hpp>
+#include <rw/math/Transform3D.hpp>
 #include <vector>
 
 namespace rw { namespace models {
@@ -79,7 +80,14 @@ namespace rw { namespace invkin {
      * \right]
      * \f$
      *
-     *
+     * For the DLS solver type there is a fast path for devices with 6 or 7
+     * degrees of freedom where all joints between the base and the end
+     * effector are plain revolute or prismatic joints (as for a SerialDevice
+     * loaded from a workcell file). The forward kinematics and the Jacobian
+     * are then calculated directly along the kinematic chain, and the
+     * iteration uses fixed size matrices without any heap allocations.
+     * The transforms of frames on the chain that are not joints are taken
+     * from the state at the start of each local search.
      */
     class JacobianIKSolver : public IterativeIK
     {
@@ -160,6 +168,21 @@ namespace rw { namespace invkin {
          */
         void setSolverType(JacobianSolverType type){ _solverType = type; };
 
+        /**
+         * @brief enables the fixed size DLS iteration for devices with 6 or 7
+         * degrees of freedom, when the device supports it (default is enabled).
+         * @param enableFixedSize [in] true to enable the fixed size iteration,
+         * false to always use the general iteration.
+         */
+        void setEnableFixedSize(bool enableFixedSize){ _useFixedSize = enableFixedSize; };
+
+        /**
+         * @brief check if the fixed size DLS iteration is used.
+         * @return true if the fixed size iteration is enabled, the solver type
+         * is DLS and the device has a supported kinematic chain.
+         */
+        bool isFixedSize() const;
+
 
         //! @copydoc InvKinSolver::setCheckJointLimits
         void setCheckJointLimits(bool check){
@@ -171,6 +194,26 @@ namespace rw { namespace invkin {
          */
         virtual rw::common::Ptr< const rw::kinematics::Frame > getTCP() const;            
 
+    private:
+        // A frame on the chain from the base to the end effector.
+        struct ChainLink {
+            const kinematics::Frame* frame;
+            // index of the joint in the configuration, or -1 if the frame is
+            // not a joint of the device
+            int qIndex;
+            bool revolute;
+            // fixed transform of a joint
+            math::Transform3D<> fixed;
+        };
+
+        void initializeChain(const kinematics::Frame* foi, const kinematics::State& state);
+
+        template <int DOF>
+        bool solveLocalFixed(const math::Transform3D<>& bTed,
+                             double maxError,
+                             kinematics::State& state,
+                             int maxIter) const;
+
     private:
         rw::common::Ptr< const rw::models::Device > _device;
         double _interpolationStep;
@@ -178,6 +221,9 @@ namespace rw { namespace invkin {
         rw::common::Ptr<models::JacobianCalculator> _devJac;
         bool _useJointClamping, _useInterpolation, _checkJointLimits;
         JacobianSolverType _solverType;
+        bool _useFixedSize;
+        // empty if the device is not supported by the fixed size iteration
+        std::vector<ChainLink> _chain;
 
     };
 
@@ -0,0 +1,504 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute, 
+ * Faculty of Engineering, University of Southern Denmark 
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include "ReachabilityMap.hpp"
+#include "ClosedFormIK.hpp"
+#include "ClosedFormIKSolverKukaIIWA.hpp"
+
+#include <rw/common/FunctionTask.hpp>
+#include <rw/common/ThreadPool.hpp>
+#include <rw/math/Math.hpp>
+#include <rw/models/Device.hpp>
+#include <rw/pathplanning/QConstraint.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace rw::invkin;
+using namespace rw::common;
+using namespace rw::kinematics;
+using namespace rw::math;
+using namespace rw::models;
+using namespace rw::pathplanning;
+
+namespace {
+    const char MAGIC[8] = { 'R', 'W', 'R', 'E', 'A', 'C', 'H', 'M' };
+    const boost::uint32_t VERSION = 2;
+
+    struct Header {
+        char magic[8];
+        boost::uint32_t version;
+        boost::uint32_t dof;
+        boost::uint32_t voxelsPerSide;
+        boost::uint32_t directionResolution;
+        boost::uint32_t rollBins;
+        boost::uint32_t elbowAngles;
+        double radius;
+        double resolution;
+        boost::uint64_t cellCount;
+    };
+
+    // Byte offsets of the sections of the file. The sections are ordered such
+    // that every section is aligned to the size of its elements.
+    struct Layout {
+        Layout(std::size_t dof, std::size_t voxels, std::size_t cells) {
+            offsets = sizeof(Header);
+            bins = offsets + (voxels + 1)*sizeof(boost::uint64_t);
+            seeds = bins + cells*sizeof(boost::uint32_t);
+            size = seeds + cells*dof*sizeof(float);
+        }
+        std::size_t offsets, bins, seeds, size;
+    };
+
+    template<class T>
+    void writeArray(std::ostream& out, const T* values, std::size_t size) {
+        if (size > 0)
+            out.write(reinterpret_cast<const char*>(values), size*sizeof(T));
+    }
+
+    std::size_t toBin(double x, std::size_t bins) {
+        const double bin = std::floor(x*bins);
+        if (bin < 0)
+            return 0;
+        return std::min((std::size_t)bin, bins - 1);
+    }
+
+    // The approach directions are binned on the faces of a cube with n x n bins per face.
+    std::size_t directionBin(const Vector3D<>& dir, std::size_t n) {
+        const double ax = std::fabs(dir[0]);
+        const double ay = std::fabs(dir[1]);
+        const double az = std::fabs(dir[2]);
+        std::size_t face;
+        double u, v;
+        if (ax >= ay && ax >= az) {
+            face = dir[0] > 0 ? 0 : 1;
+            u = dir[1]/ax;
+            v = dir[2]/ax;
+        } else if (ay >= az) {
+            face = dir[1] > 0 ? 2 : 3;
+            u = dir[0]/ay;
+            v = dir[2]/ay;
+        } else {
+            face = dir[2] > 0 ? 4 : 5;
+            u = dir[0]/az;
+            v = dir[1]/az;
+        }
+        return (face*n + toBin((v + 1)/2, n))*n + toBin((u + 1)/2, n);
+    }
+
+    Vector3D<> binDirection(std::size_t bin, std::size_t n) {
+        const std::size_t face = bin/(n*n);
+        const double u = (bin%n + 0.5)/n*2 - 1;
+        const double v = ((bin/n)%n + 0.5)/n*2 - 1;
+        const double sign = face%2 == 0 ? 1 : -1;
+        switch (face/2) {
+        case 0: return normalize(Vector3D<>(sign, u, v));
+        case 1: return normalize(Vector3D<>(u, sign, v));
+        default: return normalize(Vector3D<>(u, v, sign));
+        }
+    }
+
+    // The axis that the rotation around the approach direction is measured
+    // from, perpendicular to the direction.
+    Vector3D<> referenceAxis(const Vector3D<>& dir) {
+        Vector3D<> axis(0, 0, 0);
+        if (std::fabs(dir[0]) <= std::fabs(dir[1]) && std::fabs(dir[0]) <= std::fabs(dir[2]))
+            axis[0] = 1;
+        else if (std::fabs(dir[1]) <= std::fabs(dir[2]))
+            axis[1] = 1;
+        else
+            axis[2] = 1;
+        return normalize(cross(dir, axis));
+    }
+}
+
+struct ReachabilityMap::Build {
+    Build(const Device& device, const ClosedFormIK& solver, const State& state,
+          const std::vector<QConstraint::Ptr>& constraints, std::size_t voxels, std::size_t chunkSize):
+        device(device),
+        solver(solver),
+        state(state),
+        constraints(constraints),
+        voxels(voxels),
+        chunkSize(chunkSize),
+        next(0),
+        bins(voxels),
+        seeds(voxels)
+    {}
+
+    const Device& device;
+    const ClosedFormIK& solver;
+    const State& state;
+    const std::vector<QConstraint::Ptr>& constraints;
+    const std::size_t voxels;
+    const std::size_t chunkSize;
+    std::vector<Rotation3D<> > rotations;
+
+    // protects next
+    boost::mutex mutex;
+    std::size_t next;
+
+    // the reachable cells of each voxel (each voxel is written by one worker only)
+    std::vector<std::vector<boost::uint32_t> > bins;
+    std::vector<std::vector<float> > seeds;
+};
+
+ReachabilityMap::ReachabilityMap(const Grid& grid, std::size_t dof):
+    _grid(grid),
+    _dof(dof),
+    _voxelsPerSide((std::size_t)std::ceil(2*grid.radius/grid.resolution)),
+    _cellCount(0),
+    _offsets(NULL),
+    _bins(NULL),
+    _seeds(NULL)
+{
+}
+
+ReachabilityMap::~ReachabilityMap()
+{
+}
+
+std::size_t ReachabilityMap::getBinCount() const
+{
+    return 6*_grid.directionResolution*_grid.directionResolution*_grid.rollBins;
+}
+
+ReachabilityMap::Ptr ReachabilityMap::build(rw::common::Ptr<const Device> device,
+                                            rw::common::Ptr<const ClosedFormIK> solver,
+                                            const State& state,
+                                            const Grid& grid,
+                                            const std::vector<QConstraint::Ptr>& constraints,
+                                            ThreadPool::Ptr pool)
+{
+    RW_ASSERT(device);
+    RW_ASSERT(solver);
+    if (grid.radius <= 0 || grid.resolution <= 0 || grid.directionResolution == 0 || grid.rollBins == 0
+        || grid.elbowAngles == 0)
+        RW_THROW("ReachabilityMap: invalid grid.");
+
+    const ReachabilityMap::Ptr map = ownedPtr(new ReachabilityMap(grid, device->getDOF()));
+    const std::size_t voxels = map->getVoxelCount();
+    const std::size_t binCount = map->getBinCount();
+
+    // Solve a few thousand poses in each batch
+    Build build(*device, *solver, state, constraints, voxels, std::max<std::size_t>(1, 4096/binCount));
+    for (std::size_t bin = 0; bin < binCount; bin++)
+        build.rotations.push_back(map->getCellTransform(0, bin).R());
+
+    const bool parallel = pool != NULL && pool->getNumberOfThreads() > 0;
+    const std::size_t workers = !constraints.empty() ? constraints.size() : (parallel ? pool->getNumberOfThreads() : 1);
+    if (workers == 1 || !parallel) {
+        map->buildWorker(build, 0);
+    } else {
+        std::vector<boost::function<void()> > work;
+        for (std::size_t w = 0; w < workers; w++)
+            work.push_back(boost::bind(&ReachabilityMap::buildWorker, map.get(), boost::ref(build), w));
+        FunctionTask::runAll(pool, work);
+    }
+
+    // Collect the cells in one array sorted by voxel
+    map->_offsetData.resize(voxels + 1, 0);
+    for (std::size_t v = 0; v < voxels; v++)
+        map->_offsetData[v + 1] = map->_offsetData[v] + build.bins[v].size();
+    map->_cellCount = (std::size_t)map->_offsetData[voxels];
+    map->_binData.reserve(map->_cellCount);
+    map->_seedData.reserve(map->_cellCount*map->_dof);
+    for (std::size_t v = 0; v < voxels; v++) {
+        map->_binData.insert(map->_binData.end(), build.bins[v].begin(), build.bins[v].end());
+        map->_seedData.insert(map->_seedData.end(), build.seeds[v].begin(), build.seeds[v].end());
+    }
+    map->_offsets = &map->_offsetData[0];
+    map->_bins = map->_binData.empty() ? NULL : &map->_binData[0];
+    map->_seeds = map->_seedData.empty() ? NULL : &map->_seedData[0];
+    return map;
+}
+
+void ReachabilityMap::buildWorker(Build& build, std::size_t worker) const
+{
+    const QConstraint::Ptr constraint = worker < build.constraints.size() ? build.constraints[worker] : NULL;
+    const std::size_t binCount = build.rotations.size();
+    // The elbow of a redundant solver is sampled at fixed angles rather than
+    // randomly, which would draw from the global generator in every worker
+    const ClosedFormIKSolverKukaIIWA* const redundant = dynamic_cast<const ClosedFormIKSolverKukaIIWA*>(&build.solver);
+    const std::size_t attempts = redundant == NULL ? 1 : _grid.elbowAngles;
+    ClosedFormIK::TransformArray targets;
+    Eigen::ArrayXXd solutions;
+    ClosedFormIK::BranchArray valid;
+    std::vector<bool> found;
+    std::vector<float> seeds;
+    Q q(_dof);
+
+    while (true) {
+        std::size_t begin;
+        {
+            boost::mutex::scoped_lock lock(build.mutex);
+            if (build.next >= build.voxels)
+                return;
+            begin = build.next;
+            build.next = std::min(begin + build.chunkSize, build.voxels);
+        }
+        const std::size_t end = std::min(begin + build.chunkSize, build.voxels);
+
+        targets.resize((end - begin)*binCount, 12);
+        Eigen::Index row = 0;
+        for (std::size_t v = begin; v < end; v++) {
+            const Vector3D<> P = getCellTransform(v, 0).P();
+            for (std::size_t bin = 0; bin < binCount; bin++, row++) {
+                const Rotation3D<>& R = build.rotations[bin];
+                for (int i = 0; i < 3; i++) {
+                    for (int j = 0; j < 3; j++)
+                        targets(row, 3*i+j) = R(i,j);
+                    targets(row, 9+i) = P[i];
+                }
+            }
+        }
+
+        // Store the first valid solution of each cell
+        found.assign(targets.rows(), false);
+        seeds.resize(targets.rows()*_dof);
+        std::size_t remaining = targets.rows();
+        for (std::size_t attempt = 0; attempt < attempts && remaining > 0; attempt++) {
+            if (redundant == NULL)
+                build.solver.solveBatch(targets, build.state, solutions, valid);
+            else
+                redundant->solveBatch(targets, build.state, 2*Pi*attempt/attempts, solutions, valid);
+
+            for (row = 0; row < targets.rows(); row++) {
+                if (found[row])
+                    continue;
+                for (Eigen::Index b = 0; b < valid.cols(); b++) {
+                    if (!valid(row, b))
+                        continue;
+                    for (std::size_t j = 0; j < _dof; j++)
+                        q[j] = solutions(row, b*_dof + j);
+                    if (constraint != NULL && constraint->inCollision(q))
+                        continue;
+                    found[row] = true;
+                    remaining--;
+                    for (std::size_t j = 0; j < _dof; j++)
+                        seeds[row*_dof + j] = (float)q[j];
+                    break;
+                }
+            }
+        }
+
+        row = 0;
+        for (std::size_t v = begin; v < end; v++) {
+            for (std::size_t bin = 0; bin < binCount; bin++, row++) {
+                if (!found[row])
+                    continue;
+                build.bins[v].push_back((boost::uint32_t)bin);
+                build.seeds[v].insert(build.seeds[v].end(), seeds.begin() + row*_dof, seeds.begin() + (row + 1)*_dof);
+            }
+        }
+    }
+}
+
+void ReachabilityMap::write(const std::string& filename) const
+{
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.dof = (boost::uint32_t)_dof;
+    header.voxelsPerSide = (boost::uint32_t)_voxelsPerSide;
+    header.directionResolution = _grid.directionResolution;
+    header.rollBins = _grid.rollBins;
+    header.elbowAngles = _grid.elbowAngles;
+    header.radius = _grid.radius;
+    header.resolution = _grid.resolution;
+    header.cellCount = _cellCount;
+
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        RW_THROW("ReachabilityMap: could not open \"" << filename << "\" for writing.");
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    writeArray(out, _offsets, getVoxelCount() + 1);
+    writeArray(out, _bins, _cellCount);
+    writeArray(out, _seeds, _cellCount*_dof);
+    out.close();
+    if (out.fail())
+        RW_THROW("ReachabilityMap: failed to write \"" << filename << "\".");
+}
+
+ReachabilityMap::Ptr ReachabilityMap::load(const std::string& filename)
+{
+    using namespace boost::interprocess;
+
+    boost::shared_ptr<mapped_region> region;
+    try {
+        const file_mapping file(filename.c_str(), read_only);
+        region.reset(new mapped_region(file, read_only));
+    } catch (const interprocess_exception& e) {
+        RW_THROW("ReachabilityMap: could not map \"" << filename << "\": " << e.what());
+    }
+
+    const char* const data = static_cast<const char*>(region->get_address());
+    const std::size_t size = region->get_size();
+    if (size < sizeof(Header))
+        RW_THROW("ReachabilityMap: \"" << filename << "\" is not a reachability map file.");
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        RW_THROW("ReachabilityMap: \"" << filename << "\" is not a reachability map file.");
+    if (header.version != VERSION)
+        RW_THROW("ReachabilityMap: \"" << filename << "\" has unsupported version " << header.version << ".");
+
+    // The grid must be valid before the number of voxels is computed from it,
+    // and every count must fit in the file such that the layout does not overflow
+    const std::size_t vps = header.voxelsPerSide;
+    const std::size_t offsetCount = size/sizeof(boost::uint64_t);
+    if (!(header.radius > 0) || !(header.resolution > 0) || header.directionResolution == 0
+        || header.rollBins == 0 || header.elbowAngles == 0
+        || std::ceil(2*header.radius/header.resolution) != (double)header.voxelsPerSide
+        || vps == 0 || vps > offsetCount || vps*vps > offsetCount/vps || vps*vps*vps >= offsetCount
+        || 6.0*header.directionResolution*header.directionResolution*header.rollBins > 4294967295.0
+        || header.cellCount > size
+        || (header.cellCount > 0 && header.dof > size/sizeof(float)/header.cellCount))
+        RW_THROW("ReachabilityMap: \"" << filename << "\" has an invalid header.");
+
+    Grid grid;
+    grid.radius = header.radius;
+    grid.resolution = header.resolution;
+    grid.directionResolution = header.directionResolution;
+    grid.rollBins = header.rollBins;
+    grid.elbowAngles = header.elbowAngles;
+    const ReachabilityMap::Ptr map = ownedPtr(new ReachabilityMap(grid, header.dof));
+    if (map->_voxelsPerSide != header.voxelsPerSide)
+        RW_THROW("ReachabilityMap: \"" << filename << "\" has an inconsistent grid.");
+
+    const Layout layout(header.dof, map->getVoxelCount(), (std::size_t)header.cellCount);
+    if (size != layout.size)
+        RW_THROW("ReachabilityMap: \"" << filename << "\" has size " << size << " but " << layout.size << " was expected.");
+
+    map->_region = region;
+    map->_cellCount = (std::size_t)header.cellCount;
+    map->_offsets = reinterpret_cast<const boost::uint64_t*>(data + layout.offsets);
+    map->_bins = reinterpret_cast<const boost::uint32_t*>(data + layout.bins);
+    map->_seeds = reinterpret_cast<const float*>(data + layout.seeds);
+
+    // The queries index the cells by the offsets and search the bins of a
+    // voxel without checks, so they are validated once here
+    const std::size_t voxels = map->getVoxelCount();
+    const std::size_t binCount = map->getBinCount();
+    if (map->_offsets[0] != 0 || map->_offsets[voxels] != header.cellCount)
+        RW_THROW("ReachabilityMap: \"" << filename << "\" has inconsistent voxel offsets.");
+    for (std::size_t v = 0; v < voxels; v++) {
+        const boost::uint64_t begin = map->_offsets[v];
+        const boost::uint64_t end = map->_offsets[v + 1];
+        if (begin > end)
+            RW_THROW("ReachabilityMap: \"" << filename << "\" has inconsistent voxel offsets at voxel " << v << ".");
+        for (boost::uint64_t i = begin; i < end; i++) {
+            if (map->_bins[i] >= binCount || (i > begin && map->_bins[i] <= map->_bins[i - 1]))
+                RW_THROW("ReachabilityMap: \"" << filename << "\" has invalid orientation bins at voxel " << v << ".");
+        }
+    }
+    return map;
+}
+
+bool ReachabilityMap::getCell(const Transform3D<>& baseTend, std::size_t& voxel, std::size_t& bin) const
+{
+    const std::size_t n = _voxelsPerSide;
+    std::size_t index[3];
+    for (int i = 0; i < 3; i++) {
+        const double x = std::floor((baseTend.P()[i] + _grid.radius)/_grid.resolution);
+        if (x < 0 || x >= n)
+            return false;
+        index[i] = (std::size_t)x;
+    }
+    voxel = (index[0]*n + index[1])*n + index[2];
+
+    // The rotation around the approach direction is measured in the plane
+    // perpendicular to the center direction of the bin
+    const Vector3D<> z = baseTend.R().getCol(2);
+    const Vector3D<> x = baseTend.R().getCol(0);
+    const std::size_t dirBin = directionBin(z, _grid.directionResolution);
+    const Vector3D<> dir = binDirection(dirBin, _grid.directionResolution);
+    const Vector3D<> ref = referenceAxis(dir);
+    const double roll = std::atan2(dot(x, cross(dir, ref)), dot(x, ref));
+    bin = dirBin*_grid.rollBins + toBin((roll + Pi)/(2*Pi), _grid.rollBins);
+    return true;
+}
+
+Transform3D<> ReachabilityMap::getCellTransform(std::size_t voxel, std::size_t bin) const
+{
+    const std::size_t n = _voxelsPerSide;
+    const Vector3D<> P(-_grid.radius + (voxel/(n*n) + 0.5)*_grid.resolution,
+                       -_grid.radius + ((voxel/n)%n + 0.5)*_grid.resolution,
+                       -_grid.radius + (voxel%n + 0.5)*_grid.resolution);
+
+    const Vector3D<> z = binDirection(bin/_grid.rollBins, _grid.directionResolution);
+    const Vector3D<> ref = referenceAxis(z);
+    const double roll = -Pi + (bin%_grid.rollBins + 0.5)*2*Pi/_grid.rollBins;
+    const Vector3D<> x = std::cos(roll)*ref + std::sin(roll)*cross(z, ref);
+    return Transform3D<>(P, Rotation3D<>(x, cross(z, x), z));
+}
+
+std::ptrdiff_t ReachabilityMap::findCell(const Transform3D<>& baseTend) const
+{
+    std::size_t voxel, bin;
+    if (_cellCount == 0 || !getCell(baseTend, voxel, bin))
+        return -1;
+    const boost::uint32_t* const first = _bins + _offsets[voxel];
+    const boost::uint32_t* const last = _bins + _offsets[voxel + 1];
+    const boost::uint32_t* const it = std::lower_bound(first, last, (boost::uint32_t)bin);
+    if (it == last || *it != bin)
+        return -1;
+    return it - _bins;
+}
+
+bool ReachabilityMap::isReachable(const Transform3D<>& baseTend) const
+{
+    return findCell(baseTend) >= 0;
+}
+
+bool ReachabilityMap::getSeed(const Transform3D<>& baseTend, Q& seed) const
+{
+    const std::ptrdiff_t cell = findCell(baseTend);
+    if (cell < 0)
+        return false;
+    seed = Q(_dof);
+    for (std::size_t j = 0; j < _dof; j++)
+        seed[j] = _seeds[cell*_dof + j];
+    return true;
+}
+
+double ReachabilityMap::getReachabilityIndex(const Vector3D<>& position) const
+{
+    std::size_t voxel, bin;
+    if (_cellCount == 0 || !getCell(Transform3D<>(position), voxel, bin))
+        return 0;
+    return (double)(_offsets[voxel + 1] - _offsets[voxel])/getBinCount();
+}
+
+std::vector<std::size_t> ReachabilityMap::getReachableBins(std::size_t voxel) const
+{
+    std::vector<std::size_t> bins;
+    if (_cellCount == 0)
+        return bins;
+    RW_ASSERT(voxel < getVoxelCount());
+    for (boost::uint64_t i = _offsets[voxel]; i < _offsets[voxel + 1]; i++)
+        bins.push_back(_bins[i]);
+    return bins;
+}
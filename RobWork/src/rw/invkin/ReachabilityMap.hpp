@@ -0,0 +1,256 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute, 
+ * Faculty of Engineering, University of Southern Denmark 
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#ifndef RW_INVKIN_REACHABILITYMAP_HPP
+#define RW_INVKIN_REACHABILITYMAP_HPP
+
+/**
+ * @file ReachabilityMap.hpp
+ */
+
+#include <rw/common/Ptr.hpp>
+#include <rw/math/Q.hpp>
+#include <rw/math/Transform3D.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace boost { namespace interprocess { class mapped_region; } }
+namespace rw { namespace common { class ThreadPool; } }
+namespace rw { namespace kinematics { class State; } }
+namespace rw { namespace models { class Device; } }
+namespace rw { namespace pathplanning { class QConstraint; } }
+
+namespace rw { namespace invkin {
+    class ClosedFormIK;
+
+    /** \addtogroup invkin */
+    /*@{*/
+
+    /**
+     * @brief Precomputed map of the poses that a device can reach relative to
+     * its base.
+     *
+     * The positions around the base of the device are discretized in a cube
+     * of voxels, and the orientations are discretized in bins. The approach
+     * direction (the z axis) is binned on the faces of a cube, and the rotation
+     * around the approach direction is binned in equal intervals. A cell (a
+     * voxel and an orientation bin) is reachable if the pose at the center of
+     * the cell has an inverse kinematics solution that satisfies the
+     * constraints. The first such solution is stored as a seed for the cell.
+     *
+     * Only the reachable cells are stored, sorted by voxel and with the seeds
+     * in single precision. A query finds the voxel directly and the
+     * orientation bin by a binary search among the reachable cells of the
+     * voxel. The map can be written to a binary file that is memory mapped
+     * when it is loaded.
+     *
+     * The map tells if poses near the center of a cell are likely to be
+     * reachable. Candidate poses (for instance grasps) can be filtered with
+     * isReachable(), and the seed of the cell can be refined to the exact pose
+     * by an iterative solver (see QIKSampler::makeSeeded). The inverse
+     * reachability (the base poses from which a target can be reached) is
+     * given by the inverses of the transforms of the reachable cells.
+     */
+    class ReachabilityMap
+    {
+    public:
+        //! @brief Smart pointer type to ReachabilityMap.
+        typedef rw::common::Ptr<ReachabilityMap> Ptr;
+        //! @brief Smart pointer type to const ReachabilityMap.
+        typedef rw::common::Ptr<const ReachabilityMap> CPtr;
+
+        //! @brief The discretization of a map.
+        struct Grid {
+            //! @brief A grid of 1 m around the base with 5 cm voxels and 384 orientation bins.
+            Grid(): radius(1.0), resolution(0.05), directionResolution(4), rollBins(4), elbowAngles(8) {}
+
+            //! @brief Half the side length of the cube of positions around the base.
+            double radius;
+            //! @brief Side length of a voxel.
+            double resolution;
+            //! @brief Bins along the side of each cube face for the approach direction (\f$6n^2\f$ directions).
+            unsigned int directionResolution;
+            //! @brief Bins for the rotation around the approach direction.
+            unsigned int rollBins;
+            /**
+             * @brief Evenly spaced positions of the elbow that are tried for
+             * each cell of a redundant device (ClosedFormIKSolverKukaIIWA).
+             * Other solvers are called once per cell.
+             */
+            unsigned int elbowAngles;
+        };
+
+        //! @brief Destructor.
+        virtual ~ReachabilityMap();
+
+        /**
+         * @brief Build a map by solving the inverse kinematics for the center
+         * of every cell.
+         *
+         * The cells are solved in chunks with ClosedFormIK::solveBatch. If a
+         * ThreadPool is given, the chunks are processed by a number of workers
+         * in parallel. Each worker checks the solutions with its own
+         * constraint, as constraints are generally not thread safe. The
+         * solver is shared by the workers, so its solveBatch must be thread
+         * safe.
+         *
+         * A ClosedFormIKSolverKukaIIWA places the elbow randomly by default.
+         * For this solver the cells are instead solved with the elbow at each
+         * of Grid::elbowAngles evenly spaced angles, which is deterministic
+         * and does not use the global random generator. A cell is reachable
+         * if any of the angles gives a solution. The map is therefore
+         * conservative for redundant devices: isReachable() can return false
+         * for a pose that is only reachable with the elbow between the
+         * sampled angles.
+         *
+         * @param device [in] the device.
+         * @param solver [in] closed form solver for the base to end transform of \b device.
+         * @param state [in] the state to solve in.
+         * @param grid [in] the discretization.
+         * @param constraints [in] one constraint per worker, or an empty
+         * vector to accept all solutions. Without constraints there is one
+         * worker per thread in \b pool.
+         * @param pool [in] (optional) thread pool to run the workers in.
+         * @return the map.
+         */
+        static ReachabilityMap::Ptr build(rw::common::Ptr<const rw::models::Device> device,
+                                          rw::common::Ptr<const ClosedFormIK> solver,
+                                          const rw::kinematics::State& state,
+                                          const Grid& grid,
+                                          const std::vector<rw::common::Ptr<rw::pathplanning::QConstraint> >& constraints
+                                              = std::vector<rw::common::Ptr<rw::pathplanning::QConstraint> >(),
+                                          rw::common::Ptr<rw::common::ThreadPool> pool = NULL);
+
+        /**
+         * @brief Write the map to a binary file.
+         * @param filename [in] the file.
+         */
+        void write(const std::string& filename) const;
+
+        /**
+         * @brief Load a map written by write().
+         *
+         * The file is memory mapped read-only, such that the cells are only
+         * read from disk when they are queried.
+         *
+         * @param filename [in] the file.
+         * @return the map.
+         * @throws Exception if the file is not a reachability map file, or if
+         * its cells are inconsistent with its grid.
+         */
+        static ReachabilityMap::Ptr load(const std::string& filename);
+
+        /**
+         * @brief Check if the cell of a pose is reachable.
+         * @param baseTend [in] the pose of the end relative to the base.
+         * @return true if the cell is reachable, false if not or if the
+         * position is outside the map.
+         */
+        bool isReachable(const rw::math::Transform3D<>& baseTend) const;
+
+        /**
+         * @brief Get the seed of the cell of a pose.
+         * @param baseTend [in] the pose of the end relative to the base.
+         * @param seed [out] the configuration that reaches the center of the cell.
+         * @return true if the cell is reachable, false otherwise.
+         */
+        bool getSeed(const rw::math::Transform3D<>& baseTend, rw::math::Q& seed) const;
+
+        /**
+         * @brief The fraction of the orientation bins that are reachable at a
+         * position.
+         * @param position [in] the position relative to the base.
+         * @return the reachability index in [0;1] (0 outside the map).
+         */
+        double getReachabilityIndex(const rw::math::Vector3D<>& position) const;
+
+        /**
+         * @brief Find the cell of a pose.
+         * @param baseTend [in] the pose of the end relative to the base.
+         * @param voxel [out] the voxel.
+         * @param bin [out] the orientation bin.
+         * @return false if the position is outside the map.
+         */
+        bool getCell(const rw::math::Transform3D<>& baseTend, std::size_t& voxel, std::size_t& bin) const;
+
+        /**
+         * @brief The pose at the center of a cell.
+         * @param voxel [in] the voxel.
+         * @param bin [in] the orientation bin.
+         * @return the pose relative to the base.
+         */
+        rw::math::Transform3D<> getCellTransform(std::size_t voxel, std::size_t bin) const;
+
+        /**
+         * @brief The reachable cells of a voxel.
+         * @param voxel [in] the voxel.
+         * @return the orientation bins, in increasing order.
+         */
+        std::vector<std::size_t> getReachableBins(std::size_t voxel) const;
+
+        //! @brief The discretization of the map.
+        const Grid& getGrid() const { return _grid; }
+
+        //! @brief The degrees of freedom of the seeds.
+        std::size_t getDOF() const { return _dof; }
+
+        //! @brief The number of voxels.
+        std::size_t getVoxelCount() const { return _voxelsPerSide*_voxelsPerSide*_voxelsPerSide; }
+
+        //! @brief The number of orientation bins per voxel.
+        std::size_t getBinCount() const;
+
+        //! @brief The number of reachable cells.
+        std::size_t getReachableCount() const { return _cellCount; }
+
+    private:
+        ReachabilityMap(const Grid& grid, std::size_t dof);
+
+        // Index of the reachable cell, or -1
+        std::ptrdiff_t findCell(const rw::math::Transform3D<>& baseTend) const;
+
+        struct Build;
+        void buildWorker(Build& build, std::size_t worker) const;
+
+    private:
+        Grid _grid;
+        std::size_t _dof;
+        std::size_t _voxelsPerSide;
+        std::size_t _cellCount;
+
+        // Reachable cells sorted by voxel: the cells of voxel v are in
+        // [_offsets[v];_offsets[v+1]), with their orientation bins in _bins
+        // and their seeds in _seeds.
+        const boost::uint64_t* _offsets;
+        const boost::uint32_t* _bins;
+        const float* _seeds;
+
+        // storage of a map that is built, or the mapping of a loaded file
+        std::vector<boost::uint64_t> _offsetData;
+        std::vector<boost::uint32_t> _binData;
+        std::vector<float> _seedData;
+        boost::shared_ptr<boost::interprocess::mapped_region> _region;
+    };
+
+    /*@}*/
+}} // end namespaces
+
+#endif // end include guard
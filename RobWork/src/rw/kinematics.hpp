@@ -30,6 +30,7 @@
 #include "./kinematics/FramePairMap.hpp"
 #include "./kinematics/FKRange.hpp"
 #include "./kinematics/FKTable.hpp"
+#include "./kinematics/FKCompiled.hpp"
 #include "./kinematics/FrameType.hpp"
 #include "./kinematics/Kinematics.hpp"
 #include "./kinematics/QState.hpp"
@@ -0,0 +1,231 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+#include "FKCompiled.hpp"
+
+#include "FixedFrame.hpp"
+#include "Frame.hpp"
+#include "State.hpp"
+#include "StateStructure.hpp"
+
+#include <rw/common/macros.hpp>
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+
+using namespace rw::kinematics;
+using namespace rw::math;
+
+FKCompiled::FKCompiled():
+    _stamp(0),
+    _complete(false),
+    _noOfUpdated(0),
+    _structure(NULL),
+    _stateUniqueId(-1)
+{}
+
+FKCompiled::FKCompiled(const State& state):
+    _stamp(0),
+    _complete(false),
+    _noOfUpdated(0),
+    _structure(NULL),
+    _stateUniqueId(-1)
+{
+    compile(state);
+}
+
+void FKCompiled::compile(const State& state)
+{
+    const rw::common::Ptr<StateStructure> structure = state.getStateStructure();
+    RW_ASSERT(structure);
+    const std::size_t maxID = structure->getMaxID();
+
+    _order.clear();
+    _parentIds.clear();
+    _orderIdx.assign(maxID, -1);
+    if (_transforms.size() < maxID) {
+        _transforms.resize(maxID);
+        _stamps.resize(maxID, 0);
+        _changed.resize(maxID, 0);
+    }
+
+    // Breadth-first traversal guarantees that parents are placed before their children.
+    _order.push_back(structure->getRoot());
+    _parentIds.push_back(-1);
+    for (std::size_t i = 0; i < _order.size(); i++) {
+        const Frame* const frame = _order[i];
+        _orderIdx[frame->getID()] = (int)i;
+        BOOST_FOREACH(const Frame& child, frame->getChildren(state)) {
+            _order.push_back(&child);
+            _parentIds.push_back(frame->getID());
+        }
+    }
+
+    _valueOffsets.resize(_order.size() + 1);
+    _volatile.resize(_order.size());
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < _order.size(); i++) {
+        const Frame* const frame = _order[i];
+        _valueOffsets[i] = offset;
+        offset += frame->size();
+        _volatile[i] = frame->size() == 0 && dynamic_cast<const FixedFrame*>(frame) == NULL;
+    }
+    _valueOffsets[_order.size()] = offset;
+    _values.resize(offset);
+    _complete = false;
+
+    _dafParents.clear();
+    BOOST_FOREACH(const Frame* daf, structure->getDAFs()) {
+        if (daf != NULL)
+            _dafParents.push_back(std::make_pair(daf, daf->getDafParent(state)));
+    }
+
+    _structure = structure.get();
+    _stateUniqueId = state.getUniqueId();
+}
+
+bool FKCompiled::isCompiledFor(const State& state) const
+{
+    if (_stateUniqueId != state.getUniqueId() || _structure != state.getStateStructure().get())
+        return false;
+    typedef std::pair<const Frame*, const Frame*> DafParent;
+    BOOST_FOREACH(const DafParent& dafParent, _dafParents) {
+        if (dafParent.first->getDafParent(state) != dafParent.second)
+            return false;
+    }
+    return true;
+}
+
+void FKCompiled::update(const State& state)
+{
+    if (!isCompiledFor(state))
+        compile(state);
+    nextStamp();
+    sweep(state, false);
+}
+
+void FKCompiled::update(const State& state, const std::vector<const Frame*>& frames)
+{
+    if (!isCompiledFor(state))
+        compile(state);
+    nextStamp();
+    _complete = false;
+
+    // Stamp the frames that must be calculated and calculate them in order afterwards.
+    BOOST_FOREACH(const Frame* frame, frames) {
+        markPath(frame);
+    }
+
+    _noOfUpdated = 0;
+    const std::size_t n = _order.size();
+    for (std::size_t i = 0; i < n; i++) {
+        const Frame& frame = *_order[i];
+        const int id = frame.getID();
+        if (_stamps[id] != _stamp)
+            continue;
+        const int parentId = _parentIds[i];
+        if (parentId < 0)
+            _transforms[id] = frame.getTransform(state);
+        else
+            frame.multiplyTransform(_transforms[parentId], state, _transforms[id]);
+        _noOfUpdated++;
+    }
+}
+
+void FKCompiled::updateIncremental(const State& state)
+{
+    if (!isCompiledFor(state))
+        compile(state);
+    if (!_complete) {
+        nextStamp();
+        sweep(state, false);
+    } else {
+        // all stamps are current after a complete update, so the stamp is kept
+        sweep(state, true);
+    }
+}
+
+void FKCompiled::sweep(const State& state, bool incremental)
+{
+    _noOfUpdated = 0;
+    const std::size_t n = _order.size();
+    for (std::size_t i = 0; i < n; i++) {
+        const Frame& frame = *_order[i];
+        const int id = frame.getID();
+        const int parentId = _parentIds[i];
+
+        // compare the state values of the frame with the values of the last update
+        bool changed = !incremental || _volatile[i] || (parentId >= 0 && _changed[parentId]);
+        const std::size_t size = _valueOffsets[i+1] - _valueOffsets[i];
+        if (size > 0) {
+            const double* const vals = frame.getData(state);
+            double* const cached = &_values[_valueOffsets[i]];
+            for (std::size_t j = 0; j < size; j++) {
+                if (cached[j] != vals[j]) {
+                    cached[j] = vals[j];
+                    changed = true;
+                }
+            }
+        }
+
+        _changed[id] = changed;
+        if (!changed)
+            continue;
+        if (parentId < 0)
+            _transforms[id] = frame.getTransform(state);
+        else
+            frame.multiplyTransform(_transforms[parentId], state, _transforms[id]);
+        _stamps[id] = _stamp;
+        _noOfUpdated++;
+    }
+    _complete = true;
+}
+
+void FKCompiled::nextStamp()
+{
+    if (++_stamp == 0) {
+        std::fill(_stamps.begin(), _stamps.end(), 0);
+        _stamp = 1;
+    }
+}
+
+void FKCompiled::markPath(const Frame* frame)
+{
+    RW_ASSERT(frame);
+    int id = frame->getID();
+    while (id >= 0 && _stamps[id] != _stamp) {
+        const int idx = id < (int)_orderIdx.size() ? _orderIdx[id] : -1;
+        if (idx < 0)
+            RW_THROW("The frame \"" << frame->getName() << "\" is not in the compiled kinematic tree.");
+        _stamps[id] = _stamp;
+        id = _parentIds[idx];
+    }
+}
+
+const Transform3D<>& FKCompiled::get(const Frame& frame) const
+{
+    RW_ASSERT(has(frame));
+    return _transforms[frame.getID()];
+}
+
+bool FKCompiled::has(const Frame& frame) const
+{
+    const int id = frame.getID();
+    return _stamp != 0 && id >= 0 && id < (int)_orderIdx.size() && _orderIdx[id] >= 0 && _stamps[id] == _stamp;
+}
@@ -0,0 +1,228 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+#ifndef RW_KINEMATICS_FKCOMPILED_HPP
+#define RW_KINEMATICS_FKCOMPILED_HPP
+
+/**
+ * @file FKCompiled.hpp
+ */
+
+#include <rw/common/Ptr.hpp>
+#include <rw/math/Transform3D.hpp>
+
+#include <vector>
+
+namespace rw { namespace kinematics {
+
+    class Frame;
+    class State;
+    class StateStructure;
+
+    /** @addtogroup kinematics */
+    /*@{*/
+
+    /**
+     * @brief Forward kinematics for all frames of a StateStructure computed in
+     * a single forward sweep.
+     *
+     * Where FKTable computes and memoizes world transforms lazily by recursing
+     * towards the root, FKCompiled orders the frames of the tree
+     * topologically once (parents before children) and stores the world
+     * transforms in a contiguous array indexed by the frame ID. An update
+     * then computes the transforms by iterating the ordering from the root
+     * and outwards.
+     *
+     * The object can be reused for any number of states without reallocating.
+     * The ordering is recompiled automatically when the structure of the
+     * state changes, i.e. when frames are added to or removed from the
+     * StateStructure or when a DAF is attached to a new parent.
+     *
+     * With updateIncremental() only the frames whose state values changed
+     * since the last update, and the frames below them in the tree, are
+     * recalculated. This is useful when consecutive states differ only in a
+     * few joints, for instance when stepping along a path for a single device.
+     *
+     * @note The object is not thread safe. Use one object per thread.
+     */
+    class FKCompiled
+    {
+    public:
+        //! @brief Smart pointer type to FKCompiled.
+        typedef rw::common::Ptr<FKCompiled> Ptr;
+
+        /**
+         * @brief Construct an empty object. The frame ordering is compiled
+         * on the first call to update().
+         */
+        FKCompiled();
+
+        /**
+         * @brief Construct object and compile the frame ordering for the
+         * structure of \b state.
+         *
+         * No transforms are calculated before update() is called.
+         *
+         * @param state [in] the state defining the structure of the tree.
+         */
+        FKCompiled(const State& state);
+
+        /**
+         * @brief Compile the topological ordering of the frames for the tree
+         * structure given by \b state.
+         *
+         * Buffers are only reallocated if the number of frames has grown
+         * since the last compilation.
+         *
+         * @param state [in] the state defining the structure of the tree.
+         */
+        void compile(const State& state);
+
+        /**
+         * @brief Check if the compiled ordering is valid for the tree
+         * structure of \b state.
+         *
+         * @param state [in] the state to check.
+         * @return true if the ordering can be used with \b state, false if
+         * compile() must be called first.
+         */
+        bool isCompiledFor(const State& state) const;
+
+        /**
+         * @brief Calculate the world transforms of all frames for \b state.
+         *
+         * @param state [in] the state to calculate the forward kinematics for.
+         */
+        void update(const State& state);
+
+        /**
+         * @brief Calculate the world transforms of a subset of the frames
+         * for \b state.
+         *
+         * Only the frames in \b frames and the frames on their paths towards
+         * the root are calculated. The sweep still follows the compiled
+         * ordering, so shared parents are only calculated once.
+         *
+         * @param state [in] the state to calculate the forward kinematics for.
+         * @param frames [in] the frames for which the world transform is
+         * needed.
+         */
+        void update(const State& state, const std::vector<const Frame*>& frames);
+
+        /**
+         * @brief Calculate the world transforms of all frames for \b state,
+         * reusing the transforms from the previous update where possible.
+         *
+         * A frame is recalculated if its values in the state differ from the
+         * values used in the last update, or if its parent was recalculated.
+         * Frames without state values that are not FixedFrame's (such as
+         * dependent joints) can depend on other parts of the state and are
+         * always recalculated.
+         *
+         * If the previous call was a partial update, or the ordering had to be
+         * recompiled, all frames are calculated.
+         *
+         * @note Changes to the kinematics that are not stored in the State,
+         * for instance FixedFrame::setTransform(), are not detected. Call
+         * invalidate() after such changes.
+         *
+         * @param state [in] the state to calculate the forward kinematics for.
+         */
+        void updateIncremental(const State& state);
+
+        /**
+         * @brief Discard the transforms of the previous update, such that the
+         * next call to updateIncremental() calculates all frames.
+         */
+        void invalidate() { _complete = false; }
+
+        /**
+         * @brief The number of frames that was calculated in the last update.
+         * @return the number of frames.
+         */
+        std::size_t getNoOfUpdatedFrames() const { return _noOfUpdated; }
+
+        /**
+         * @brief The world transform for the frame \b frame.
+         *
+         * @param frame [in] the frame for which to find the world transform.
+         * The frame must have been calculated in the last call to update().
+         *
+         * @return The transform of the frame relative to the world.
+         */
+        const math::Transform3D<>& get(const Frame& frame) const;
+
+        //! @copydoc get(const Frame&) const
+        inline const math::Transform3D<>& get(const Frame* frame) const { return get(*frame); }
+
+        /**
+         * @brief Check if the world transform of \b frame was calculated in
+         * the last call to update().
+         *
+         * @param frame [in] the frame.
+         * @return true if get() can be called for \b frame.
+         */
+        bool has(const Frame& frame) const;
+
+        /**
+         * @brief The frames in the compiled order. A frame is always placed
+         * after its parent.
+         *
+         * @return the ordered frames.
+         */
+        const std::vector<const Frame*>& getFrames() const { return _order; }
+
+    private:
+        void markPath(const Frame* frame);
+        void sweep(const State& state, bool incremental);
+        void nextStamp();
+
+    private:
+        // frames in topological order and the IDs of their parents (-1 for the root)
+        std::vector<const Frame*> _order;
+        std::vector<int> _parentIds;
+        // position of each frame in _order indexed by frame ID (-1 if not in the tree)
+        std::vector<int> _orderIdx;
+
+        // world transforms indexed by frame ID
+        std::vector<math::Transform3D<> > _transforms;
+        // stamp of the update in which the transform was last calculated, indexed by frame ID
+        std::vector<unsigned int> _stamps;
+        unsigned int _stamp;
+
+        // the state values used in the last complete update, packed in the compiled order
+        std::vector<double> _values;
+        std::vector<std::size_t> _valueOffsets;
+        // frames that must always be recalculated, indexed by order
+        std::vector<char> _volatile;
+        // frames recalculated in the current sweep, indexed by frame ID
+        std::vector<char> _changed;
+        // true if all transforms and values are from the same state
+        bool _complete;
+        std::size_t _noOfUpdated;
+
+        // the DAFs and their parents at the time of compilation
+        std::vector<std::pair<const Frame*, const Frame*> > _dafParents;
+        const StateStructure* _structure;
+        int _stateUniqueId;
+    };
+
+    /*@}*/
+}} // end namespaces
+
+#endif // end include guard
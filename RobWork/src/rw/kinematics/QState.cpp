@@ -18,25 +18,99 @@
 
 #include "QState.hpp"
 
+#include "QStatePool.hpp"
 #include "StateData.hpp"
 #include "StateSetup.hpp"
 
+#include <cstring>
+#include <new>
+
 using namespace rw::kinematics;
 
 QState::QState():
-    _contents(1)
+    _buffer(allocate(NULL, 1))
 {
+    values()[0] = 0;
 }
 
 QState::QState(boost::shared_ptr<StateSetup> setup) :
-    _contents(setup->size()+1),
-    _setup(setup)
+    _setup(setup),
+    _buffer(allocate(setup->getQStatePool(), setup->size()+1))
+{
+    double* const vals = values();
+    for (size_t i = 0; i < size(); i++)
+        vals[i] = 0;
+}
+
+QState::QState(const math::Q& contents, boost::shared_ptr<StateSetup> setup):
+    _setup(setup),
+    _buffer(allocate(setup == NULL ? NULL : setup->getQStatePool(), contents.size()))
+{
+    double* const vals = values();
+    for (size_t i = 0; i < size(); i++)
+        vals[i] = contents[i];
+}
+
+QState::QState(const QState& other):
+    _setup(other._setup)
+{
+    QStatePool* const pool = other._buffer->pool;
+    if (pool != NULL && pool->isCopyOnWrite()) {
+        ++other._buffer->refs;
+        _buffer = other._buffer;
+    } else {
+        _buffer = allocate(pool, other.size());
+        memcpy(values(), other.values(), other.size() * sizeof(double));
+    }
+}
+
+QState::~QState()
+{
+    // The buffer must be returned to the pool before the setup is released.
+    release(_buffer);
+}
+
+std::size_t QState::getBlockSize(std::size_t size)
+{
+    return sizeof(Buffer) + size * sizeof(double);
+}
+
+QState::Buffer* QState::allocate(QStatePool* pool, std::size_t size)
+{
+    void* block;
+    if (pool != NULL && pool->getBlockSize() >= getBlockSize(size))
+        block = pool->allocate();
+    else {
+        block = ::operator new(getBlockSize(size));
+        pool = NULL;
+    }
+    return new (block) Buffer(pool, size);
+}
+
+void QState::release(Buffer* buffer)
+{
+    if (--buffer->refs == 0) {
+        QStatePool* const pool = buffer->pool;
+        buffer->~Buffer();
+        if (pool != NULL)
+            pool->deallocate(buffer);
+        else
+            ::operator delete(buffer);
+    }
+}
+
+void QState::detach()
 {
-    for (size_t i = 0; i < _contents.size(); i++)
-        _contents[i] = 0;
+    Buffer* const buffer = allocate(_buffer->pool, _buffer->size);
+    memcpy(getValues(buffer), getValues(_buffer), _buffer->size * sizeof(double));
+    release(_buffer);
+    _buffer = buffer;
 }
 
-QState::~QState(){ }
+rw::math::Q QState::toQ() const
+{
+    return rw::math::Q(size(), values());
+}
 
 const double* QState::getQ(const StateData& data) const
 {
@@ -44,10 +118,9 @@ const double* QState::getQ(const StateData& data) const
     if (pos < 0)
     	RW_THROW("The values can not be retrieved from this state, as this state does not appear to hold that data. Please make sure you use the correct State object.");
 
-    // NB: This is _not_ the same as &_contents[pos] when pos ==
-    // _contents.size(). It is OK to return a pointer to one element past the
-    // end of the array.
-    return &_contents[0] + pos;
+    // NB: It is OK to return a pointer to one element past the end of the
+    // array.
+    return values() + pos;
 }
 
 double* QState::getQ(const StateData& data)
@@ -56,10 +129,9 @@ double* QState::getQ(const StateData& data)
     if (pos < 0)
     	RW_THROW("The values can not be retrieved from this state, as this state does not appear to hold that data. Please make sure you use the correct State object.");
 
-    // NB: This is _not_ the same as &_contents[pos] when pos ==
-    // _contents.size(). It is OK to return a pointer to one element past the
-    // end of the array.
-    return &_contents[0] + pos;
+    // NB: It is OK to return a pointer to one element past the end of the
+    // array.
+    return values() + pos;
 }
 
 void QState::setQ(const StateData& data, const double* vals)
@@ -69,11 +141,29 @@ void QState::setQ(const StateData& data, const double* vals)
     	RW_THROW("The new values can not be set in this state, as this state does not appear to hold that data. Please make sure you use the correct State object.");
     const int dof = data.size();
     // See above with regards to the (+ pos) expression.
-    memmove(&_contents[0] + pos, vals, dof * sizeof(double));
+    memmove(values() + pos, vals, dof * sizeof(double));
 }
 
 QState& QState::operator=(const QState &rhs) {
+    if (_buffer == rhs._buffer)
+        return *this;
+    Buffer* buffer;
+    QStatePool* const pool = rhs._buffer->pool;
+    if (pool != NULL && pool->isCopyOnWrite()) {
+        ++rhs._buffer->refs;
+        buffer = rhs._buffer;
+    } else if (_buffer->refs == 1 && _buffer->pool == pool && _buffer->size == rhs._buffer->size) {
+        // reuse the values of this state
+        memcpy(values(), rhs.values(), rhs.size() * sizeof(double));
+        _setup = rhs._setup;
+        return *this;
+    } else {
+        buffer = allocate(pool, rhs.size());
+        memcpy(getValues(buffer), rhs.values(), rhs.size() * sizeof(double));
+    }
+    // The old buffer is returned before the setup it belongs to is released.
+    release(_buffer);
+    _buffer = buffer;
     _setup = rhs._setup;
-    _contents = rhs._contents;
     return *this;
 }
@@ -24,12 +24,14 @@
  */
 
 #include <boost/shared_ptr.hpp>
+#include <boost/smart_ptr/detail/atomic_count.hpp>
 #include <rw/math/Q.hpp>
 #include <rw/common/macros.hpp>
 
 namespace rw { namespace kinematics {
     class StateSetup;
     class StateData;
+    class QStatePool;
 
     /** @addtogroup kinematics */
     /*@{*/
@@ -46,6 +48,11 @@ namespace rw { namespace kinematics {
      *
      * Configuration states can be freely copied and assigned.
      *
+     * The values are stored in blocks from the QStatePool of the StateSetup.
+     * If copy-on-write is enabled for the pool (see
+     * StateStructure::setCopyOnWrite()), copies share the values until one of
+     * them is modified.
+     *
      * The configuration state is a part of the StateStructure state (see
      * State).
      */
@@ -68,6 +75,12 @@ namespace rw { namespace kinematics {
          */
         explicit QState(boost::shared_ptr<StateSetup> setup);
 
+        /**
+         * @brief Copy constructor.
+         * @param other [in] the QState to copy.
+         */
+        QState(const QState& other);
+
         //! destructor
         virtual ~QState();
 
@@ -118,7 +131,7 @@ namespace rw { namespace kinematics {
          */
         friend std::ostream& operator<<(std::ostream& os, const QState& state)
         {
-            os << state._contents;
+            os << state.toQ();
             return os;
         }
 
@@ -127,7 +140,7 @@ namespace rw { namespace kinematics {
          */
         friend QState operator*(const QState& q, double scale)
         {
-            return QState(scale * q._contents, q._setup);
+            return QState(scale * q.toQ(), q._setup);
         }
 
         /**
@@ -135,7 +148,7 @@ namespace rw { namespace kinematics {
          */
         friend QState operator/(const QState& q, double scale)
         {
-            return QState(q._contents/scale, q._setup);
+            return QState(q.toQ()/scale, q._setup);
         }
 
         /**
@@ -143,7 +156,7 @@ namespace rw { namespace kinematics {
          */
         friend QState operator*(double scale, const QState& q)
         {
-            return QState(scale * q._contents, q._setup);
+            return QState(scale * q.toQ(), q._setup);
         }
 
         /**
@@ -153,7 +166,7 @@ namespace rw { namespace kinematics {
         {
             // It does not matter here if we use the setup of a or b.
             // They are assumed to be the identical.
-            return QState(a._contents + b._contents, a._setup);
+            return QState(a.toQ() + b.toQ(), a._setup);
         }
 
         /**
@@ -161,7 +174,7 @@ namespace rw { namespace kinematics {
          */
         friend QState operator-(const QState& a, const QState& b)
         {
-            return QState(a._contents - b._contents, a._setup);
+            return QState(a.toQ() - b.toQ(), a._setup);
         }
 
         /**
@@ -169,7 +182,7 @@ namespace rw { namespace kinematics {
          */
         QState operator-() const
         {
-            return QState(-_contents, _setup);
+            return QState(-toQ(), _setup);
         }
 
         /**
@@ -192,7 +205,7 @@ namespace rw { namespace kinematics {
         /**
            @brief The dimension of the state vector.
          */
-        size_t size() const { return _contents.size(); }
+        size_t size() const { return _buffer->size; }
 
         /**
          * @brief Get element of state.
@@ -201,27 +214,55 @@ namespace rw { namespace kinematics {
          */
         double& operator()(size_t index) {
             RW_ASSERT(index<size());
-            return _contents(index);
+            return values()[index];
         }
 
         //! @copydoc operator()
         const double& operator()(size_t index) const {
             RW_ASSERT(index<size());
-            return _contents(index);
+            return values()[index];
         }
 
     private:
-        QState(
-            const math::Q& contents,
-            boost::shared_ptr<StateSetup> setup)
-            :
-            _contents(contents),
-            _setup(setup)
-        {}
+        friend class StateSetup;
+
+        // Header of a reference counted block with the values. The values
+        // follow right after the header.
+        struct Buffer {
+            Buffer(QStatePool* pool, std::size_t size): refs(1), pool(pool), size(size) {}
+            boost::detail::atomic_count refs;
+            // the pool the block belongs to, or NULL if allocated with new
+            QStatePool* const pool;
+            const std::size_t size;
+        };
+
+        QState(const math::Q& contents, boost::shared_ptr<StateSetup> setup);
+
+        math::Q toQ() const;
+
+        // the size in bytes of a block holding size values
+        static std::size_t getBlockSize(std::size_t size);
+
+        static Buffer* allocate(QStatePool* pool, std::size_t size);
+
+        static void release(Buffer* buffer);
+
+        // make sure that the values are not shared before they are modified
+        void detach();
+
+        static double* getValues(Buffer* buffer) { return reinterpret_cast<double*>(buffer + 1); }
+
+        const double* values() const { return getValues(_buffer); }
+
+        double* values() {
+            if (_buffer->refs > 1)
+                detach();
+            return getValues(_buffer);
+        }
 
     private:
-        math::Q _contents;
         boost::shared_ptr<StateSetup> _setup;
+        Buffer* _buffer;
     };
 
     /*@}*/
@@ -0,0 +1,110 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute, 
+ * Faculty of Engineering, University of Southern Denmark 
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+#include "QStatePool.hpp"
+
+#include <rw/common/macros.hpp>
+
+#include <new>
+
+using namespace rw::kinematics;
+
+QStatePool::QStatePool(std::size_t blockSize):
+    _blockSize(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize),
+    _free(NULL),
+    _noOfBlocks(0),
+    _copyOnWrite(false),
+    _pooling(true)
+{
+}
+
+QStatePool::~QStatePool()
+{
+    std::size_t freed = 0;
+    while (_free != NULL) {
+        FreeBlock* const next = _free->next;
+        ::operator delete(_free);
+        _free = next;
+        freed++;
+    }
+    // blocks still in use are leaked, as they can not be freed without invalidating the states using them
+    if (freed != _noOfBlocks) {
+        try {
+            RW_WARN("QStatePool destroyed with " << _noOfBlocks - freed << " blocks still in use.");
+        } catch (...) {
+        }
+    }
+}
+
+void* QStatePool::allocate()
+{
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_free != NULL) {
+            FreeBlock* const block = _free;
+            _free = block->next;
+            return block;
+        }
+        _noOfBlocks++;
+    }
+    return ::operator new(_blockSize);
+}
+
+void QStatePool::deallocate(void* block)
+{
+    if (block == NULL)
+        return;
+    FreeBlock* const free = static_cast<FreeBlock*>(block);
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_pooling) {
+            free->next = _free;
+            _free = free;
+            return;
+        }
+        _noOfBlocks--;
+    }
+    ::operator delete(block);
+}
+
+void QStatePool::setPooling(bool enable)
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    _pooling = enable;
+    if (_pooling)
+        return;
+    // release the free list, such that all blocks go to the heap from now on
+    while (_free != NULL) {
+        FreeBlock* const next = _free->next;
+        ::operator delete(_free);
+        _free = next;
+        _noOfBlocks--;
+    }
+}
+
+bool QStatePool::isPooling() const
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    return _pooling;
+}
+
+std::size_t QStatePool::getNoOfBlocks() const
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    return _noOfBlocks;
+}
@@ -0,0 +1,138 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute, 
+ * Faculty of Engineering, University of Southern Denmark 
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+#ifndef RW_KINEMATICS_QSTATEPOOL_HPP
+#define RW_KINEMATICS_QSTATEPOOL_HPP
+
+/**
+ * @file QStatePool.hpp
+ */
+
+#include <boost/thread/mutex.hpp>
+
+#include <cstddef>
+
+namespace rw { namespace kinematics {
+
+    /** @addtogroup kinematics */
+    /*@{*/
+
+    /**
+     * @brief Pool of memory blocks for the values of QState objects.
+     *
+     * All QState objects of a StateSetup have the same size, so the blocks of
+     * the pool have a fixed size. Released blocks are kept on a free list and
+     * reused, such that copying and destroying states does not go to the heap
+     * once the pool holds enough blocks for the states in use.
+     *
+     * The pool also decides if QState objects share their values until one of
+     * them is written to (copy-on-write). This is disabled by default, see
+     * StateStructure::setCopyOnWrite().
+     *
+     * The pool is thread safe.
+     */
+    class QStatePool
+    {
+    public:
+        /**
+         * @brief Construct pool.
+         * @param blockSize [in] the size of the blocks in bytes.
+         */
+        explicit QStatePool(std::size_t blockSize);
+
+        /**
+         * @brief Destructor.
+         *
+         * All blocks should have been returned to the pool. Blocks still in use
+         * are not freed, and a warning is logged.
+         */
+        ~QStatePool();
+
+        /**
+         * @brief Get a block from the pool.
+         * @return a block of getBlockSize() bytes.
+         */
+        void* allocate();
+
+        /**
+         * @brief Return a block to the pool.
+         * @param block [in] a block allocated from this pool.
+         */
+        void deallocate(void* block);
+
+        /**
+         * @brief The size of the blocks.
+         * @return the size in bytes.
+         */
+        std::size_t getBlockSize() const { return _blockSize; }
+
+        /**
+         * @brief The number of blocks allocated from the heap by the pool.
+         * @return the number of blocks in use or on the free list.
+         */
+        std::size_t getNoOfBlocks() const;
+
+        /**
+         * @brief Enable or disable sharing of values between copies of QState.
+         * @param enable [in] true to enable copy-on-write.
+         */
+        void setCopyOnWrite(bool enable) { _copyOnWrite = enable; }
+
+        /**
+         * @brief Check if copies of QState share their values until written.
+         * @return true if copy-on-write is enabled.
+         */
+        bool isCopyOnWrite() const { return _copyOnWrite; }
+
+        /**
+         * @brief Enable or disable reuse of released blocks.
+         *
+         * With pooling disabled, every block is allocated from and released to
+         * the heap, as if there was no pool. This is mainly useful for
+         * measuring the effect of the pool.
+         *
+         * @param enable [in] false to bypass the free list (default is true).
+         */
+        void setPooling(bool enable);
+
+        /**
+         * @brief Check if released blocks are reused.
+         * @return true if pooling is enabled.
+         */
+        bool isPooling() const;
+
+    private:
+        QStatePool(const QStatePool&);
+        QStatePool& operator=(const QStatePool&);
+
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        const std::size_t _blockSize;
+        FreeBlock* _free;
+        std::size_t _noOfBlocks;
+        bool _copyOnWrite;
+        bool _pooling;
+        mutable boost::mutex _mutex;
+    };
+
+    /*@}*/
+}} // end namespaces
+
+#endif // end include guard
@@ -17,11 +17,21 @@
 
 
 #include "StateSetup.hpp"
+#include "QState.hpp"
+#include "QStatePool.hpp"
 
 #include <boost/foreach.hpp>
 
 using namespace rw::kinematics;
 
+StateSetup::StateSetup():
+    _version(-1), _tree(NULL),
+    _dof(0),_nrOfDAF(0),_nrOfValidFrames(0),
+    _initMaxID(0),_nrCaches(0),
+    _qstatePool(new QStatePool(QState::getBlockSize(1)))
+{
+}
+
 StateSetup::StateSetup(int version, StateStructure& tree,
                        const std::vector<boost::shared_ptr<StateData> >& stateDatas):
             _version(version),_tree(&tree),_datas(stateDatas),
@@ -92,4 +102,9 @@ StateSetup::StateSetup(int version, StateStructure& tree,
 
     _nrOfDAF = nrOfDAF;
     _nrOfValidFrames = nrOfValidFrames;
+
+    //************* finally the pool for the QState values
+    _qstatePool.reset(new QStatePool(QState::getBlockSize(_dof+1)));
+    _qstatePool->setCopyOnWrite(tree.isCopyOnWrite());
+    _qstatePool->setPooling(tree.isStatePooling());
 }
@@ -29,6 +29,7 @@
 #include <boost/shared_ptr.hpp>
 
 namespace rw { namespace kinematics {
+    class QStatePool;
 
     /** @addtogroup kinematics */
     /*@{*/
@@ -48,12 +49,7 @@ namespace rw { namespace kinematics {
         /**
          * @brief Creates an empty StateSetup
          */
-        StateSetup():
-            _version(-1), _tree(NULL),
-            _dof(0),_nrOfDAF(0),_nrOfValidFrames(0),
-            _initMaxID(0),_nrCaches(0)
-        {
-        }
+        StateSetup();
 
         /**
          * @brief Creates a StateSetup from a StateStructure and a number of
@@ -215,6 +211,13 @@ namespace rw { namespace kinematics {
          */
         inline int getMaxCacheIdx() const { return  _nrCaches; }
 
+        /**
+         * @brief The pool that the values of QState objects for this setup
+         * are allocated from.
+         * @return the pool.
+         */
+        QStatePool* getQStatePool() const { return _qstatePool.get(); }
+
     private:
         friend class StateData;
 
@@ -255,6 +258,9 @@ namespace rw { namespace kinematics {
         // indexes into the StateCache array,
         // size==<nr of statedata>
         std::vector<int> _sdataTCacheIdx;
+
+        ////////////////////////////////// Storage
+        boost::shared_ptr<QStatePool> _qstatePool;
     private:
         // You _can_ go around copying StateSetup without memory leaks or other
         // infelicities, but we don't expect to do that so we disallow it.
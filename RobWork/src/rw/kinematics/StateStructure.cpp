@@ -20,6 +20,7 @@
 #include "FixedFrame.hpp"
 #include "State.hpp"
 #include "QState.hpp"
+#include "QStatePool.hpp"
 #include "StateSetup.hpp"
 #include "TreeState.hpp"
 
@@ -31,7 +32,9 @@ using namespace rw::kinematics;
 StateStructure::StateStructure():
     _version(0),
     _root(NULL),
-    _stateSetupUniqueId(0)
+    _stateSetupUniqueId(0),
+    _copyOnWrite(false),
+    _statePooling(true)
 {
     _root = new FixedFrame("WORLD",Transform3D<>::identity());
     // now add the state data of the frame
@@ -249,6 +252,22 @@ void StateStructure::setDefaultState(const State &state)
     _defaultState.copy(state);
 }
 
+void StateStructure::setCopyOnWrite(bool enable)
+{
+    _copyOnWrite = enable;
+    for(const boost::shared_ptr<StateSetup>& setup : _setups) {
+        setup->getQStatePool()->setCopyOnWrite(enable);
+    }
+}
+
+void StateStructure::setStatePooling(bool enable)
+{
+    _statePooling = enable;
+    for(const boost::shared_ptr<StateSetup>& setup : _setups) {
+        setup->getQStatePool()->setPooling(enable);
+    }
+}
+
 void StateStructure::cleanup(int ID) {
     // first run through StateSetup list and remove all state setups that are not
     // used anymore
@@ -156,6 +156,53 @@ namespace rw { namespace kinematics {
          */
         void setDefaultState(const State &state);
 
+        /**
+         * @brief Let copies of a State share their configuration values until
+         * one of the copies is modified.
+         *
+         * The configuration values of states are allocated from a pool per
+         * StateSetup. With copy-on-write enabled, copying a state does not
+         * copy the values either, which makes copies of states cheap in
+         * planners that copy a state for each configuration they test.
+         *
+         * The setting applies to existing and future states of the structure.
+         *
+         * @note With copy-on-write enabled, a pointer to the values obtained
+         * with StateData::getData(State&) must not be used to write to the
+         * state after the state has been copied, as the values are then
+         * shared with the copy.
+         *
+         * @param enable [in] true to enable copy-on-write (default is false).
+         */
+        void setCopyOnWrite(bool enable);
+
+        /**
+         * @brief Check if states share configuration values until modified.
+         * @return true if copy-on-write is enabled.
+         * @see setCopyOnWrite
+         */
+        bool isCopyOnWrite() const { return _copyOnWrite; }
+
+        /**
+         * @brief Let states reuse the released configuration values of other
+         * states of the same StateSetup.
+         *
+         * With pooling disabled, every copy of a state allocates its values on
+         * the heap. This is only useful for measuring the effect of the pool.
+         *
+         * The setting applies to existing and future states of the structure.
+         *
+         * @param enable [in] false to allocate the values on the heap (default is true).
+         */
+        void setStatePooling(bool enable);
+
+        /**
+         * @brief Check if states reuse released configuration values.
+         * @return true if pooling is enabled.
+         * @see setStatePooling
+         */
+        bool isStatePooling() const { return _statePooling; }
+
         /**
          * @brief All state data in the tree.
          * @return All state data in the tree
@@ -289,6 +336,8 @@ namespace rw { namespace kinematics {
         typedef std::vector<boost::shared_ptr<StateSetup> > StateSetupList;
         StateSetupList _setups;
         int _stateSetupUniqueId;
+        bool _copyOnWrite;
+        bool _statePooling;
 
         // the complete list of frames
         std::vector<Frame*> _frames;
@@ -47,21 +47,17 @@ namespace {
     const std::vector<Frame*> emptyFrameList(0);
 }
 
-TreeState::TreeState()
+TreeState::TreeState():
+    _data(new Data())
 {}
 
 TreeState::~TreeState()
 {}
 
-TreeState::TreeState(const TreeState &src){
-    _setup = src._setup;
-
-    _parentIdxToChildList = src._parentIdxToChildList;
-
-    _childLists = src._childLists;
-
-    _dafIdxToParentIdx = src._dafIdxToParentIdx;
-}
+TreeState::TreeState(const TreeState &src):
+    _setup(src._setup),
+    _data(src._data)
+{}
 
 boost::shared_ptr<StateSetup> TreeState::getStateSetup() const{
     return _setup;
@@ -69,18 +65,20 @@ boost::shared_ptr<StateSetup> TreeState::getStateSetup() const{
 
 TreeState::TreeState(boost::shared_ptr<StateSetup> setup):
     _setup(setup),
-    _parentIdxToChildList( nrOfIDs(setup), -1 ),
-    _childLists(1, FrameList(nrOfDafs(setup))),
-    _dafIdxToParentIdx( nrOfDafs(setup), getRootIdx(setup) )
+    _data(new Data())
 {
+    _data->parentIdxToChildList.resize( nrOfIDs(setup), -1 );
+    _data->childLists.resize(1, FrameList(nrOfDafs(setup)));
+    _data->dafIdxToParentIdx.resize( nrOfDafs(setup), getRootIdx(setup) );
+
     // initialize child list such that
     const std::vector<Frame*> dafs = setup->getDafs();
     for(int i=0;i<nrOfDafs(setup); i++){
-        _childLists[0].at(i) = dafs[i];
+        _data->childLists[0].at(i) = dafs[i];
     }
     // remember to point the root frame toward its children
     int rootIdx = setup->getChildListIdx(getRoot(setup));
-    _parentIdxToChildList[rootIdx] = 0;
+    _data->parentIdxToChildList[rootIdx] = 0;
 
 }
 
@@ -91,7 +89,7 @@ const Frame* TreeState::getParent(const Frame* frame) const
     // if -1 then frame is not a DAF
     if( dafidx == -1 ) return NULL;
     // next use the idx to get the real frame idx
-    int idx = _dafIdxToParentIdx[dafidx];
+    int idx = _data->dafIdxToParentIdx[dafidx];
     // if -1 then DAF has no parent
     if( idx == -1 ) return NULL;
     return _setup->getFrame(idx);
@@ -107,7 +105,7 @@ Frame* TreeState::getParent(Frame* frame) const
         return NULL;
 
     // next use the idx to get the real frame idx
-    int idx = _dafIdxToParentIdx[dafidx];
+    int idx = _data->dafIdxToParentIdx[dafidx];
     // if -1 then DAF has no parent
     if( idx == -1 )
         return NULL;
@@ -124,11 +122,11 @@ const TreeState::FrameList& TreeState::getChildren(const Frame* frame) const
         return emptyFrameList;
 
     // next use the idx to get the real frame idx
-    const int childlistidx = _parentIdxToChildList[idx];
+    const int childlistidx = _data->parentIdxToChildList[idx];
     if( childlistidx == -1 )
         return emptyFrameList;
 
-    return _childLists[childlistidx];
+    return _data->childLists[childlistidx];
 }
 
 void TreeState::attachFrame(Frame* frame, Frame* parent)
@@ -161,16 +159,22 @@ void TreeState::attachFrame(Frame* frame, Frame* parent)
 
     // check if daf allready has a parent
     Frame *p = getParent(frame);
+    if( p==parent )
+        return; // then we are done
+
+    // the tree structure is about to change, so stop sharing it with copies
+    if( !_data.unique() )
+        _data.reset(new Data(*_data));
+
     if( p != NULL ){
-        if( p==parent) return;// then we are done
         //else remove child from ps list
         int idx = _setup->getChildListIdx(p);
 
-        const int childlistidx = _parentIdxToChildList[idx];
+        const int childlistidx = _data->parentIdxToChildList[idx];
 
         RW_ASSERT(childlistidx!=-1);
 
-        FrameList *childrenList = &_childLists[childlistidx];
+        FrameList *childrenList = &_data->childLists[childlistidx];
         FrameList::iterator iter = childrenList->begin();
         for(;iter!=childrenList->end();++iter){
             if( *iter == frame ) {
@@ -188,14 +192,14 @@ void TreeState::attachFrame(Frame* frame, Frame* parent)
 
     // get the children vector if any else create one
     //FrameList *childrenList = _parentIdxToChildList[idx];
-    int childlistidx = _parentIdxToChildList[idx];
+    int childlistidx = _data->parentIdxToChildList[idx];
     if( childlistidx==-1 ){
-        childlistidx = (int)_childLists.size();
-        _childLists.push_back(FrameList(1,frame));
-        _parentIdxToChildList[idx] = childlistidx;
+        childlistidx = (int)_data->childLists.size();
+        _data->childLists.push_back(FrameList(1,frame));
+        _data->parentIdxToChildList[idx] = childlistidx;
     } else {
-        _childLists[childlistidx].push_back(frame);
+        _data->childLists[childlistidx].push_back(frame);
     }
     // lastly remember to update the _dafToParent map
-    _dafIdxToParentIdx[dafidx] = parent->getID();
+    _data->dafIdxToParentIdx[dafidx] = parent->getID();
 }
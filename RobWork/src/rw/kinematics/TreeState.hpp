@@ -43,7 +43,8 @@ namespace rw { namespace kinematics {
      * Currently modification of the tree structure is not supported. (This
      * implementation simply forwards to the non-public Tree data structure.)
      *
-     * Tree structure states can be copied and assigned freely.
+     * Tree structure states can be copied and assigned freely. Copies share
+     * the tree structure until one of them is modified with attachFrame().
      */
     class TreeState
     {
@@ -130,22 +131,23 @@ namespace rw { namespace kinematics {
         boost::shared_ptr<StateSetup> getStateSetup() const;
 
     private:
-		
-        boost::shared_ptr<StateSetup> _setup;
-
-        // map descring parent to child relationships
-        // size == <nr of Frames>
-        std::vector< int > _parentIdxToChildList;
+        // The tree structure, shared between copies until modified.
+        struct Data {
+            // map descring parent to child relationships
+            // size == <nr of Frames>
+            std::vector< int > parentIdxToChildList;
 
-        // a list of all child-arrays
-        // size == <nr of DAF parents>
-        std::vector< FrameList > _childLists;
+            // a list of all child-arrays
+            // size == <nr of DAF parents>
+            std::vector< FrameList > childLists;
 
-        // map describing child to parent relationships of DAFs
-        // size == <nr of DAFs>
-        std::vector<int> _dafIdxToParentIdx;
-		
+            // map describing child to parent relationships of DAFs
+            // size == <nr of DAFs>
+            std::vector<int> dafIdxToParentIdx;
+        };
 
+        boost::shared_ptr<StateSetup> _setup;
+        boost::shared_ptr<Data> _data;
     };
 
     /*@}*/
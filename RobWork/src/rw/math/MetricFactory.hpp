@@ -82,6 +82,13 @@ namespace rw { namespace math {
         WeightedManhattanMetric(const typename Metric<T>::value_type& weights) :
             _weights(weights)
         {}
+
+        /**
+           @brief The weights of the metric.
+           @return the weights.
+        */
+        const typename Metric<T>::value_type& getWeights() const { return _weights; }
+
     protected:
         typename Metric<T>::scalar_type doDistance(const typename Metric<T>::value_type& q) const{
             return MetricUtil::norm1Weighted(q, _weights);
@@ -145,6 +152,13 @@ namespace rw { namespace math {
         WeightedEuclideanMetric(const typename Metric<T>::value_type& weights) :
             _weights(weights)
         {}
+
+        /**
+           @brief The weights of the metric.
+           @return the weights.
+        */
+        const typename Metric<T>::value_type& getWeights() const { return _weights; }
+
     protected:
         typename Metric<T>::scalar_type doDistance(const typename Metric<T>::value_type& q) const{
             return MetricUtil::norm2Weighted(q, _weights);
@@ -209,6 +223,13 @@ namespace rw { namespace math {
         WeightedInfinityMetric(const typename Metric<T>::value_type& weights) :
             _weights(weights)
         {}
+
+        /**
+           @brief The weights of the metric.
+           @return the weights.
+        */
+        const typename Metric<T>::value_type& getWeights() const { return _weights; }
+
     protected:
         typename Metric<T>::scalar_type doDistance(const typename Metric<T>::value_type& q) const{
             return MetricUtil::normInfWeighted(q, _weights);
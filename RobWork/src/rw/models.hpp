@@ -41,6 +41,7 @@
 #include "./models/JacobianCalculator.hpp"
 #include "./models/Joint.hpp"
 #include "./models/JointDevice.hpp"
+#include "./models/JointDeviceBatchFK.hpp"
 #include "./models/JointDeviceJacobianCalculator.hpp"
 #include "./models/MobileDevice.hpp"
 #include "./models/Models.hpp"
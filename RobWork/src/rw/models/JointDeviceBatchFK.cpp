@@ -0,0 +1,279 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+#include "JointDeviceBatchFK.hpp"
+
+#include "DependentJoint.hpp"
+#include "Joint.hpp"
+#include "PrismaticJoint.hpp"
+#include "RevoluteJoint.hpp"
+
+#include <rw/common/FunctionTask.hpp>
+#include <rw/common/ThreadPool.hpp>
+#include <rw/kinematics/Kinematics.hpp>
+#include <rw/kinematics/StateStructure.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <map>
+#include <typeinfo>
+
+using namespace rw::common;
+using namespace rw::kinematics;
+using namespace rw::math;
+using namespace rw::models;
+
+namespace {
+    typedef JointDeviceBatchFK::TransformArray TransformArray;
+
+    void setIdentity(TransformArray& res) {
+        res.setZero();
+        res.col(0).setOnes();
+        res.col(4).setOnes();
+        res.col(8).setOnes();
+    }
+
+    // res = a * c, where c is the same for all rows
+    void multiply(const TransformArray& a, const Transform3D<>& c, TransformArray& res) {
+        const Rotation3D<>& R = c.R();
+        const Vector3D<>& P = c.P();
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                res.col(3*i+j) = a.col(3*i)*R(0,j) + a.col(3*i+1)*R(1,j) + a.col(3*i+2)*R(2,j);
+            }
+            res.col(9+i) = a.col(3*i)*P[0] + a.col(3*i+1)*P[1] + a.col(3*i+2)*P[2] + a.col(9+i);
+        }
+    }
+
+    void setTransform(TransformArray& res, Eigen::Index row, const Transform3D<>& t) {
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++)
+                res(row, 3*i+j) = t.R()(i,j);
+            res(row, 9+i) = t.P()[i];
+        }
+    }
+}
+
+JointDeviceBatchFK::JointDeviceBatchFK(JointDevice::CPtr device, const State& state):
+    _device(device),
+    _hasGeneral(false),
+    _state(state),
+    _chunkSize(256)
+{
+    RW_ASSERT(device);
+    initialize(std::vector<const Frame*>(1, device->getEnd()), device->getBase(), state);
+}
+
+JointDeviceBatchFK::JointDeviceBatchFK(JointDevice::CPtr device,
+                                       const std::vector<const Frame*>& frames,
+                                       const Frame* root,
+                                       const State& state):
+    _device(device),
+    _hasGeneral(false),
+    _state(state),
+    _chunkSize(256)
+{
+    RW_ASSERT(device);
+    if (root == NULL)
+        root = state.getStateStructure()->getRoot();
+    initialize(frames, root, state);
+}
+
+JointDeviceBatchFK::~JointDeviceBatchFK()
+{
+}
+
+void JointDeviceBatchFK::initialize(const std::vector<const Frame*>& frames,
+                                    const Frame* root,
+                                    const State& state)
+{
+    // Column of each device joint in the configuration matrix
+    std::map<const Frame*, int> qIndices;
+    int qIndex = 0;
+    BOOST_FOREACH(const Joint* joint, _device->getJoints()) {
+        qIndices[joint] = qIndex;
+        qIndex += joint->getDOF();
+    }
+
+    std::map<const Frame*, int> nodeIndices;
+    Node rootNode;
+    rootNode.frame = root;
+    rootNode.type = Root;
+    rootNode.parent = -1;
+    rootNode.qIndex = -1;
+    _nodes.push_back(rootNode);
+    nodeIndices[root] = 0;
+
+    _frames = frames;
+    BOOST_FOREACH(const Frame* frame, frames) {
+        RW_ASSERT(frame);
+        const std::vector<Frame*> chain = Kinematics::reverseChildToParentChain(
+            const_cast<Frame*>(frame), const_cast<Frame*>(root), state);
+
+        int parent = 0;
+        BOOST_FOREACH(const Frame* cframe, chain) {
+            const std::map<const Frame*, int>::const_iterator it = nodeIndices.find(cframe);
+            if (it != nodeIndices.end()) {
+                parent = it->second;
+                continue;
+            }
+
+            Node node;
+            node.frame = cframe;
+            node.parent = parent;
+            node.qIndex = -1;
+            const std::map<const Frame*, int>::const_iterator qIt = qIndices.find(cframe);
+            if (qIt != qIndices.end()) {
+                const RevoluteJoint* const revolute = dynamic_cast<const RevoluteJoint*>(cframe);
+                const PrismaticJoint* const prismatic = dynamic_cast<const PrismaticJoint*>(cframe);
+                if (revolute != NULL && typeid(*cframe) == typeid(RevoluteJoint) && !revolute->hasJointMapping()) {
+                    node.type = Revolute;
+                    node.transform = revolute->getFixedTransform();
+                    node.qIndex = qIt->second;
+                } else if (prismatic != NULL && typeid(*cframe) == typeid(PrismaticJoint) && !prismatic->hasJointMapping()) {
+                    node.type = Prismatic;
+                    node.transform = prismatic->getFixedTransform();
+                    node.qIndex = qIt->second;
+                } else {
+                    node.type = General;
+                }
+            } else if (dynamic_cast<const DependentJoint*>(cframe) != NULL) {
+                node.type = General;
+            } else {
+                node.type = Constant;
+                node.transform = cframe->getTransform(state);
+            }
+            _hasGeneral = _hasGeneral || node.type == General;
+
+            parent = (int)_nodes.size();
+            nodeIndices[cframe] = parent;
+            _nodes.push_back(node);
+        }
+        _frameNodes.push_back(parent);
+    }
+}
+
+std::vector<JointDeviceBatchFK::TransformArray> JointDeviceBatchFK::compute(const Eigen::MatrixXd& qs) const
+{
+    std::vector<TransformArray> result;
+    compute(qs, result);
+    return result;
+}
+
+void JointDeviceBatchFK::compute(const Eigen::MatrixXd& qs, std::vector<TransformArray>& result) const
+{
+    if ((std::size_t)qs.cols() != _device->getDOF())
+        RW_THROW("JointDeviceBatchFK: configurations have " << qs.cols() << " columns, but the device has " << _device->getDOF() << " degrees of freedom.");
+
+    const Eigen::Index n = qs.rows();
+    result.resize(_frames.size());
+    BOOST_FOREACH(TransformArray& transforms, result) {
+        transforms.resize(n, 12);
+    }
+
+    const Eigen::Index chunkSize = (Eigen::Index)_chunkSize;
+    if (_pool == NULL || _pool->getNumberOfThreads() == 0 || n <= chunkSize) {
+        computeChunk(qs, 0, n, result);
+        return;
+    }
+
+    std::vector<boost::function<void()> > work;
+    for (Eigen::Index begin = 0; begin < n; begin += chunkSize) {
+        const Eigen::Index end = std::min(begin + chunkSize, n);
+        work.push_back(boost::bind(&JointDeviceBatchFK::computeChunk, this,
+                                   boost::cref(qs), begin, end, boost::ref(result)));
+    }
+    FunctionTask::runAll(_pool, work);
+}
+
+void JointDeviceBatchFK::computeChunk(const Eigen::MatrixXd& qs, Eigen::Index begin, Eigen::Index end,
+                                      std::vector<TransformArray>& result) const
+{
+    const Eigen::Index n = end - begin;
+    std::vector<TransformArray> transforms(_nodes.size(), TransformArray(n, 12));
+    setIdentity(transforms[0]);
+
+    // work state and configuration buffer for joints that are not vectorized
+    State state;
+    std::vector<double> q;
+    if (_hasGeneral) {
+        state = _state;
+        q.resize(qs.cols());
+    }
+
+    for (std::size_t k = 1; k < _nodes.size(); k++) {
+        const Node& node = _nodes[k];
+        const TransformArray& parent = transforms[node.parent];
+        TransformArray& res = transforms[k];
+        switch (node.type) {
+        case Constant:
+            multiply(parent, node.transform, res);
+            break;
+        case Revolute: {
+            multiply(parent, node.transform, res);
+            const Eigen::ArrayXd qk = qs.col(node.qIndex).segment(begin, n).array();
+            const Eigen::ArrayXd c = qk.cos();
+            const Eigen::ArrayXd s = qk.sin();
+            for (int i = 0; i < 3; i++) {
+                const Eigen::ArrayXd x = res.col(3*i);
+                res.col(3*i) = x*c + res.col(3*i+1)*s;
+                res.col(3*i+1) = res.col(3*i+1)*c - x*s;
+            }
+            break;
+        }
+        case Prismatic: {
+            multiply(parent, node.transform, res);
+            const Eigen::ArrayXd qk = qs.col(node.qIndex).segment(begin, n).array();
+            for (int i = 0; i < 3; i++)
+                res.col(9+i) += qk*res.col(3*i+2);
+            break;
+        }
+        case General:
+            for (Eigen::Index r = 0; r < n; r++) {
+                for (Eigen::Index j = 0; j < qs.cols(); j++)
+                    q[j] = qs(begin + r, j);
+                int qIndex = 0;
+                BOOST_FOREACH(const Joint* joint, _device->getJoints()) {
+                    if (joint->getDOF() > 0) {
+                        joint->setData(state, &q[qIndex]);
+                        qIndex += joint->getDOF();
+                    }
+                }
+                setTransform(res, r, getTransform(parent, r) * node.frame->getTransform(state));
+            }
+            break;
+        case Root:
+            RW_THROW("JointDeviceBatchFK: only the first node can be a root node.");
+        }
+    }
+
+    for (std::size_t f = 0; f < _frameNodes.size(); f++) {
+        result[f].middleRows(begin, n) = transforms[_frameNodes[f]];
+    }
+}
+
+Transform3D<> JointDeviceBatchFK::getTransform(const TransformArray& transforms, Eigen::Index i)
+{
+    const TransformArray& t = transforms;
+    return Transform3D<>(
+        Vector3D<>(t(i,9), t(i,10), t(i,11)),
+        Rotation3D<>(t(i,0), t(i,1), t(i,2),
+                     t(i,3), t(i,4), t(i,5),
+                     t(i,6), t(i,7), t(i,8)));
+}
@@ -0,0 +1,197 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+#ifndef RW_MODELS_JOINTDEVICEBATCHFK_HPP
+#define RW_MODELS_JOINTDEVICEBATCHFK_HPP
+
+/**
+ * @file JointDeviceBatchFK.hpp
+ */
+
+#include "JointDevice.hpp"
+
+#include <rw/kinematics/State.hpp>
+#include <rw/math/Transform3D.hpp>
+
+#include <Eigen/Core>
+
+#include <vector>
+
+namespace rw { namespace common { class ThreadPool; } }
+
+namespace rw { namespace models {
+
+    /** @addtogroup models */
+    /*@{*/
+
+    /**
+     * @brief Forward kinematics of a JointDevice for many configurations at once.
+     *
+     * The configurations are given as a matrix with one configuration per row,
+     * and the transforms of a set of frames relative to a root frame (by
+     * default the end frame relative to the base of the device) are returned
+     * in a structure-of-arrays layout. No State is constructed per configuration.
+     *
+     * At construction the frames between the root and the requested frames are
+     * collected in a small tree. Frames that are not joints of the device are
+     * considered constant and their transforms are taken from the state given
+     * at construction. Plain RevoluteJoint and PrismaticJoint joints (without
+     * a joint mapping) are evaluated for all configurations at once with
+     * vectorized Eigen array expressions. Other joint types, and dependent
+     * joints, are evaluated one configuration at a time through a work state.
+     *
+     * If a ThreadPool is set, the configurations are split in chunks that are
+     * processed in parallel.
+     *
+     * @note The structure of the tree (DAF attachments) and the transforms of
+     * frames that are not device joints are captured at construction.
+     */
+    class JointDeviceBatchFK
+    {
+    public:
+        //! @brief Smart pointer type to JointDeviceBatchFK.
+        typedef rw::common::Ptr<JointDeviceBatchFK> Ptr;
+
+        /**
+         * @brief Transforms for a batch of configurations.
+         *
+         * There is one row per configuration. The columns hold the elements
+         * \f$ R_{00}, R_{01}, R_{02}, R_{10}, \ldots, R_{22}, P_0, P_1, P_2 \f$
+         * such that each element is stored contiguously for all configurations.
+         */
+        typedef Eigen::Array<double, Eigen::Dynamic, 12> TransformArray;
+
+        /**
+         * @brief Batch forward kinematics for the end of \b device relative to
+         * its base.
+         *
+         * @param device [in] the device.
+         * @param state [in] the state giving the tree structure and the
+         * configuration of frames that are not part of the device.
+         */
+        JointDeviceBatchFK(JointDevice::CPtr device, const kinematics::State& state);
+
+        /**
+         * @brief Batch forward kinematics for the frames \b frames relative to
+         * \b root.
+         *
+         * @param device [in] the device.
+         * @param frames [in] the frames to calculate the transforms for.
+         * @param root [in] the frame the transforms are expressed relative
+         * to. It must be a parent of all frames in \b frames. If NULL, the
+         * world frame is used.
+         * @param state [in] the state giving the tree structure and the
+         * configuration of frames that are not part of the device.
+         */
+        JointDeviceBatchFK(JointDevice::CPtr device,
+                           const std::vector<const kinematics::Frame*>& frames,
+                           const kinematics::Frame* root,
+                           const kinematics::State& state);
+
+        //! @brief Destructor.
+        virtual ~JointDeviceBatchFK();
+
+        /**
+         * @brief Set a thread pool used to process the configurations in
+         * parallel.
+         * @param pool [in] the pool, or NULL to process in the calling thread
+         * (default).
+         */
+        void setThreadPool(rw::common::Ptr<rw::common::ThreadPool> pool) { _pool = pool; }
+
+        /**
+         * @brief Set the number of configurations processed as one unit of work.
+         * @param size [in] the chunk size (default is 256).
+         */
+        void setChunkSize(std::size_t size) { _chunkSize = size > 0 ? size : 1; }
+
+        /**
+         * @brief Calculate the transforms for a batch of configurations.
+         *
+         * @param qs [in] matrix with one configuration of the device per row.
+         * @param result [out] one TransformArray per frame (in the order
+         * given at construction), with one row per configuration.
+         */
+        void compute(const Eigen::MatrixXd& qs, std::vector<TransformArray>& result) const;
+
+        /**
+         * @brief Calculate the transforms for a batch of configurations.
+         * @param qs [in] matrix with one configuration of the device per row.
+         * @return one TransformArray per frame.
+         */
+        std::vector<TransformArray> compute(const Eigen::MatrixXd& qs) const;
+
+        /**
+         * @brief The frames that transforms are calculated for.
+         * @return the frames.
+         */
+        const std::vector<const kinematics::Frame*>& getFrames() const { return _frames; }
+
+        /**
+         * @brief Check if all joints between the root and the frames can be
+         * evaluated by the vectorized kernels.
+         * @return true if no configuration is evaluated through a work state.
+         */
+        bool isVectorized() const { return !_hasGeneral; }
+
+        /**
+         * @brief Extract the transform of a single configuration.
+         * @param transforms [in] the transforms.
+         * @param i [in] the configuration (row).
+         * @return the transform.
+         */
+        static math::Transform3D<> getTransform(const TransformArray& transforms, Eigen::Index i);
+
+    private:
+        //! The ways a node in the tree is evaluated.
+        typedef enum { Root, Constant, Revolute, Prismatic, General } NodeType;
+
+        struct Node {
+            const kinematics::Frame* frame;
+            NodeType type;
+            int parent;
+            // column in the configuration matrix for Revolute/Prismatic nodes
+            int qIndex;
+            // fixed transform (Revolute/Prismatic) or constant transform (Constant)
+            math::Transform3D<> transform;
+        };
+
+        void initialize(const std::vector<const kinematics::Frame*>& frames,
+                        const kinematics::Frame* root,
+                        const kinematics::State& state);
+
+        void computeChunk(const Eigen::MatrixXd& qs, Eigen::Index begin, Eigen::Index end,
+                          std::vector<TransformArray>& result) const;
+
+    private:
+        JointDevice::CPtr _device;
+        std::vector<const kinematics::Frame*> _frames;
+        // nodes in topological order, the first node is the root
+        std::vector<Node> _nodes;
+        // the node for each requested frame
+        std::vector<int> _frameNodes;
+        bool _hasGeneral;
+        kinematics::State _state;
+        rw::common::Ptr<rw::common::ThreadPool> _pool;
+        std::size_t _chunkSize;
+    };
+
+    /*@}*/
+}} // end namespaces
+
+#endif // end include guard
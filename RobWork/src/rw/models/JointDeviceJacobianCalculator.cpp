@@ -22,9 +22,13 @@
 
 #include <rw/models/DependentJoint.hpp>
 #include <rw/kinematics/FKTable.hpp>
+#include <rw/common/macros.hpp>
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+#include <map>
+
 using namespace rw::models;
 using namespace rw::kinematics;
 using namespace rw::math;
@@ -113,6 +117,57 @@ JointDeviceJacobianCalculator::JointDeviceJacobianCalculator(/*const std::vector
     BOOST_FOREACH(const Frame* tcp, _tcps) {
         _jacobianSetups.push_back(getJacobianSetups(labeledJoints, tcp, state));
     }
+
+    // Collect the frames from the world to the base and the end-effectors
+    std::map<const Frame*, int> nodeIndices;
+    _baseNode = addPath(_base, state, nodeIndices);
+    BOOST_FOREACH(const Frame* tcp, _tcps) {
+        _tcpNodes.push_back(addPath(tcp, state, nodeIndices));
+    }
+
+    // Joints are ancestors of the end-effectors and thereby already on a path
+    _dependencies.setConstant(_tcps.size(), _dof, false);
+    for (size_t i = 0; i < _tcps.size(); i++) {
+        std::vector<int> nodes;
+        BOOST_FOREACH(const JacobianSetup::value_type& entry, _jacobianSetups[i]) {
+            RW_ASSERT(nodeIndices.find(entry.first) != nodeIndices.end());
+            nodes.push_back(nodeIndices[entry.first]);
+            // dependent joints have no DOF of their own but add to the column of their owner
+            const size_t cols = std::max<size_t>(entry.first->getDOF(), 1);
+            for (size_t j = 0; j < cols && entry.second + j < _dof; j++)
+                _dependencies(i, entry.second + j) = true;
+        }
+        _setupNodes.push_back(nodes);
+    }
+
+    std::vector<Eigen::Triplet<double> > entries;
+    for (size_t j = 0; j < _dof; j++) {
+        for (size_t i = 0; i < _tcps.size(); i++) {
+            if (_dependencies(i, j)) {
+                for (size_t k = 0; k < 6; k++)
+                    entries.push_back(Eigen::Triplet<double>((int)(6*i + k), (int)j, 0.0));
+            }
+        }
+    }
+    _pattern.resize(6 * _tcps.size(), _dof);
+    _pattern.setFromTriplets(entries.begin(), entries.end());
+    _pattern.makeCompressed();
+}
+
+int JointDeviceJacobianCalculator::addPath(const Frame* frame, const State& state, std::map<const Frame*, int>& nodeIndices)
+{
+    const std::map<const Frame*, int>::const_iterator it = nodeIndices.find(frame);
+    if (it != nodeIndices.end())
+        return it->second;
+
+    const Frame* parentFrame = frame->getParent(state);
+    Node node;
+    node.frame = frame;
+    node.parent = parentFrame == NULL ? -1 : addPath(parentFrame, state, nodeIndices);
+    node.daf = parentFrame != NULL && frame->getParent() == NULL;
+    nodeIndices[frame] = (int)_nodes.size();
+    _nodes.push_back(node);
+    return nodeIndices[frame];
 }
 
 
@@ -122,13 +177,73 @@ JointDeviceJacobianCalculator::~JointDeviceJacobianCalculator()
 }
 
 
-//Jacobian JointDeviceJacobianCalculator::get(const FKTable& fk) const {
 Jacobian JointDeviceJacobianCalculator::get(const rw::kinematics::State& state) const {
+    Jacobian jacobian(6 * _tcps.size(), _dof);
+    get(state, jacobian);
+    return jacobian;
+}
+
+void JointDeviceJacobianCalculator::get(const State& state, Jacobian& jacobian) const {
+    if (jacobian.size1() != 6 * _tcps.size() || jacobian.size2() != _dof)
+        jacobian.e().resize(6 * _tcps.size(), _dof);
+    jacobian.e().setZero();
+
+    if (isStructureValid(state))
+        fill(state, jacobian);
+    else
+        fillFromTable(state, jacobian);
+}
+
+void JointDeviceJacobianCalculator::getSparse(const State& state, Eigen::SparseMatrix<double>& jacobian) const {
+    Jacobian dense(6 * _tcps.size(), _dof);
+    get(state, dense);
+
+    if (jacobian.rows() != _pattern.rows() || jacobian.cols() != _pattern.cols()
+        || jacobian.nonZeros() != _pattern.nonZeros() || !jacobian.isCompressed())
+    {
+        jacobian = _pattern;
+    }
+    for (int j = 0; j < jacobian.outerSize(); j++) {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(jacobian, j); it; ++it)
+            it.valueRef() = dense.e()(it.row(), j);
+    }
+}
+
+bool JointDeviceJacobianCalculator::isStructureValid(const State& state) const {
+    BOOST_FOREACH(const Node& node, _nodes) {
+        if (node.daf && node.frame->getParent(state) != _nodes[node.parent].frame)
+            return false;
+    }
+    return true;
+}
+
+void JointDeviceJacobianCalculator::fill(const State& state, Jacobian& jacobian) const {
+    // Forward kinematics for the frames on the paths only, shared by all end-effectors
+    std::vector<Transform3D<> > transforms(_nodes.size());
+    for (size_t k = 0; k < _nodes.size(); k++) {
+        const Node& node = _nodes[k];
+        if (node.parent < 0)
+            transforms[k] = node.frame->getTransform(state);
+        else
+            node.frame->multiplyTransform(transforms[node.parent], state, transforms[k]);
+    }
+
+    for (size_t i = 0; i < _tcps.size(); i++) {
+        const Transform3D<>& tcp = transforms[_tcpNodes[i]];
+        const JacobianSetup& setup = _jacobianSetups[i];
+        const std::vector<int>& nodes = _setupNodes[i];
+        for (size_t k = 0; k < setup.size(); k++) {
+            setup[k].first->getJacobian(6*i, setup[k].second, transforms[nodes[k]], tcp, state, jacobian);
+        }
+    }
+    rotateToBase(transforms[_baseNode].R(), jacobian);
+}
+
+void JointDeviceJacobianCalculator::fillFromTable(const State& state, Jacobian& jacobian) const {
     const rw::kinematics::FKTable fk(state);
-    Jacobian jacobian(Jacobian::zero(6 * _tcps.size(), _dof));
     for (size_t i = 0; i<_tcps.size(); i++) {
         const Frame* tcpFrame = _tcps[i];
-        const JacobianSetup& setup = _jacobianSetups[i];        
+        const JacobianSetup& setup = _jacobianSetups[i];
 
         Transform3D<> tcp = fk.get(*tcpFrame);
         for (std::vector<std::pair<const Joint*, size_t> >::const_iterator it = setup.begin(); it != setup.end(); ++it) {
@@ -136,10 +251,19 @@ Jacobian JointDeviceJacobianCalculator::get(const rw::kinematics::State& state)
             (*it).first->getJacobian(6*i, (*it).second, jointTransform, tcp, state, jacobian);
         }
     }
-
-    const Rotation3D<>& R = fk.get(*_base).R();
-    return inverse(R) * jacobian;
+    rotateToBase(fk.get(*_base).R(), jacobian);
 }
 
-
-
+void JointDeviceJacobianCalculator::rotateToBase(const Rotation3D<>& R, Jacobian& jacobian) const {
+    // Same as inverse(R) * jacobian, but only for the columns that can be non-zero
+    const Rotation3D<>::EigenMatrix3x3 Rinv = R.e().transpose();
+    Jacobian::Base& jac = jacobian.e();
+    for (size_t i = 0; i < _tcps.size(); i++) {
+        for (size_t j = 0; j < _dof; j++) {
+            if (!_dependencies(i, j))
+                continue;
+            jac.block<3,1>(6*i, j) = Rinv*jac.block<3,1>(6*i, j);
+            jac.block<3,1>(6*i+3, j) = Rinv*jac.block<3,1>(6*i+3, j);
+        }
+    }
+}
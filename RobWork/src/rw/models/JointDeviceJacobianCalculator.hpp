@@ -21,6 +21,12 @@
 
 #include "JacobianCalculator.hpp"
 
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include <map>
+#include <vector>
+
 namespace rw { namespace kinematics { class Frame; } }
 namespace rw { namespace kinematics { class State; } }
 namespace rw { namespace models { class Joint; } }
@@ -36,6 +42,17 @@ namespace models {
  *
  * If more than one end-effector is given a "stacked" Jacobian is returned.
  *
+ * At construction the joints that each end-effector depends on are found,
+ * and the frames on the paths from the world to the base and the end-effectors
+ * are collected in a small tree. A Jacobian is then calculated from a single
+ * forward kinematics sweep over these frames only, and only the columns that
+ * an end-effector depends on are filled. For tree and composite devices, where
+ * most columns of each end-effector block are structurally zero, the Jacobian
+ * can also be returned as a sparse matrix with a sparsity pattern fixed at
+ * construction.
+ *
+ * If a DAF on the paths has been attached to another frame since construction,
+ * the calculator falls back to a full forward kinematics table.
  */
 class JointDeviceJacobianCalculator: public JacobianCalculator
 {
@@ -66,6 +83,55 @@ public:
     //virtual math::Jacobian get(const rw::kinematics::FKTable& fk) const;
     virtual rw::math::Jacobian get(const rw::kinematics::State& state) const;
 
+    /**
+     * @brief Calculate the Jacobian for \b state without allocating a new Jacobian.
+     *
+     * The storage of \b jacobian is reused if it already has the right dimensions.
+     * This is useful when Jacobians are calculated at high rates, for instance
+     * in control loops and iterative inverse kinematics.
+     *
+     * @param state [in] State for which to calculate the Jacobian
+     * @param jacobian [out] the Jacobian with dimension (tcps.size() * 6, device.getDOF()).
+     */
+    void get(const rw::kinematics::State& state, rw::math::Jacobian& jacobian) const;
+
+    /**
+     * @brief Calculate the Jacobian for \b state as a sparse matrix.
+     *
+     * The sparsity pattern is given by getDependencies(): the six rows of an
+     * end-effector are stored for the columns of the joints that it depends on.
+     * If \b jacobian already has this pattern, only its values are updated.
+     *
+     * @param state [in] State for which to calculate the Jacobian
+     * @param jacobian [out] the Jacobian in column-major sparse format.
+     */
+    void getSparse(const rw::kinematics::State& state, Eigen::SparseMatrix<double>& jacobian) const;
+
+    /**
+     * @brief The joint to end-effector dependencies.
+     *
+     * Element (i,j) is true if the Jacobian of end-effector i has non-zero
+     * elements in column j. All other blocks of the Jacobian are always zero.
+     *
+     * @return matrix of dimension (tcps.size(), device.getDOF()).
+     */
+    const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic>& getDependencies() const { return _dependencies; }
+
+private:
+    //! A frame on the path from the world to the base or an end-effector.
+    struct Node {
+        const kinematics::Frame* frame;
+        // index of the parent node, or -1 for the world
+        int parent;
+        // true if the frame is a DAF that can be attached elsewhere
+        bool daf;
+    };
+
+    bool isStructureValid(const rw::kinematics::State& state) const;
+    void fill(const rw::kinematics::State& state, rw::math::Jacobian& jacobian) const;
+    void fillFromTable(const rw::kinematics::State& state, rw::math::Jacobian& jacobian) const;
+    void rotateToBase(const rw::math::Rotation3D<>& R, rw::math::Jacobian& jacobian) const;
+    int addPath(const kinematics::Frame* frame, const rw::kinematics::State& state, std::map<const kinematics::Frame*, int>& nodeIndices);
 
 private:
     const kinematics::Frame* _base;
@@ -76,6 +142,14 @@ private:
 
     std::vector<JacobianSetup> _jacobianSetups;
 
+    // nodes in topological order, parents before children
+    std::vector<Node> _nodes;
+    int _baseNode;
+    std::vector<int> _tcpNodes;
+    // node of the joint in each entry of _jacobianSetups
+    std::vector<std::vector<int> > _setupNodes;
+    Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> _dependencies;
+    Eigen::SparseMatrix<double> _pattern;
 
 
 };
@@ -117,6 +117,10 @@ void PrismaticJoint::removeJointMapping() {
 }
 
 
+bool PrismaticJoint::hasJointMapping() const {
+	return dynamic_cast<const PrismaticJointWithQMapping*>(_impl) != NULL;
+}
+
 rw::math::Transform3D<> PrismaticJoint::getTransform(double q) const{
     return _impl->getTransform( q );
 }
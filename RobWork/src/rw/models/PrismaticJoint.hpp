@@ -130,6 +130,12 @@ namespace rw { namespace models {
 		//! @copydoc Joint::removeJointMapping()
 		virtual void removeJointMapping();
 
+		/**
+		 * @brief Check if a mapping of the joint value is set with setJointMapping().
+		 * @return true if the joint value is mapped, false otherwise.
+		 */
+		bool hasJointMapping() const;
+
     protected:
         /**
          * @copydoc rw::kinematics::Frame::doMultiplyTransform
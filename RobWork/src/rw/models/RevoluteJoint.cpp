@@ -200,6 +200,10 @@ void RevoluteJoint::removeJointMapping() {
     delete tmp;	
 }
 
+bool RevoluteJoint::hasJointMapping() const {
+	return dynamic_cast<const RevoluteJointWithQMapping*>(_impl) != NULL;
+}
+
 rw::math::Transform3D<> RevoluteJoint::getTransform(double q) const{
     return _impl->getTransform(q);
 }
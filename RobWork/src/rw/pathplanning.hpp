@@ -27,8 +27,11 @@
 #include "./pathplanning/PlannerConstraint.hpp"
 #include "./pathplanning/PlannerUtil.hpp"
 #include "./pathplanning/QConstraint.hpp"
+#include "./pathplanning/QEdgeCache.hpp"
 #include "./pathplanning/QEdgeConstraint.hpp"
+#include "./pathplanning/QEdgeConstraintContinuous.hpp"
 #include "./pathplanning/QIKSampler.hpp"
+#include "./pathplanning/QNearestNeighbor.hpp"
 #include "./pathplanning/QNormalizer.hpp"
 #include "./pathplanning/QSampler.hpp"
 #include "./pathplanning/QToQPlanner.hpp"
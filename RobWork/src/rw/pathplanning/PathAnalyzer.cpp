@@ -23,6 +23,7 @@
 #include <rw/math/MetricUtil.hpp>
 #include <rw/math/MetricFactory.hpp>
 #include <rw/models/Device.hpp>
+#include <rw/proximity/CollisionDetector.hpp>
 #include <rw/proximity/DistanceCalculator.hpp>
 #include <rw/kinematics/FKRange.hpp>
 
@@ -121,5 +122,41 @@ PathAnalyzer::ClearanceAnalysis PathAnalyzer::analyzeClearance(const QPath& path
     return analysis;
 }
 
+PathAnalyzer::CollisionAnalysis PathAnalyzer::analyzeCollisions(const QPath& path,
+                                                                const CollisionDetector::CPtr& collisionDetector,
+                                                                double resolution) const
+{
+    if (resolution <= 0)
+        RW_THROW("PathAnalyzer: the resolution must be positive.");
+
+    CollisionAnalysis analysis;
+    if (path.empty())
+        return analysis;
+
+    // the segment that each configuration belongs to
+    std::vector<Q> qs;
+    std::vector<std::size_t> segments;
+    qs.push_back(path.front());
+    segments.push_back(0);
+    for (std::size_t i = 1; i < path.size(); i++) {
+        const Q& start = path[i-1];
+        const Q& end = path[i];
+        const std::size_t steps = std::max<std::size_t>(1, (std::size_t)std::ceil((end - start).normInf() / resolution));
+        for (std::size_t j = 1; j <= steps; j++) {
+            qs.push_back(start + (end - start) * ((double)j / steps));
+            segments.push_back(i - 1);
+        }
+    }
+
+    const boost::dynamic_bitset<> colliding = collisionDetector->inCollisionBatch(_device, qs, _state);
+    analysis.samples = qs.size();
+    for (std::size_t i = colliding.find_first(); i != boost::dynamic_bitset<>::npos; i = colliding.find_next(i)) {
+        const std::size_t segment = segments[i];
+        if (analysis.collidingSegments.empty() || analysis.collidingSegments.back() != segment)
+            analysis.collidingSegments.push_back(segment);
+    }
+    return analysis;
+}
+
 
 
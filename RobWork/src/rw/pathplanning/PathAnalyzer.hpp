@@ -29,6 +29,7 @@
  */
 
 namespace rw { namespace models { class Device; } }
+namespace rw { namespace proximity { class CollisionDetector; } }
 namespace rw { namespace proximity { class DistanceCalculator; } }
 
 namespace rw {
@@ -42,9 +43,9 @@ namespace pathplanning {
  * @brief The PathAnalyzer provides a set a basic tools for analyzing a path.
  *
  * Features in the PathAnalyzer include analysis of joint space, Cartesian space,
- * estimation of execution time and measures for clearance. See more details in
+ * estimation of execution time, measures for clearance and collisions. See more details in
  * the result structs PathAnalyzer::JointSpaceAnalysis, PathAnalyzer::CartesianAnalysis,
- * PathAnalyzer::TimeAnalysis and PathAnalyzer::ClearanceAnalysis.
+ * PathAnalyzer::TimeAnalysis, PathAnalyzer::ClearanceAnalysis and PathAnalyzer::CollisionAnalysis.
  */
 class PathAnalyzer
 {
@@ -127,6 +128,21 @@ public:
         }
     };
 
+    /**
+     * @brief Result struct for CollisionAnalysis
+     */
+    struct CollisionAnalysis {
+        /** Number of configurations checked */
+        std::size_t samples;
+        /** Index of the segments (from node i to node i+1) with a configuration in collision */
+        std::vector<std::size_t> collidingSegments;
+
+        /** Construct CollisionAnalysis struct with no samples */
+        CollisionAnalysis() {
+            samples = 0;
+        }
+    };
+
 public:
     /**
      * @brief Construct PathAnalyzer for a specific device
@@ -186,6 +202,23 @@ public:
 	 */
 	ClearanceAnalysis analyzeClearance(const rw::trajectory::QPath& path, const rw::common::Ptr<const rw::proximity::DistanceCalculator>& distanceCalculator);
 
+	/**
+	 * @brief Performs an analysis of collisions along a path
+	 *
+	 * Each segment of the path is discretized by linear interpolation such that no joint moves
+	 * more than \b resolution between two configurations. All configurations of the path are
+	 * checked as one batch with rw::proximity::CollisionDetector::inCollisionBatch, which checks
+	 * them in parallel if the collision detector has a thread pool.
+	 *
+	 * @param path [in] Path to analyze
+	 * @param collisionDetector [in] CollisionDetector to be used in the analysis
+	 * @param resolution [in] the maximum joint step between two checked configurations.
+	 * @return Result of the analysis.
+	 */
+	CollisionAnalysis analyzeCollisions(const rw::trajectory::QPath& path,
+		const rw::common::Ptr<const rw::proximity::CollisionDetector>& collisionDetector,
+		double resolution) const;
+
     //TODO: Move to path statistics
 	/**
 	@brief The length of the path from \b begin up to and excluding \b end.
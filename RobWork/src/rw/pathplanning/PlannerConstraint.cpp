@@ -90,3 +90,7 @@ bool PlannerConstraint::inCollision(const rw::math::Q& q) {
 bool PlannerConstraint::inCollision(const rw::math::Q& q1, const rw::math::Q& q2) {
 	return _edge->inCollision(q1, q2);
 }
+
+boost::dynamic_bitset<> PlannerConstraint::inCollisionBatch(const std::vector<rw::math::Q>& qs, bool stopAtFirst) {
+	return _constraint->inCollisionBatch(qs, stopAtFirst);
+}
@@ -79,6 +79,12 @@ namespace rw { namespace pathplanning {
 		 */
 		bool inCollision(const rw::math::Q& q1, const rw::math::Q& q2);
 
+		/**
+		 * @brief Forwards a batch of configurations to the QConstraint wrapped by the PlannerConstraint
+		 * @see QConstraint::inCollisionBatch
+		 */
+		boost::dynamic_bitset<> inCollisionBatch(const std::vector<rw::math::Q>& qs, bool stopAtFirst = false);
+
         /**
            @brief The configuration constraint.
         */
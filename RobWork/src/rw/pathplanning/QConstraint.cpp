@@ -20,14 +20,27 @@
 #include "QNormalizer.hpp"
 #include "StateConstraint.hpp"
 
+#include <rw/geometry/GeometryUtil.hpp>
+#include <rw/geometry/TriMesh.hpp>
+#include <rw/models/Joint.hpp>
+#include <rw/models/JointDeviceBatchFK.hpp>
 #include <rw/models/Models.hpp>
+#include <rw/models/Object.hpp>
 #include <rw/models/WorkCell.hpp>
 #include <rw/common/macros.hpp>
+#include <rw/kinematics/Kinematics.hpp>
 #include <rw/kinematics/State.hpp>
+#include <rw/proximity/BasicFilterStrategy.hpp>
 #include <rw/proximity/CollisionDetector.hpp>
+#include <rw/proximity/CollisionStrategy.hpp>
+#include <rw/proximity/ProximityStrategyData.hpp>
 #include <boost/foreach.hpp>
 
+#include <map>
+#include <set>
+
 using namespace rw::math;
+using namespace rw::geometry;
 using namespace rw::kinematics;
 using namespace rw::models;
 using namespace rw::common;
@@ -59,6 +72,14 @@ namespace
             return _detector->inCollision(state);
         }
 
+        boost::dynamic_bitset<> doInCollisionBatch(const std::vector<Q>& qs, bool stopAtFirst) const
+        {
+            std::vector<State> states(qs.size(), _state);
+            for (std::size_t i = 0; i < qs.size(); i++)
+                _device->setQ(qs[i], states[i]);
+            return _detector->inCollisionBatch(states, stopAtFirst);
+        }
+
 		void doUpdate(const State& state) {
 			_state = state;			
 		}
@@ -73,6 +94,319 @@ namespace
         State _state;
     };
 
+    // A sphere given in the frame of the geometry. The radius is negative if
+    // the frame is unbounded.
+    struct BoundingSphere {
+        BoundingSphere(): radius(0) {}
+        Vector3D<> center;
+        double radius;
+    };
+
+    bool isSeparated(const Vector3D<>& ca, double ra, const Vector3D<>& cb, double rb)
+    {
+        if (ra < 0 || rb < 0)
+            return false;
+        return (ca - cb).norm2() > ra + rb;
+    }
+
+    class BatchedConstraint : public QConstraint
+    {
+    public:
+        BatchedConstraint(CollisionDetector::Ptr detector,
+            WorkCell::CPtr workcell,
+            JointDevice::CPtr device,
+            const State& state)
+            :
+            _detector(detector),
+            _device(device),
+            _state(state)
+        {
+            RW_ASSERT(detector);
+            RW_ASSERT(workcell);
+            RW_ASSERT(device);
+
+            BOOST_FOREACH(const Object::Ptr& object, workcell->getObjects()) {
+                BOOST_FOREACH(const Geometry::Ptr& geom, object->getGeometry(state)) {
+                    addBoundingSphere(*geom);
+                }
+            }
+            initialize();
+        }
+
+    private:
+        // A frame pair of the broad phase filter. The frame indices refer to
+        // the frames of the batch forward kinematics, or are -1 if the frame
+        // is not moved by the device.
+        struct Pair {
+            FramePair frames;
+            ProximityModel::Ptr a, b;
+            int fa, fb;
+            Transform3D<> wTa, wTb;
+            BoundingSphere sa, sb;
+        };
+
+        void addBoundingSphere(const Geometry& geom)
+        {
+            const Frame* const frame = geom.getFrame();
+            RW_ASSERT(frame);
+            const std::pair<std::map<const Frame*, BoundingSphere>::iterator, bool> inserted =
+                _bounds.insert(std::make_pair(frame, BoundingSphere()));
+            BoundingSphere& sphere = inserted.first->second;
+            if (!inserted.second && sphere.radius < 0)
+                return;
+
+            TriMesh::Ptr mesh;
+            try {
+                mesh = geom.getGeometryData()->getTriMesh(false);
+            } catch (const Exception&) {
+            }
+            if (mesh == NULL || mesh->getSize() == 0) {
+                sphere.radius = -1;
+                return;
+            }
+
+            // Sphere around the axis aligned box of the scaled vertices
+            const double scale = geom.getScale();
+            const Transform3D<>& t3d = geom.getTransform();
+            const std::pair<Vector3D<>, Vector3D<> > box = GeometryUtil::getExtremumDistances(
+                mesh, Transform3D<>(t3d.P() / scale, t3d.R()));
+            const Vector3D<> center = scale * (box.first + box.second) / 2;
+            const double radius = scale * (box.second - box.first).norm2() / 2;
+
+            // Merge with the geometries already added for the frame
+            if (inserted.second) {
+                sphere.center = center;
+                sphere.radius = radius;
+            } else {
+                const Vector3D<> c = (sphere.center + center) / 2;
+                sphere.radius = std::max((sphere.center - c).norm2() + sphere.radius,
+                                         (center - c).norm2() + radius);
+                sphere.center = c;
+            }
+        }
+
+        BoundingSphere getBoundingSphere(const Frame* frame) const
+        {
+            const std::map<const Frame*, BoundingSphere>::const_iterator it = _bounds.find(frame);
+            if (it == _bounds.end()) {
+                BoundingSphere unbounded;
+                unbounded.radius = -1;
+                return unbounded;
+            }
+            return it->second;
+        }
+
+        void initialize()
+        {
+            std::set<const Frame*> joints;
+            BOOST_FOREACH(const Joint* joint, _device->getJoints()) {
+                joints.insert(joint);
+            }
+
+            _staticPairs.clear();
+            _movingPairs.clear();
+            std::vector<const Frame*> frames;
+            std::map<const Frame*, int> frameIndices;
+            const CollisionStrategy::Ptr strategy = _detector->getCollisionStrategy();
+            // The pairs are found once for all configurations, so a filter that
+            // drops pairs depending on the state (such as the
+            // DynamicAABBTreeFilterStrategy) would miss pairs moved by the device.
+            const BasicFilterStrategy::Ptr basic = _detector->getProximityFilterStrategy().cast<BasicFilterStrategy>();
+            if (basic == NULL)
+                RW_THROW("QConstraint::makeBatched requires a collision detector with a BasicFilterStrategy, as the frame pairs are found once for all configurations.");
+            ProximityFilter::Ptr filter = basic->update(_state);
+            while (!filter->isEmpty()) {
+                const FramePair pair = filter->frontAndPop();
+                Pair p;
+                p.frames = pair;
+                if (strategy != NULL) {
+                    p.a = strategy->getModel(pair.first);
+                    p.b = strategy->getModel(pair.second);
+                    if (p.a == NULL || p.b == NULL)
+                        continue;
+                }
+
+                const Frame* const pairFrames[2] = { pair.first, pair.second };
+                int indices[2] = { -1, -1 };
+                for (std::size_t k = 0; k < 2; k++) {
+                    const Frame* const frame = pairFrames[k];
+                    const std::map<const Frame*, int>::const_iterator it = frameIndices.find(frame);
+                    if (it != frameIndices.end()) {
+                        indices[k] = it->second;
+                        continue;
+                    }
+                    // the frame is moved if a joint of the device is a parent
+                    bool moving = false;
+                    for (const Frame* f = frame; f != NULL && !moving; f = f->getParent(_state))
+                        moving = joints.find(f) != joints.end();
+                    if (moving) {
+                        indices[k] = (int)frames.size();
+                        frames.push_back(frame);
+                    }
+                    frameIndices[frame] = indices[k];
+                }
+
+                p.fa = indices[0];
+                p.fb = indices[1];
+                if (p.fa < 0)
+                    p.wTa = Kinematics::worldTframe(pair.first, _state);
+                if (p.fb < 0)
+                    p.wTb = Kinematics::worldTframe(pair.second, _state);
+                p.sa = getBoundingSphere(pair.first);
+                p.sb = getBoundingSphere(pair.second);
+                if (p.fa < 0 && p.fb < 0)
+                    _staticPairs.push_back(p);
+                else
+                    _movingPairs.push_back(p);
+            }
+
+            _fk = ownedPtr(new JointDeviceBatchFK(_device, frames, NULL, _state));
+            _frameBounds.clear();
+            BOOST_FOREACH(const Frame* frame, frames) {
+                _frameBounds.push_back(getBoundingSphere(frame));
+            }
+        }
+
+        bool inCollision(const Pair& pair,
+                         const Transform3D<>& wTa,
+                         const Transform3D<>& wTb,
+                         ProximityStrategyData& data) const
+        {
+            const CollisionStrategy::Ptr strategy = _detector->getCollisionStrategy();
+            const bool res = strategy == NULL || strategy->inCollision(pair.a, wTa, pair.b, wTb, data);
+            if (res && _log != NULL)
+                _log->debug() << "Colliding: " << pair.frames.first->getName() << " -- " << pair.frames.second->getName() << std::endl;
+            return res;
+        }
+
+        bool doInCollision(const Q& q) const
+        {
+            return doInCollisionBatch(std::vector<Q>(1, q), true).test(0);
+        }
+
+        boost::dynamic_bitset<> doInCollisionBatch(const std::vector<Q>& qs, bool stopAtFirst) const
+        {
+            const std::size_t n = qs.size();
+            boost::dynamic_bitset<> res(n);
+            if (n == 0)
+                return res;
+
+            ProximityStrategyData data;
+            data.setCollisionQueryType(CollisionStrategy::FirstContact);
+
+            // pairs that are not moved by the device give the same result for all
+            // configurations
+            BOOST_FOREACH(const Pair& pair, _staticPairs) {
+                if (isSeparated(pair.wTa * pair.sa.center, pair.sa.radius, pair.wTb * pair.sb.center, pair.sb.radius))
+                    continue;
+                if (inCollision(pair, pair.wTa, pair.wTb, data)) {
+                    if (stopAtFirst)
+                        res.set(0);
+                    else
+                        res.set();
+                    return res;
+                }
+            }
+            if (_movingPairs.empty())
+                return res;
+
+            const std::size_t dof = _device->getDOF();
+            _qs.resize(n, dof);
+            for (std::size_t i = 0; i < n; i++) {
+                RW_ASSERT(qs[i].size() == dof);
+                for (std::size_t j = 0; j < dof; j++)
+                    _qs(i, j) = qs[i](j);
+            }
+            _fk->compute(_qs, _transforms);
+
+            // The centers of the bounding spheres for all configurations, and the
+            // sphere bounding each frame over the batch
+            _centers.resize(_transforms.size());
+            std::vector<BoundingSphere> swept(_transforms.size());
+            for (std::size_t f = 0; f < _transforms.size(); f++) {
+                const BoundingSphere& sphere = _frameBounds[f];
+                if (sphere.radius < 0) {
+                    swept[f].radius = -1;
+                    continue;
+                }
+                const JointDeviceBatchFK::TransformArray& t = _transforms[f];
+                const Vector3D<>& c = sphere.center;
+                Eigen::Array<double, Eigen::Dynamic, 3>& centers = _centers[f];
+                centers.resize(n, 3);
+                for (int k = 0; k < 3; k++)
+                    centers.col(k) = t.col(3*k)*c[0] + t.col(3*k+1)*c[1] + t.col(3*k+2)*c[2] + t.col(9+k);
+
+                const Eigen::Array<double, 1, 3> mid = (centers.colwise().minCoeff() + centers.colwise().maxCoeff()) / 2;
+                swept[f].center = Vector3D<>(mid(0), mid(1), mid(2));
+                swept[f].radius = std::sqrt((centers.rowwise() - mid).square().rowwise().sum().maxCoeff()) + sphere.radius;
+            }
+
+            std::vector<const Pair*> active;
+            BOOST_FOREACH(const Pair& pair, _movingPairs) {
+                const BoundingSphere sa = pair.fa < 0 ? BoundingSphere() : swept[pair.fa];
+                const BoundingSphere sb = pair.fb < 0 ? BoundingSphere() : swept[pair.fb];
+                const Vector3D<> ca = pair.fa < 0 ? pair.wTa * pair.sa.center : sa.center;
+                const Vector3D<> cb = pair.fb < 0 ? pair.wTb * pair.sb.center : sb.center;
+                if (!isSeparated(ca, pair.fa < 0 ? pair.sa.radius : sa.radius, cb, pair.fb < 0 ? pair.sb.radius : sb.radius))
+                    active.push_back(&pair);
+            }
+
+            for (std::size_t i = 0; i < n && !active.empty(); i++) {
+                BOOST_FOREACH(const Pair* pair, active) {
+                    if (pair->sa.radius >= 0 && pair->sb.radius >= 0) {
+                        const Vector3D<> ca = pair->fa < 0 ? pair->wTa * pair->sa.center : getCenter(pair->fa, i);
+                        const Vector3D<> cb = pair->fb < 0 ? pair->wTb * pair->sb.center : getCenter(pair->fb, i);
+                        if (isSeparated(ca, pair->sa.radius, cb, pair->sb.radius))
+                            continue;
+                    }
+                    const Transform3D<> wTa = pair->fa < 0 ? pair->wTa : JointDeviceBatchFK::getTransform(_transforms[pair->fa], i);
+                    const Transform3D<> wTb = pair->fb < 0 ? pair->wTb : JointDeviceBatchFK::getTransform(_transforms[pair->fb], i);
+                    if (inCollision(*pair, wTa, wTb, data)) {
+                        res.set(i);
+                        break;
+                    }
+                }
+                if (stopAtFirst && res.test(i))
+                    return res;
+            }
+            return res;
+        }
+
+        Vector3D<> getCenter(int frame, std::size_t i) const
+        {
+            const Eigen::Array<double, Eigen::Dynamic, 3>& centers = _centers[frame];
+            return Vector3D<>(centers(i, 0), centers(i, 1), centers(i, 2));
+        }
+
+		void doUpdate(const State& state) {
+			_state = state;
+			initialize();
+		}
+
+		void doSetLog(Log::Ptr log) {
+			_log = log;
+		}
+
+    private:
+		CollisionDetector::Ptr _detector;
+		JointDevice::CPtr _device;
+        State _state;
+        std::map<const Frame*, BoundingSphere> _bounds;
+
+        std::vector<Pair> _staticPairs;
+        std::vector<Pair> _movingPairs;
+        JointDeviceBatchFK::Ptr _fk;
+        // the bounding spheres of the frames of the batch forward kinematics
+        std::vector<BoundingSphere> _frameBounds;
+
+        // work buffers
+        mutable Eigen::MatrixXd _qs;
+        mutable std::vector<JointDeviceBatchFK::TransformArray> _transforms;
+        mutable std::vector<Eigen::Array<double, Eigen::Dynamic, 3> > _centers;
+
+		Log::Ptr _log;
+    };
+
     class MergedConstraints : public QConstraint
     {
     public:
@@ -91,6 +425,27 @@ namespace
             return false;
         }
 
+        boost::dynamic_bitset<> doInCollisionBatch(const std::vector<Q>& qs, bool stopAtFirst) const
+        {
+			boost::dynamic_bitset<> res(qs.size());
+			BOOST_FOREACH(const QConstraint::Ptr& sc, _constraints) {
+				if (stopAtFirst && res.any()) {
+					// only the configurations before the first known collision need to be checked
+					const std::vector<Q> remaining(qs.begin(), qs.begin() + res.find_first());
+					if (remaining.empty())
+						break;
+					boost::dynamic_bitset<> sub = sc->inCollisionBatch(remaining, true);
+					if (sub.any()) {
+						res.reset();
+						res.set(sub.find_first());
+					}
+				} else {
+					res |= sc->inCollisionBatch(qs, stopAtFirst);
+				}
+			}
+			return res;
+        }
+
 		void doUpdate(const rw::kinematics::State& state) {
 			BOOST_FOREACH(const QConstraint::Ptr& sc, _constraints) {
 				sc->update(state);
@@ -126,6 +481,15 @@ namespace
             return _constraint->inCollision(q);
         }
 
+        boost::dynamic_bitset<> doInCollisionBatch(const std::vector<Q>& raw_qs, bool stopAtFirst) const
+        {
+            std::vector<Q> qs = raw_qs;
+            BOOST_FOREACH(Q& q, qs) {
+                _normalizer.setFromNormalized(q);
+            }
+            return _constraint->inCollisionBatch(qs, stopAtFirst);
+        }
+
 		void doSetLog(Log::Ptr log) {
 			_constraint->setLog(log);
 		}
@@ -190,6 +554,24 @@ bool QConstraint::inCollision(const rw::math::Q& q) const
     return doInCollision(q);
 }
 
+boost::dynamic_bitset<> QConstraint::inCollisionBatch(const std::vector<Q>& qs, bool stopAtFirst) const
+{
+    return doInCollisionBatch(qs, stopAtFirst);
+}
+
+boost::dynamic_bitset<> QConstraint::doInCollisionBatch(const std::vector<Q>& qs, bool stopAtFirst) const
+{
+    boost::dynamic_bitset<> res(qs.size());
+    for (std::size_t i = 0; i < qs.size(); i++) {
+        if (inCollision(qs[i])) {
+            res.set(i);
+            if (stopAtFirst)
+                break;
+        }
+    }
+    return res;
+}
+
 void QConstraint::setLog(rw::common::Log::Ptr log) {
 	doSetLog(log);
 }
@@ -225,6 +607,14 @@ QConstraint::Ptr QConstraint::make(rw::common::Ptr<CollisionDetector> detector,
         state);
 }
 
+QConstraint::Ptr QConstraint::makeBatched(CollisionDetector::Ptr detector,
+	WorkCell::CPtr workcell,
+	JointDevice::CPtr device,
+    const State& state)
+{
+    return ownedPtr(new BatchedConstraint(detector, workcell, device, state));
+}
+
 QConstraint::Ptr QConstraint::makeMerged(
 	const std::vector<QConstraint::Ptr>& constraints)
 {
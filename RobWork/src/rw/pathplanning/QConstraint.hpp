@@ -27,7 +27,12 @@
 #include <rw/common/Ptr.hpp>
 #include <rw/models/Device.hpp>
 
+#include <boost/dynamic_bitset.hpp>
+
+#include <vector>
+
 namespace rw { namespace kinematics { class State; } }
+namespace rw { namespace models { class JointDevice; class WorkCell; } }
 namespace rw { namespace proximity { class CollisionDetector; } }
 
 namespace rw { namespace pathplanning {
@@ -73,6 +78,22 @@ namespace rw { namespace pathplanning {
         */
         bool inCollision(const rw::math::Q& q) const;
 
+        /**
+           @brief Check a batch of device configurations.
+
+           The configurations are checked in one call to the constraint, which
+           allows constraints based on a rw::proximity::CollisionDetector to
+           check them in parallel.
+
+           @param qs [in] the configurations to check.
+           @param stopAtFirst [in] if true, the checking stops at the first
+           configuration in collision and only the bit of this configuration
+           is set.
+           @return bitset where bit i is set if configuration i is in collision.
+        */
+        boost::dynamic_bitset<> inCollisionBatch(const std::vector<rw::math::Q>& qs,
+                                                 bool stopAtFirst = false) const;
+
         /**
            @brief A fixed constraint.
 
@@ -104,6 +125,45 @@ namespace rw { namespace pathplanning {
 			rw::models::Device::CPtr device,
             const rw::kinematics::State& state);
 
+        /**
+           @brief Map a collision detector to a configuration constraint that
+           checks batches of configurations with batch forward kinematics.
+
+           The transforms of the frames moved by \b device are calculated for
+           all configurations of a batch at once with
+           rw::models::JointDeviceBatchFK, and no State is created per
+           configuration. The frame pairs of the broad phase filter of \b
+           detector are then culled for the whole batch by comparing the
+           spheres that bound each frame over all configurations of the batch.
+           The pairs that remain are culled by the bounding spheres of each
+           configuration before the narrow phase strategy of \b detector
+           checks them. Pairs of frames that are not moved by the device are
+           checked once per batch.
+
+           The bounding spheres are calculated from the geometry of the
+           objects of \b workcell. Frames without a triangle mesh are never
+           culled.
+
+           The frame pairs are found once for all configurations, so the
+           broad phase filter of \b detector must be a
+           rw::proximity::BasicFilterStrategy, which does not depend on the
+           state. An exception is thrown for other filters, such as
+           rw::proximity::DynamicAABBTreeFilterStrategy.
+
+           @param detector [in] the collision detector.
+           @param workcell [in] the workcell with the geometry.
+           @param device [in] the device.
+           @param state [in] the state of the rest of the workcell.
+
+           @note The constraint keeps work buffers between calls and must not
+           be used by several threads at a time.
+        */
+		static QConstraint::Ptr makeBatched(
+			rw::common::Ptr<rw::proximity::CollisionDetector> detector,
+			rw::common::Ptr<const rw::models::WorkCell> workcell,
+			rw::common::Ptr<const rw::models::JointDevice> device,
+            const rw::kinematics::State& state);
+
         /**
            @brief Combine a set of configuration constraints into a single
            configuration constraint.
@@ -158,6 +218,14 @@ namespace rw { namespace pathplanning {
         */
         virtual bool doInCollision(const rw::math::Q& q) const = 0;
 
+        /**
+           @brief Subclass implementation of the inCollisionBatch() method.
+
+           The default implementation calls inCollision() for each configuration.
+        */
+        virtual boost::dynamic_bitset<> doInCollisionBatch(const std::vector<rw::math::Q>& qs,
+                                                           bool stopAtFirst) const;
+
         /**
          * @brief Set a log.
          * @param log [in] the log.
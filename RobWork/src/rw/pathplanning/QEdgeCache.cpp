@@ -0,0 +1,198 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#include "QEdgeCache.hpp"
+
+#include <rw/common/macros.hpp>
+
+#include <boost/functional/hash.hpp>
+
+#include <cmath>
+
+using namespace rw::common;
+using namespace rw::math;
+using namespace rw::pathplanning;
+
+QEdgeCache::QEdgeCache(std::size_t capacity, double quantization):
+    _capacity(capacity),
+    _quantization(quantization),
+    _hits(0),
+    _misses(0)
+{
+    if (quantization <= 0)
+        RW_THROW("QEdgeCache: the quantization must be positive.");
+}
+
+QEdgeCache::~QEdgeCache()
+{
+}
+
+QEdgeCache::Ptr QEdgeCache::getInstance()
+{
+    static const QEdgeCache::Ptr instance = ownedPtr(new QEdgeCache());
+    return instance;
+}
+
+boost::uint64_t QEdgeCache::makeSetupId()
+{
+    static boost::mutex mutex;
+    static boost::uint64_t next = 1;
+    boost::mutex::scoped_lock lock(mutex);
+    return next++;
+}
+
+std::size_t QEdgeCache::KeyHash::operator()(const Key& key) const
+{
+    std::size_t seed = boost::hash_range(key.coordinates.begin(), key.coordinates.end());
+    boost::hash_combine(seed, key.setup);
+    return seed;
+}
+
+QEdgeCache::Key QEdgeCache::makeKey(boost::uint64_t setup, const Q& start, const Q& end) const
+{
+    Key key;
+    key.setup = setup;
+    key.coordinates.resize(start.size() + end.size());
+    for (std::size_t i = 0; i < start.size(); i++)
+        key.coordinates[i] = (boost::int64_t)std::floor(start[i]/_quantization + 0.5);
+    for (std::size_t i = 0; i < end.size(); i++)
+        key.coordinates[start.size() + i] = (boost::int64_t)std::floor(end[i]/_quantization + 0.5);
+    return key;
+}
+
+QEdgeCache::Entry* QEdgeCache::find(const Key& key)
+{
+    const EntryMap::iterator it = _map.find(key);
+    if (it == _map.end())
+        return NULL;
+    // move the entry to the front of the list
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return &_entries.front();
+}
+
+void QEdgeCache::insert(const Entry& entry)
+{
+    if (_capacity == 0)
+        return;
+    _entries.push_front(entry);
+    _map[entry.key] = _entries.begin();
+    while (_entries.size() > _capacity) {
+        _map.erase(_entries.back().key);
+        _entries.pop_back();
+    }
+}
+
+QEdgeCache::Status QEdgeCache::get(boost::uint64_t setup, const Q& start, const Q& end, double* resolution)
+{
+    const Key key = makeKey(setup, start, end);
+    boost::mutex::scoped_lock lock(_mutex);
+    const Entry* const entry = find(key);
+    if (entry == NULL) {
+        _misses++;
+        return Unknown;
+    }
+    _hits++;
+    if (entry->blocked)
+        return Blocked;
+    if (resolution != NULL)
+        *resolution = entry->resolution;
+    return Free;
+}
+
+void QEdgeCache::setFree(boost::uint64_t setup, const Q& start, const Q& end, double resolution)
+{
+    Entry entry;
+    entry.key = makeKey(setup, start, end);
+    entry.blocked = false;
+    entry.resolution = resolution;
+
+    boost::mutex::scoped_lock lock(_mutex);
+    Entry* const existing = find(entry.key);
+    if (existing == NULL)
+        insert(entry);
+    else if (!existing->blocked && resolution < existing->resolution)
+        existing->resolution = resolution;
+}
+
+void QEdgeCache::setBlocked(boost::uint64_t setup, const Q& start, const Q& end)
+{
+    Entry entry;
+    entry.key = makeKey(setup, start, end);
+    entry.blocked = true;
+    entry.resolution = 0;
+
+    boost::mutex::scoped_lock lock(_mutex);
+    Entry* const existing = find(entry.key);
+    if (existing == NULL)
+        insert(entry);
+    else
+        existing->blocked = true;
+}
+
+int QEdgeCache::getVerifiedLevel(double cached, double resolution)
+{
+    const double eps = 1e-9;
+    if (cached <= resolution*(1 + eps))
+        return 0;
+    const int k = (int)std::floor(std::log(cached/resolution)/std::log(2.0) + 0.5);
+    if (std::fabs(cached - resolution*std::pow(2.0, k)) > eps*cached)
+        return -1;
+    return k;
+}
+
+void QEdgeCache::clear()
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    _entries.clear();
+    _map.clear();
+}
+
+std::size_t QEdgeCache::size() const
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    return _entries.size();
+}
+
+std::size_t QEdgeCache::getCapacity() const
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    return _capacity;
+}
+
+void QEdgeCache::setCapacity(std::size_t capacity)
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    _capacity = capacity;
+    while (_entries.size() > _capacity) {
+        _map.erase(_entries.back().key);
+        _entries.pop_back();
+    }
+}
+
+unsigned long QEdgeCache::getHits() const
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    return _hits;
+}
+
+unsigned long QEdgeCache::getMisses() const
+{
+    boost::mutex::scoped_lock lock(_mutex);
+    return _misses;
+}
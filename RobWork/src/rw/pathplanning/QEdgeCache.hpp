@@ -0,0 +1,227 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#ifndef RW_PATHPLANNING_QEDGECACHE_HPP
+#define RW_PATHPLANNING_QEDGECACHE_HPP
+
+/**
+   @file QEdgeCache.hpp
+*/
+
+#include <rw/common/Ptr.hpp>
+#include <rw/math/Q.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <list>
+#include <vector>
+
+namespace rw { namespace pathplanning {
+
+    /** @addtogroup pathplanning */
+    /** @{*/
+
+    /**
+       @brief Bounded cache of the results of checking straight line edges
+       between pairs of configurations.
+
+       An edge is identified by a setup id and its start and end
+       configurations. The setup id identifies the configuration constraint,
+       the metric the resolution is measured by, and the state of the obstacles
+       that the results are valid for. A new id must be used whenever any of
+       these change (see makeSetupId()). The cache cannot detect such changes
+       itself, so a setup id that is reused after the ProximitySetup, the
+       geometries or the obstacles have changed gives stale results.
+
+       The configurations are quantized before they are compared, such that
+       configurations closer than the quantization are considered equal.
+
+       For an edge that is not in collision, the cache stores the coarsest
+       spacing at which the edge has been verified: The configurations
+       \f$ start + k r \cdot (end - start)/|end - start| \f$ for all
+       integers \f$ k \geq 1 \f$ with \f$ k r \leq |end - start| \f$ have been
+       verified free for the resolution \f$ r \f$. This allows an edge
+       constraint that checks the edge in levels of increasing resolution to
+       resume from the finest level found in the cache.
+
+       When the cache is full, the least recently used edge is removed.
+
+       The cache is thread-safe.
+    */
+    class QEdgeCache
+    {
+    public:
+        //! @brief smart pointer type to this class
+        typedef rw::common::Ptr<QEdgeCache> Ptr;
+
+        //! @brief What is known about an edge.
+        enum Status {
+            Unknown, //!< Nothing is known about the edge.
+            Free, //!< The edge has been verified free up to a resolution.
+            Blocked //!< The edge is in collision.
+        };
+
+        /**
+           @brief Construct an empty cache.
+           @param capacity [in] the maximum number of edges in the cache.
+           @param quantization [in] the configurations are rounded to a
+           multiple of this value.
+        */
+        QEdgeCache(std::size_t capacity = 100000, double quantization = 1e-6);
+
+        //! @brief Destructor
+        virtual ~QEdgeCache();
+
+        /**
+           @brief The process-wide cache used by the edge constraints if no
+           other cache is given.
+        */
+        static QEdgeCache::Ptr getInstance();
+
+        /**
+           @brief Get a setup id that has not been returned before.
+
+           Setups that are not shared with other planners can use a new id,
+           and should take a new id whenever the obstacles change.
+        */
+        static boost::uint64_t makeSetupId();
+
+        /**
+           @brief Look up an edge.
+           @param setup [in] the setup id.
+           @param start [in] the start configuration.
+           @param end [in] the end configuration.
+           @param resolution [out] if non-NULL and the status is Free, the
+           resolution the edge has been verified at.
+           @return the status of the edge.
+        */
+        Status get(boost::uint64_t setup,
+                   const rw::math::Q& start,
+                   const rw::math::Q& end,
+                   double* resolution = NULL);
+
+        /**
+           @brief Store that an edge has been verified free at a resolution.
+
+           If the edge is already known at a finer resolution or known to be in
+           collision, the cache is not changed.
+
+           @param setup [in] the setup id.
+           @param start [in] the start configuration.
+           @param end [in] the end configuration.
+           @param resolution [in] the resolution.
+        */
+        void setFree(boost::uint64_t setup,
+                     const rw::math::Q& start,
+                     const rw::math::Q& end,
+                     double resolution);
+
+        /**
+           @brief Store that an edge is in collision.
+           @param setup [in] the setup id.
+           @param start [in] the start configuration.
+           @param end [in] the end configuration.
+        */
+        void setBlocked(boost::uint64_t setup,
+                        const rw::math::Q& start,
+                        const rw::math::Q& end);
+
+        //! @brief Remove all edges.
+        void clear();
+
+        /**
+           @brief The number of levels of an edge checked in levels of
+           doubling resolution that a cached resolution corresponds to.
+
+           @param cached [in] the resolution found in the cache.
+           @param resolution [in] the finest resolution the edge is checked
+           at.
+           @return 0 if \b cached is at least as fine as \b resolution,
+           \f$ k \f$ if \b cached is \f$ 2^k \f$ times \b resolution, and -1
+           otherwise (no level has been verified).
+        */
+        static int getVerifiedLevel(double cached, double resolution);
+
+        //! @brief The number of edges in the cache.
+        std::size_t size() const;
+
+        //! @brief The maximum number of edges in the cache.
+        std::size_t getCapacity() const;
+
+        /**
+           @brief Set the maximum number of edges in the cache.
+
+           If the cache holds more edges, the least recently used edges are
+           removed.
+
+           @param capacity [in] the capacity.
+        */
+        void setCapacity(std::size_t capacity);
+
+        //! @brief The number of look ups that found the edge.
+        unsigned long getHits() const;
+
+        //! @brief The number of look ups that did not find the edge.
+        unsigned long getMisses() const;
+
+    private:
+        struct Key {
+            boost::uint64_t setup;
+            std::vector<boost::int64_t> coordinates;
+            bool operator==(const Key& other) const {
+                return setup == other.setup && coordinates == other.coordinates;
+            }
+        };
+
+        struct KeyHash {
+            std::size_t operator()(const Key& key) const;
+        };
+
+        struct Entry {
+            Key key;
+            bool blocked;
+            double resolution;
+        };
+
+        typedef std::list<Entry> EntryList;
+        typedef boost::unordered_map<Key, EntryList::iterator, KeyHash> EntryMap;
+
+        Key makeKey(boost::uint64_t setup, const rw::math::Q& start, const rw::math::Q& end) const;
+        Entry* find(const Key& key);
+        void insert(const Entry& entry);
+
+        std::size_t _capacity;
+        double _quantization;
+        // the most recently used entry is first
+        EntryList _entries;
+        EntryMap _map;
+        unsigned long _hits;
+        unsigned long _misses;
+        mutable boost::mutex _mutex;
+
+        QEdgeCache(const QEdgeCache&);
+        QEdgeCache& operator=(const QEdgeCache&);
+    };
+
+    /* @} */
+}} // end namespaces
+
+#endif // end include guard
@@ -18,6 +18,7 @@
 
 #include "QEdgeConstraint.hpp"
 #include "PlannerUtil.hpp"
+#include "QEdgeCache.hpp"
 #include <rw/math/Math.hpp>
 #include <rw/models/Device.hpp>
 
@@ -41,12 +42,15 @@ namespace
     public:
         ExpandedBinary(rw::common::Ptr<QConstraint> constraint,
 				QMetric::CPtr metric,
-				double resolution)
+				double resolution,
+				QEdgeCache::Ptr cache = NULL,
+				boost::uint64_t setup = 0)
             :
             _metric(metric),
             _resolution(resolution),
-            _constraint(constraint)
-            
+            _constraint(constraint),
+            _cache(cache),
+            _setup(setup)
         {
             if (resolution <= 0)
                 RW_THROW("Unable to create constraint with resolution<=0");
@@ -80,23 +84,46 @@ namespace
             int maxPos = (int)floor(len1 / _resolution);
 			int maxLevel = Math::ceilLog2(maxPos + 1);
             int level = 1;
-            
+
+			// Skip the levels verified by earlier checks of the same edge. After
+			// level l the spacing of the checked positions is 2^(maxLevel - l)
+			// steps.
+			if (_cache != NULL && level <= maxLevel) {
+				double resolution;
+				const QEdgeCache::Status status = _cache->get(_setup, start, end, &resolution);
+				if (status == QEdgeCache::Blocked)
+					return true;
+				if (status == QEdgeCache::Free) {
+					const int k = QEdgeCache::getVerifiedLevel(resolution, _resolution);
+					if (k == 0)
+						return false;
+					if (k > 0 && k < maxLevel)
+						level = maxLevel - k + 1;
+				}
+			}
+
+			// The configurations of a level are checked as one batch, so the
+			// constraint can check them in parallel.
 			Q dir = (end - start) / len1;
+			std::vector<Q> qs;
 			while (level <= maxLevel) {
 				int pos = 1 << (maxLevel - level);
 				const int step = 2 * pos;
 
+				qs.clear();
 				while (pos <= maxPos) {
-					const Q q = start + (pos * _resolution) * dir;
-
-					if (_constraint->inCollision(q)) {
-						return true;
-					} else {
-						pos += step;
-					}
+					qs.push_back(start + (pos * _resolution) * dir);
+					pos += step;
+				}
+				if (_constraint->inCollisionBatch(qs, true).any()) {
+					if (_cache != NULL)
+						_cache->setBlocked(_setup, start, end);
+					return true;
 				}
-				level += 1;			
-			} 
+				if (_cache != NULL)
+					_cache->setFree(_setup, start, end, _resolution * (1 << (maxLevel - level)));
+				level += 1;
+			}
 			return false;
 
         }
@@ -105,6 +132,67 @@ namespace
 		QMetric::CPtr _metric;
         double _resolution;
         rw::common::Ptr<QConstraint> _constraint;
+        QEdgeCache::Ptr _cache;
+        boost::uint64_t _setup;
+    };
+
+    class BisectionBatched: public QEdgeConstraint
+    {
+    public:
+        BisectionBatched(rw::common::Ptr<QConstraint> constraint,
+				QMetric::CPtr metric,
+				double resolution,
+				std::size_t batchSize)
+            :
+            _metric(metric),
+            _resolution(resolution),
+            _constraint(constraint),
+            _batchSize(batchSize)
+        {
+            if (resolution <= 0)
+                RW_THROW("Unable to create constraint with resolution<=0");
+            if (batchSize == 0)
+                RW_THROW("Unable to create constraint with batch size 0");
+        }
+
+    private:
+		bool doInCollision(const Q& start, const Q& end) const
+        {
+            // The positions 1 ... maxPos are numbered as for ExpandedBinary.
+            // Position k of the van der Corput sequence is k with the maxLevel
+            // bits reversed, which visits the positions of level 1, 2, ...
+            // in turn and spreads the positions of each level over the edge.
+            const double len = _metric->distance(start, end);
+            const int maxPos = (int)floor(len / _resolution);
+            const int maxLevel = Math::ceilLog2(maxPos + 1);
+
+            const Q dir = (end - start) / len;
+            std::vector<Q> qs;
+            qs.reserve(_batchSize);
+            for (int k = 1; k < (1 << maxLevel); k++) {
+                int pos = 0;
+                for (int bit = 0; bit < maxLevel; bit++) {
+                    if (k & (1 << bit))
+                        pos |= 1 << (maxLevel - 1 - bit);
+                }
+                if (pos > maxPos)
+                    continue;
+
+                qs.push_back(start + (pos * _resolution) * dir);
+                if (qs.size() == _batchSize) {
+                    if (_constraint->inCollisionBatch(qs, true).any())
+                        return true;
+                    qs.clear();
+                }
+            }
+            return !qs.empty() && _constraint->inCollisionBatch(qs, true).any();
+        }
+
+    private:
+		QMetric::CPtr _metric;
+        double _resolution;
+        rw::common::Ptr<QConstraint> _constraint;
+        std::size_t _batchSize;
     };
 
 	class MergedEdgeConstraint: public QEdgeConstraint {
@@ -133,6 +221,25 @@ QEdgeConstraint::Ptr QEdgeConstraint::make(rw::common::Ptr<QConstraint> constrai
     return ownedPtr(new ExpandedBinary(constraint, metric, resolution));
 }
 
+QEdgeConstraint::Ptr QEdgeConstraint::makeCached(rw::common::Ptr<QConstraint> constraint,
+	QMetric::CPtr metric,
+    double resolution,
+    boost::uint64_t setup,
+    QEdgeCache::Ptr cache)
+{
+    if (cache == NULL)
+        cache = QEdgeCache::getInstance();
+    return ownedPtr(new ExpandedBinary(constraint, metric, resolution, cache, setup));
+}
+
+QEdgeConstraint::Ptr QEdgeConstraint::makeBisection(rw::common::Ptr<QConstraint> constraint,
+	QMetric::CPtr metric,
+    double resolution,
+    std::size_t batchSize)
+{
+    return ownedPtr(new BisectionBatched(constraint, metric, resolution, batchSize));
+}
+
 QEdgeConstraint::Ptr QEdgeConstraint::makeDefault(rw::common::Ptr<QConstraint> constraint,
 												  Device::CPtr device)
 {
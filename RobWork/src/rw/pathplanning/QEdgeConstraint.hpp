@@ -27,10 +27,13 @@
 #include <rw/math/Q.hpp>
 #include <rw/math/Metric.hpp>
 
+#include <boost/cstdint.hpp>
+
 namespace rw { namespace models { class Device; } }
 
 namespace rw { namespace pathplanning {
 	class QConstraint;
+	class QEdgeCache;
 
     /** @addtogroup pathplanning */
     /*@{*/
@@ -98,6 +101,67 @@ namespace rw { namespace pathplanning {
 										 rw::math::QMetric::CPtr metric,
 										 double resolution);
 
+        /**
+           @brief Discrete path verification for a linearly interpolated path
+           with results shared through a cache.
+
+           The edges are checked as for make(). Before an edge is checked, the
+           result of earlier checks is looked up in \b cache, and the check is
+           resumed from the finest resolution found. The result of every level
+           of the check is stored in the cache.
+
+           Planners and path optimizers that check the same edges repeatedly,
+           such as the shortcut methods of the PathLengthOptimizer, can reuse
+           earlier results by using this constraint in their PlannerConstraint.
+
+           @note The cache does not observe the constraint: Entries are not
+           invalidated when the ProximitySetup, the geometries of the
+           CollisionDetector, the metric or the obstacles change. The caller
+           must pass a new \b setup, e.g. from QEdgeCache::makeSetupId(),
+           after any such change, or stale results are returned.
+
+		   \param constraint [in] Constraint to check configurations with
+		   \param metric [in] Metric with which the resolution it to be measured
+		   \param resolution [in] The test resolution
+		   \param setup [in] Identifies \b constraint, \b metric and the
+		   obstacles in the cache (see QEdgeCache).
+		   \param cache [in] The cache, or NULL for the process-wide
+		   QEdgeCache::getInstance().
+        */
+		static QEdgeConstraint::Ptr makeCached(rw::common::Ptr<QConstraint> constraint,
+											   rw::math::QMetric::CPtr metric,
+											   double resolution,
+											   boost::uint64_t setup,
+											   rw::common::Ptr<QEdgeCache> cache = NULL);
+
+        /**
+           @brief Discrete path verification for a linearly interpolated path
+           in bisection order with batches of fixed size.
+
+           The configurations checked are the same as for make(), but they are
+           visited in the van der Corput order of their positions on the edge:
+           the middle first, then the quarters, the eighths in the order 1/8,
+           5/8, 3/8, 7/8, and so on. Consecutive configurations in this order
+           are spread over the edge, so collisions, which are most often found
+           near the middle of an edge, are found after few checks.
+
+           The configurations are given to QConstraint::inCollisionBatch() in
+           batches of \b batchSize configurations, and the checking stops after
+           the first batch with a collision. A constraint made with
+           QConstraint::makeBatched() computes the forward kinematics of a
+           batch at once and culls the frame pairs of the batch by bounding
+           spheres before the narrow phase.
+
+		   \param constraint [in] Constraint to check configurations with
+		   \param metric [in] Metric with which the resolution it to be measured
+		   \param resolution [in] The test resolution
+		   \param batchSize [in] The number of configurations per batch.
+        */
+		static QEdgeConstraint::Ptr makeBisection(rw::common::Ptr<QConstraint> constraint,
+												  rw::math::QMetric::CPtr metric,
+												  double resolution,
+												  std::size_t batchSize = 8);
+
         /**
            @brief Default edge constraint for a configuration constraint and a
            device.
@@ -0,0 +1,255 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#include "QEdgeConstraintContinuous.hpp"
+
+#include <rw/common/macros.hpp>
+#include <rw/geometry/Geometry.hpp>
+#include <rw/geometry/GeometryUtil.hpp>
+#include <rw/geometry/TriMesh.hpp>
+#include <rw/models/DependentJoint.hpp>
+#include <rw/models/JointDevice.hpp>
+#include <rw/models/Object.hpp>
+#include <rw/models/PrismaticJoint.hpp>
+#include <rw/models/RevoluteJoint.hpp>
+#include <rw/models/WorkCell.hpp>
+#include <rw/proximity/DistanceCalculator.hpp>
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <typeinfo>
+
+using namespace rw::common;
+using namespace rw::geometry;
+using namespace rw::kinematics;
+using namespace rw::math;
+using namespace rw::models;
+using namespace rw::pathplanning;
+using namespace rw::proximity;
+
+namespace {
+    // Radius of the sphere around the origin of the frame that contains the geometry
+    double getRadius(const Geometry& geom)
+    {
+        TriMesh::Ptr mesh;
+        try {
+            mesh = geom.getGeometryData()->getTriMesh(false);
+        } catch (const Exception&) {
+        }
+        if (mesh == NULL)
+            RW_THROW("QEdgeConstraintContinuous: the geometry " << geom.getId() << " has no triangle mesh.");
+        if (mesh->getSize() == 0)
+            return 0;
+
+        const double scale = geom.getScale();
+        const Transform3D<>& t3d = geom.getTransform();
+        const std::pair<Vector3D<>, Vector3D<> > box = GeometryUtil::getExtremumDistances(
+            mesh, Transform3D<>(t3d.P() / scale, t3d.R()));
+        Vector3D<> corner;
+        for (std::size_t i = 0; i < 3; i++)
+            corner[i] = std::max(std::fabs(box.first[i]), std::fabs(box.second[i]));
+        return scale * corner.norm2();
+    }
+}
+
+QEdgeConstraintContinuous::QEdgeConstraintContinuous(DistanceCalculator::Ptr distance,
+                                                     WorkCell::CPtr workcell,
+                                                     JointDevice::CPtr device,
+                                                     const State& state,
+                                                     double tolerance):
+    _distance(distance),
+    _workcell(workcell),
+    _device(device),
+    _state(state),
+    _tolerance(tolerance),
+    _steps(0)
+{
+    RW_ASSERT(distance);
+    RW_ASSERT(workcell);
+    RW_ASSERT(device);
+    if (tolerance <= 0)
+        RW_THROW("QEdgeConstraintContinuous: the tolerance must be positive.");
+    initialize();
+}
+
+QEdgeConstraintContinuous::~QEdgeConstraintContinuous()
+{
+}
+
+QEdgeConstraintContinuous::Ptr QEdgeConstraintContinuous::make(DistanceCalculator::Ptr distance,
+                                                               WorkCell::CPtr workcell,
+                                                               JointDevice::CPtr device,
+                                                               const State& state,
+                                                               double tolerance)
+{
+    return ownedPtr(new QEdgeConstraintContinuous(distance, workcell, device, state, tolerance));
+}
+
+void QEdgeConstraintContinuous::setState(const State& state)
+{
+    _state = state;
+    initialize();
+}
+
+void QEdgeConstraintContinuous::initialize()
+{
+    std::map<const Frame*, int> qIndices;
+    int qIndex = 0;
+    BOOST_FOREACH(const Joint* joint, _device->getJoints()) {
+        qIndices[joint] = qIndex;
+        qIndex += joint->getDOF();
+    }
+
+    std::map<const Frame*, double> radius;
+    BOOST_FOREACH(const Object::Ptr& object, _workcell->getObjects()) {
+        BOOST_FOREACH(const Geometry::Ptr& geom, object->getGeometry(_state)) {
+            const Frame* const frame = geom->getFrame();
+            RW_ASSERT(frame);
+            radius[frame] = std::max(radius[frame], getRadius(*geom));
+        }
+    }
+
+    _bounds.clear();
+    _pairs.clear();
+    std::map<const Frame*, int> boundIndices;
+    BOOST_FOREACH(const FramePair& pair, _distance->getDistancePairs()) {
+        int indices[2] = { -1, -1 };
+        const Frame* const pairFrames[2] = { pair.first, pair.second };
+        for (std::size_t k = 0; k < 2; k++) {
+            const std::map<const Frame*, int>::const_iterator it = boundIndices.find(pairFrames[k]);
+            if (it != boundIndices.end()) {
+                indices[k] = it->second;
+                continue;
+            }
+
+            // The chain up to the topmost joint of the device
+            FrameBound bound;
+            std::size_t size = 0;
+            for (const Frame* frame = pairFrames[k]; frame != NULL; frame = frame->getParent(_state)) {
+                bound.frames.push_back(frame);
+                const std::map<const Frame*, int>::const_iterator qIt = qIndices.find(frame);
+                if (qIt == qIndices.end()) {
+                    if (dynamic_cast<const DependentJoint*>(frame) != NULL)
+                        RW_THROW("QEdgeConstraintContinuous: the dependent joint " << frame->getName() << " is not supported.");
+                    bound.joints.push_back(-1);
+                    bound.prismatic.push_back(false);
+                    bound.lengths.push_back(frame->getTransform(_state).P().norm2());
+                    continue;
+                }
+
+                const RevoluteJoint* const revolute = dynamic_cast<const RevoluteJoint*>(frame);
+                const PrismaticJoint* const prismatic = dynamic_cast<const PrismaticJoint*>(frame);
+                if (revolute != NULL && typeid(*frame) == typeid(RevoluteJoint) && !revolute->hasJointMapping()) {
+                    bound.prismatic.push_back(false);
+                    bound.lengths.push_back(revolute->getFixedTransform().P().norm2());
+                } else if (prismatic != NULL && typeid(*frame) == typeid(PrismaticJoint) && !prismatic->hasJointMapping()) {
+                    bound.prismatic.push_back(true);
+                    bound.lengths.push_back(prismatic->getFixedTransform().P().norm2());
+                } else {
+                    RW_THROW("QEdgeConstraintContinuous: the joint " << frame->getName() << " is not supported.");
+                }
+                bound.joints.push_back(qIt->second);
+                size = bound.frames.size();
+            }
+
+            if (size > 0) {
+                const std::map<const Frame*, double>::const_iterator rIt = radius.find(pairFrames[k]);
+                if (rIt == radius.end())
+                    RW_THROW("QEdgeConstraintContinuous: no geometry found for the frame " << pairFrames[k]->getName() << ".");
+                bound.radius = rIt->second;
+                bound.frames.resize(size);
+                bound.lengths.resize(size);
+                bound.joints.resize(size);
+                bound.prismatic.resize(size);
+                indices[k] = (int)_bounds.size();
+                _bounds.push_back(bound);
+            }
+            boundIndices[pairFrames[k]] = indices[k];
+        }
+        if (indices[0] >= 0 || indices[1] >= 0)
+            _pairs.push_back(std::make_pair(indices[0], indices[1]));
+    }
+}
+
+double QEdgeConstraintContinuous::getMotionBound(const FrameBound& bound, const Q& start, const Q& end) const
+{
+    // r bounds the distance from the origin of the current frame of the chain
+    // to the points of the geometry
+    double r = bound.radius;
+    double motion = 0;
+    for (std::size_t i = 0; i < bound.frames.size(); i++) {
+        const int j = bound.joints[i];
+        if (j >= 0) {
+            const double dq = std::fabs(end[j] - start[j]);
+            if (bound.prismatic[i]) {
+                motion += dq;
+                r += std::max(std::fabs(start[j]), std::fabs(end[j]));
+            } else {
+                motion += dq * r;
+            }
+        }
+        r += bound.lengths[i];
+    }
+    return motion;
+}
+
+bool QEdgeConstraintContinuous::findContact(const Q& start, const Q& end, double* time) const
+{
+    const std::size_t dof = _device->getDOF();
+    if (start.size() != dof || end.size() != dof)
+        RW_THROW("QEdgeConstraintContinuous: the configurations must have " << dof << " values.");
+
+    std::vector<double> motions(_bounds.size());
+    for (std::size_t i = 0; i < _bounds.size(); i++)
+        motions[i] = getMotionBound(_bounds[i], start, end);
+
+    // The largest relative motion of a pair per unit of t
+    double motion = 0;
+    typedef std::pair<int, int> IndexPair;
+    BOOST_FOREACH(const IndexPair& pair, _pairs) {
+        const double a = pair.first < 0 ? 0 : motions[pair.first];
+        const double b = pair.second < 0 ? 0 : motions[pair.second];
+        motion = std::max(motion, a + b);
+    }
+
+    // No pair can come closer than the distance d in a step of d / motion
+    _steps = 0;
+    State state = _state;
+    const Q delta = end - start;
+    double t = 0;
+    for (;;) {
+        _device->setQ(start + t * delta, state);
+        const double d = _distance->distance(state).distance;
+        _steps++;
+        if (d < _tolerance) {
+            if (time != NULL)
+                *time = t;
+            return true;
+        }
+        if (t >= 1 || motion == 0)
+            return false;
+        t = std::min(1.0, t + d / motion);
+    }
+}
+
+bool QEdgeConstraintContinuous::doInCollision(const Q& start, const Q& end) const
+{
+    return findContact(start, end);
+}
@@ -0,0 +1,185 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#ifndef RW_PATHPLANNING_QEDGECONSTRAINTCONTINUOUS_HPP
+#define RW_PATHPLANNING_QEDGECONSTRAINTCONTINUOUS_HPP
+
+/**
+   @file QEdgeConstraintContinuous.hpp
+*/
+
+#include "QEdgeConstraint.hpp"
+
+#include <rw/kinematics/State.hpp>
+
+#include <vector>
+
+namespace rw { namespace models { class JointDevice; class WorkCell; } }
+namespace rw { namespace proximity { class DistanceCalculator; } }
+
+namespace rw { namespace pathplanning {
+
+    /** @addtogroup pathplanning */
+    /** @{*/
+
+    /**
+       @brief Continuous collision checking of straight line edges of a device
+       by conservative advancement.
+
+       The device moves along the edge \f$ q(t) = start + t (end - start) \f$
+       for \f$ t \in [0, 1] \f$. For every frame with geometry that is moved by
+       the device, an upper bound on how far any point of its geometry can
+       move per unit of \f$ t \f$ is calculated from the joint displacements:
+       a revolute joint that turns by \f$ \Delta q \f$ moves a point at most
+       \f$ r |\Delta q| \f$, where \f$ r \f$ bounds the distance from the
+       joint to the point, and a prismatic joint moves a point at most
+       \f$ |\Delta q| \f$. The distance bound \f$ r \f$ is the sum of the
+       lengths of the translations between the joint and the frame plus the
+       radius of the geometry, which bounds the rows of the joint Jacobian of
+       every point on the geometry along the entire edge.
+
+       The edge is checked by calculating the shortest distance \f$ d \f$ of
+       the rw::proximity::DistanceCalculator at \f$ q(t) \f$ and advancing
+       \f$ t \f$ by \f$ d / \mu \f$, where \f$ \mu \f$ is the largest relative
+       motion bound of the frame pairs of the distance calculator. No pair can
+       come into contact within this step. The edge is free if \f$ t = 1 \f$
+       is reached, and a configuration closer than the tolerance to an
+       obstacle is reported as the contact.
+
+       Long edges through free space are verified in few steps, and obstacles
+       that are thinner than the resolution of a discrete edge constraint are
+       not missed.
+
+       Only plain rw::models::RevoluteJoint and rw::models::PrismaticJoint
+       joints without a joint mapping are supported, and the frames between
+       the joints and the geometries must not depend on the configuration in
+       other ways.
+    */
+    class QEdgeConstraintContinuous: public QEdgeConstraint
+    {
+    public:
+        //! @brief smart pointer type to this class
+        typedef rw::common::Ptr<QEdgeConstraintContinuous> Ptr;
+
+        /**
+           @brief Continuous edge constraint.
+
+           @param distance [in] the distance calculator to step by.
+           @param workcell [in] the workcell with the geometry of the frames.
+           @param device [in] the device.
+           @param state [in] the state of the rest of the workcell.
+           @param tolerance [in] configurations with a distance less than
+           \b tolerance are considered in contact.
+        */
+        QEdgeConstraintContinuous(rw::common::Ptr<rw::proximity::DistanceCalculator> distance,
+                                  rw::common::Ptr<const rw::models::WorkCell> workcell,
+                                  rw::common::Ptr<const rw::models::JointDevice> device,
+                                  const rw::kinematics::State& state,
+                                  double tolerance = 1e-4);
+
+        //! @brief Destructor
+        virtual ~QEdgeConstraintContinuous();
+
+        /**
+           @brief Make a continuous edge constraint.
+
+           See QEdgeConstraintContinuous().
+        */
+        static QEdgeConstraintContinuous::Ptr make(
+            rw::common::Ptr<rw::proximity::DistanceCalculator> distance,
+            rw::common::Ptr<const rw::models::WorkCell> workcell,
+            rw::common::Ptr<const rw::models::JointDevice> device,
+            const rw::kinematics::State& state,
+            double tolerance = 1e-4);
+
+        /**
+           @brief Find the first contact on the edge from \b start to \b end.
+
+           @param start [in] the start configuration.
+           @param end [in] the end configuration.
+           @param time [out] if non-NULL and a contact is found, the
+           parameter \f$ t \in [0, 1] \f$ of the first configuration found
+           closer than the tolerance. The edge is free of collisions before
+           \f$ t \f$.
+           @return true if a contact is found, and false if the edge is
+           guaranteed to be free.
+        */
+        bool findContact(const rw::math::Q& start, const rw::math::Q& end, double* time = NULL) const;
+
+        /**
+           @brief The number of distance calculations of the last call to
+           findContact().
+           @return the number of steps.
+        */
+        std::size_t getNumberOfSteps() const { return _steps; }
+
+        /**
+           @brief Update the state of the rest of the workcell.
+           @param state [in] the state.
+        */
+        void setState(const rw::kinematics::State& state);
+
+    private:
+        bool doInCollision(const rw::math::Q& start, const rw::math::Q& end) const;
+
+        /**
+           @brief The chain of frames from a frame moved by the device to the
+           topmost joint of the device that moves it.
+        */
+        struct FrameBound {
+            // the frames of the chain, starting at the frame with geometry
+            std::vector<const rw::kinematics::Frame*> frames;
+            // length of the constant translation of each frame of the chain
+            std::vector<double> lengths;
+            // index in the configuration of the joint of each frame, or -1
+            std::vector<int> joints;
+            // true if the frame is a prismatic joint
+            std::vector<bool> prismatic;
+            // radius of the geometry around the origin of the first frame
+            double radius;
+        };
+
+        void initialize();
+
+        /**
+           @brief Upper bound on how far any point of the geometry of a frame
+           moves per unit of the edge parameter.
+        */
+        double getMotionBound(const FrameBound& bound, const rw::math::Q& start, const rw::math::Q& end) const;
+
+    private:
+        rw::common::Ptr<rw::proximity::DistanceCalculator> _distance;
+        rw::common::Ptr<const rw::models::WorkCell> _workcell;
+        rw::common::Ptr<const rw::models::JointDevice> _device;
+        rw::kinematics::State _state;
+        double _tolerance;
+
+        // the frames moved by the device with geometry in a distance pair
+        std::vector<FrameBound> _bounds;
+        // the distance pairs as indices in _bounds, or -1 for frames that
+        // are not moved by the device
+        std::vector<std::pair<int, int> > _pairs;
+
+        mutable std::size_t _steps;
+    };
+
+    /** @} */
+}} // end namespaces
+
+#endif // end include guard
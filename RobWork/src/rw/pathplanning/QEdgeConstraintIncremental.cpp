@@ -18,6 +18,7 @@
 
 #include "QEdgeConstraintIncremental.hpp"
 #include "PlannerUtil.hpp"
+#include "QEdgeCache.hpp"
 #include <rw/math/Math.hpp>
 #include <rw/models/Device.hpp>
 
@@ -108,12 +109,16 @@ namespace
             const Q& end,
 			QMetric::Ptr metric,
             double resolution,
-			QConstraint::Ptr constraint)
+			QConstraint::Ptr constraint,
+            QEdgeCache::Ptr cache = NULL,
+            boost::uint64_t setup = 0)
             :
             QEdgeConstraintIncremental(start, end),
             _metric(metric),
             _resolution(resolution),
-            _constraint(constraint)
+            _constraint(constraint),
+            _cache(cache),
+            _setup(setup)
         {
             if (resolution <= 0)
                 RW_THROW("Unable to create constraint with resolution<=0");
@@ -160,6 +165,31 @@ namespace
                 // Because of the above check this shouldn't be a division by
                 // zero.
                 _dir = (getEnd() - getStart()) / len1;
+                resumeFromCache();
+            }
+        }
+
+        // Skip the levels that have been verified by earlier checks of the
+        // same edge.
+        void resumeFromCache()
+        {
+            if (_cache == NULL)
+                return;
+
+            double resolution;
+            const QEdgeCache::Status status = _cache->get(_setup, getStart(), getEnd(), &resolution);
+            if (status == QEdgeCache::Blocked) {
+                _knownInCollision = true;
+            } else if (status == QEdgeCache::Free) {
+                // After level l the spacing of the checked positions is
+                // 2^(maxLevel - l) steps.
+                const int k = QEdgeCache::getVerifiedLevel(resolution, _resolution);
+                if (k == 0) {
+                    _knownCollisionFree = true;
+                } else if (k > 0 && k < _maxLevel) {
+                    _level = _maxLevel - k + 1;
+                    _cost = pow(2.0, (double)k);
+                }
             }
         }
 
@@ -187,6 +217,8 @@ namespace
                 ++_collisionChecks;
                 if (_constraint->inCollision(q)) {
                     _knownInCollision = true;
+                    if (_cache != NULL)
+                        _cache->setBlocked(_setup, getStart(), getEnd());
                     return true;
                 } else {
                     pos += step;
@@ -195,6 +227,8 @@ namespace
 
             _level += 1;
             _cost /= 2;
+            if (_cache != NULL)
+                _cache->setFree(_setup, getStart(), getEnd(), _resolution * _cost);
 
             if (_level > _maxLevel) _knownCollisionFree = true;
             return false;
@@ -209,7 +243,7 @@ namespace
         {
             return ownedPtr(
                 new DiscreteLinear(
-                    from, to, _metric, _resolution, _constraint));
+                    from, to, _metric, _resolution, _constraint, _cache, _setup));
         }
 
     private:
@@ -217,6 +251,8 @@ namespace
 		QMetric::Ptr _metric;
         double _resolution;
 		QConstraint::Ptr _constraint;
+        QEdgeCache::Ptr _cache;
+        boost::uint64_t _setup;
 
         // These are updated as the path is being verified.
         int _level;
@@ -268,6 +304,17 @@ QEdgeConstraintIncremental::Ptr QEdgeConstraintIncremental::make(QConstraint::Pt
     return ownedPtr(new DiscreteLinear(Q(), Q(), metric, resolution, constraint));
 }
 
+QEdgeConstraintIncremental::Ptr QEdgeConstraintIncremental::makeCached(QConstraint::Ptr constraint,
+	QMetric::Ptr metric,
+    double resolution,
+    boost::uint64_t setup,
+    QEdgeCache::Ptr cache)
+{
+    if (cache == NULL)
+        cache = QEdgeCache::getInstance();
+    return ownedPtr(new DiscreteLinear(Q(), Q(), metric, resolution, constraint, cache, setup));
+}
+
 QEdgeConstraintIncremental::Ptr QEdgeConstraintIncremental::makeDefault(QConstraint::Ptr constraint,
 												  Device::Ptr device)
 {
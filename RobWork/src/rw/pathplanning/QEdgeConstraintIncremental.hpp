@@ -27,10 +27,13 @@
 #include <rw/math/Q.hpp>
 #include <rw/math/Metric.hpp>
 
+#include <boost/cstdint.hpp>
+
 namespace rw { namespace models { class Device; } }
 
 namespace rw { namespace pathplanning {
 	class QConstraint;
+	class QEdgeCache;
 
     /** @addtogroup pathplanning */
     /*@{*/
@@ -165,6 +168,36 @@ namespace rw { namespace pathplanning {
 			rw::math::QMetric::Ptr metric,
             double resolution = 1);
 
+        /**
+           @brief Discrete path verification for a linearly interpolated path
+           with results shared through a cache.
+
+           The edges are checked as for make(). Before an edge is checked, the
+           result of earlier checks is looked up in \b cache, and the check is
+           resumed from the finest resolution found. The result of every
+           level of the check is stored in the cache.
+
+           @note The cache does not observe the constraint: Entries are not
+           invalidated when the ProximitySetup, the geometries of the
+           CollisionDetector, the metric or the obstacles change. The caller
+           must pass a new \b setup, e.g. from QEdgeCache::makeSetupId(),
+           after any such change, or stale results are returned.
+
+           @param constraint [in] Constraint to check configurations with.
+           @param metric [in] Metric the resolution is measured by.
+           @param resolution [in] The resolution.
+           @param setup [in] Identifies \b constraint, \b metric and the
+           obstacles in the cache (see QEdgeCache).
+           @param cache [in] The cache, or NULL for the process-wide
+           QEdgeCache::getInstance().
+        */
+		static QEdgeConstraintIncremental::Ptr makeCached(
+			rw::common::Ptr<QConstraint> constraint,
+			rw::math::QMetric::Ptr metric,
+            double resolution,
+            boost::uint64_t setup,
+            rw::common::Ptr<QEdgeCache> cache = NULL);
+
         /**
            @brief Default edge constraint for a configuration constraint and a
            device.
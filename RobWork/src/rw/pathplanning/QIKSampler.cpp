@@ -23,6 +23,7 @@
 #include <rw/models/Device.hpp>
 #include <rw/models/Models.hpp>
 #include <rw/invkin/IterativeIK.hpp>
+#include <rw/invkin/ReachabilityMap.hpp>
 
 using namespace rw::pathplanning;
 using namespace rw::math;
@@ -96,6 +97,57 @@ namespace
         std::vector<Q> _available;
     };
 
+    class SeededQIKSampler : public QIKSampler
+    {
+    public:
+        SeededQIKSampler(
+			ReachabilityMap::CPtr map,
+			Device::Ptr device,
+            const State& state,
+			IterativeIK::Ptr solver,
+            int maxAttempts)
+            :
+            _map(map),
+            _device(device),
+            _state(state),
+            _solver(solver),
+            _seed(QSampler::makeUniform(device)),
+            _maxAttempts(maxAttempts)
+        {
+            if (!_solver) _solver = IterativeIK::makeDefault(device, state);
+            if (_maxAttempts < 0) _maxAttempts = 15;
+        }
+
+    private:
+        Q doSample(const Transform3D<>& target)
+        {
+            Q seed;
+            if (!_map->getSeed(target, seed))
+                return Q();
+
+            for (int cnt = 0; cnt < _maxAttempts; ++cnt) {
+                if (cnt > 0)
+                    seed = _seed->sample();
+                _device->setQ(seed, _state);
+
+                const std::vector<Q> qs = _solver->solve(target, _state);
+                BOOST_FOREACH(const Q& q, qs) {
+                    if (Models::inBounds(q, *_device))
+                        return q;
+                }
+            }
+            return Q();
+        }
+
+    private:
+		ReachabilityMap::CPtr _map;
+		Device::Ptr _device;
+        State _state;
+		IterativeIK::Ptr _solver;
+		QSampler::Ptr _seed;
+        int _maxAttempts;
+    };
+
     class ConstrainedQIKSampler : public QIKSampler
     {
     public:
@@ -147,6 +199,16 @@ QIKSampler::Ptr QIKSampler::make(Device::Ptr device,
         new IterativeQIKSampler(device, state, solver, seed, maxAttempts));
 }
 
+QIKSampler::Ptr QIKSampler::makeSeeded(ReachabilityMap::CPtr map,
+	Device::Ptr device,
+    const State& state,
+	IterativeIK::Ptr solver,
+    int maxAttempts)
+{
+    return ownedPtr(
+        new SeededQIKSampler(map, device, state, solver, maxAttempts));
+}
+
 QIKSampler::Ptr QIKSampler::makeConstrained(
 	QIKSampler::Ptr sampler,
 	QConstraint::Ptr constraint,
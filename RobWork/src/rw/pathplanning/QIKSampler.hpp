@@ -29,7 +29,7 @@
 
 namespace rw { namespace kinematics { class State; } }
 namespace rw { namespace models { class Device; } }
-namespace rw { namespace invkin { class IterativeIK; } }
+namespace rw { namespace invkin { class IterativeIK; class ReachabilityMap; } }
 
 namespace rw { namespace pathplanning {
 	class QConstraint;
@@ -96,6 +96,35 @@ namespace rw { namespace pathplanning {
 			rw::common::Ptr<QSampler> seed = NULL,
             int maxAttempts = -1);
 
+        /**
+           @brief An IK sampler seeded by a reachability map.
+
+           Targets in cells that are not reachable in \b map are rejected
+           without solving the inverse kinematics. For a reachable cell, the
+           first seed fed to the IK solver is the seed stored in \b map, and
+           the following seeds are sampled uniformly.
+
+           All solutions returned are checked to be within the bounds of the device.
+
+           @param map [in] Reachability map of \b device.
+
+           @param device [in] The device for which seeds are sampled.
+
+           @param state [in] Fixed state with respect to which IK is solved.
+
+           @param solver [in] Optional IK solver for \b device and \b state.
+
+           @param maxAttempts [in] Optional number of seeds to feed the IK
+           solver. If \b maxAttempts is negative, a default value for \b
+           maxAttempts is chosen.
+        */
+		static QIKSampler::Ptr makeSeeded(
+			rw::common::Ptr<const rw::invkin::ReachabilityMap> map,
+			rw::common::Ptr<rw::models::Device> device,
+            const rw::kinematics::State& state,
+			rw::common::Ptr<rw::invkin::IterativeIK> solver = NULL,
+            int maxAttempts = -1);
+
         /**
            @brief An IK sampler filtered by a constraint.
 
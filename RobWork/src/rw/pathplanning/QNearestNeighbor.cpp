@@ -0,0 +1,348 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#include "QNearestNeighbor.hpp"
+
+#include <rw/common/macros.hpp>
+#include <rw/math/MetricFactory.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace rw::common;
+using namespace rw::math;
+using namespace rw::pathplanning;
+
+namespace
+{
+    class LinearNearestNeighbor: public QNearestNeighbor
+    {
+    public:
+        LinearNearestNeighbor(QMetric::Ptr metric):
+            _metric(metric)
+        {
+            RW_ASSERT(metric);
+        }
+
+        void add(const Q& q) { _qs.push_back(q); }
+
+        int nearest(const Q& q, double* dist) const
+        {
+            double minDist = DBL_MAX;
+            int minIdx = -1;
+            for (std::size_t i = 0; i < _qs.size(); i++) {
+                const double d = _metric->distance(q, _qs[i]);
+                if (d < minDist) {
+                    minDist = d;
+                    minIdx = (int)i;
+                }
+            }
+            if (dist != NULL)
+                *dist = minDist;
+            return minIdx;
+        }
+
+        void nearestWithin(const Q& q, double radius, std::vector<int>& result) const
+        {
+            result.clear();
+            for (std::size_t i = 0; i < _qs.size(); i++) {
+                if (_metric->distance(q, _qs[i]) <= radius)
+                    result.push_back((int)i);
+            }
+        }
+
+        std::size_t size() const { return _qs.size(); }
+
+        void clear() { _qs.clear(); }
+
+    private:
+        QMetric::Ptr _metric;
+        std::vector<Q> _qs;
+    };
+
+    class KDTreeNearestNeighbor: public QNearestNeighbor
+    {
+    public:
+        KDTreeNearestNeighbor(const Q& weights, Norm norm):
+            _weights(weights),
+            _norm(norm),
+            _dim(weights.size()),
+            _size(0)
+        {}
+
+        void add(const Q& q)
+        {
+            if (_size == 0 && _weights.size() == 0)
+                _dim = q.size();
+            if (q.size() != _dim)
+                RW_THROW("Configuration of dimension " << q.size() << " added to a nearest neighbor index of dimension " << _dim);
+            if (_nodes.empty())
+                _nodes.push_back(Node());
+
+            const int idx = (int)_size++;
+            for (std::size_t i = 0; i < _dim; i++)
+                _coords.push_back(_weights.size() == 0 ? q[i] : q[i]*_weights[i]);
+            const double* const coord = &_coords[idx*_dim];
+
+            int n = 0;
+            while (_nodes[n].left >= 0)
+                n = coord[_nodes[n].axis] < _nodes[n].split ? _nodes[n].left : _nodes[n].right;
+            _nodes[n].points.push_back(idx);
+            if (_nodes[n].points.size() > BucketSize)
+                split(n);
+        }
+
+        int nearest(const Q& q, double* dist) const
+        {
+            if (_size == 0) {
+                if (dist != NULL)
+                    *dist = DBL_MAX;
+                return -1;
+            }
+            if (q.size() != _dim)
+                RW_THROW("Configuration of dimension " << q.size() << " searched for in a nearest neighbor index of dimension " << _dim);
+
+            std::vector<double> coord(_dim);
+            for (std::size_t i = 0; i < _dim; i++)
+                coord[i] = _weights.size() == 0 ? q[i] : q[i]*_weights[i];
+
+            Search search;
+            search.coord = &coord[0];
+            search.best = DBL_MAX;
+            search.bestIdx = -1;
+            nearest(0, search);
+
+            if (dist != NULL)
+                *dist = _norm == Norm2 ? std::sqrt(search.best) : search.best;
+            return search.bestIdx;
+        }
+
+        void nearestWithin(const Q& q, double radius, std::vector<int>& result) const
+        {
+            result.clear();
+            if (_size == 0)
+                return;
+            if (q.size() != _dim)
+                RW_THROW("Configuration of dimension " << q.size() << " searched for in a nearest neighbor index of dimension " << _dim);
+
+            std::vector<double> coord(_dim);
+            for (std::size_t i = 0; i < _dim; i++)
+                coord[i] = _weights.size() == 0 ? q[i] : q[i]*_weights[i];
+            within(0, &coord[0], _norm == Norm2 ? radius*radius : radius, result);
+        }
+
+        std::size_t size() const { return _size; }
+
+        void clear()
+        {
+            _nodes.clear();
+            _coords.clear();
+            _size = 0;
+        }
+
+    private:
+        static const std::size_t BucketSize = 16;
+
+        struct Node {
+            Node(): left(-1), right(-1), axis(0), split(0) {}
+            // children (-1 for a leaf)
+            int left, right;
+            std::size_t axis;
+            double split;
+            // configurations in a leaf
+            std::vector<int> points;
+        };
+
+        struct Search {
+            const double* coord;
+            // best distance (squared for Norm2)
+            double best;
+            int bestIdx;
+        };
+
+        void split(int n)
+        {
+            std::vector<int> points;
+            points.swap(_nodes[n].points);
+
+            // Split the dimension of largest spread at the median
+            std::size_t axis = 0;
+            double spread = 0;
+            double lower = 0;
+            double upper = 0;
+            for (std::size_t d = 0; d < _dim; d++) {
+                double min = DBL_MAX;
+                double max = -DBL_MAX;
+                for (std::size_t i = 0; i < points.size(); i++) {
+                    const double v = _coords[points[i]*_dim + d];
+                    min = std::min(min, v);
+                    max = std::max(max, v);
+                }
+                if (max - min > spread) {
+                    spread = max - min;
+                    axis = d;
+                    lower = min;
+                    upper = max;
+                }
+            }
+            if (spread == 0) {
+                // all configurations are identical
+                _nodes[n].points.swap(points);
+                return;
+            }
+
+            std::vector<double> values(points.size());
+            for (std::size_t i = 0; i < points.size(); i++)
+                values[i] = _coords[points[i]*_dim + axis];
+            std::nth_element(values.begin(), values.begin() + values.size()/2, values.end());
+            double split = values[values.size()/2];
+            if (split == lower)
+                split = (lower + upper)/2;
+
+            Node left, right;
+            for (std::size_t i = 0; i < points.size(); i++) {
+                if (_coords[points[i]*_dim + axis] < split)
+                    left.points.push_back(points[i]);
+                else
+                    right.points.push_back(points[i]);
+            }
+
+            _nodes[n].axis = axis;
+            _nodes[n].split = split;
+            _nodes[n].left = (int)_nodes.size();
+            _nodes[n].right = (int)_nodes.size() + 1;
+            _nodes.push_back(left);
+            _nodes.push_back(right);
+        }
+
+        // Distance in the units of Search::best, stops early if larger than best.
+        double distance(const double* a, const double* b, double best) const
+        {
+            double result = 0;
+            switch (_norm) {
+            case Norm1:
+                for (std::size_t i = 0; i < _dim && result < best; i++)
+                    result += std::fabs(a[i] - b[i]);
+                break;
+            case Norm2:
+                for (std::size_t i = 0; i < _dim && result < best; i++)
+                    result += (a[i] - b[i])*(a[i] - b[i]);
+                break;
+            case NormInf:
+                for (std::size_t i = 0; i < _dim && result < best; i++)
+                    result = std::max(result, std::fabs(a[i] - b[i]));
+                break;
+            }
+            return result;
+        }
+
+        void nearest(int n, Search& search) const
+        {
+            const Node& node = _nodes[n];
+            if (node.left < 0) {
+                for (std::size_t i = 0; i < node.points.size(); i++) {
+                    const int idx = node.points[i];
+                    const double d = distance(search.coord, &_coords[idx*_dim], search.best);
+                    if (d < search.best) {
+                        search.best = d;
+                        search.bestIdx = idx;
+                    }
+                }
+                return;
+            }
+
+            // The distance to the splitting plane is a lower bound for the far side
+            const double diff = search.coord[node.axis] - node.split;
+            nearest(diff < 0 ? node.left : node.right, search);
+            const double bound = _norm == Norm2 ? diff*diff : std::fabs(diff);
+            if (bound < search.best)
+                nearest(diff < 0 ? node.right : node.left, search);
+        }
+
+        // 'radius' is in the units of Search::best.
+        void within(int n, const double* coord, double radius, std::vector<int>& result) const
+        {
+            const Node& node = _nodes[n];
+            if (node.left < 0) {
+                for (std::size_t i = 0; i < node.points.size(); i++) {
+                    const int idx = node.points[i];
+                    if (distance(coord, &_coords[idx*_dim], DBL_MAX) <= radius)
+                        result.push_back(idx);
+                }
+                return;
+            }
+
+            const double diff = coord[node.axis] - node.split;
+            within(diff < 0 ? node.left : node.right, coord, radius, result);
+            const double bound = _norm == Norm2 ? diff*diff : std::fabs(diff);
+            if (bound <= radius)
+                within(diff < 0 ? node.right : node.left, coord, radius, result);
+        }
+
+    private:
+        const Q _weights;
+        const Norm _norm;
+        std::size_t _dim;
+        std::size_t _size;
+        std::vector<Node> _nodes;
+        // the weighted configurations, _dim values per configuration
+        std::vector<double> _coords;
+    };
+
+    template <class WeightedMetric>
+    bool getWeights(const QMetric& metric, Q& weights)
+    {
+        const WeightedMetric* const weighted = dynamic_cast<const WeightedMetric*>(&metric);
+        if (weighted == NULL)
+            return false;
+        weights = weighted->getWeights();
+        return true;
+    }
+}
+
+QNearestNeighbor::Ptr QNearestNeighbor::makeLinear(QMetric::Ptr metric)
+{
+    return ownedPtr(new LinearNearestNeighbor(metric));
+}
+
+QNearestNeighbor::Ptr QNearestNeighbor::makeKDTree(const Q& weights, Norm norm)
+{
+    return ownedPtr(new KDTreeNearestNeighbor(weights, norm));
+}
+
+QNearestNeighbor::Ptr QNearestNeighbor::make(QMetric::Ptr metric, Type type)
+{
+    RW_ASSERT(metric);
+    if (type == Linear)
+        return makeLinear(metric);
+
+    const QMetric& m = *metric;
+    Q weights;
+    if (dynamic_cast<const ManhattanMetric<Q>*>(&m) != NULL || getWeights<WeightedManhattanMetric<Q> >(m, weights))
+        return makeKDTree(weights, Norm1);
+    if (dynamic_cast<const EuclideanMetric<Q>*>(&m) != NULL || getWeights<WeightedEuclideanMetric<Q> >(m, weights))
+        return makeKDTree(weights, Norm2);
+    if (dynamic_cast<const InfinityMetric<Q>*>(&m) != NULL || getWeights<WeightedInfinityMetric<Q> >(m, weights))
+        return makeKDTree(weights, NormInf);
+
+    if (type == KDTree)
+        RW_THROW("A k-d tree nearest neighbor index does not support the metric.");
+    return makeLinear(metric);
+}
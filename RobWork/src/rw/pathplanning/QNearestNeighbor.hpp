@@ -0,0 +1,154 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#ifndef RW_PATHPLANNING_QNEARESTNEIGHBOR_HPP
+#define RW_PATHPLANNING_QNEARESTNEIGHBOR_HPP
+
+/**
+   @file QNearestNeighbor.hpp
+*/
+
+#include <rw/common/Ptr.hpp>
+#include <rw/math/Metric.hpp>
+#include <rw/math/Q.hpp>
+
+#include <vector>
+
+namespace rw { namespace pathplanning {
+
+    /** @addtogroup pathplanning */
+    /** @{*/
+
+    /**
+       @brief Index for nearest neighbor search among a growing set of
+       configurations.
+
+       Configurations are added one at a time and are identified by the order
+       in which they were added, such that the index can be kept next to an
+       array of nodes of a planner (the first configuration has index 0).
+
+       Use make() to construct an index that is suitable for a given metric.
+    */
+    class QNearestNeighbor
+    {
+    public:
+        //! @brief smart pointer type to this class
+        typedef rw::common::Ptr<QNearestNeighbor> Ptr;
+
+        //! @brief The search structure to use.
+        enum Type {
+            //! @brief Select KDTree if the metric supports it, otherwise Linear.
+            Auto,
+            //! @brief Compare with all configurations (any metric).
+            Linear,
+            /**
+               @brief k-d tree for (weighted) Manhattan, Euclidean and infinity
+               metrics.
+            */
+            KDTree
+        };
+
+        //! @brief The norm of a KDTree index.
+        enum Norm { Norm1, Norm2, NormInf };
+
+        //! @brief Destructor
+        virtual ~QNearestNeighbor() {}
+
+        /**
+           @brief Add a configuration to the index.
+           @param q [in] the configuration.
+        */
+        virtual void add(const rw::math::Q& q) = 0;
+
+        /**
+           @brief Find the configuration nearest to \b q.
+           @param q [in] the configuration to search for.
+           @param dist [out] if non-NULL, the distance to the nearest
+           configuration.
+           @return the index of the nearest configuration, or -1 if the index
+           is empty.
+        */
+        virtual int nearest(const rw::math::Q& q, double* dist = NULL) const = 0;
+
+        /**
+           @brief Find the configurations within distance \b radius of \b q.
+           @param q [in] the configuration to search for.
+           @param radius [in] the largest distance to include.
+           @param result [out] the indices of the configurations, in no
+           particular order. The vector is cleared first.
+        */
+        virtual void nearestWithin(const rw::math::Q& q,
+                                   double radius,
+                                   std::vector<int>& result) const = 0;
+
+        /**
+           @brief The number of configurations in the index.
+        */
+        virtual std::size_t size() const = 0;
+
+        //! @brief Remove all configurations from the index.
+        virtual void clear() = 0;
+
+        /**
+           @brief Index that compares \b q with all configurations.
+           @param metric [in] the metric to measure distances by.
+        */
+        static QNearestNeighbor::Ptr makeLinear(rw::math::QMetric::Ptr metric);
+
+        /**
+           @brief k-d tree index for the distance
+           \f$ \|(\omega_1(p_1 - q_1), \ldots, \omega_n(p_n - q_n))\| \f$.
+
+           The tree is grown incrementally: leaves hold a bucket of
+           configurations and are split at the median of the dimension of
+           largest spread when they are full.
+
+           @param weights [in] the weights \f$ \omega_i \f$, or an empty
+           configuration for unit weights.
+           @param norm [in] the norm.
+        */
+        static QNearestNeighbor::Ptr makeKDTree(const rw::math::Q& weights, Norm norm);
+
+        /**
+           @brief Index for the distances measured by \b metric.
+
+           A KDTree is used for the Manhattan, Euclidean and infinity metrics of
+           rw::math::MetricFactory and their weighted versions (such as the
+           metric returned by PlannerUtil::normalizingInfinityMetric()). For
+           other metrics the Linear index is used.
+
+           @param metric [in] the metric.
+           @param type [in] the search structure. If KDTree is requested for a
+           metric that it does not support, an exception is thrown.
+        */
+        static QNearestNeighbor::Ptr make(rw::math::QMetric::Ptr metric, Type type = Auto);
+
+    protected:
+        //! @brief Constructor
+        QNearestNeighbor() {}
+
+    private:
+        QNearestNeighbor(const QNearestNeighbor&);
+        QNearestNeighbor& operator=(const QNearestNeighbor&);
+    };
+
+    /* @} */
+}} // end namespaces
+
+#endif // end include guard
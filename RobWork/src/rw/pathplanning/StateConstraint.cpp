@@ -19,6 +19,7 @@
 #include "StateConstraint.hpp"
 #include <rw/common/macros.hpp>
 #include <rw/common/Log.hpp>
+#include <rw/kinematics/State.hpp>
 #include <rw/proximity/CollisionDetector.hpp>
 #include <boost/foreach.hpp>
 
@@ -52,6 +53,14 @@ namespace
 			}	
         }
 
+        boost::dynamic_bitset<> doInCollisionBatch(const std::vector<State>& states, bool stopAtFirst) const
+        {
+			// the colliding frames are only logged for single queries
+			if (_log == NULL)
+				return _detector->inCollisionBatch(states, NULL, true, stopAtFirst);
+			return StateConstraint::doInCollisionBatch(states, stopAtFirst);
+        }
+
 		void doSetLog(Log::Ptr log) {
 			_log = log;
 		}
@@ -79,6 +88,27 @@ namespace
             return false;
         }
 
+        boost::dynamic_bitset<> doInCollisionBatch(const std::vector<State>& states, bool stopAtFirst) const
+        {
+			boost::dynamic_bitset<> res(states.size());
+			BOOST_FOREACH(const StateConstraint::Ptr& sc, _constraints) {
+				if (stopAtFirst && res.any()) {
+					// only the states before the first known collision need to be checked
+					const std::vector<State> remaining(states.begin(), states.begin() + res.find_first());
+					if (remaining.empty())
+						break;
+					boost::dynamic_bitset<> sub = sc->inCollisionBatch(remaining, true);
+					if (sub.any()) {
+						res.reset();
+						res.set(sub.find_first());
+					}
+				} else {
+					res |= sc->inCollisionBatch(states, stopAtFirst);
+				}
+			}
+			return res;
+        }
+
 		void doSetLog(Log::Ptr log) {
 			BOOST_FOREACH(const StateConstraint::Ptr& sc, _constraints) {
                 sc->setLog(log);
@@ -95,6 +125,24 @@ bool StateConstraint::inCollision(const rw::kinematics::State& state) const
     return doInCollision(state);
 }
 
+boost::dynamic_bitset<> StateConstraint::inCollisionBatch(const std::vector<State>& states, bool stopAtFirst) const
+{
+    return doInCollisionBatch(states, stopAtFirst);
+}
+
+boost::dynamic_bitset<> StateConstraint::doInCollisionBatch(const std::vector<State>& states, bool stopAtFirst) const
+{
+    boost::dynamic_bitset<> res(states.size());
+    for (std::size_t i = 0; i < states.size(); i++) {
+        if (inCollision(states[i])) {
+            res.set(i);
+            if (stopAtFirst)
+                break;
+        }
+    }
+    return res;
+}
+
 void StateConstraint::setLog(rw::common::Log::Ptr log) {
 	doSetLog(log);
 }
@@ -25,6 +25,8 @@
 
 #include <rw/common/Ptr.hpp>
 
+#include <boost/dynamic_bitset.hpp>
+
 #include <vector>
 
 namespace rw { namespace common { class Log; } }
@@ -58,6 +60,20 @@ namespace rw { namespace pathplanning {
          */
         bool inCollision(const rw::kinematics::State& state) const;
 
+        /**
+           @brief Check a batch of work cell states.
+
+           The states are checked in one call to the constraint, which allows
+           a constraint to check them in parallel.
+
+           @param states [in] the states to check.
+           @param stopAtFirst [in] if true, the checking stops at the first
+           state in collision and only the bit of this state is set.
+           @return bitset where bit i is set if state i is in collision.
+         */
+        boost::dynamic_bitset<> inCollisionBatch(const std::vector<rw::kinematics::State>& states,
+                                                 bool stopAtFirst = false) const;
+
         /**
            Destructor
         */
@@ -84,6 +100,14 @@ namespace rw { namespace pathplanning {
         */
         virtual bool doInCollision(const rw::kinematics::State& state) const = 0;
 
+        /**
+           @brief Subclass implementation of the inCollisionBatch() method.
+
+           The default implementation calls inCollision() for each state.
+        */
+        virtual boost::dynamic_bitset<> doInCollisionBatch(const std::vector<rw::kinematics::State>& states,
+                                                           bool stopAtFirst) const;
+
         /**
          * @brief Set a log.
          * @param log [in] the log.
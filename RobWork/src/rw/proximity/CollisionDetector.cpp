@@ -20,17 +20,24 @@
 #include "CollisionStrategy.hpp"
 
 #include <rw/common/ScopedTimer.hpp>
+#include <rw/common/FunctionTask.hpp>
+#include <rw/common/ThreadPool.hpp>
+#include <rw/models/Device.hpp>
 #include <rw/models/Object.hpp>
 #include <rw/models/WorkCell.hpp>
 #include <rw/kinematics/State.hpp>
 #include <rw/kinematics/Frame.hpp>
-#include <rw/kinematics/FKTable.hpp>
 #include <rw/common/macros.hpp>
 
 #include "BasicFilterStrategy.hpp"
 
 #include "ProximityData.hpp"
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <limits>
 
 using namespace rw;
 using namespace rw::common;
@@ -40,9 +47,127 @@ using namespace rw::math;
 using namespace rw::proximity;
 using namespace rw::geometry;
 
+namespace {
+	// A frame pair from the broad phase filter with its models and transforms.
+	struct Candidate {
+		FramePair pair;
+		ProximityModel::Ptr a, b;
+		const Transform3D<>* aT;
+		const Transform3D<>* bT;
+		// the data kept for the pair, or NULL to use the data of the task
+		ProximityStrategyData* data;
+	};
+
+	// The state shared by the narrow phase tasks of a parallel query.
+	class ParallelQuery {
+	public:
+		ParallelQuery(const std::vector<Candidate>& candidates,
+					  CollisionStrategy::Ptr strategy,
+					  CollisionStrategy::QueryType type,
+					  bool stopAtFirstContact):
+			candidates(candidates),
+			strategy(strategy),
+			type(type),
+			stopAtFirstContact(stopAtFirstContact),
+			_first(std::numeric_limits<std::size_t>::max())
+		{}
+
+		// Index of the first colliding candidate found so far.
+		std::size_t getFirstContact() const {
+			boost::mutex::scoped_lock lock(_mutex);
+			return _first;
+		}
+
+		void setContact(std::size_t i) {
+			boost::mutex::scoped_lock lock(_mutex);
+			if (i < _first)
+				_first = i;
+		}
+
+		const std::vector<Candidate>& candidates;
+		const CollisionStrategy::Ptr strategy;
+		const CollisionStrategy::QueryType type;
+		const bool stopAtFirstContact;
+
+	private:
+		mutable boost::mutex _mutex;
+		std::size_t _first;
+	};
+
+	// check the candidates [begin, end) and store the indices of the colliding candidates
+	void narrowPhase(ParallelQuery& query, std::size_t begin, std::size_t end, std::vector<std::size_t>& colliding)
+	{
+		ProximityStrategyData data;
+		data.setCollisionQueryType(query.type);
+		for (std::size_t i = begin; i < end; i++) {
+			// pairs after a known contact do not change the result
+			if (query.stopAtFirstContact && i > query.getFirstContact())
+				return;
+			const Candidate& c = query.candidates[i];
+			bool res = query.strategy.isNull();
+			if (!res)
+				res = query.strategy->inCollision(c.a, *c.aT, c.b, *c.bT, c.data ? *c.data : data);
+			if (res) {
+				if (query.stopAtFirstContact) {
+					query.setContact(i);
+					return;
+				}
+				colliding.push_back(i);
+			}
+		}
+	}
+}
+
+struct CollisionDetector::BatchQuery {
+	BatchQuery(std::size_t size, std::vector<QueryResult>* results,
+			   bool stopAtFirstContact, bool stopAtFirstState):
+		size(size),
+		states(NULL),
+		qs(NULL),
+		state(NULL),
+		results(results),
+		stopAtFirstContact(stopAtFirstContact),
+		stopAtFirstState(stopAtFirstState),
+		colliding(size, 0),
+		_first(std::numeric_limits<std::size_t>::max())
+	{}
+
+	// Index of the first colliding state found so far.
+	std::size_t getFirstState() const {
+		boost::mutex::scoped_lock lock(_mutex);
+		return _first;
+	}
+
+	void setFirstState(std::size_t i) {
+		boost::mutex::scoped_lock lock(_mutex);
+		if (i < _first)
+			_first = i;
+	}
+
+	const std::size_t size;
+	// either the states are given directly, or as configurations of a device
+	const std::vector<State>* states;
+	Device::CPtr device;
+	const std::vector<Q>* qs;
+	const State* state;
+	std::vector<QueryResult>* const results;
+	const bool stopAtFirstContact;
+	const bool stopAtFirstState;
+	// one flag per state, written by one chunk only
+	std::vector<char> colliding;
+	// the broad phase filter is not required to be thread safe
+	boost::mutex filterMutex;
+
+private:
+	mutable boost::mutex _mutex;
+	std::size_t _first;
+};
+
 CollisionDetector::CollisionDetector(WorkCell::Ptr workcell):
 	_numberOfCalls(0),
-	_npstrategy(NULL)
+	_npstrategy(NULL),
+	_incrementalFK(false),
+	_temporalCoherence(false)
 {
 	RW_ASSERT(workcell);
 	_bpfilter = ownedPtr( new BasicFilterStrategy(workcell) );
@@ -50,7 +175,9 @@ CollisionDetector::CollisionDetector(WorkCell::Ptr workcell):
 
 CollisionDetector::CollisionDetector(WorkCell::Ptr workcell,
 									 CollisionStrategy::Ptr strategy) :
-    _npstrategy(strategy)
+    _npstrategy(strategy),
+    _incrementalFK(false),
+    _temporalCoherence(false)
 {
     RW_ASSERT(strategy!=NULL);
     RW_ASSERT(workcell!=NULL);
@@ -63,7 +190,9 @@ CollisionDetector::CollisionDetector(WorkCell::Ptr workcell,
 									 CollisionStrategy::Ptr strategy,
 									 ProximityFilterStrategy::Ptr bpfilter) :
     _bpfilter(bpfilter),
-    _npstrategy(strategy)
+    _npstrategy(strategy),
+    _incrementalFK(false),
+    _temporalCoherence(false)
 {
     RW_ASSERT(strategy);
     RW_ASSERT(workcell);
@@ -95,7 +224,10 @@ bool CollisionDetector::inCollision(const kinematics::State& state, ProximityDat
 	_numberOfCalls++;
 
     ProximityFilter::Ptr filter = _bpfilter->update(state);
-    FKTable fk(state);
+    if (_incrementalFK)
+        _fk.updateIncremental(state);
+    else
+        _fk.update(state);
     ProximityStrategyData data;
 
     proxdata._collisionData.collidingFrames.clear();
@@ -113,6 +245,11 @@ bool CollisionDetector::inCollision(const kinematics::State& state, ProximityDat
         data.setCollisionQueryType( CollisionStrategy::FirstContact );
     }
 
+    if (!_pool.isNull() && _pool->getNumberOfThreads() > 0) {
+        return inCollisionParallel(filter, data.getCollisionQueryType(), stopAtFirstContact,
+                                   &proxdata._collisionData.collidingFrames);
+    }
+
     // next we query the BP filter for framepairs that are possibly in collision
     while( !filter->isEmpty() ){
         const FramePair& pair = filter->frontAndPop();
@@ -127,11 +264,11 @@ bool CollisionDetector::inCollision(const kinematics::State& state, ProximityDat
         if(a==NULL || b==NULL)
             continue;
 
-        const Transform3D<> aT = fk.get(*pair.first);
-        const Transform3D<> bT = fk.get(*pair.second);
+        const Transform3D<>& aT = _fk.get(*pair.first);
+        const Transform3D<>& bT = _fk.get(*pair.second);
         bool res = _npstrategy.isNull();
         if (!res)
-        	res = _npstrategy->inCollision(a, aT, b, bT, data);
+        	res = _npstrategy->inCollision(a, aT, b, bT, getPairData(pair, data));
         if( res ){
             proxdata._collisionData.collidingFrames.insert(pair);
             if (stopAtFirstContact)
@@ -152,7 +289,17 @@ bool CollisionDetector::inCollision(const State& state,
 	//std::cout << "inCollision" << std::endl;
     // first we update the broadphase filter with the current state
 	ProximityFilter::Ptr filter = _bpfilter->update(state);
-	FKTable fk(state);
+	if (_incrementalFK)
+		_fk.updateIncremental(state);
+	else
+		_fk.update(state);
+
+	if (!_pool.isNull() && _pool->getNumberOfThreads() > 0) {
+		return inCollisionParallel(filter, CollisionStrategy::FirstContact,
+								   stopAtFirstContact || result == NULL,
+								   result == NULL ? NULL : &result->collidingFrames);
+	}
+
 	ProximityStrategyData data;
 	// next we query the BP filter for framepairs that are possibly in collision
 	while( !filter->isEmpty() ){
@@ -168,11 +315,11 @@ bool CollisionDetector::inCollision(const State& state,
 		if(a==NULL || b==NULL)
 			continue;
 
-		const Transform3D<> aT = fk.get(*pair.first);
-		const Transform3D<> bT = fk.get(*pair.second);
+		const Transform3D<>& aT = _fk.get(*pair.first);
+		const Transform3D<>& bT = _fk.get(*pair.second);
         bool res = _npstrategy.isNull();
         if (!res)
-        	res = _npstrategy->inCollision(a, aT, b, bT, data);
+        	res = _npstrategy->inCollision(a, aT, b, bT, getPairData(pair, data));
         if( res ){
 			if (result) {
 				result->collidingFrames.insert(pair);
@@ -188,6 +335,206 @@ bool CollisionDetector::inCollision(const State& state,
     return false;
 }
 
+bool CollisionDetector::inCollisionParallel(ProximityFilter::Ptr filter,
+											CollisionStrategy::QueryType type,
+											bool stopAtFirstContact,
+											FramePairSet* colliding) const
+{
+	// collect the candidate pairs in the order given by the broad phase filter
+	std::vector<Candidate> candidates;
+	ProximityStrategyData data;
+	data.setCollisionQueryType(type);
+	while( !filter->isEmpty() ){
+		const FramePair& pair = filter->frontAndPop();
+		Candidate c;
+		c.a = _frameToModels[*pair.first];
+		c.b = _frameToModels[*pair.second];
+		if(c.a==NULL || c.b==NULL)
+			continue;
+		c.pair = pair;
+		c.aT = &_fk.get(*pair.first);
+		c.bT = &_fk.get(*pair.second);
+		// each pair is checked by one task only, so the data of the pair can be used by the task
+		c.data = _temporalCoherence ? &getPairData(pair, data) : NULL;
+		candidates.push_back(c);
+	}
+	if (candidates.empty())
+		return false;
+
+	// use more chunks than threads to balance the load
+	const std::size_t nrOfChunks = std::min<std::size_t>(candidates.size(), 4*_pool->getNumberOfThreads());
+	ParallelQuery query(candidates, _npstrategy, type, stopAtFirstContact);
+	std::vector<std::vector<std::size_t> > chunkResults(nrOfChunks);
+	std::vector<boost::function<void()> > work;
+	for (std::size_t i = 0; i < nrOfChunks; i++) {
+		const std::size_t begin = i*candidates.size()/nrOfChunks;
+		const std::size_t end = (i+1)*candidates.size()/nrOfChunks;
+		work.push_back(boost::bind(&narrowPhase, boost::ref(query), begin, end, boost::ref(chunkResults[i])));
+	}
+	FunctionTask::runAll(_pool, work);
+
+	// merge the results in the order of the chunks
+	if (stopAtFirstContact) {
+		const std::size_t first = query.getFirstContact();
+		if (first >= candidates.size())
+			return false;
+		if (colliding)
+			colliding->insert(candidates[first].pair);
+		return true;
+	}
+	bool res = false;
+	BOOST_FOREACH(const std::vector<std::size_t>& chunk, chunkResults) {
+		BOOST_FOREACH(std::size_t i, chunk) {
+			if (colliding)
+				colliding->insert(candidates[i].pair);
+			res = true;
+		}
+	}
+	return res;
+}
+
+boost::dynamic_bitset<> CollisionDetector::inCollisionBatch(const std::vector<State>& states,
+														  std::vector<QueryResult>* results,
+														  bool stopAtFirstContact,
+														  bool stopAtFirstState) const
+{
+	BatchQuery query(states.size(), results, stopAtFirstContact, stopAtFirstState);
+	query.states = &states;
+	return inCollisionBatch(query);
+}
+
+boost::dynamic_bitset<> CollisionDetector::inCollisionBatch(Device::CPtr device,
+														  const std::vector<Q>& qs,
+														  const State& state,
+														  std::vector<QueryResult>* results,
+														  bool stopAtFirstContact,
+														  bool stopAtFirstState) const
+{
+	RW_ASSERT(device);
+	BatchQuery query(qs.size(), results, stopAtFirstContact, stopAtFirstState);
+	query.device = device;
+	query.qs = &qs;
+	query.state = &state;
+	return inCollisionBatch(query);
+}
+
+boost::dynamic_bitset<> CollisionDetector::inCollisionBatch(BatchQuery& query) const
+{
+	ScopedTimer stimer(_timer);
+	_numberOfCalls += (int)query.size;
+
+	if (query.results) {
+		query.results->clear();
+		query.results->resize(query.size);
+	}
+
+	if (_pool.isNull() || _pool->getNumberOfThreads() == 0 || query.size <= 1) {
+		inCollisionBatchChunk(query, 0, query.size);
+	} else {
+		// use more chunks than threads to balance the load
+		const std::size_t nrOfChunks = std::min<std::size_t>(query.size, 4*_pool->getNumberOfThreads());
+		std::vector<boost::function<void()> > work;
+		for (std::size_t i = 0; i < nrOfChunks; i++) {
+			const std::size_t begin = i*query.size/nrOfChunks;
+			const std::size_t end = (i+1)*query.size/nrOfChunks;
+			work.push_back(boost::bind(&CollisionDetector::inCollisionBatchChunk, this,
+									   boost::ref(query), begin, end));
+		}
+		FunctionTask::runAll(_pool, work);
+	}
+
+	boost::dynamic_bitset<> res(query.size);
+	if (query.stopAtFirstState) {
+		const std::size_t first = query.getFirstState();
+		if (first < query.size)
+			res.set(first);
+		return res;
+	}
+	for (std::size_t i = 0; i < query.size; i++) {
+		if (query.colliding[i])
+			res.set(i);
+	}
+	return res;
+}
+
+void CollisionDetector::inCollisionBatchChunk(BatchQuery& query, std::size_t begin, std::size_t end) const
+{
+	// Consecutive states of a chunk reuse the forward kinematics, so only the
+	// frames that changed since the previous state are recalculated.
+	FKCompiled fk;
+	ProximityStrategyData data;
+	data.setCollisionQueryType(CollisionStrategy::FirstContact);
+	std::vector<Candidate> candidates;
+	State qstate;
+	if (query.qs)
+		qstate = *query.state;
+
+	for (std::size_t i = begin; i < end; i++) {
+		// states after a known collision do not change the result
+		if (query.stopAtFirstState && i > query.getFirstState())
+			return;
+
+		const State* state = &qstate;
+		if (query.qs)
+			query.device->setQ((*query.qs)[i], qstate);
+		else
+			state = &(*query.states)[i];
+
+		// the frame map may grow on lookup, so the models are found while locked
+		candidates.clear();
+		{
+			boost::mutex::scoped_lock lock(query.filterMutex);
+			ProximityFilter::Ptr filter = _bpfilter->update(*state);
+			while( !filter->isEmpty() ){
+				const FramePair& pair = filter->frontAndPop();
+				Candidate c;
+				c.a = _frameToModels[*pair.first];
+				c.b = _frameToModels[*pair.second];
+				if(c.a==NULL || c.b==NULL)
+					continue;
+				c.pair = pair;
+				c.data = NULL;
+				candidates.push_back(c);
+			}
+		}
+		fk.updateIncremental(*state);
+
+		QueryResult* const result = query.results ? &(*query.results)[i] : NULL;
+		bool colliding = false;
+		BOOST_FOREACH(const Candidate& c, candidates) {
+			bool res = _npstrategy.isNull();
+			if (!res)
+				res = _npstrategy->inCollision(c.a, fk.get(*c.pair.first), c.b, fk.get(*c.pair.second), data);
+			if (res) {
+				colliding = true;
+				if (result)
+					result->collidingFrames.insert(c.pair);
+				if (result == NULL || query.stopAtFirstContact)
+					break;
+			}
+		}
+
+		if (colliding) {
+			query.colliding[i] = 1;
+			if (query.stopAtFirstState) {
+				query.setFirstState(i);
+				return;
+			}
+		}
+	}
+}
+
+ProximityStrategyData& CollisionDetector::getPairData(const FramePair& pair, ProximityStrategyData& data) const
+{
+	if (!_temporalCoherence)
+		return data;
+	ProximityStrategyData::Ptr& pairData = _pairData[pair];
+	if (pairData == NULL)
+		pairData = ownedPtr(new ProximityStrategyData());
+	pairData->setCollisionQueryType(data.getCollisionQueryType());
+	return *pairData;
+}
+
 void CollisionDetector::addGeometry(rw::kinematics::Frame* frame, const rw::geometry::Geometry::Ptr geometry) {
 	if (geometry == NULL) {
 		RW_THROW("Unable to add NULL as geometry");
@@ -198,8 +545,8 @@ void CollisionDetector::addGeometry(rw::kinematics::Frame* frame, const rw::geom
 	}
 
 	_bpfilter->addGeometry(frame, geometry);
-
-	
+	// the cached results refer to the old geometries
+	_pairData.clear();
 }
 
 void CollisionDetector::removeGeometry(rw::kinematics::Frame* frame, const rw::geometry::Geometry::Ptr geo) {
@@ -220,6 +567,7 @@ void CollisionDetector::removeGeometry(rw::kinematics::Frame* frame, const std::
 		_npstrategy->removeGeometry(model.get(), geoid);
 		_frameToModels[*frame] = _npstrategy->getModel(frame);
 	}
+	_pairData.clear();
 }
 
 
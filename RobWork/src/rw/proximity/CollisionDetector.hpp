@@ -31,6 +31,10 @@
 #include <rw/common/Ptr.hpp>
 #include <rw/common/Timer.hpp>
 #include <rw/kinematics/FrameMap.hpp>
+#include <rw/kinematics/FramePairMap.hpp>
+#include <rw/kinematics/FKCompiled.hpp>
+
+#include <boost/dynamic_bitset.hpp>
 
 #include <vector>
 
@@ -41,6 +45,9 @@ class State;
 }
 }
 
+namespace rw { namespace common { class ThreadPool; } }
+namespace rw { namespace math { class Q; } }
+namespace rw { namespace models { class Device; } }
 namespace rw { namespace models { class WorkCell; } }
 
 namespace rw {
@@ -63,6 +70,9 @@ namespace proximity {
  strategy or algorithm, instead it relies on the CollisionStrategy interface for
  the actual collision checking between two frames.
 
+ The narrow phase checks of a query can be distributed over a rw::common::ThreadPool,
+ see setThreadPool().
+
  @note The collision detector is not thread safe and as such should not be used by multiple
  threads at a time.
  */
@@ -164,6 +174,60 @@ public:
      */
     bool inCollision(const kinematics::State& state, class ProximityData &data) const;
 
+    /**
+     @brief Check a batch of states for collisions.
+
+     The states are divided in chunks that are checked by the threads of the
+     pool set with setThreadPool(), or in the calling thread if no pool is
+     set. Each chunk reuses its own forward kinematics and
+     ProximityStrategyData for consecutive states, so batches of states that
+     differ in few frames, such as the discretization of an edge, are
+     cheap to check.
+
+     @param states [in] the states to check.
+     @param results [out] if non-NULL, it is resized to the number of states
+     and the pairs of colliding frames for state i are inserted in element i.
+     @param stopAtFirstContact [in] if \b results is non-NULL and \b
+     stopAtFirstContact is true, then only the first colliding pair of a state
+     is inserted. By default all colliding pairs are inserted.
+     @param stopAtFirstState [in] if true, the checking stops at the first
+     state in collision and only the bit for this state is set in the result.
+     @return bitset where bit i is set if state i is in collision.
+
+     @note The CollisionStrategy must allow concurrent queries that use
+     different ProximityStrategyData objects when a thread pool is used. The
+     ProximityFilterStrategy is only accessed by one thread at a time.
+     */
+    boost::dynamic_bitset<> inCollisionBatch(const std::vector<kinematics::State>& states,
+                                             std::vector<QueryResult>* results = NULL,
+                                             bool stopAtFirstContact = false,
+                                             bool stopAtFirstState = false) const;
+
+    /**
+     @brief Check a batch of configurations of a device for collisions.
+
+     This is the same as inCollisionBatch(const std::vector<kinematics::State>&, std::vector<QueryResult>*, bool, bool) const
+     for the states given by setting each configuration of \b qs for \b device
+     in \b state, but without creating a state per configuration.
+
+     @param device [in] the device.
+     @param qs [in] the configurations of the device.
+     @param state [in] the state giving the configuration of the rest of the
+     workcell.
+     @param results [out] if non-NULL, the pairs of colliding frames for
+     configuration i are inserted in element i.
+     @param stopAtFirstContact [in] only insert the first colliding pair of a
+     configuration.
+     @param stopAtFirstState [in] stop at the first configuration in collision.
+     @return bitset where bit i is set if configuration i is in collision.
+     */
+    boost::dynamic_bitset<> inCollisionBatch(rw::common::Ptr<const rw::models::Device> device,
+                                             const std::vector<rw::math::Q>& qs,
+                                             const kinematics::State& state,
+                                             std::vector<QueryResult>* results = NULL,
+                                             bool stopAtFirstContact = false,
+                                             bool stopAtFirstState = false) const;
+
     /**
      * @brief The broad phase collision strategy of the collision checker.
      */
@@ -241,6 +305,96 @@ public:
 		_numberOfCalls = 0;
 	}
 
+    /**
+     * @brief Enable or disable incremental forward kinematics between calls
+     * to the inCollision functions.
+     *
+     * When enabled, only the frames whose state values changed since the
+     * previous query (and the frames below them) have their world transforms
+     * recalculated. This pays off when consecutive queries differ in only a few
+     * joints, such as when checking the intermediate configurations of an edge.
+     *
+     * @note Kinematic changes that are not part of the State, such as
+     * FixedFrame::setTransform(), are not detected when this is enabled.
+     * See rw::kinematics::FKCompiled::updateIncremental.
+     *
+     * @param enable [in] true to enable, false to calculate all frames (default).
+     */
+    void setIncrementalKinematics(bool enable) {
+        _incrementalFK = enable;
+        _fk.invalidate();
+    }
+
+    /**
+     * @brief Check if incremental forward kinematics is used.
+     * @return true if enabled, false otherwise.
+     */
+    bool isIncrementalKinematics() const {
+        return _incrementalFK;
+    }
+
+    /**
+     * @brief Enable or disable temporal coherence between calls to the
+     * inCollision functions.
+     *
+     * When enabled, a ProximityStrategyData is kept for each frame pair
+     * between queries, such that the CollisionStrategy can keep its cache
+     * for the pair. Strategies use the cache to start the next query from
+     * the result of the previous one, such as a separating axis or a pair of
+     * colliding primitives. This pays off when consecutive queries are for
+     * nearly identical states, such as when validating a trajectory.
+     *
+     * The data is not used by inCollisionBatch(), where each chunk of states
+     * uses its own data.
+     *
+     * @param enable [in] true to keep data for each frame pair, false to use
+     * new data for each query (default).
+     */
+    void setTemporalCoherence(bool enable) {
+        _temporalCoherence = enable;
+        _pairData.clear();
+    }
+
+    /**
+     * @brief Check if data is kept for each frame pair between queries.
+     * @return true if enabled, false otherwise.
+     */
+    bool isTemporalCoherence() const {
+        return _temporalCoherence;
+    }
+
+    /**
+     * @brief Set a thread pool used to run the narrow phase checks of a query
+     * in parallel.
+     *
+     * The frame pairs returned by the broad phase filter are divided in
+     * chunks that are checked by the threads of the pool, each with its own
+     * ProximityStrategyData. The result is the same as for a sequential
+     * query: when the query stops at the first contact, it is the first
+     * colliding pair in the order of the broad phase filter that is
+     * reported, and the checking of later pairs is cancelled as soon as a
+     * contact is found.
+     *
+     * @note The CollisionStrategy must allow concurrent queries that use
+     * different ProximityStrategyData objects. The query waits for the
+     * pool, so it should not be called from a task running in the same
+     * pool.
+     *
+     * @param pool [in] the pool, or NULL to check all pairs in the calling
+     * thread (default).
+     */
+    void setThreadPool(rw::common::Ptr<rw::common::ThreadPool> pool) {
+        _pool = pool;
+    }
+
+    /**
+     * @brief Get the thread pool used for the narrow phase checks.
+     * @return the pool, or NULL if the checks are done in the calling thread.
+     */
+    rw::common::Ptr<rw::common::ThreadPool> getThreadPool() const {
+        return _pool;
+    }
+
     /**
      * @brief return the ids of all the geometries of this frames.
      */
@@ -260,6 +414,47 @@ private:
 	 */
     void initialize(rw::common::Ptr<rw::models::WorkCell> wc);
 
+    /**
+     * @brief Run the narrow phase checks for the pairs of \b filter on the
+     * thread pool.
+     * @param filter [in] the broad phase filter with the candidate pairs.
+     * @param type [in] the query type for the collision strategy.
+     * @param stopAtFirstContact [in] stop at the first colliding pair.
+     * @param colliding [out] if non-NULL, the colliding pairs are inserted.
+     * @return true if a collision is detected; false otherwise.
+     */
+    bool inCollisionParallel(ProximityFilter::Ptr filter,
+                             CollisionStrategy::QueryType type,
+                             bool stopAtFirstContact,
+                             kinematics::FramePairSet* colliding) const;
+
+    //! @brief The states and settings of a batch query.
+    struct BatchQuery;
+
+    /**
+     * @brief Run a batch query on the thread pool, or in the calling thread
+     * if there is no pool.
+     * @param query [in/out] the query.
+     * @return bitset with the states in collision.
+     */
+    boost::dynamic_bitset<> inCollisionBatch(BatchQuery& query) const;
+
+    /**
+     * @brief Check the states \b begin to \b end of a batch query.
+     * @param query [in/out] the query.
+     * @param begin [in] the first state.
+     * @param end [in] one past the last state.
+     */
+    void inCollisionBatchChunk(BatchQuery& query, std::size_t begin, std::size_t end) const;
+
+    /**
+     * @brief Get the data for a frame pair when temporal coherence is enabled.
+     * @param pair [in] the frame pair.
+     * @param data [in] the data to use if temporal coherence is disabled.
+     * @return the data to use for the pair.
+     */
+    ProximityStrategyData& getPairData(const kinematics::FramePair& pair, ProximityStrategyData& data) const;
+
     //! @brief Timer for measuring the time spent in inCollision functions.
 	mutable rw::common::Timer _timer;
 	//! @brief The number of calls to the inCollision functions.
@@ -270,6 +465,16 @@ private:
 	CollisionStrategy::Ptr _npstrategy;
 	//! @brief Map from frame to collision model.
 	rw::kinematics::FrameMap<ProximityModel::Ptr> _frameToModels;
+	//! @brief Forward kinematics reused between calls to the inCollision functions.
+	mutable rw::kinematics::FKCompiled _fk;
+	//! @brief Use incremental forward kinematics.
+	bool _incrementalFK;
+	//! @brief Keep data for each frame pair between queries.
+	bool _temporalCoherence;
+	//! @brief The data for each frame pair.
+	mutable rw::kinematics::FramePairMap<ProximityStrategyData::Ptr> _pairData;
+	//! @brief Thread pool for the narrow phase checks.
+	rw::common::Ptr<rw::common::ThreadPool> _pool;
 
 #if __cplusplus < 201103L
 private:
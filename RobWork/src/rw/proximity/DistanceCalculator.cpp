@@ -21,15 +21,21 @@
 #include <RobWorkConfig.hpp>
 
 #include <rw/common/ScopedTimer.hpp>
+#include <rw/common/FunctionTask.hpp>
+#include <rw/common/ThreadPool.hpp>
+#include <rw/geometry/Geometry.hpp>
+#include <rw/geometry/TriMesh.hpp>
 #include <rw/kinematics/FKTable.hpp>
 #include <rw/kinematics/Kinematics.hpp>
 #include <rw/models/Object.hpp>
 #include <rw/models/WorkCell.hpp>
 
-//#include <omp.h>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <algorithm>
 #include <float.h>
-//#include <algorithm>
-#include "ProximityStrategyData.hpp"
 
 using namespace rw;
 using namespace rw::math;
@@ -66,8 +72,8 @@ DistanceCalculator::DistanceCalculator(WorkCell::Ptr workcell,
 									   DistanceStrategy::Ptr strategy):
     _root(workcell->getWorldFrame()),
     _strategy(strategy),
-    _state(workcell->getDefaultState())
-
+    _state(workcell->getDefaultState()),
+    _temporalCoherence(false)
 {
     RW_ASSERT(strategy);
     RW_ASSERT(workcell);
@@ -87,7 +93,8 @@ DistanceCalculator::DistanceCalculator(Frame* root,
                                        const State& initialState):
     _root(root),
     _strategy(strategy),
-    _state(initialState)
+    _state(initialState),
+    _temporalCoherence(false)
 {
     RW_ASSERT(root);
     RW_ASSERT(workcell);
@@ -109,7 +116,8 @@ DistanceCalculator::DistanceCalculator(const FramePairList& pairs,
 	_cnt(0),
 	_root(nullptr),
 	_strategy(strategy),
-	_distancePairs(pairs)
+	_distancePairs(pairs),
+	_temporalCoherence(false)
 {
     RW_ASSERT(strategy);
 	_thresholdStrategy = _strategy;
@@ -127,6 +135,7 @@ void DistanceCalculator::initializeGeometry(rw::common::Ptr<const WorkCell> wc)
             const Frame* frame = geom->getFrame(); // this is not const - should it be?
             RW_ASSERT(frame);
             _strategy->addModel(frame, geom);
+            addBoundingSphere(frame, *geom);
             //_frameToModels[*frame] = _npstrategy->getModel(frame);
         }
     }
@@ -184,163 +193,268 @@ DistanceCalculator::~DistanceCalculator()
 {
 }
 
+struct DistanceCalculator::PairQuery {
+    const Frame* a;
+    const Frame* b;
+    ProximityModel::Ptr modelA;
+    ProximityModel::Ptr modelB;
+    // models of the threshold strategy
+    ProximityModel::Ptr thresholdModelA;
+    ProximityModel::Ptr thresholdModelB;
+    Transform3D<> wTa;
+    Transform3D<> wTb;
+    double lowerBound;
+    // the data kept for the pair, or NULL to use the data of the worker
+    ProximityStrategyData* data;
+    // index in the result
+    std::size_t index;
+};
+
+struct DistanceCalculator::ParallelQuery {
+    ParallelQuery(const std::vector<PairQuery>& queries, bool prune, std::vector<DistanceStrategy::Result>* result):
+        queries(queries), prune(prune), result(result), next(0)
+    {
+        distance.distance = DBL_MAX;
+    }
+
+    const std::vector<PairQuery>& queries;
+    const bool prune;
+    std::vector<DistanceStrategy::Result>* const result;
+
+    boost::mutex mutex;
+    // the next query to check and the shortest distance found (protected by mutex)
+    std::size_t next;
+    DistanceStrategy::Result distance;
+};
+
 DistanceStrategy::Result DistanceCalculator::distance(const State& state,
 											std::vector<DistanceStrategy::Result>* result) const
 {
 	_cnt++;
 	ScopedTimer stimer(_timer);
-    FKTable fk(state);
-
-    if (result != NULL)
-    	result->clear();
-
-    ProximityStrategyData data;
-    DistanceStrategy::Result distance;
-    distance.distance = DBL_MAX;
-
-	typedef FramePairList::const_iterator I;
-	for (I p = _distancePairs.cbegin(); p != _distancePairs.cend(); ++p) {
-        const Frame* a = p->first;
-        const Frame* b = p->second;
-
-        DistanceStrategy::Result *dist;
-        if (distance.distance == DBL_MAX || _thresholdStrategy == NULL) {
-	       dist = &_strategy->distance(a, fk.get(*a), b, fk.get(*b), data);
-		} else {
-	        dist = &_thresholdStrategy->distance(a, fk.get(*a), b, fk.get(*b), distance.distance, data);
-		}
-
-        dist->f1 = a;
-        dist->f2 = b;
+    const FKTable fk(state);
 
-        if (dist->distance < distance.distance)
-            distance = *dist;
-
-        if (result != NULL)
-            result->push_back(*dist);
-
-    }
-
-    return distance;
+    std::vector<std::size_t> pairs(_distancePairs.size());
+    for (std::size_t i = 0; i < pairs.size(); i++)
+        pairs[i] = i;
+    return distance(fk, pairs, result);
 }
 
 DistanceResult DistanceCalculator::distanceOMP(const State& state,
 											std::vector<DistanceResult>* result) const
 {
-	_cnt++;
+    return distance(state, result);
+}
+
+DistanceStrategy::Result DistanceCalculator::distance(const State& state,
+                                            const Frame* frame,
+                                            std::vector<DistanceStrategy::Result>* result) const
+{
 	ScopedTimer stimer(_timer);
-    FKTable fk(state);
+    const FKTable fk(state);
 
-    if (result != NULL)
-    	result->clear();
+    std::vector<std::size_t> pairs;
+    for (std::size_t i = 0; i < _distancePairs.size(); i++) {
+        if (_distancePairs[i].first == frame || _distancePairs[i].second == frame)
+            pairs.push_back(i);
+    }
+    return distance(fk, pairs, result);
+}
 
-    ProximityStrategyData data;
-    DistanceResult distance;
-    distance.distance = DBL_MAX;
-	//std::cout<<"Distance Pairs = "<<_distancePairs.size()<<std::endl;
-	const int N = (int)_distancePairs.size();
-	int i;
-	Transform3D<> ta, tb; 
-
-#ifdef RW_HAVE_OMP
-#pragma omp parallel for shared(distance, result, fk) private(i, data, ta, tb) schedule(static, 1)
-#endif
-	for (i = 0; i<N; i++) {
-	//for (I p = _distancePairs.begin(); p != _distancePairs.end(); ++p) {
-        //const Frame* a = p->first;
-        //const Frame* b = p->second;
-		const Frame* a = _distancePairs[i].first;
-		const Frame* b = _distancePairs[i].second;
-
-        DistanceResult *dist;
-#ifdef RW_HAVE_OMP
-#pragma omp critical
-#endif
-		{
-		ta = fk.get(*a);
-		tb = fk.get(*b);
-		}
-
-        if (distance.distance == DBL_MAX || _thresholdStrategy == NULL) {
-	       dist = &_strategy->distance(a, ta, b, tb, data);
-		} else {
-	        dist = &_thresholdStrategy->distance(a, ta, b, tb, distance.distance, data);
-		}
-
-        dist->f1 = a;
-        dist->f2 = b;
-#ifdef RW_HAVE_OMP
-#pragma omp critical
-#endif
-	{
-        if (dist->distance < distance.distance)
-            distance = *dist;
-
-        if (result != NULL)
-            result->push_back(*dist);
-		
-	} //#End #pragma omp critical
+DistanceStrategy::Result DistanceCalculator::distance(const FKTable& fk,
+                                                      const std::vector<std::size_t>& pairs,
+                                                      std::vector<DistanceStrategy::Result>* result) const
+{
+    // Everything that is not thread safe (the lazy FKTable, the frame to
+    // model maps and the pair data) is looked up before the pairs are checked.
+    const bool prune = result == NULL;
+    std::vector<PairQuery> queries(pairs.size());
+    for (std::size_t i = 0; i < pairs.size(); i++) {
+        const FramePair& pair = _distancePairs[pairs[i]];
+        PairQuery& query = queries[i];
+        query.a = pair.first;
+        query.b = pair.second;
+        query.modelA = _strategy->getModel(query.a);
+        query.modelB = _strategy->getModel(query.b);
+        if (query.modelA == NULL)
+            RW_THROW("Frame " << query.a->getName() << " has no Collision model attached!");
+        if (query.modelB == NULL)
+            RW_THROW("Frame " << query.b->getName() << " has no Collision model attached!");
+        if (_thresholdStrategy == _strategy) {
+            query.thresholdModelA = query.modelA;
+            query.thresholdModelB = query.modelB;
+        } else if (_thresholdStrategy != NULL) {
+            query.thresholdModelA = _thresholdStrategy->getModel(query.a);
+            query.thresholdModelB = _thresholdStrategy->getModel(query.b);
+        }
+        query.wTa = fk.get(*query.a);
+        query.wTb = fk.get(*query.b);
+        query.lowerBound = prune ? getLowerBound(query.a, query.wTa, query.b, query.wTb) : 0;
+        query.data = getPairData(pair);
+        query.index = i;
+    }
 
+    // The pairs most likely to be close are checked first, such that the
+    // threshold for the remaining pairs is low.
+    if (prune) {
+        std::stable_sort(queries.begin(), queries.end(), boost::bind(&PairQuery::lowerBound, _1) < boost::bind(&PairQuery::lowerBound, _2));
+    } else {
+        result->resize(queries.size());
     }
-//	} //End #pragma omp parallel for schedule
 
-    return distance;
+    ParallelQuery query(queries, prune, result);
+    const std::size_t threads = _pool == NULL ? 0 : (std::size_t)_pool->getNumberOfThreads();
+    if (threads == 0 || queries.size() < 2) {
+        distanceWorker(query);
+    } else {
+        const std::size_t workers = std::min(threads, queries.size());
+        const boost::function<void()> worker = boost::bind(&DistanceCalculator::distanceWorker, this, boost::ref(query));
+        FunctionTask::runAll(_pool, std::vector<boost::function<void()> >(workers, worker));
+    }
+    return query.distance;
 }
 
-DistanceStrategy::Result DistanceCalculator::distance(const State& state,
-                                            const Frame* frame,
-                                            std::vector<DistanceStrategy::Result>* result) const
+void DistanceCalculator::distanceWorker(ParallelQuery& query) const
 {
-	ScopedTimer stimer(_timer);
-    FKTable fk(state);
+    ProximityStrategyData data;
+    const std::size_t n = query.queries.size();
+    for (;;) {
+        std::size_t i;
+        double threshold;
+        {
+            boost::mutex::scoped_lock lock(query.mutex);
+            if (query.next >= n)
+                return;
+            i = query.next++;
+            threshold = query.distance.distance;
+        }
 
-    if (result != NULL)
-        result->clear();
+        const PairQuery& pair = query.queries[i];
+        if (query.prune && pair.lowerBound >= threshold) {
+            // the pairs are sorted by the lower bound, so no remaining pair can be closer
+            boost::mutex::scoped_lock lock(query.mutex);
+            query.next = n;
+            return;
+        }
 
-    ProximityStrategyData data;
-    DistanceStrategy::Result distance;
-    distance.distance = DBL_MAX;	
-    typedef FramePairList::const_iterator I;
-    for (I p = _distancePairs.cbegin(); p != _distancePairs.cend(); ++p) {
-        const Frame* a = p->first;
-        const Frame* b = p->second;
+        ProximityStrategyData& pdata = pair.data == NULL ? data : *pair.data;
+        DistanceStrategy::Result dist;
+        if (threshold == DBL_MAX || _thresholdStrategy == NULL) {
+            dist = _strategy->distance(pair.modelA, pair.wTa, pair.modelB, pair.wTb, pdata);
+        } else {
+            dist = _thresholdStrategy->distance(pair.thresholdModelA, pair.wTa, pair.thresholdModelB, pair.wTb, threshold, pdata);
+        }
+        dist.f1 = pair.a;
+        dist.f2 = pair.b;
 
-        if (a == frame || b == frame) {
+        if (query.result != NULL)
+            (*query.result)[pair.index] = dist;
 
-            DistanceStrategy::Result *dist;
-			if (distance.distance == DBL_MAX) {
-				dist = &_strategy->distance(a, fk.get(*a), b, fk.get(*b), data);
-			} else {
-				dist = &_thresholdStrategy->distance(a, fk.get(*a), b, fk.get(*b), distance.distance, data);
-			}
+        boost::mutex::scoped_lock lock(query.mutex);
+        if (dist.distance < query.distance.distance)
+            query.distance = dist;
+    }
+}
 
-            dist->f1 = a;
-            dist->f2 = b;
+void DistanceCalculator::addBoundingSphere(const Frame* frame, const Geometry& geom)
+{
+    const std::pair<std::map<const Frame*, BoundingSphere>::iterator, bool> inserted =
+        _bounds.insert(std::make_pair(frame, BoundingSphere()));
+    BoundingSphere& sphere = inserted.first->second;
+    if (!inserted.second && sphere.radius < 0)
+        return;
 
-            if (dist->distance < distance.distance)
-                distance = *dist;
+    TriMesh::Ptr mesh;
+    try {
+        mesh = geom.getGeometryData()->getTriMesh(false);
+    } catch (const Exception&) {
+    }
+    if (mesh == NULL || mesh->getSize() == 0) {
+        sphere.radius = -1;
+        return;
+    }
+
+    // Sphere centered in the middle of the axis aligned box of the vertices
+    const Transform3D<>& t3d = geom.getTransform();
+    const double scale = geom.getScale();
+    std::vector<Vector3D<> > vertices;
+    vertices.reserve(mesh->getSize()*3);
+    Vector3D<> min(DBL_MAX, DBL_MAX, DBL_MAX);
+    Vector3D<> max(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+    for (std::size_t i = 0; i < mesh->getSize(); i++) {
+        const Triangle<> tri = mesh->getTriangle(i);
+        for (std::size_t j = 0; j < 3; j++) {
+            const Vector3D<> v = t3d*(tri.getVertex(j)*scale);
+            for (std::size_t k = 0; k < 3; k++) {
+                min[k] = std::min(min[k], v[k]);
+                max[k] = std::max(max[k], v[k]);
+            }
+            vertices.push_back(v);
+        }
+    }
+    const Vector3D<> center = (min + max)/2.;
+    double radius = 0;
+    BOOST_FOREACH(const Vector3D<>& v, vertices) {
+        radius = std::max(radius, (v - center).norm2());
+    }
 
-            if (result != NULL)
-                result->push_back(*dist);
+    if (inserted.second) {
+        sphere.center = center;
+        sphere.radius = radius;
+    } else {
+        // Smallest sphere enclosing both spheres
+        const Vector3D<> dir = center - sphere.center;
+        const double dist = dir.norm2();
+        if (dist + radius <= sphere.radius)
+            return;
+        if (dist + sphere.radius <= radius) {
+            sphere.center = center;
+            sphere.radius = radius;
+            return;
         }
+        const double newRadius = (dist + sphere.radius + radius)/2.;
+        sphere.center += dir*((newRadius - sphere.radius)/dist);
+        sphere.radius = newRadius;
     }
+}
 
-    return distance;
+double DistanceCalculator::getLowerBound(const Frame* a, const Transform3D<>& wTa,
+                                         const Frame* b, const Transform3D<>& wTb) const
+{
+    const std::map<const Frame*, BoundingSphere>::const_iterator sa = _bounds.find(a);
+    const std::map<const Frame*, BoundingSphere>::const_iterator sb = _bounds.find(b);
+    if (sa == _bounds.end() || sb == _bounds.end() || sa->second.radius < 0 || sb->second.radius < 0)
+        return 0;
+    const double dist = (wTa*sa->second.center - wTb*sb->second.center).norm2();
+    return std::max(0., dist - sa->second.radius - sb->second.radius);
 }
 
+ProximityStrategyData* DistanceCalculator::getPairData(const FramePair& pair) const
+{
+    if (!_temporalCoherence)
+        return NULL;
+    ProximityStrategyData::Ptr& pairData = _pairData[pair];
+    if (pairData == NULL)
+        pairData = ownedPtr(new ProximityStrategyData());
+    return pairData.get();
+}
 
 void DistanceCalculator::setDistanceStrategy(DistanceStrategy::Ptr strategy)
 {
     RW_ASSERT(strategy);
     _strategy = strategy;
+    _pairData.clear();
 }
 
 bool DistanceCalculator::addDistanceModel(const Frame* frame,
 										  const rw::geometry::Geometry& faces)
 {
     bool res = _strategy->addModel(frame, faces);
-    if (res)
+    if (res) {
+        addBoundingSphere(frame, faces);
         initializeDistancePairs();
+        _pairData.clear();
+    }
     return res;
 }
 
@@ -349,4 +463,6 @@ void DistanceCalculator::clearCache()
     // Clear frame pairs list
     _strategy->clear();
     initializeDistancePairs();
+    _pairData.clear();
+    _bounds.clear();
 }
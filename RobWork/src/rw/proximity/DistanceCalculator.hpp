@@ -20,14 +20,19 @@
 #define RW_PROXIMITY_DISTANCECALCULATOR_HPP
 
 #include "DistanceStrategy.hpp"
+#include "ProximityStrategyData.hpp"
 #include <rw/common/Timer.hpp>
+#include <rw/kinematics/FramePairMap.hpp>
 #include <rw/proximity/CollisionSetup.hpp>
 
+#include <map>
+
 /**
  * @file DistanceCalculator.hpp
  */
 
-namespace rw { namespace kinematics { class State; } }
+namespace rw { namespace common { class ThreadPool; } }
+namespace rw { namespace kinematics { class FKTable; class State; } }
 namespace rw { namespace models { class WorkCell; } }
 
 namespace rw { namespace proximity {
@@ -45,6 +50,14 @@ namespace rw { namespace proximity {
      * chosen.
      *
      * The DistanceCalculator supports switching between multiple strategies
+     *
+     * For each frame with geometry added through the DistanceCalculator, a
+     * bounding sphere is kept. When only the shortest distance is requested,
+     * the frame pairs are checked in order of the lower bound on their
+     * distance given by the spheres, and the current shortest distance is
+     * given as threshold to the DistanceStrategy. The remaining pairs are
+     * skipped as soon as their lower bound exceeds the shortest distance.
+     * The pairs can be checked in parallel, see setThreadPool().
      */
     class DistanceCalculator {
     public:
@@ -114,6 +127,11 @@ namespace rw { namespace proximity {
         /**
          * @brief Calculates the distances between frames in the tree
          *
+         * If \b result is NULL, pairs that can not be closer than the
+         * shortest distance found are skipped. Otherwise all pairs are checked,
+         * but only the results closer than the shortest distance found by
+         * earlier pairs are exact.
+         *
          * @param state [in] The state for which to calculate distances.
          *
          * @param result [out] If non-NULL, the distance results are written
@@ -124,6 +142,12 @@ namespace rw { namespace proximity {
         DistanceStrategy::Result distance(const kinematics::State& state,
                                 std::vector<DistanceStrategy::Result>* result = 0) const;
 
+        /**
+         * @brief Calculates the distances between frames in the tree.
+         * @deprecated The pairs are checked in parallel by distance() when a
+         * thread pool is set with setThreadPool(). This function is the same
+         * as distance().
+         */
         DistanceStrategy::Result distanceOMP(const kinematics::State& state,
 					  			   std::vector<DistanceStrategy::Result>* result = 0) const;
 
@@ -186,6 +210,120 @@ namespace rw { namespace proximity {
 
 
 		void setDistanceThresholdStrategy(DistanceStrategy::Ptr strategy);
+
+        /**
+         * @brief The pairs of frames that distances are calculated for.
+         * @return the frame pairs.
+         */
+        const kinematics::FramePairList& getDistancePairs() const {
+            return _distancePairs;
+        }
+
+        /**
+         * @brief Enable or disable temporal coherence between calls to the
+         * distance functions.
+         *
+         * When enabled, a ProximityStrategyData is kept for each frame pair
+         * between queries, such that the DistanceStrategy can keep its cache
+         * for the pair. Strategies use the cache to start the next query from
+         * the result of the previous one, such as the closest pair of
+         * primitives. This pays off when consecutive queries are for nearly
+         * identical states.
+         *
+         * @param enable [in] true to keep data for each frame pair, false to
+         * use new data for each query (default).
+         */
+        void setTemporalCoherence(bool enable) {
+            _temporalCoherence = enable;
+            _pairData.clear();
+        }
+
+        /**
+         * @brief Check if data is kept for each frame pair between queries.
+         * @return true if enabled, false otherwise.
+         */
+        bool isTemporalCoherence() const {
+            return _temporalCoherence;
+        }
+
+        /**
+         * @brief Set a thread pool used to calculate the distances of the
+         * frame pairs in parallel.
+         *
+         * The threads of the pool take the next unchecked pair from the
+         * common list of pairs, and use the shortest distance found so far by
+         * any thread as threshold. If only the shortest distance is requested,
+         * the threads stop when the lower bound of the next pair exceeds the
+         * shortest distance.
+         *
+         * @note The DistanceStrategy must allow concurrent queries that use
+         * different ProximityStrategyData objects. The query waits for the
+         * pool, so it should not be called from a task running in the same
+         * pool.
+         *
+         * @param pool [in] the pool, or NULL to check all pairs in the calling
+         * thread (default).
+         */
+        void setThreadPool(rw::common::Ptr<rw::common::ThreadPool> pool) {
+            _pool = pool;
+        }
+
+        /**
+         * @brief Get the thread pool used for the distance calculations.
+         * @return the pool, or NULL if the distances are calculated in the
+         * calling thread.
+         */
+        rw::common::Ptr<rw::common::ThreadPool> getThreadPool() const {
+            return _pool;
+        }
+
+    private:
+        //! @brief A bounding sphere given in the frame of the geometry.
+        struct BoundingSphere {
+            BoundingSphere(): radius(0) {}
+            math::Vector3D<> center;
+            double radius;
+        };
+
+        struct PairQuery;
+        struct ParallelQuery;
+
+        /**
+         * @brief Calculate the distances for the pairs with the given indices
+         * in the list of distance pairs.
+         * @param fk [in] the frame transforms.
+         * @param pairs [in] indices of the pairs to check.
+         * @param result [out] if non-NULL, the results of all pairs in the
+         * order of \b pairs.
+         * @return the shortest distance.
+         */
+        DistanceStrategy::Result distance(const kinematics::FKTable& fk,
+                                          const std::vector<std::size_t>& pairs,
+                                          std::vector<DistanceStrategy::Result>* result) const;
+
+        //! @brief Check pairs of the query until there are no more pairs to check.
+        void distanceWorker(ParallelQuery& query) const;
+
+        //! @brief Add the geometry to the bounding sphere of \b frame.
+        void addBoundingSphere(const kinematics::Frame* frame, const geometry::Geometry& geom);
+
+        /**
+         * @brief A lower bound on the distance between the geometries of
+         * two frames.
+         * @return the bound, or 0 if a frame has no bounding sphere.
+         */
+        double getLowerBound(const kinematics::Frame* a, const math::Transform3D<>& wTa,
+                             const kinematics::Frame* b, const math::Transform3D<>& wTb) const;
+
+    private:
+        /**
+         * @brief Get the data for a frame pair when temporal coherence is enabled.
+         * @param pair [in] the frame pair.
+         * @return the data kept for the pair, or NULL if temporal coherence
+         * is disabled.
+         */
+        ProximityStrategyData* getPairData(const kinematics::FramePair& pair) const;
+
     private:
 		mutable rw::common::Timer _timer;
 		mutable int _cnt;
@@ -200,6 +338,15 @@ namespace rw { namespace proximity {
         // The pairs of frames to check for distances.
         kinematics::FramePairList _distancePairs;
 
+        // Keep data for each frame pair between queries.
+        bool _temporalCoherence;
+        mutable kinematics::FramePairMap<ProximityStrategyData::Ptr> _pairData;
+
+        // Bounding spheres of the frames with geometry (radius is negative if unbounded).
+        std::map<const kinematics::Frame*, BoundingSphere> _bounds;
+
+        rw::common::Ptr<rw::common::ThreadPool> _pool;
+
 
         DistanceCalculator(const DistanceCalculator&);
         DistanceCalculator& operator=(const DistanceCalculator&);
@@ -0,0 +1,489 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute, 
+ * Faculty of Engineering, University of Southern Denmark 
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+#include "DynamicAABBTreeFilterStrategy.hpp"
+
+#include <rw/common/macros.hpp>
+#include <rw/geometry/Geometry.hpp>
+#include <rw/geometry/TriMesh.hpp>
+#include <rw/models/Object.hpp>
+#include <rw/models/WorkCell.hpp>
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace rw::common;
+using namespace rw::geometry;
+using namespace rw::kinematics;
+using namespace rw::math;
+using namespace rw::models;
+using namespace rw::proximity;
+
+namespace {
+	void merge(const Vector3D<>& lowerA, const Vector3D<>& upperA,
+			   const Vector3D<>& lowerB, const Vector3D<>& upperB,
+			   Vector3D<>& lower, Vector3D<>& upper)
+	{
+		for (std::size_t i = 0; i < 3; i++) {
+			lower[i] = std::min(lowerA[i], lowerB[i]);
+			upper[i] = std::max(upperA[i], upperB[i]);
+		}
+	}
+
+	bool overlap(const Vector3D<>& lowerA, const Vector3D<>& upperA,
+				 const Vector3D<>& lowerB, const Vector3D<>& upperB)
+	{
+		for (std::size_t i = 0; i < 3; i++) {
+			if (upperA[i] < lowerB[i] || upperB[i] < lowerA[i])
+				return false;
+		}
+		return true;
+	}
+
+	bool contains(const Vector3D<>& lowerA, const Vector3D<>& upperA,
+				  const Vector3D<>& lowerB, const Vector3D<>& upperB)
+	{
+		for (std::size_t i = 0; i < 3; i++) {
+			if (lowerB[i] < lowerA[i] || upperA[i] < upperB[i])
+				return false;
+		}
+		return true;
+	}
+
+	// half the surface area of a box, used as cost when building the tree
+	double area(const Vector3D<>& lower, const Vector3D<>& upper)
+	{
+		const Vector3D<> d = upper - lower;
+		return d[0]*d[1] + d[1]*d[2] + d[2]*d[0];
+	}
+
+	double mergedArea(const Vector3D<>& lowerA, const Vector3D<>& upperA,
+					  const Vector3D<>& lowerB, const Vector3D<>& upperB)
+	{
+		Vector3D<> lower, upper;
+		merge(lowerA, upperA, lowerB, upperB, lower, upper);
+		return area(lower, upper);
+	}
+
+	bool isBounded(const Geometry& geom)
+	{
+		switch (geom.getGeometryData()->getType()) {
+		case GeometryData::PlanePrim:
+		case GeometryData::LinePrim:
+		case GeometryData::RayPrim:
+		case GeometryData::Quadratic:
+			return false;
+		default:
+			return true;
+		}
+	}
+}
+
+DynamicAABBTreeFilterStrategy::DynamicAABBTreeFilterStrategy(WorkCell::Ptr workcell):
+	_workcell(workcell),
+	_basic(ownedPtr(new BasicFilterStrategy(workcell))),
+	_root(-1),
+	_freeList(-1),
+	_margin(0.01),
+	_noOfReinserted(0)
+{
+	reset(_workcell->getDefaultState());
+}
+
+DynamicAABBTreeFilterStrategy::DynamicAABBTreeFilterStrategy(WorkCell::Ptr workcell, const ProximitySetup& setup):
+	_workcell(workcell),
+	_basic(ownedPtr(new BasicFilterStrategy(workcell, setup))),
+	_root(-1),
+	_freeList(-1),
+	_margin(0.01),
+	_noOfReinserted(0)
+{
+	reset(_workcell->getDefaultState());
+}
+
+DynamicAABBTreeFilterStrategy::~DynamicAABBTreeFilterStrategy()
+{
+}
+
+void DynamicAABBTreeFilterStrategy::initializeBodies(const State& state)
+{
+	// run through all objects in workcell and collect the geometric information
+	_bodies.clear();
+	_frameToBody.clear();
+	BOOST_FOREACH(Object::Ptr object, _workcell->getObjects()) {
+		BOOST_FOREACH(Geometry::Ptr geom, object->getGeometry(state)) {
+			Frame* const frame = geom->getFrame();
+			RW_ASSERT(frame);
+			if (std::find(_removed.begin(), _removed.end(), std::make_pair(frame, geom->getName())) == _removed.end())
+				addToBody(frame, geom);
+		}
+	}
+	typedef std::pair<Frame*, Geometry::Ptr> FrameGeometry;
+	BOOST_FOREACH(const FrameGeometry& added, _added) {
+		addToBody(added.first, added.second);
+	}
+}
+
+void DynamicAABBTreeFilterStrategy::addToBody(Frame* frame, Geometry::Ptr geom)
+{
+	if (!_frameToBody.has(*frame)) {
+		Body body;
+		body.frame = frame;
+		_frameToBody[*frame] = (int)_bodies.size();
+		_bodies.push_back(body);
+	}
+	_bodies[_frameToBody[*frame]].geometries.push_back(geom);
+}
+
+void DynamicAABBTreeFilterStrategy::initializeBody(Body& body)
+{
+	body.bounded = !body.geometries.empty();
+	body.localLower = Vector3D<>(DBL_MAX, DBL_MAX, DBL_MAX);
+	body.localUpper = Vector3D<>(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+	BOOST_FOREACH(const Geometry::Ptr& geom, body.geometries) {
+		if (!isBounded(*geom)) {
+			body.bounded = false;
+			break;
+		}
+		const TriMesh::Ptr mesh = geom->getGeometryData()->getTriMesh(false);
+		const double scale = geom->getScale();
+		const Transform3D<>& fTg = geom->getTransform();
+		Triangle<> tri;
+		for (std::size_t i = 0; i < mesh->size(); i++) {
+			mesh->getTriangle(i, tri);
+			for (std::size_t j = 0; j < 3; j++) {
+				const Vector3D<> p = fTg * (tri.getVertex(j) * scale);
+				for (std::size_t k = 0; k < 3; k++) {
+					body.localLower[k] = std::min(body.localLower[k], p[k]);
+					body.localUpper[k] = std::max(body.localUpper[k], p[k]);
+				}
+			}
+		}
+	}
+	// an empty mesh gives an inverted box, which overlaps nothing
+	body.hasTransform = false;
+	body.leaf = -1;
+}
+
+void DynamicAABBTreeFilterStrategy::initializeAllowedPairs(const State& state)
+{
+	_allowed.clear();
+	_basic->reset(state);
+	ProximityFilter::Ptr filter = _basic->update(state);
+	while (!filter->isEmpty())
+		_allowed.insert(filter->frontAndPop());
+
+	_alwaysPairs.clear();
+	BOOST_FOREACH(const FramePair& pair, _allowed) {
+		const bool firstBounded = _frameToBody.has(*pair.first) && _bodies[_frameToBody[*pair.first]].bounded;
+		const bool secondBounded = _frameToBody.has(*pair.second) && _bodies[_frameToBody[*pair.second]].bounded;
+		if (!firstBounded || !secondBounded)
+			_alwaysPairs.push_back(pair);
+	}
+}
+
+void DynamicAABBTreeFilterStrategy::reset(const State& state)
+{
+	_nodes.clear();
+	_root = -1;
+	_freeList = -1;
+	_state = state;
+	initializeBodies(state);
+	BOOST_FOREACH(Body& body, _bodies) {
+		initializeBody(body);
+	}
+	initializeAllowedPairs(state);
+}
+
+ProximityCache::Ptr DynamicAABBTreeFilterStrategy::createProximityCache()
+{
+	return ownedPtr(new Cache(this));
+}
+
+void DynamicAABBTreeFilterStrategy::refit(Body& body, const Transform3D<>& wTf)
+{
+	body.wTf = wTf;
+	body.hasTransform = true;
+
+	// world box of the local box
+	const Vector3D<> center = wTf * ((body.localLower + body.localUpper) / 2.0);
+	const Vector3D<> half = (body.localUpper - body.localLower) / 2.0;
+	const Rotation3D<>& R = wTf.R();
+	for (std::size_t i = 0; i < 3; i++) {
+		const double extent = std::fabs(R(i,0))*half[0] + std::fabs(R(i,1))*half[1] + std::fabs(R(i,2))*half[2];
+		body.lower[i] = center[i] - extent;
+		body.upper[i] = center[i] + extent;
+	}
+
+	if (body.leaf >= 0) {
+		const Node& node = _nodes[body.leaf];
+		if (contains(node.lower, node.upper, body.lower, body.upper))
+			return;
+		removeLeaf(body.leaf);
+	} else {
+		body.leaf = allocateNode();
+		_nodes[body.leaf].body = (int)(&body - &_bodies[0]);
+	}
+	const Vector3D<> margin(_margin, _margin, _margin);
+	_nodes[body.leaf].lower = body.lower - margin;
+	_nodes[body.leaf].upper = body.upper + margin;
+	insertLeaf(body.leaf);
+	_noOfReinserted++;
+}
+
+ProximityFilter::Ptr DynamicAABBTreeFilterStrategy::update(const State& state)
+{
+	_fk.updateIncremental(state);
+
+	// refit the frames that moved
+	_noOfReinserted = 0;
+	BOOST_FOREACH(Body& body, _bodies) {
+		if (!body.bounded || body.localLower[0] > body.localUpper[0])
+			continue;
+		const Transform3D<>& wTf = _fk.get(*body.frame);
+		if (!body.hasTransform || !(body.wTf == wTf))
+			refit(body, wTf);
+	}
+
+	const rw::common::Ptr<Filter> filter = ownedPtr(new Filter());
+	filter->pairs = _alwaysPairs;
+
+	// query the tree with the box of each body
+	for (std::size_t i = 0; i < _bodies.size(); i++) {
+		const Body& body = _bodies[i];
+		if (body.leaf < 0)
+			continue;
+		const Node& leaf = _nodes[body.leaf];
+		_stack.clear();
+		_stack.push_back(_root);
+		while (!_stack.empty()) {
+			const int index = _stack.back();
+			_stack.pop_back();
+			const Node& node = _nodes[index];
+			if (!overlap(node.lower, node.upper, leaf.lower, leaf.upper))
+				continue;
+			if (!node.isLeaf()) {
+				_stack.push_back(node.left);
+				_stack.push_back(node.right);
+				continue;
+			}
+			// each pair is reported once, from the body with the lowest index
+			if (node.body <= (int)i)
+				continue;
+			const Body& other = _bodies[node.body];
+			if (!overlap(body.lower, body.upper, other.lower, other.upper))
+				continue;
+			const FramePair pair(body.frame, other.frame);
+			if (_allowed.find(pair) != _allowed.end()) {
+				filter->pairs.push_back(pair);
+			} else {
+				const FramePair reversed(other.frame, body.frame);
+				if (_allowed.find(reversed) != _allowed.end())
+					filter->pairs.push_back(reversed);
+			}
+		}
+	}
+
+	// same order as the BasicFilterStrategy
+	std::sort(filter->pairs.begin(), filter->pairs.end());
+	return filter;
+}
+
+ProximityFilter::Ptr DynamicAABBTreeFilterStrategy::update(const State& state, ProximityCache::Ptr data)
+{
+	return update(state);
+}
+
+ProximitySetup& DynamicAABBTreeFilterStrategy::getProximitySetup()
+{
+	return _basic->getProximitySetup();
+}
+
+void DynamicAABBTreeFilterStrategy::addGeometry(Frame* frame, const Geometry::Ptr geo)
+{
+	_basic->addGeometry(frame, geo);
+	_added.push_back(std::make_pair(frame, geo));
+	reset(_state);
+}
+
+void DynamicAABBTreeFilterStrategy::removeGeometry(Frame* frame, const Geometry::Ptr geo)
+{
+	if (geo == NULL)
+		RW_THROW("Unable to remove NULL geometry");
+	removeGeometry(frame, geo->getName());
+}
+
+void DynamicAABBTreeFilterStrategy::removeGeometry(Frame* frame, const std::string& geometryId)
+{
+	_basic->removeGeometry(frame, geometryId);
+	// geometries added through addGeometry are forgotten, geometries of the workcell are skipped from now on
+	bool found = false;
+	for (std::vector<std::pair<Frame*, Geometry::Ptr> >::iterator it = _added.begin(); it != _added.end(); ++it) {
+		if (it->first == frame && it->second->getName() == geometryId) {
+			_added.erase(it);
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+		_removed.push_back(std::make_pair(frame, geometryId));
+	reset(_state);
+}
+
+void DynamicAABBTreeFilterStrategy::addRule(const ProximitySetupRule& rule)
+{
+	_basic->addRule(rule);
+	initializeAllowedPairs(_state);
+}
+
+void DynamicAABBTreeFilterStrategy::removeRule(const ProximitySetupRule& rule)
+{
+	_basic->removeRule(rule);
+	initializeAllowedPairs(_state);
+}
+
+void DynamicAABBTreeFilterStrategy::setMargin(double margin)
+{
+	_margin = margin;
+	reset(_state);
+}
+
+int DynamicAABBTreeFilterStrategy::allocateNode()
+{
+	int index;
+	if (_freeList >= 0) {
+		index = _freeList;
+		_freeList = _nodes[index].parent;
+	} else {
+		index = (int)_nodes.size();
+		_nodes.push_back(Node());
+	}
+	Node& node = _nodes[index];
+	node.parent = -1;
+	node.left = -1;
+	node.right = -1;
+	node.body = -1;
+	return index;
+}
+
+void DynamicAABBTreeFilterStrategy::freeNode(int index)
+{
+	_nodes[index].parent = _freeList;
+	_freeList = index;
+}
+
+void DynamicAABBTreeFilterStrategy::insertLeaf(int leaf)
+{
+	if (_root < 0) {
+		_root = leaf;
+		_nodes[leaf].parent = -1;
+		return;
+	}
+
+	// find the sibling that gives the smallest increase in surface area
+	const Vector3D<> lower = _nodes[leaf].lower;
+	const Vector3D<> upper = _nodes[leaf].upper;
+	int index = _root;
+	while (!_nodes[index].isLeaf()) {
+		const Node& node = _nodes[index];
+		const double nodeArea = area(node.lower, node.upper);
+		const double combinedArea = mergedArea(node.lower, node.upper, lower, upper);
+		// cost of a new parent for this node and the leaf
+		const double cost = 2*combinedArea;
+		// minimum cost of pushing the leaf further down the tree
+		const double inheritanceCost = 2*(combinedArea - nodeArea);
+
+		double childCost[2];
+		const int children[2] = { node.left, node.right };
+		for (std::size_t i = 0; i < 2; i++) {
+			const Node& child = _nodes[children[i]];
+			childCost[i] = mergedArea(child.lower, child.upper, lower, upper) + inheritanceCost;
+			if (!child.isLeaf())
+				childCost[i] -= area(child.lower, child.upper);
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+		index = childCost[0] < childCost[1] ? node.left : node.right;
+	}
+
+	// create a new parent for the sibling and the leaf
+	const int sibling = index;
+	const int oldParent = _nodes[sibling].parent;
+	const int newParent = allocateNode();
+	Node& parent = _nodes[newParent];
+	parent.parent = oldParent;
+	merge(lower, upper, _nodes[sibling].lower, _nodes[sibling].upper, parent.lower, parent.upper);
+	parent.left = sibling;
+	parent.right = leaf;
+	_nodes[sibling].parent = newParent;
+	_nodes[leaf].parent = newParent;
+	if (oldParent < 0) {
+		_root = newParent;
+	} else if (_nodes[oldParent].left == sibling) {
+		_nodes[oldParent].left = newParent;
+	} else {
+		_nodes[oldParent].right = newParent;
+	}
+
+	// refit the ancestors
+	index = _nodes[leaf].parent;
+	while (index >= 0) {
+		Node& node = _nodes[index];
+		merge(_nodes[node.left].lower, _nodes[node.left].upper,
+			  _nodes[node.right].lower, _nodes[node.right].upper,
+			  node.lower, node.upper);
+		index = node.parent;
+	}
+}
+
+void DynamicAABBTreeFilterStrategy::removeLeaf(int leaf)
+{
+	if (leaf == _root) {
+		_root = -1;
+		return;
+	}
+
+	const int parent = _nodes[leaf].parent;
+	const int grandParent = _nodes[parent].parent;
+	const int sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+	freeNode(parent);
+	if (grandParent < 0) {
+		_root = sibling;
+		_nodes[sibling].parent = -1;
+		return;
+	}
+
+	if (_nodes[grandParent].left == parent)
+		_nodes[grandParent].left = sibling;
+	else
+		_nodes[grandParent].right = sibling;
+	_nodes[sibling].parent = grandParent;
+
+	int index = grandParent;
+	while (index >= 0) {
+		Node& node = _nodes[index];
+		merge(_nodes[node.left].lower, _nodes[node.left].upper,
+			  _nodes[node.right].lower, _nodes[node.right].upper,
+			  node.lower, node.upper);
+		index = node.parent;
+	}
+}
@@ -0,0 +1,241 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute, 
+ * Faculty of Engineering, University of Southern Denmark 
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#ifndef RW_PROXIMITY_DYNAMICAABBTREEFILTERSTRATEGY_HPP_
+#define RW_PROXIMITY_DYNAMICAABBTREEFILTERSTRATEGY_HPP_
+
+/**
+ * @file DynamicAABBTreeFilterStrategy.hpp
+ *
+ * \copydoc rw::proximity::DynamicAABBTreeFilterStrategy
+ */
+
+#include "BasicFilterStrategy.hpp"
+#include "ProximityFilterStrategy.hpp"
+#include "ProximitySetup.hpp"
+
+#include <rw/kinematics/FKCompiled.hpp>
+#include <rw/kinematics/FrameMap.hpp>
+#include <rw/kinematics/State.hpp>
+#include <rw/math/Transform3D.hpp>
+#include <rw/math/Vector3D.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rw { namespace models { class WorkCell; } }
+
+namespace rw { namespace proximity {
+
+/** @addtogroup proximity */
+/*@{*/
+
+/**
+ * @brief Broad phase filter strategy that only returns the frame pairs whose
+ * world space bounding boxes overlap.
+ *
+ * The axis aligned bounding box of the geometry of each frame is kept in a
+ * dynamic AABB tree (similar to the dynamic bounding volume tree in Bullet).
+ * The boxes in the tree are enlarged by a margin, such that a frame that
+ * moves a little does not need to be reinserted. In update() only the frames
+ * whose transforms changed since the last call are refitted, and only those
+ * that moved out of their enlarged box are removed and reinserted.
+ *
+ * The frame pairs that may be returned are the same as for
+ * BasicFilterStrategy, i.e. the include and exclude rules of the
+ * ProximitySetup are respected. Pairs with a frame without a bounded
+ * geometry (such as a plane) are always returned.
+ *
+ * The filter can be used with a CollisionDetector through the
+ * CollisionDetector(workcell, strategy, filter) constructor.
+ */
+class DynamicAABBTreeFilterStrategy: public ProximityFilterStrategy {
+public:
+	//! @brief smart pointer type to this class
+	typedef rw::common::Ptr<DynamicAABBTreeFilterStrategy> Ptr;
+	//! @brief smart pointer type to this const class
+	typedef rw::common::Ptr<const DynamicAABBTreeFilterStrategy> CPtr;
+
+	/**
+	 * @brief constructor - the ProximitySetup will be extracted from
+	 * the workcell description if possible.
+	 *
+	 * @param workcell [in] the workcell.
+	 */
+	DynamicAABBTreeFilterStrategy(rw::common::Ptr<rw::models::WorkCell> workcell);
+
+	/**
+	 * @brief constructor - the frame pairs are filtered based on the \b setup
+	 * @param workcell [in] the workcell
+	 * @param setup [in] the ProximitySetup describing exclude/include relations
+	 */
+	DynamicAABBTreeFilterStrategy(rw::common::Ptr<rw::models::WorkCell> workcell, const ProximitySetup& setup);
+
+	//! @brief destructor
+	virtual ~DynamicAABBTreeFilterStrategy();
+
+	//////// interface inherited from ProximityFilterStrategy
+
+	/**
+	 * @brief Rebuild the tree from the geometry of the workcell objects in \b state.
+	 *
+	 * The workcell geometry and the allowed frame pairs are read in \b state.
+	 * Later calls to addGeometry(), removeGeometry() and setMargin() rebuild
+	 * the tree in the same state.
+	 * @param state [in] the state.
+	 */
+	virtual void reset(const rw::kinematics::State& state);
+
+	//! @copydoc ProximityFilterStrategy::createProximityCache
+	virtual ProximityCache::Ptr createProximityCache();
+
+	//! @copydoc ProximityFilterStrategy::update
+	virtual ProximityFilter::Ptr update(const rw::kinematics::State& state);
+
+	//! @copydoc ProximityFilterStrategy::update(const rw::kinematics::State&, ProximityCache::Ptr)
+	virtual ProximityFilter::Ptr update(const rw::kinematics::State& state, ProximityCache::Ptr data);
+
+	//! @copydoc ProximityFilterStrategy::getProximitySetup
+	ProximitySetup& getProximitySetup();
+
+	//! @copydoc ProximityFilterStrategy::addGeometry
+	virtual void addGeometry(rw::kinematics::Frame* frame, const rw::common::Ptr<rw::geometry::Geometry> geo);
+
+	//! @copydoc ProximityFilterStrategy::removeGeometry(rw::kinematics::Frame*, const rw::common::Ptr<rw::geometry::Geometry>)
+	virtual void removeGeometry(rw::kinematics::Frame* frame, const rw::common::Ptr<rw::geometry::Geometry> geo);
+
+	//! @copydoc ProximityFilterStrategy::removeGeometry(rw::kinematics::Frame*, const std::string&)
+	virtual void removeGeometry(rw::kinematics::Frame* frame, const std::string& geometryId);
+
+	//! @copydoc ProximityFilterStrategy::addRule
+	virtual void addRule(const ProximitySetupRule& rule);
+
+	//! @copydoc ProximityFilterStrategy::removeRule
+	virtual void removeRule(const ProximitySetupRule& rule);
+
+	/**
+	 * @brief Set the margin that the boxes in the tree are enlarged by.
+	 *
+	 * A larger margin means fewer reinsertions of moving frames, but more
+	 * pairs tested against the tight boxes.
+	 *
+	 * @param margin [in] the margin in meters (default is 0.01).
+	 */
+	void setMargin(double margin);
+
+	/**
+	 * @brief Get the margin that the boxes in the tree are enlarged by.
+	 * @return the margin in meters.
+	 */
+	double getMargin() const { return _margin; }
+
+	/**
+	 * @brief The number of frames that were reinserted in the tree in the last
+	 * call to update.
+	 * @return the number of reinserted frames.
+	 */
+	std::size_t getNoOfReinserted() const { return _noOfReinserted; }
+
+private:
+	struct Cache: public ProximityCache {
+	public:
+		Cache(void *owner): ProximityCache(owner) {}
+		size_t size() const { return 0; }
+		void clear() {}
+	};
+
+	struct Filter: public ProximityFilter {
+	public:
+		Filter(): _front(0) {}
+		void pop() { _front++; }
+		kinematics::FramePair frontAndPop() { return pairs[_front++]; }
+		kinematics::FramePair front() { return pairs[_front]; }
+		bool isEmpty() { return _front >= pairs.size(); }
+
+		std::vector<kinematics::FramePair> pairs;
+
+	private:
+		std::size_t _front;
+	};
+
+	// A frame with geometry.
+	struct Body {
+		kinematics::Frame* frame;
+		std::vector<rw::common::Ptr<rw::geometry::Geometry> > geometries;
+		// false if the geometry has no finite bounds
+		bool bounded;
+		// box of the geometry in frame coordinates
+		rw::math::Vector3D<> localLower, localUpper;
+		// tight box in world coordinates for the transform wTf
+		rw::math::Vector3D<> lower, upper;
+		rw::math::Transform3D<> wTf;
+		bool hasTransform;
+		// leaf node of the body in the tree, or -1
+		int leaf;
+	};
+
+	// A node in the tree. Leaf nodes have no children and refer to a body.
+	struct Node {
+		rw::math::Vector3D<> lower, upper;
+		int parent;
+		int left, right;
+		int body;
+		bool isLeaf() const { return left < 0; }
+	};
+
+	void initializeBodies(const rw::kinematics::State& state);
+	void addToBody(rw::kinematics::Frame* frame, rw::common::Ptr<rw::geometry::Geometry> geom);
+	void initializeBody(Body& body);
+	void initializeAllowedPairs(const rw::kinematics::State& state);
+	void refit(Body& body, const rw::math::Transform3D<>& wTf);
+
+	int allocateNode();
+	void freeNode(int node);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+
+	rw::common::Ptr<rw::models::WorkCell> _workcell;
+	// the rule based filter that gives the allowed frame pairs
+	BasicFilterStrategy::Ptr _basic;
+	kinematics::FramePairSet _allowed;
+	// allowed pairs with a frame without bounded geometry
+	std::vector<kinematics::FramePair> _alwaysPairs;
+
+	std::vector<Body> _bodies;
+	kinematics::FrameMap<int> _frameToBody;
+	// geometries added to and removed from the workcell geometry through addGeometry and removeGeometry
+	std::vector<std::pair<kinematics::Frame*, rw::common::Ptr<rw::geometry::Geometry> > > _added;
+	std::vector<std::pair<kinematics::Frame*, std::string> > _removed;
+	// the state given in the last reset
+	rw::kinematics::State _state;
+
+	std::vector<Node> _nodes;
+	int _root;
+	int _freeList;
+	std::vector<int> _stack;
+
+	double _margin;
+	std::size_t _noOfReinserted;
+	rw::kinematics::FKCompiled _fk;
+};
+
+/*@}*/
+}
+}
+
+#endif /* RW_PROXIMITY_DYNAMICAABBTREEFILTERSTRATEGY_HPP_ */
@@ -25,6 +25,7 @@
 //#include "OBBToleranceCollider.hpp"
 #include "BVTreeCollider.hpp"
 #include "OBVTreeDFSCollider.hpp"
+#include "OBVTreePacketCollider.hpp"
 
 
 namespace rw {
@@ -95,6 +96,17 @@ namespace proximity {
             return makeDFSCollider<BVTREE>(bvcollider, dstrategy);
         }
 
+        /**
+         * @brief creates a tree collider for OBB trees with triangle primitives that tests
+         * bounding volumes and triangles in packets using SIMD instructions. The instruction
+         * set is chosen at runtime, with a fallback to scalar code.
+         * @see OBVTreePacketCollider
+         */
+        template<class BVTREE>
+        static BVTreeCollider<BVTREE>* makePacketColliderOBB(){
+            return new OBVTreePacketCollider<BVTREE>();
+        }
+
         /**
          * @brief creates a depth first search tree collider for trees that use triangles for
          * primitives.
@@ -39,6 +39,7 @@
 #include <rw/geometry/IndexedTriArray.hpp>
 
 #include "BinaryBVTree.hpp"
+#include "BinaryIdxBVTree.hpp"
 
 namespace rw {
 namespace proximity {
@@ -205,6 +206,8 @@ namespace proximity {
 			NodeIterator root = tree->createRoot();
 			//std::cout << "recursiveTopDownTree: " << std::flush;
 			recursiveTopDownTree<BVTREE>(tree, root, idxArray, bvFactory, splitter, maxTrisInLeaf);
+			// let the tree pack itself for traversal
+			tree->optimize();
 			//std::cout << t.toString() << std::endl;
 			//std::cout << "IDX MAP ARRAY" << std::endl;
 			//BOOST_FOREACH(int idx, idxArray.getIndexes()){
@@ -18,212 +18,285 @@
 #ifndef RW_PROXIMITY_BINARYIDXTREE_HPP_
 #define RW_PROXIMITY_BINARYIDXTREE_HPP_
 
-//#include <stack>
-//#include "BVTree.hpp"
+#include <vector>
+#include "BVTree.hpp"
+
+#include <rw/common/macros.hpp>
+#include <rw/common/Ptr.hpp>
+#include <rw/geometry/Triangle.hpp>
+
+#include <boost/align/aligned_allocator.hpp>
+
 namespace rw {
 namespace proximity {
 
-#ifdef xkdfnslafn
+    template<class BV, class PRIM> class BinaryIdxBVTree;
+
     /**
-     * @brief this node class stores the bv implicitly and use explicit pointers to its child nodes
+     * @brief this node class stores the bv and the index of its right child. Nodes are
+     * stored in depth first (preorder) order in a flat array, such that the left child
+     * of a node is always the next node in the array. Leaf nodes store the index
+     * of their first primitive instead of the right child.
      */
-    template<class BVTREE, class BV, class PRIM>
-    class IdxNode {
+    template<class BV, class PRIM>
+    class BTIdxNode {
     public:
         typedef BV BVType;
         typedef PRIM PRIMType;
 
-        class NodeIterator: public BVTreeIterator<typename IdxNode<BVTREE,BV,PRIM>::NodeIterator, BV, PRIM>
-        {
-        public:
-            typedef IdxNode BVNode;
-            typedef BV BVType;
+        BTIdxNode():_data(-1),_size(0){}
 
-            //! @brief constructor
-            NodeIterator():_nodeIdx(-1),_depth(0){};
-            NodeIterator(const BVTREE* tree, int nodeidx, unsigned char dep):
-                _tree(tree),_nodeIdx(nodeidx),_depth(dep){};
-
-            inline const BVType& bv() const { return _tree->bv(_nodeIdx); };
-            inline bool leaf() const { return _tree->isLeaf(_nodeIdx); };
-            inline NodeIterator left() const { return NodeIterator( _tree, _tree->left(_nodeIdx), _depth+1 ); };
-            inline NodeIterator right() const { return NodeIterator( _tree, _tree->right(_nodeIdx), _depth+1 ); };
-            inline unsigned char depth() const { return _depth; };
-            inline size_t primitiveIdx() const {return _tree->primIdx(_nodeIdx);}
-            inline size_t nrOfPrimitives() const { return _tree->nrOfPrims(_nodeIdx);}
+        //! @brief get the bounding volume of this node
+        inline BV& bv() {return _bv;}
+        inline const BV& bv() const {return _bv;}
 
-            const BVTREE *_tree;
-            int _nodeIdx;
-            unsigned char _depth;
-        };
+        //! @brief true if this is a leaf node
+        inline bool isLeaf() const { return _size>0; }
 
+        //! @brief index of the first primitive of a leaf node
+        inline int primIdx() const { return _data; }
+        //! @brief nr of primitives in a leaf node
+        inline int nrOfPrims() const { return _size; }
 
-        IdxNode(){
-            _left = -1;
-            _right = -1;
-        }
+        //! @brief true if an inner node has a left child (the next node in the array)
+        inline bool hasLeft() const { return _size==0; }
+        //! @brief index of the right child of an inner node, or -1 if it has none
+        inline int right() const { return _data; }
 
-        IdxNode(const BV& bv):
-            _bv(bv)
-        {
-            _left = -1;
-            _right = -1;
-        }
+    private:
+        template<class B, class P> friend class BinaryIdxBVTree;
 
-        virtual ~IdxNode(){}
+        BV _bv;
+        // primitive index for leafs, right child index for inner nodes
+        int _data;
+        // nr of primitives for leafs, 0 for inner nodes with a left child, -1 for inner nodes without
+        int _size;
 
-        //! @brief get the OBB of this node
-        BV& bv() {return _bv;}
-        const BV& bv() const {return _bv;}
-        int primIdx() const {return _right;}
-        void setPrimIdx(int pidx){
-            _right = pidx;
-            _left = -2; // indicates that this is a leaf node
-        }
-        int nrOfPrims() const {return -1*(_left+2);}
-        void setNrOfPrims(int size){_left = -2-size;};
+    public:
+        /**
+         * @brief an iterator for the BTIdxNode
+         */
+        class NodeIterator: public BVTreeIterator<typename BTIdxNode<BV,PRIM>::NodeIterator, BV>
+        {
+        public:
+            typedef BTIdxNode<BV,PRIM> Node;
 
-        int left() const {return _left;};
-        int right() const {return _right;};
-        void setLeft(int left){_left = left;};
-        void setRight(int right){_right = right;};
+            //! @brief constructor
+            NodeIterator():_nodes(NULL),_idx(-1),_depth(0){};
+            NodeIterator(const Node* nodes, int idx, unsigned char dep):_nodes(nodes),_idx(idx),_depth(dep){};
 
-        bool isLeaf() const { return _left<-1;}
+            inline const BVType& bv() const { return _nodes[_idx].bv(); };
+            inline bool leaf() const { return _nodes[_idx].isLeaf(); };
+            inline NodeIterator left() const { return NodeIterator( _nodes, _idx+1, _depth+1 ); };
+            inline NodeIterator right() const { return NodeIterator( _nodes, _nodes[_idx].right(), _depth+1 ); };
+            inline unsigned char depth() const { return _depth; };
+            inline bool hasLeft() const { return _nodes[_idx].hasLeft(); }
+            inline bool hasRight() const { return !_nodes[_idx].isLeaf() && _nodes[_idx].right()>=0; }
+            inline int getId() const { return _idx; };
 
-    private:
-        BV _bv;
+            inline size_t primitiveIdx() const {return _nodes[_idx].primIdx();}
+            inline size_t nrOfPrimitives() const { return _nodes[_idx].nrOfPrims();}
 
-        int _left;
-        int _right; // when left is <-1 then right points to the primitives start index
+            const Node* _nodes;
+            int _idx;
+            unsigned char _depth;
+        };
     };
 
-
-
-//typedef PrtNode<OBB<double> > OBBPtrNodeD;
-//typedef PrtNode<OBB<float> > OBBPtrNodeF;
-
 	/**
-	 * @brief a generic pointer based tree structure. This is not the most efficient
-	 * structure for bounding volume trees. though it is quite generic and easy to work with
-	 * because of its pointer based structure.
+	 * @brief a bounding volume tree that stores all nodes in one flat array.
 	 *
+	 * The nodes are stored in depth first order with the left child of a node
+	 * next to it in memory, which is the order the DFS tree colliders visit them
+	 * in. The node array is aligned to cache lines (for OBB<double> a node is
+	 * exactly two cache lines), and the primitives of the leafs are copied into
+	 * an array of their own in leaf order, such that no pointers are followed and
+	 * no virtual calls are made while traversing the tree.
+	 *
+	 * The tree is built through the BVTree interface, e.g. by the BVTreeFactory,
+	 * after which optimize() packs it into the flat layout. The BVTreeFactory calls
+	 * optimize() when the tree has been built.
 	 */
 	template <class BV, class PRIM>
-	class BinaryIdxBVTree : public BVTree<typename IdxNode<BinaryIdxBVTree<BV, PRIM> >::NodeIterator > {
+	class BinaryIdxBVTree : public BVTree< BinaryIdxBVTree<BV,PRIM> > {
 	public:
-		typedef BV BVType;
+	    typedef BV BVType;
+		typedef PRIM PRIMType;
 		typedef typename BV::value_type value_type;
-
-		typedef IdxNode< BinaryIdxBVTree<BV, PRIM>, BV, PRIM> Node;
-        typedef typename Node::NodeIterator iterator;
-        typedef typename Node::NodeIterator node_iterator;
-
-		iterator getIterator() const { return iterator(); };
+		typedef rw::common::Ptr<BinaryIdxBVTree<BV,PRIM> > Ptr;
+		typedef BTIdxNode<BV,PRIM> Node;
+		typedef typename BTIdxNode<BV,PRIM>::NodeIterator NodeIterator;
 
 	public:
 		//! @brief constructor
 		BinaryIdxBVTree(PrimArrayAccessor<PRIM>* paccessor):
-		    BVTree<node_iterator>(paccessor)
+		    BVTree<BinaryIdxBVTree<BV,PRIM> >(paccessor)
 		{
-		    _nodes.reserve(300);
-		}
-
-		node_iterator getRootIterator() const {
-                return node_iterator(this, 0, 0);
-		};
-
-		Node* getRoot(){return &_nodes[0];};
-
-		int countNodes(){
-		    return _nodes.size();
 		}
 
-		int getMaxTrisPerLeaf() const{return 2;};
-
-		inline int left(int idx) const {
-		    return _nodes[idx].left();
-		}
+		//! @brief Destructor.
+		virtual ~BinaryIdxBVTree() {}
 
-        inline size_t nrOfPrims(int idx) const {
-            return _nodes[idx].nrOfPrims();
-        }
+		NodeIterator getIterator() const { return getRootIterator(); };
 
-        inline size_t primIdx(int idx) const {
-            return _nodes[idx].primIdx();
+		NodeIterator createLeft( NodeIterator parent){
+		    const int idx = newNode();
+		    _children[parent._idx].first = idx;
+		    return NodeIterator(&_nodes[0], idx, parent.depth()+1);
         }
 
-		inline int right(int idx) const {
-		    return _nodes[idx].right();
+		NodeIterator createRight( NodeIterator parent ){
+		    const int idx = newNode();
+		    _children[parent._idx].second = idx;
+		    return NodeIterator(&_nodes[0], idx, parent.depth()+1);
 		}
 
-		inline bool isLeaf(int idx) const {
-		    return _nodes[idx].isLeaf();
+		NodeIterator createRoot(){
+		    if(_nodes.size()==0)
+		        newNode();
+		    return NodeIterator(&_nodes[0], 0, 0);
 		}
 
-		inline BV& bv(int idx){
-		    return _nodes[idx].bv();
-		}
-
-        inline const BV& bv(int idx) const {
-            return _nodes[idx].bv();
+        void setBV(const BVType& bv, NodeIterator node){
+            _nodes[node._idx]._bv = bv;
         }
 
-        node_iterator createLeft( node_iterator parent){
-            _nodes.push_back( Node() );
-            int nidx = _nodes.size()-1;
-            _nodes[ parent._nodeIdx ].setLeft( nidx );
-            return node_iterator(this, _nodes.size()-1 , parent.depth()+1);
+        void setNrOfPrims(int size, NodeIterator node){
+            _nodes[node._idx]._size = size;
         }
 
-        node_iterator createRight( node_iterator parent ){
-            _nodes.push_back( Node() );
-            int nidx = _nodes.size()-1;
-            _nodes[ parent._nodeIdx ].setRight( nidx );
-            return node_iterator(this, _nodes.size()-1 , parent.depth()+1);
+        void setPrimIdx(int primIdx, NodeIterator node){
+            _nodes[node._idx]._data = primIdx;
         }
 
-        node_iterator createRoot(){
-            if(_nodes.size()==0){
-                _nodes.push_back( Node() );
+        /**
+         * @brief packs the tree into the flat depth first layout and copies the
+         * primitives of the leafs into the tree. Must be called when the tree has
+         * been built and before it is traversed.
+         */
+        void optimize(){
+            if(_children.empty())
+                return;
+
+            NodeArray nodes;
+            nodes.reserve(_nodes.size());
+            std::vector<PRIM> prims;
+            std::vector<int> primIds;
+
+            // (old index, index of the parent in the new array if this is a right child)
+            std::vector<std::pair<int,int> > stack;
+            stack.push_back(std::make_pair(0,-1));
+            while(!stack.empty()){
+                const std::pair<int,int> job = stack.back();
+                stack.pop_back();
+                const int newIdx = (int)nodes.size();
+                if(job.second>=0)
+                    nodes[job.second]._data = newIdx;
+
+                const Node& old = _nodes[job.first];
+                nodes.push_back(old);
+                Node& node = nodes.back();
+                if(old.isLeaf()){
+                    node._data = (int)prims.size();
+                    const NodeIterator oldIt(&_nodes[0], job.first, 0);
+                    for(int i=0;i<old.nrOfPrims();i++){
+                        PRIM prim;
+                        primIds.push_back(BVTree<BinaryIdxBVTree<BV,PRIM> >::getPrimitive(oldIt, prim, i));
+                        prims.push_back(prim);
+                    }
+                } else {
+                    const std::pair<int,int>& children = _children[job.first];
+                    node._data = -1;
+                    node._size = children.first>=0 ? 0 : -1;
+                    // the right child is pushed first such that the left child is placed next to its parent
+                    if(children.second>=0)
+                        stack.push_back(std::make_pair(children.second, newIdx));
+                    if(children.first>=0)
+                        stack.push_back(std::make_pair(children.first, -1));
+                }
             }
-            return node_iterator(this, 0 , 0);
-        }
 
-        void setBV(const BVType& bv, node_iterator node){
-            this->bv(node._nodeIdx) = bv;
+            _nodes.swap(nodes);
+            _prims.swap(prims);
+            _primIds.swap(primIds);
+            _children.clear();
+
+            // position of each global primitive index in the packed array
+            _primPos.clear();
+            for(size_t i=0;i<_primIds.size();i++){
+                if(_primIds[i]>=(int)_primPos.size())
+                    _primPos.resize(_primIds[i]+1, -1);
+                _primPos[_primIds[i]] = (int)i;
+            }
         }
 
-        void setNrOfPrims(int size, node_iterator node){
-            _nodes[node._nodeIdx].setNrOfPrims( size );
+		NodeIterator getRootIterator() const {
+		    RW_ASSERT(_children.empty());
+		    return NodeIterator(&_nodes[0], 0, 0);
+		};
+
+        /**
+         * @brief get primitive nr \b triNr of the leaf node \b leafnode.
+         * The primitive is read from the packed primitive array of the tree.
+         * @param leafnode [in] the leaf containing primitives
+         * @param dst [out] the primitive
+         * @param triNr [in] the primitive nr
+         * @return global index of the primitive
+         */
+        inline int getPrimitive(const NodeIterator& leafnode, PRIMType& dst, size_t triNr) const {
+            const size_t idx = leafnode.primitiveIdx()+triNr;
+            dst = _prims[idx];
+            return _primIds[idx];
         }
 
-        void setPrimIdx(int primIdx, node_iterator node){
-            _nodes[node._nodeIdx].setPrimIdx(primIdx);
+        /**
+         * @brief get the primitive with the global index \b primIdx.
+         * @param primIdx [in] the global index as returned by getPrimitive
+         * @param dst [out] the primitive
+         * @return true if the tree has a primitive with the index, false otherwise
+         */
+        inline bool getPrimitiveByIndex(int primIdx, PRIMType& dst) const {
+            if(primIdx<0 || primIdx>=(int)_primPos.size() || _primPos[primIdx]<0)
+                return false;
+            dst = _prims[_primPos[primIdx]];
+            return true;
         }
 
-        void compile(){};
+        //! @brief get the number of nodes in the tree
+        size_t getNrOfNodes() const { return _nodes.size(); }
 
-        Node* createNode(const BV& bv){
-            _nodes.push_back( Node(bv) );
-            return &_nodes.back();
-        };
-
-        Node* createNode(){
-            _nodes.push_back( Node() );
-            return &_nodes.back();
-        };
+		int getMaxTrisPerLeaf() const{return 1;};
 
 	private:
+		typedef std::vector<Node, boost::alignment::aligned_allocator<Node, 64> > NodeArray;
 
-		std::vector<Node> _nodes;
-		std::vector<size_t> _leafIndexes;
+		int newNode(){
+		    _nodes.push_back(Node());
+		    _children.push_back(std::make_pair(-1,-1));
+		    return (int)_nodes.size()-1;
+		}
+
+		NodeArray _nodes;
+		// children of the nodes while the tree is being built
+		std::vector<std::pair<int,int> > _children;
+		std::vector<PRIM> _prims;
+		std::vector<int> _primIds;
+		std::vector<int> _primPos;
 	};
-#endif
 
-	//typedef BinaryIdxBVTree<rw::geometry::OBB<> > BinaryOBBIdxTreeD;
-	//typedef BinaryIdxBVTree<rw::geometry::OBB<float> > BinaryOBBIdxTreeF;
+	typedef BinaryIdxBVTree<rw::geometry::OBB<>, rw::geometry::Triangle<> > BinaryOBBIdxTreeD;
+	typedef BinaryIdxBVTree<rw::geometry::OBB<float>, rw::geometry::Triangle<float> > BinaryOBBIdxTreeF;
 
 }
+
+    //! define traits of the BinaryIdxBVTree
+    template<class BV, class PRIM> struct Traits<proximity::BinaryIdxBVTree<BV,PRIM> >{
+        typedef BV BVType;
+        typedef PRIM PRIMType;
+        typedef typename proximity::BTIdxNode<BV,PRIM> Node;
+        typedef typename proximity::BTIdxNode<BV,PRIM>::NodeIterator NodeIterator;
+    };
+
 }
 
-#endif /* BINARYTREE_HPP_ */
+#endif /* BINARYIDXTREE_HPP_ */
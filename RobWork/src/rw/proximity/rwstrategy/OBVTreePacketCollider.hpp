@@ -0,0 +1,236 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#ifndef RW_PROXIMITY_OBVTREEPACKETCOLLIDER_HPP_
+#define RW_PROXIMITY_OBVTREEPACKETCOLLIDER_HPP_
+
+#include "BVTree.hpp"
+#include "BVTreeCollider.hpp"
+
+#include <rw/geometry/OBBPacketCollider.hpp>
+#include <rw/geometry/TriTriPacketIntersect.hpp>
+#include <rw/math/Transform3D.hpp>
+
+#include <vector>
+
+namespace rw {
+namespace proximity {
+
+    /**
+     * @brief this tree collider is used for OBB trees with triangle primitives. It
+     * traverses the trees depth first with an explicit stack, and descends into both
+     * trees at once. The (up to four) pairs of child nodes are tested with one call to
+     * an rw::geometry::OBBPacketCollider, and overlapping leaf pairs are collected and
+     * tested in packets of eight with an rw::geometry::TriTriPacketIntersect. In a
+     * first contact query, the collected leaf pairs are tested before the traversal
+     * descends further, even if the packet is not full.
+     *
+     * The packet tests use SSE2 or AVX instructions when the CPU supports them and
+     * give the same results as the scalar OBBCollider and TriTriIntersectDeviller.
+     */
+    template<class BVTREE>
+    class OBVTreePacketCollider: public BVTreeCollider<BVTREE> {
+    public:
+        typedef typename Traits<BVTREE>::NodeIterator NodeIterator;
+        typedef typename Traits<BVTREE>::BVType BVType;
+        typedef typename Traits<BVTREE>::PRIMType PRIMType;
+        typedef typename Traits<BVType>::value_type value_type;
+
+        //! @brief constructor
+        OBVTreePacketCollider():_firstContact(true)
+        {
+            initVars();
+        }
+
+        //! @brief destructor
+        virtual ~OBVTreePacketCollider(){};
+
+        //! check if two trees are colliding
+        bool collides(
+            const rw::math::Transform3D<value_type>& fTA, const BVTREE& treeA,
+            const rw::math::Transform3D<value_type>& fTB, const BVTREE& treeB,
+            std::vector<std::pair<int,int> > *collidingPrimitives=NULL);
+
+        /**
+         * @brief select the instruction set of the packet tests.
+         * @param set [in] the instruction set.
+         */
+        void setInstructionSet(rw::geometry::OBBPacketCollider::InstructionSet set){
+            _bvCollider.setInstructionSet(set);
+            _primCollider.setInstructionSet(set);
+        }
+
+        int getMemUsage(){ return (int)(_stack.capacity()*sizeof(Job)); }
+        virtual int getNrOfTestedBVs(){ return _nrOfBVTests; };
+        virtual int getNrOfCollidingBVs(){ return _nrOfCollidingBVs;};
+        virtual int getNrOfTestedPrimitives(){ return _nrOfPrimTests;};
+        virtual int getNrOfCollidingPrimitives(){ return _nrOfCollidingPrims;};
+
+    private:
+        struct Job {
+            Job() {}
+            Job(const NodeIterator& a, const NodeIterator& b): nodeA(a), nodeB(b) {}
+            NodeIterator nodeA, nodeB;
+        };
+
+        inline void initVars(){
+            _nrOfBVTests = 0;
+            _nrOfCollidingBVs = 0;
+            _nrOfPrimTests = 0;
+            _nrOfCollidingPrims = 0;
+            _firstContact = BVTreeCollider<BVTREE>::_queryType==CollisionStrategy::FirstContact;
+        }
+
+        // the children of a node, or the node itself if it is a leaf
+        static inline int children(const NodeIterator& node, NodeIterator* res){
+            if(node.isLeaf()){
+                res[0] = node;
+                return 1;
+            }
+            int n = 0;
+            if(node.hasLeft())
+                res[n++] = node.left();
+            if(node.hasRight())
+                res[n++] = node.right();
+            return n;
+        }
+
+        // test the collected primitive pairs, returns true if any of them collide
+        bool testPrimitives(std::vector<std::pair<int,int> > *collidingPrimitives);
+
+    private:
+        rw::geometry::OBBPacketCollider _bvCollider;
+        rw::geometry::OBBPacketCollider::Packet _bvPacket;
+        rw::geometry::TriTriPacketIntersect _primCollider;
+        rw::geometry::TriTriPacketIntersect::Packet _primPacket;
+        std::pair<int,int> _primIds[rw::geometry::TriTriPacketIntersect::MaxSize];
+        std::vector<Job> _stack;
+        bool _firstContact;
+
+        int _nrOfBVTests, _nrOfCollidingBVs;
+        int _nrOfPrimTests, _nrOfCollidingPrims;
+    };
+
+    template<class BVTREE>
+    bool OBVTreePacketCollider<BVTREE>::testPrimitives(std::vector<std::pair<int,int> > *collidingPrimitives)
+    {
+        if(_primPacket.size==0)
+            return false;
+        const unsigned int mask = _primCollider.inCollision(_primPacket);
+        _nrOfPrimTests += (int)_primPacket.size;
+        for(std::size_t i=0;i<_primPacket.size;i++){
+            if( mask & (1u<<i) ){
+                _nrOfCollidingPrims++;
+                if(collidingPrimitives)
+                    collidingPrimitives->push_back( _primIds[i] );
+            }
+        }
+        _primPacket.clear();
+        return mask!=0;
+    }
+
+    template<class BVTREE>
+    bool OBVTreePacketCollider<BVTREE>::collides(
+            const rw::math::Transform3D<value_type>& fTA, const BVTREE& treeA,
+            const rw::math::Transform3D<value_type>& fTB, const BVTREE& treeB,
+            std::vector<std::pair<int,int> > *collidingPrimitives)
+    {
+        using namespace rw::math;
+
+        initVars();
+        _bvPacket.clear();
+        _primPacket.clear();
+        _stack.clear();
+
+        Transform3D<value_type> tATtB;
+        Transform3D<value_type>::invMult(fTA, fTB, tATtB);
+
+        // the root nodes are tested on their own, all other pairs are tested when they are pushed
+        const NodeIterator rootA = treeA.getRootIterator();
+        const NodeIterator rootB = treeB.getRootIterator();
+        Transform3D<value_type> aATtB;
+        Transform3D<value_type>::invMult(rootA.getBV().getTransform(), tATtB, aATtB);
+        _bvPacket.add(rootA.getBV(), rootB.getBV(), aATtB*rootB.getBV().getTransform());
+        _nrOfBVTests++;
+        if( _bvCollider.collides(_bvPacket)==0 )
+            return false;
+        _stack.push_back( Job(rootA, rootB) );
+
+        bool incollision = false;
+        NodeIterator childrenA[2], childrenB[2];
+        Job jobs[4];
+        PRIMType tria, trib;
+        while( !_stack.empty() ){
+            const Job job = _stack.back();
+            _stack.pop_back();
+
+            if( job.nodeA.isLeaf() && job.nodeB.isLeaf() ){
+                const size_t nrTrisA = treeA.getNrPrimitives(job.nodeA);
+                const size_t nrTrisB = treeB.getNrPrimitives(job.nodeB);
+                for(size_t ai=0;ai<nrTrisA;ai++){
+                    const int triaidx = treeA.getPrimitive(job.nodeA,tria,ai);
+                    for(size_t bi=0;bi<nrTrisB;bi++){
+                        const int tribidx = treeB.getPrimitive(job.nodeB,trib,bi);
+                        _primIds[_primPacket.size] = std::make_pair(triaidx, tribidx);
+                        _primPacket.add(tria, trib, tATtB);
+                        if( _primPacket.isFull() && testPrimitives(collidingPrimitives) ){
+                            incollision = true;
+                            if(_firstContact)
+                                return true;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            // for the first contact, the collected pairs are tested before descending
+            // further, such that a contact found in them is returned at once
+            if( _firstContact && testPrimitives(collidingPrimitives) )
+                return true;
+
+            _nrOfCollidingBVs++;
+            const int nA = children(job.nodeA, childrenA);
+            const int nB = children(job.nodeB, childrenB);
+            _bvPacket.clear();
+            for(int ia=0;ia<nA;ia++){
+                const BVType& bvA = childrenA[ia].getBV();
+                Transform3D<value_type>::invMult(bvA.getTransform(), tATtB, aATtB);
+                for(int ib=0;ib<nB;ib++){
+                    const BVType& bvB = childrenB[ib].getBV();
+                    jobs[_bvPacket.size] = Job(childrenA[ia], childrenB[ib]);
+                    _bvPacket.add(bvA, bvB, aATtB*bvB.getTransform());
+                }
+            }
+            _nrOfBVTests += (int)_bvPacket.size;
+            const unsigned int mask = _bvCollider.collides(_bvPacket);
+
+            // pushed in reverse order such that the pairs of the left children are visited first
+            for(int i=(int)_bvPacket.size-1;i>=0;i--){
+                if( mask & (1u<<i) )
+                    _stack.push_back(jobs[i]);
+            }
+        }
+
+        if( testPrimitives(collidingPrimitives) )
+            incollision = true;
+        return incollision;
+    }
+
+}
+}
+
+#endif /* RW_PROXIMITY_OBVTREEPACKETCOLLIDER_HPP_ */
@@ -21,6 +21,7 @@
 #include "BVTreeFactory.hpp"
 #include "BVTreeColliderFactory.hpp"
 
+#include <rw/geometry/TriTriIntersectDeviller.hpp>
 #include <rw/proximity/ProximityStrategyData.hpp>
 
 #include <vector>
@@ -38,10 +39,62 @@ using namespace rw::models;
 
 using namespace rw::proximity;
 
+namespace {
+    /*
+     * Check if \b axis separates the boxes \b a and \b b, where \b R and \b T are
+     * the rotation and translation of \b b relative to \b a. The axes are numbered
+     * as the three axes of a, the three axes of b and the nine cross products.
+     * The absolute rotation is padded as in OBBCollider.
+     */
+    bool isSeparatingAxis(const Vector3D<>& a, const Vector3D<>& b,
+                          const Rotation3D<>& R, const Vector3D<>& T, int axis)
+    {
+        static const double reps = 1e-6;
+        if (axis < 3) {
+            const int i = axis;
+            const double rb = b[0]*(std::fabs(R(i,0))+reps) + b[1]*(std::fabs(R(i,1))+reps) + b[2]*(std::fabs(R(i,2))+reps);
+            return std::fabs(T[i]) > a[i] + rb;
+        } else if (axis < 6) {
+            const int j = axis - 3;
+            const double ra = a[0]*(std::fabs(R(0,j))+reps) + a[1]*(std::fabs(R(1,j))+reps) + a[2]*(std::fabs(R(2,j))+reps);
+            return std::fabs(T[0]*R(0,j) + T[1]*R(1,j) + T[2]*R(2,j)) > ra + b[j];
+        }
+        const int i = (axis - 6) / 3;
+        const int j = (axis - 6) % 3;
+        const int i1 = (i+1)%3, i2 = (i+2)%3;
+        const int j1 = (j+1)%3, j2 = (j+2)%3;
+        const double ra = a[i1]*(std::fabs(R(i2,j))+reps) + a[i2]*(std::fabs(R(i1,j))+reps);
+        const double rb = b[j1]*(std::fabs(R(i,j2))+reps) + b[j2]*(std::fabs(R(i,j1))+reps);
+        return std::fabs(T[i2]*R(i1,j) - T[i1]*R(i2,j)) > ra + rb;
+    }
+
+    /*
+     * Find an axis that separates the root bounding volumes of two trees, trying
+     * \b first before the other axes. Returns -1 if the volumes overlap.
+     */
+    int findSeparatingAxis(const BinaryOBBIdxTreeD& treeA, const BinaryOBBIdxTreeD& treeB,
+                           const Transform3D<>& tATtB, int first)
+    {
+        const OBB<>& bvA = treeA.getRootIterator().getBV();
+        const OBB<>& bvB = treeB.getRootIterator().getBV();
+        const Transform3D<> aTb = inverse(bvA.getTransform()) * tATtB * bvB.getTransform();
+        const Vector3D<>& a = bvA.getHalfLengths();
+        const Vector3D<>& b = bvB.getHalfLengths();
+        if (first >= 0 && isSeparatingAxis(a, b, aTb.R(), aTb.P(), first))
+            return first;
+        for (int axis = 0; axis < 15; axis++) {
+            if (axis != first && isSeparatingAxis(a, b, aTb.R(), aTb.P(), axis))
+                return axis;
+        }
+        return -1;
+    }
+}
+
 //----------------------------------------------------------------------
 // ProximityStrategyRW
 
-ProximityStrategyRW::ProximityStrategyRW()
+ProximityStrategyRW::ProximityStrategyRW():
+	_instructionSet(OBBPacketCollider::getSupportedInstructionSet())
 {
 	clearStats();
 }
@@ -81,9 +134,15 @@ bool ProximityStrategyRW::addGeometry(ProximityModel* model, const Geometry& geo
 
     Model::Ptr rwmodel;
     // check if model is in
-    CacheKey key(geom.getId(),geom.getScale());
+    // geometries with the same id can have different data, so the data is used as key
+    CacheKey key(geom.getGeometryData().get(),geom.getScale());
     if( _modelCache.has(key) ){
-        rwmodel = _modelCache.get(key);
+        // the tree is shared, but the id and transform belong to this geometry
+        const Model::Ptr cached = _modelCache.get(key);
+        rwmodel = ownedPtr( new Model(geom.getId(), geom.getTransform(), cached->tree) );
+        rwmodel->ckey = key;
+        rwmodel->scale = cached->scale;
+        rwmodel->data = cached->data;
     } else {
         GeometryData::Ptr gdata = geom.getGeometryData();
         TriMesh::Ptr mesh = gdata->getTriMesh(false);
@@ -97,11 +156,12 @@ bool ProximityStrategyRW::addGeometry(ProximityModel* model, const Geometry& geo
 
         //Timer t;
         //std::cout << "Mesh size: " << mesh->getSize() << std::endl;
-        BinaryOBBPtrTreeD::Ptr tree = ownedPtr(treefactory.makeTopDownOBBTreeCovarMedian<BinaryOBBPtrTreeD>(mesh,1));
+        BinaryOBBIdxTreeD::Ptr tree = ownedPtr(treefactory.makeTopDownOBBIdxTreeCovarMedian<BinaryOBBIdxTreeD>(mesh,1));
         //std::cout << "Time to create OBB tree: " << t.toString("ss:zzz") << std::endl;
         rwmodel = ownedPtr( new Model(geom.getId(), geom.getTransform(), tree) );
         rwmodel->ckey = key;
         rwmodel->scale = scale;
+        rwmodel->data = gdata;
         _modelCache.add(key, rwmodel);
     }
 
@@ -145,7 +205,8 @@ ProximityStrategyRW::QueryData ProximityStrategyRW::initQuery(ProximityModel::Pt
 
     qdata.cache = static_cast<PCache*>(data.getCache().get());
     if(qdata.cache->tcollider==NULL)
-        qdata.cache->tcollider = ownedPtr( BVTreeColliderFactory::makeBalancedDFSColliderOBB<BinaryOBBPtrTreeD>() );
+        qdata.cache->tcollider = ownedPtr( new OBVTreePacketCollider<BinaryOBBIdxTreeD>() );
+    qdata.cache->tcollider->setInstructionSet(_instructionSet);
 
     qdata.a = (RWProximityModel*)aModel.get();
     qdata.b = (RWProximityModel*)bModel.get();
@@ -188,14 +249,45 @@ bool ProximityStrategyRW::doInCollision(ProximityModel::Ptr aModel,
 
     qdata.cache->tcollider->setQueryType( pdata.getCollisionQueryType() );
 
+    // The witnesses of the last query for the same models are used to start this query
+    std::vector<Witness>& witnesses = qdata.cache->witnesses;
+    if (qdata.cache->a != qdata.a || qdata.cache->b != qdata.b) {
+        witnesses.clear();
+        qdata.cache->a = qdata.a;
+        qdata.cache->b = qdata.b;
+    }
+    witnesses.resize(qdata.a->models.size()*qdata.b->models.size());
+
     BOOST_FOREACH(Model::Ptr &ma, qdata.a->models) {
         BOOST_FOREACH(Model::Ptr &mb, qdata.b->models) {
             int startIdx = static_cast<int>(data._geomPrimIds.size());
-            bool res = qdata.cache->tcollider->collides(wTa*ma->t3d, *ma->tree, wTb*mb->t3d, *mb->tree, &data._geomPrimIds);
-
-            //std::cout << res << std::endl;
-            _numBVTests += qdata.cache->tcollider->getNrOfTestedBVs();
-            _numTriTests += qdata.cache->tcollider->getNrOfTestedPrimitives();
+            Witness& witness = witnesses[geoIdxA*qdata.b->models.size() + geoIdxB];
+            const Transform3D<> wTta = wTa*ma->t3d;
+            const Transform3D<> wTtb = wTb*mb->t3d;
+            const Transform3D<> tATtB = inverse(wTta)*wTtb;
+
+            // the geometries are still apart if the last separating axis still separates them
+            witness.axis = findSeparatingAxis(*ma->tree, *mb->tree, tATtB, witness.axis);
+            bool res;
+            if (witness.axis >= 0) {
+                data._nrBVTests++;
+                res = false;
+            } else if (firstContact && hasWitnessContact(witness, *ma->tree, *mb->tree, tATtB)) {
+                // the primitives that collided in the last query still collide
+                data._nrPrimTests++;
+                data._geomPrimIds.push_back(std::make_pair(witness.primA, witness.primB));
+                res = true;
+            } else {
+                res = qdata.cache->tcollider->collides(wTta, *ma->tree, wTtb, *mb->tree, &data._geomPrimIds);
+                data._nrBVTests += qdata.cache->tcollider->getNrOfTestedBVs();
+                data._nrPrimTests += qdata.cache->tcollider->getNrOfTestedPrimitives();
+                if (res && (int)data._geomPrimIds.size() > startIdx) {
+                    witness.primA = data._geomPrimIds[startIdx].first;
+                    witness.primB = data._geomPrimIds[startIdx].second;
+                } else {
+                    witness.primA = witness.primB = -1;
+                }
+            }
 
             if(res==true){
                 nrOfCollidingGeoms++;
@@ -209,17 +301,38 @@ bool ProximityStrategyRW::doInCollision(ProximityModel::Ptr aModel,
                 data._collisionPairs[nrOfCollidingGeoms-1].startIdx = startIdx;
                 data._collisionPairs[nrOfCollidingGeoms-1].size = static_cast<int>(data._geomPrimIds.size())-startIdx;
 
-                if(firstContact)
+                if(firstContact) {
+                    addStats(data._nrBVTests, data._nrPrimTests);
                     return true;
+                }
                 col_res = true;
             }
             geoIdxB++;
         }
         geoIdxA++;
     }
+    addStats(data._nrBVTests, data._nrPrimTests);
     return col_res;
 }
 
+void ProximityStrategyRW::addStats(int bvTests, int triTests)
+{
+    boost::mutex::scoped_lock lock(_statsMutex);
+    _numBVTests += bvTests;
+    _numTriTests += triTests;
+}
+
+bool ProximityStrategyRW::hasWitnessContact(const Witness& witness,
+                                            const BinaryOBBIdxTreeD& treeA,
+                                            const BinaryOBBIdxTreeD& treeB,
+                                            const Transform3D<>& tATtB) const
+{
+    Triangle<> triA, triB;
+    if (witness.primA < 0 || !treeA.getPrimitiveByIndex(witness.primA, triA) || !treeB.getPrimitiveByIndex(witness.primB, triB))
+        return false;
+    return TriTriIntersectDeviller<>().inCollision(triA, triB, tATtB);
+}
+
 void ProximityStrategyRW::getCollisionContacts(std::vector<CollisionStrategy::Contact>& contacts,
 											  ProximityStrategyData& data)
 {
@@ -34,10 +34,16 @@
 #include <rw/proximity/ProximityCache.hpp>
 
 #include "BinaryBVTree.hpp"
+#include "BinaryIdxBVTree.hpp"
 #include "BVTreeCollider.hpp"
+#include "OBVTreePacketCollider.hpp"
 
 #include <rw/geometry/OBBToleranceCollider.hpp>
 
+#include <boost/thread/mutex.hpp>
+
+namespace rw { namespace geometry { class GeometryData; } }
+
 //#include "RSSDistanceCalc.hpp"
 
 
@@ -73,17 +79,34 @@ namespace rw { namespace proximity {
         typedef rw::common::Ptr<ProximityStrategyRW> Ptr;
 
         //! @brief cache key
-        typedef std::pair<std::string, double> CacheKey;
+        typedef std::pair<rw::geometry::GeometryData*, double> CacheKey;
+
+        /**
+         * @brief result of the last query for a pair of geometries, used to
+         * start the next query for the pair.
+         */
+        struct Witness {
+            Witness(): axis(-1), primA(-1), primB(-1) {}
+            //! @brief axis that separated the root bounding volumes, or -1
+            int axis;
+            //! @brief global indices of a pair of colliding primitives, or -1
+            int primA, primB;
+        };
 
         //! @brief cache for any of the queries possible on this strategy
         struct PCache: public rw::proximity::ProximityCache{
-            PCache(void *owner):ProximityCache(owner){}
-            virtual size_t size() const{ return 0;};
-            virtual void clear(){};
+            PCache(void *owner):ProximityCache(owner),a(NULL),b(NULL){}
+            virtual size_t size() const{ return witnesses.size();};
+            virtual void clear(){ witnesses.clear(); a = NULL; b = NULL; };
+
+            //! @brief the models that the witnesses are for
+            const ProximityModel *a, *b;
+            //! @brief witness for each pair of geometries of the models
+            std::vector<Witness> witnesses;
 
             // TODO: reuse stuff from the collision test
-            rw::common::Ptr<rw::proximity::BVTreeCollider<rw::proximity::BinaryOBBPtrTreeD > > tcollider;
-            rw::common::Ptr<rw::proximity::BVTreeCollider<rw::proximity::BinaryOBBPtrTreeD > > tolcollider;
+            rw::common::Ptr<rw::proximity::OBVTreePacketCollider<rw::proximity::BinaryOBBIdxTreeD > > tcollider;
+            rw::common::Ptr<rw::proximity::BVTreeCollider<rw::proximity::BinaryOBBIdxTreeD > > tolcollider;
             rw::geometry::OBBToleranceCollider<> *tolCollider;
 
         };
@@ -93,14 +116,16 @@ namespace rw { namespace proximity {
         struct Model {
             typedef rw::common::Ptr<Model > Ptr;
 
-            Model(std::string id, rw::math::Transform3D<> trans, rw::proximity::BinaryOBBPtrTreeD::Ptr obbtree):
+            Model(std::string id, rw::math::Transform3D<> trans, rw::proximity::BinaryOBBIdxTreeD::Ptr obbtree):
                 geoid(id),t3d(trans),tree(obbtree){}
 
             std::string geoid;
             double scale;
             rw::math::Transform3D<> t3d;
-            rw::proximity::BinaryOBBPtrTreeD::Ptr tree;
+            rw::proximity::BinaryOBBIdxTreeD::Ptr tree;
             CacheKey ckey;
+            //! @brief keeps the data of the cache key alive, such that its address is not reused
+            rw::common::Ptr<rw::geometry::GeometryData> data;
         };
 
         //typedef std::vector<RWPQPModel> RWPQPModelList;
@@ -171,22 +196,36 @@ namespace rw { namespace proximity {
          */
         void clear();
 
+        /**
+         * @brief select the instruction set of the packet tests used by the
+         * tree collider. The default is the best instruction set supported by
+         * the CPU.
+         * @param set [in] the instruction set.
+         */
+        void setInstructionSet(rw::geometry::OBBPacketCollider::InstructionSet set){ _instructionSet = set; };
+
+        /**
+         * @brief get the instruction set selected for the packet tests.
+         * @return the instruction set.
+         */
+        rw::geometry::OBBPacketCollider::InstructionSet getInstructionSet() const { return _instructionSet; };
+
         /**
          * @brief returns the number of bounding volume tests performed
          * since the last call to clearStats
          */
-        int getNrOfBVTests(){return _numBVTests;};
+        int getNrOfBVTests(){ boost::mutex::scoped_lock lock(_statsMutex); return _numBVTests; };
 
         /**
          * @brief returns the number of ptriangle tests performed
          * since the last call to clearStats
          */
-        int getNrOfTriTests(){return _numTriTests;};
+        int getNrOfTriTests(){ boost::mutex::scoped_lock lock(_statsMutex); return _numTriTests; };
 
         /**
          * @brief clears the bounding volume and triangle test counters.
          */
-        void clearStats(){ _numBVTests = 0; _numTriTests = 0;};
+        void clearStats(){ boost::mutex::scoped_lock lock(_statsMutex); _numBVTests = 0; _numTriTests = 0; };
 
 		void getCollisionContacts(std::vector<CollisionStrategy::Contact>& contacts,
 											  ProximityStrategyData& data);
@@ -201,11 +240,21 @@ namespace rw { namespace proximity {
         QueryData initQuery(rw::proximity::ProximityModel::Ptr& aModel,
                             rw::proximity::ProximityModel::Ptr& bModel,
                             rw::proximity::ProximityStrategyData &data);
+
+        bool hasWitnessContact(const Witness& witness,
+                               const rw::proximity::BinaryOBBIdxTreeD& treeA,
+                               const rw::proximity::BinaryOBBIdxTreeD& treeB,
+                               const rw::math::Transform3D<>& tATtB) const;
     private:
 
+    	// the counters are shared by queries that run in parallel
+    	void addStats(int bvTests, int triTests);
+
     	int _numBVTests,_numTriTests;
+    	boost::mutex _statsMutex;
+    	rw::geometry::OBBPacketCollider::InstructionSet _instructionSet;
 
-    	rw::proximity::BVTreeCollider<rw::proximity::BinaryOBBPtrTreeD>::Ptr _tcollider;
+    	rw::proximity::BVTreeCollider<rw::proximity::BinaryOBBIdxTreeD>::Ptr _tcollider;
     	std::vector<Model::Ptr> _allModels;
     };
 
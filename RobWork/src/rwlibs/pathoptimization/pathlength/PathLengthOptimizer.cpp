@@ -19,11 +19,18 @@
 #include "PathLengthOptimizer.hpp"
 
 #include <rw/pathplanning/PlannerUtil.hpp>
+#include <rw/common/FunctionTask.hpp>
+#include <rw/common/ThreadPool.hpp>
 #include <rw/common/Timer.hpp>
 #include <rw/math/Random.hpp>
 #include <rw/math/Metric.hpp>
 #include <rw/pathplanning/PathAnalyzer.hpp>
 
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include <algorithm>
+
 using namespace rw::math;
 using namespace rw::common;
 using namespace rw::models;
@@ -55,22 +62,81 @@ namespace
         // Math::pathLength() does not include the end iterator in the sequence.
         return rw::pathplanning::PathAnalyzer::pathLength(start, ++end, metric);
     }
+
+    // The configurations strictly between q1 and q2 when the straight line
+    // from q1 to q2 is subdivided into segments of at most subDivideLength.
+    void subdivide(const Q& q1, const Q& q2, double subDivideLength, const QMetric& metric, std::vector<Q>& result)
+    {
+        if (subDivideLength == 0)
+            return;
+        const int stepcount = (int)std::ceil(metric.distance(q1, q2) / subDivideLength);
+        const double delta = 1.0 / (double)stepcount;
+        for (int i = 1; i < stepcount; i++)
+            result.push_back((1 - delta * i) * q1 + (delta * i) * q2);
+    }
+
+    void subdividePath(std::vector<Q>& path, double subDivideLength, const QMetric& metric)
+    {
+        if (path.empty())
+            return;
+        std::vector<Q> result;
+        result.reserve(path.size());
+        for (std::size_t i = 0; i + 1 < path.size(); i++) {
+            result.push_back(path[i]);
+            subdivide(path[i], path[i + 1], subDivideLength, metric, result);
+        }
+        result.push_back(path.back());
+        path.swap(result);
+    }
 }
 
+struct PathLengthOptimizer::Candidate {
+    // the shortcut goes from node i1 to node i2 of the path
+    int i1, i2;
+    // the nodes that replace the nodes strictly between i1 and i2
+    std::vector<Q> nodes;
+    // the reduction of the path length
+    double gain;
+    bool valid;
+
+    bool operator<(const Candidate& other) const {
+        return gain > other.gain;
+    }
+};
+
 const std::string PathLengthOptimizer::PROP_LOOPCOUNT = "LoopCount";
 const std::string PathLengthOptimizer::PROP_MAXTIME = "MaxTime";
 const std::string PathLengthOptimizer::PROP_SUBDIVLENGTH = "SubDivideLength";
+const std::string PathLengthOptimizer::PROP_CANDIDATES = "CandidatesPerRound";
 
 PathLengthOptimizer::PathLengthOptimizer(
     const PlannerConstraint& constraint,
 	QMetric::CPtr metric)
     :
     _constraint(constraint),
+    _constraints(1, constraint),
+    _metric(metric)
+{
+    _propertyMap.add(PROP_LOOPCOUNT, "Maximal Number of Loops", 1000);
+    _propertyMap.add(PROP_MAXTIME, "Maximal Time to use (seconds)", 200.0);
+    _propertyMap.add(PROP_SUBDIVLENGTH, "Subdivide Length", 0.1);
+    _propertyMap.add(PROP_CANDIDATES, "Candidate shortcuts per round of the parallel optimizers", 16);
+}
+
+PathLengthOptimizer::PathLengthOptimizer(
+    const std::vector<PlannerConstraint>& constraints,
+	QMetric::CPtr metric)
+    :
+    _constraints(constraints),
     _metric(metric)
 {
+    if (constraints.empty())
+        RW_THROW("PathLengthOptimizer needs at least one constraint.");
+    _constraint = constraints.front();
     _propertyMap.add(PROP_LOOPCOUNT, "Maximal Number of Loops", 1000);
     _propertyMap.add(PROP_MAXTIME, "Maximal Time to use (seconds)", 200.0);
     _propertyMap.add(PROP_SUBDIVLENGTH, "Subdivide Length", 0.1);
+    _propertyMap.add(PROP_CANDIDATES, "Candidate shortcuts per round of the parallel optimizers", 16);
 }
 
 PathLengthOptimizer::~PathLengthOptimizer() {}
@@ -80,6 +146,11 @@ PropertyMap& PathLengthOptimizer::getPropertyMap()
     return _propertyMap;
 }
 
+void PathLengthOptimizer::setThreadPool(ThreadPool::Ptr pool)
+{
+    _pool = pool;
+}
+
 /**
  * Runs through the path an tests if nodes with
  * index i and i+2 can be directly connected. If so it removed node i+1.
@@ -247,6 +318,132 @@ void PathLengthOptimizer::partialShortCut(
     }
 }
 
+void PathLengthOptimizer::parallelShortCut(std::vector<Q>& path,
+                                           size_t maxcnt,
+                                           double time,
+                                           double subDivideLength,
+                                           bool partial) const
+{
+    if (maxcnt == 0 && time == 0)
+        RW_THROW("With maxcnt == 0 and time == 0 the algorithm will never terminate");
+
+    subdividePath(path, subDivideLength, *_metric);
+
+    const int roundSize = std::max(1, _propertyMap.get<int>(PROP_CANDIDATES));
+    size_t cnt = 0;
+    Timer timer;
+
+    std::vector<Candidate> candidates;
+    std::vector<Q> result;
+    while ((maxcnt == 0 || cnt < maxcnt) && (time == 0 || timer.getTime() < time))
+    {
+        const int n = (int)path.size();
+        if (n <= 2) break;
+
+        // Draw the candidates that would shorten the path
+        candidates.clear();
+        for (int k = 0; k < roundSize && (maxcnt == 0 || cnt < maxcnt); k++) {
+            cnt++;
+            Candidate c;
+            c.i1 = Random::ranI(0, n - 2);
+            c.i2 = Random::ranI(c.i1 + 2, n);
+            c.valid = false;
+            const double length = PathAnalyzer::pathLength(path.begin() + c.i1, path.begin() + c.i2 + 1, *_metric);
+            double newLength;
+            if (partial) {
+                // interpolate a single value of the configurations
+                const int index = Random::ranI(0, (int)path.front().size());
+                const double qstart = path[c.i1](index);
+                const double qend = path[c.i2](index);
+                const double delta = 1.0 / (c.i2 - c.i1);
+                c.nodes.assign(path.begin() + c.i1 + 1, path.begin() + c.i2);
+                for (std::size_t j = 0; j < c.nodes.size(); j++) {
+                    const double t = delta * (j + 1);
+                    c.nodes[j](index) = qstart * (1 - t) + qend * t;
+                }
+                newLength = _metric->distance(path[c.i1], c.nodes.front()) +
+                    PathAnalyzer::pathLength(c.nodes.begin(), c.nodes.end(), *_metric) +
+                    _metric->distance(c.nodes.back(), path[c.i2]);
+            } else {
+                newLength = _metric->distance(path[c.i1], path[c.i2]);
+            }
+            c.gain = length - newLength;
+            if (c.gain > 0)
+                candidates.push_back(c);
+        }
+        if (candidates.empty())
+            continue;
+
+        // Validate the candidates concurrently
+        const std::size_t workers = _constraints.size();
+        if (_pool == NULL || _pool->getNumberOfThreads() == 0 || workers == 1) {
+            for (std::size_t w = 0; w < workers; w++)
+                validateCandidates(candidates, path, w);
+        } else {
+            std::vector<boost::function<void()> > work;
+            for (std::size_t w = 0; w < workers; w++) {
+                work.push_back(boost::bind(&PathLengthOptimizer::validateCandidates, this,
+                                           boost::ref(candidates), boost::cref(path), w));
+            }
+            FunctionTask::runAll(_pool, work);
+        }
+
+        // Apply the valid candidates that save the most and do not overlap
+        std::stable_sort(candidates.begin(), candidates.end());
+        std::vector<const Candidate*> accepted;
+        for (std::size_t k = 0; k < candidates.size(); k++) {
+            const Candidate& c = candidates[k];
+            if (!c.valid)
+                continue;
+            bool overlaps = false;
+            for (std::size_t a = 0; a < accepted.size() && !overlaps; a++)
+                overlaps = c.i1 < accepted[a]->i2 && accepted[a]->i1 < c.i2;
+            if (!overlaps)
+                accepted.push_back(&c);
+        }
+        if (accepted.empty())
+            continue;
+        std::sort(accepted.begin(), accepted.end(),
+                  boost::bind(&Candidate::i1, _1) < boost::bind(&Candidate::i1, _2));
+
+        result.clear();
+        result.reserve(path.size());
+        int pos = 0;
+        for (std::size_t a = 0; a < accepted.size(); a++) {
+            const Candidate& c = *accepted[a];
+            result.insert(result.end(), path.begin() + pos, path.begin() + c.i1 + 1);
+            if (partial)
+                result.insert(result.end(), c.nodes.begin(), c.nodes.end());
+            else
+                subdivide(path[c.i1], path[c.i2], subDivideLength, *_metric, result);
+            pos = c.i2;
+        }
+        result.insert(result.end(), path.begin() + pos, path.end());
+        path.swap(result);
+    }
+}
+
+void PathLengthOptimizer::validateCandidates(std::vector<Candidate>& candidates,
+                                             const std::vector<Q>& path,
+                                             std::size_t worker) const
+{
+    const PlannerConstraint& constraint = _constraints[worker];
+    for (std::size_t k = worker; k < candidates.size(); k += _constraints.size()) {
+        Candidate& c = candidates[k];
+        if (c.nodes.empty()) {
+            // The start and end configurations does not change
+            c.valid = validPath(constraint, path[c.i1], path[c.i2], false, false);
+            continue;
+        }
+
+        c.valid = validPath(constraint, path[c.i1], c.nodes.front(), false, true);
+        for (std::size_t j = 1; j < c.nodes.size() && c.valid; j++)
+            c.valid = validPath(constraint, c.nodes[j - 1], c.nodes[j], false, true);
+        if (c.valid)
+            c.valid = validPath(constraint, c.nodes.back(), path[c.i2], false, true);
+    }
+}
+
 void PathLengthOptimizer::resamplePath(QList& path, double subDivideLength) const
 {
     QList::iterator it1 = path.begin();
@@ -286,9 +483,18 @@ bool PathLengthOptimizer::validPath(
     const Q& from,
     const Q& to, 
 	const bool testQStart, const bool testQEnd) const
+{
+    return validPath(_constraint, from, to, testQStart, testQEnd);
+}
+
+bool PathLengthOptimizer::validPath(
+    const PlannerConstraint& constraint,
+    const Q& from,
+    const Q& to,
+	const bool testQStart, const bool testQEnd) const
 {
     return !PlannerUtil::inCollision(
-        _constraint,
+        constraint,
         from,
         to,
 		testQStart,
@@ -339,3 +545,27 @@ QPath PathLengthOptimizer::partialShortCut(const QPath& path) const
     partialShortCut(tmp);
     return QPath(tmp.begin(), tmp.end());
 }
+
+QPath PathLengthOptimizer::shortCutParallel(const QPath& path,
+                                            size_t cnt,
+                                            double time,
+                                            double subDivideLength) const
+{
+    if (path.empty()) return path;
+
+    std::vector<Q> tmp(path.begin(), path.end());
+    parallelShortCut(tmp, cnt, time, subDivideLength, false);
+    return QPath(tmp.begin(), tmp.end());
+}
+
+QPath PathLengthOptimizer::partialShortCutParallel(const QPath& path,
+                                                   size_t cnt,
+                                                   double time,
+                                                   double subDivideLength) const
+{
+    std::vector<Q> tmp(path.begin(), path.end());
+    if (tmp.size() <= 1)
+        RW_THROW("Length or size of path is too short!");
+    parallelShortCut(tmp, cnt, time, subDivideLength, true);
+    return QPath(tmp.begin(), tmp.end());
+}
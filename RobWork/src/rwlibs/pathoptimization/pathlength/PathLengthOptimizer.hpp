@@ -25,6 +25,9 @@
 #include <rw/pathplanning/PlannerConstraint.hpp>
 #include <rw/trajectory/Path.hpp>
 #include <list>
+#include <vector>
+
+namespace rw { namespace common { class ThreadPool; } }
 
 namespace rwlibs { namespace pathoptimization {
 
@@ -49,6 +52,16 @@ namespace rwlibs { namespace pathoptimization {
      * position in the configuration vector. A shortcut is then only tried between the values
      * corresponding to the random position. This algorithm is generally more powerful than
      * shortCut but may in some cases be more computational expensive.
+     *
+     * The shortcut methods check many of the same edges repeatedly. Use an
+     * edge constraint made with rw::pathplanning::QEdgeConstraint::makeCached()
+     * in the planner constraint to reuse the results of earlier checks.
+     *
+     * The \b shortCutParallel and \b partialShortCutParallel algorithms
+     * propose a round of random shortcuts at a time and validate them
+     * concurrently with one planner constraint per worker. The valid
+     * shortcuts of a round that shorten the path the most and do not
+     * overlap are then applied together.
      */
     class PathLengthOptimizer
     {
@@ -74,6 +87,21 @@ namespace rwlibs { namespace pathoptimization {
         PathLengthOptimizer(const rw::pathplanning::PlannerConstraint& constraint,
 			rw::math::QMetric::CPtr metric);
 
+        /**
+           @brief Constructor for the parallel optimizers.
+
+           The constraints are used concurrently by shortCutParallel() and
+           partialShortCutParallel(), so they must not share state such as a
+           collision detector or a work state. The other optimizers use the
+           first constraint.
+
+           @param constraints [in] Verification of edges and configurations
+           for each worker. The number of workers is the number of constraints.
+           @param metric [in] Distance metric for edge lengths
+        */
+        PathLengthOptimizer(const std::vector<rw::pathplanning::PlannerConstraint>& constraints,
+			rw::math::QMetric::CPtr metric);
+
         /**
            @brief Destructor
         */
@@ -150,6 +178,62 @@ namespace rwlibs { namespace pathoptimization {
          */
         rw::trajectory::QPath partialShortCut(const rw::trajectory::QPath& path) const;
 
+        /**
+         * @brief Optimizes using the shortcut technique with candidate
+         * shortcuts validated in parallel.
+         *
+         * Each round draws the number of candidate shortcuts given by the
+         * PROP_CANDIDATES property as two random indices i and j, as for
+         * shortCut(). The candidates that would shorten the path are checked
+         * concurrently by the workers, and the valid candidates are applied
+         * in the order of the length they save, skipping candidates that
+         * overlap a shortcut already applied in the round.
+         *
+         * The candidates are drawn in the calling thread, so the result is
+         * the same for the same seed of rw::math::Random regardless of the
+         * number of workers and threads.
+         *
+         * @param path [in] Path to optimize
+         * @param cnt [in] Max number of candidates to try. If cnt=0, only the
+         * time limit will be used
+         * @param time [in] Max time to use (in seconds). If time=0, only the
+         * cnt limit will be used
+         * @param subDivideLength [in] The length into which the path is subdivided
+         * @return The optimized path
+         */
+        rw::trajectory::QPath shortCutParallel(const rw::trajectory::QPath& path,
+                                               size_t cnt,
+                                               double time,
+                                               double subDivideLength) const;
+
+        /**
+         * @brief Optimizes using the partial shortcut technique with
+         * candidate shortcuts validated in parallel.
+         *
+         * The candidates are drawn as for partialShortCut() and are
+         * validated and applied in rounds as for shortCutParallel().
+         *
+         * @param path [in] Path to optimize
+         * @param cnt [in] Max number of candidates to try. If cnt=0, only the
+         * time limit will be used
+         * @param time [in] Max time to use (in seconds). If time=0, only the
+         * cnt limit will be used
+         * @param subDivideLength [in] The length into which the path is subdivided
+         * @return The optimized path
+         */
+        rw::trajectory::QPath partialShortCutParallel(const rw::trajectory::QPath& path,
+                                                      size_t cnt,
+                                                      double time,
+                                                      double subDivideLength) const;
+
+        /**
+         * @brief Set the thread pool that the workers of the parallel
+         * optimizers run in.
+         * @param pool [in] the pool, or NULL to run the workers in the calling
+         * thread (default).
+         */
+        void setThreadPool(rw::common::Ptr<rw::common::ThreadPool> pool);
+
         //----------------------------------------------------------------------
 
         /**
@@ -167,10 +251,28 @@ namespace rwlibs { namespace pathoptimization {
         //!Property key for length of segment in when subdividing
         static const std::string PROP_SUBDIVLENGTH;
 
+        //!Property key for the number of candidates per round of the parallel optimizers
+        static const std::string PROP_CANDIDATES;
+
     private:
         rw::pathplanning::PlannerConstraint _constraint;
+        std::vector<rw::pathplanning::PlannerConstraint> _constraints;
 		rw::math::QMetric::CPtr _metric;
         rw::common::PropertyMap _propertyMap;
+        rw::common::Ptr<rw::common::ThreadPool> _pool;
+
+        //! A candidate shortcut of the parallel optimizers.
+        struct Candidate;
+
+        void parallelShortCut(std::vector<rw::math::Q>& path,
+                              size_t cnt,
+                              double time,
+                              double subDivideLength,
+                              bool partial) const;
+
+        void validateCandidates(std::vector<Candidate>& candidates,
+                                const std::vector<rw::math::Q>& path,
+                                std::size_t worker) const;
 
         void pathPruning(QList& path) const;
 
@@ -196,6 +298,10 @@ namespace rwlibs { namespace pathoptimization {
                                  QList& result) const;
 
         bool validPath(const rw::math::Q& from, const rw::math::Q& to, const bool testQStart, const bool testQEnd) const;
+
+        bool validPath(const rw::pathplanning::PlannerConstraint& constraint,
+                       const rw::math::Q& from, const rw::math::Q& to,
+                       const bool testQStart, const bool testQEnd) const;
     };
 
     /** @} */
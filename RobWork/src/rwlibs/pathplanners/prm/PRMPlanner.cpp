@@ -29,6 +29,10 @@
 #include <boost/graph/astar_search.hpp>
 #include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <boost/graph/adjacency_list.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <limits>
 #include <queue>
 
 #include "PartialIndexTable.hpp"
@@ -301,6 +305,7 @@ PRMPlanner::Node PRMPlanner::addNode(const Q& q, bool checked)
 void PRMPlanner::buildRoadmap(size_t nodecount)
 {
     roadmapBuildTimer.resume();
+    _roadmap = NULL;
     _Rneighbor = estimateRneighbor(nodecount);
     //std::cout<<"Rneighbor = "<<_Rneighbor<<std::endl;
 
@@ -409,6 +414,12 @@ bool PRMPlanner::doQuery(
         return false;
     }
 
+    if (_roadmap != NULL) {
+        const bool found = doRoadmapQuery(qInit, qGoal, path, stop);
+        queryTimer.pause();
+        return found;
+    }
+
     // check if roadmap was initialized, if not then build it
     if( !_roadmap_initialized ){
         RW_WARN("Roadmap was not build/initialized before first query. It will be built now with 1000 nodes!");
@@ -741,3 +752,209 @@ void PRMPlanner::setShortestPathSearchStrategy(ShortestPathSearchStrategy shorte
 void PRMPlanner::setAStarTimeOutTime(double timeout) {
     _astarTimeOutTime = timeout;
 }
+
+void PRMPlanner::saveRoadmap(const std::string& filename) const
+{
+    std::map<Node, prm::PRMRoadmap::NodeIndex> indices;
+    std::vector<Q> nodes;
+    std::vector<prm::PRMRoadmap::Validity> nodeValidity;
+    BOOST_FOREACH(const Node& node, boost::vertices(_graph)) {
+        indices[node] = (prm::PRMRoadmap::NodeIndex)nodes.size();
+        nodes.push_back(_graph[node].q);
+        nodeValidity.push_back(_graph[node].checked ? prm::PRMRoadmap::Free : prm::PRMRoadmap::Unknown);
+    }
+
+    std::vector<prm::PRMRoadmap::Edge> edges;
+    BOOST_FOREACH(const Edge& edge, boost::edges(_graph)) {
+        const EdgeData& data = _graph[edge];
+        edges.push_back(prm::PRMRoadmap::Edge(
+            indices[boost::source(edge, _graph)],
+            indices[boost::target(edge, _graph)],
+            data.weight,
+            data.resolution <= _resolution ? prm::PRMRoadmap::Free : prm::PRMRoadmap::Unknown));
+    }
+
+    prm::PRMRoadmap::write(filename, nodes, nodeValidity, edges, _Rneighbor);
+}
+
+void PRMPlanner::loadRoadmap(const std::string& filename, bool writable)
+{
+    const prm::PRMRoadmap::Ptr roadmap = prm::PRMRoadmap::load(filename, writable);
+    if (roadmap->getNodeCount() > 0 && roadmap->getDOF() != _bounds.first.size())
+        RW_THROW("The roadmap in \"" << filename << "\" has dimension " << roadmap->getDOF() << " instead of " << _bounds.first.size() << ".");
+    _roadmap = roadmap;
+}
+
+namespace {
+    typedef rwlibs::pathplanners::prm::PRMRoadmap PRMRoadmap;
+
+    // An edge between the start or goal configuration and a roadmap node
+    struct QueryLink {
+        QueryLink(PRMRoadmap::NodeIndex node, double weight):
+            node(node), weight(weight), validity(PRMRoadmap::Unknown) {}
+        PRMRoadmap::NodeIndex node;
+        double weight;
+        PRMRoadmap::Validity validity;
+    };
+
+    typedef std::pair<double, PRMRoadmap::NodeIndex> QueueEntry;
+}
+
+bool PRMPlanner::doRoadmapQuery(
+    const rw::math::Q& qInit,
+    const rw::math::Q& qGoal,
+    QPath& path,
+    const StopCriteria& stop)
+{
+    PRMRoadmap& roadmap = *_roadmap;
+    const PRMRoadmap::NodeIndex n = (PRMRoadmap::NodeIndex)roadmap.getNodeCount();
+
+    // The start and goal are virtual nodes n and n+1 that are not stored in the roadmap
+    const PRMRoadmap::NodeIndex nInit = n;
+    const PRMRoadmap::NodeIndex nGoal = n + 1;
+    std::vector<QueryLink> links;
+    std::vector<int> goalLinks(n, -1);
+    neighborTimer.resume();
+    const double directDistance = _metric->distance(qInit, qGoal);
+    if (directDistance < roadmap.getRadius())
+        links.push_back(QueryLink(nGoal, directDistance));
+    for (PRMRoadmap::NodeIndex i = 0; i < n; i++) {
+        if (roadmap.getNodeValidity(i) == PRMRoadmap::Blocked)
+            continue;
+        const double dInit = _metric->distance(qInit, roadmap.getQ(i));
+        if (dInit < roadmap.getRadius())
+            links.push_back(QueryLink(i, dInit));
+    }
+    const std::size_t initLinkCount = links.size();
+    for (PRMRoadmap::NodeIndex i = 0; i < n; i++) {
+        if (roadmap.getNodeValidity(i) == PRMRoadmap::Blocked)
+            continue;
+        const double dGoal = _metric->distance(roadmap.getQ(i), qGoal);
+        if (dGoal < roadmap.getRadius()) {
+            goalLinks[i] = (int)links.size();
+            links.push_back(QueryLink(i, dGoal));
+        }
+    }
+    neighborTimer.pause();
+
+    // Edge to each node on the search tree: a roadmap edge (>= 0) or a link (-1 - link)
+    std::vector<double> cost(n + 2);
+    std::vector<double> heuristic(n + 2, -1);
+    std::vector<boost::int64_t> parentEdge(n + 2);
+    std::vector<PRMRoadmap::NodeIndex> parent(n + 2);
+    std::vector<bool> closed(n + 2);
+
+    while (!stop.stop()) {
+        // A* search that skips nodes and edges known to be in collision
+        shortestPathTimer.resume();
+        std::fill(cost.begin(), cost.end(), std::numeric_limits<double>::max());
+        std::fill(closed.begin(), closed.end(), false);
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+        cost[nInit] = 0;
+        queue.push(QueueEntry(0, nInit));
+
+        bool found = false;
+        while (!queue.empty()) {
+            const PRMRoadmap::NodeIndex node = queue.top().second;
+            queue.pop();
+            if (closed[node])
+                continue;
+            closed[node] = true;
+            if (node == nGoal) {
+                found = true;
+                break;
+            }
+
+            // collect the edges to the neighbors as (neighbor, weight, edge)
+            std::vector<std::pair<PRMRoadmap::NodeIndex, std::pair<double, boost::int64_t> > > next;
+            if (node == nInit) {
+                for (std::size_t k = 0; k < initLinkCount; k++) {
+                    if (links[k].validity != PRMRoadmap::Blocked)
+                        next.push_back(std::make_pair(links[k].node, std::make_pair(links[k].weight, -1 - (boost::int64_t)k)));
+                }
+            } else {
+                const PRMRoadmap::NodeIndex* const neighbors = roadmap.getNeighbors(node);
+                const PRMRoadmap::EdgeIndex* const edges = roadmap.getNeighborEdges(node);
+                for (std::size_t k = 0; k < roadmap.getDegree(node); k++) {
+                    if (roadmap.getEdgeValidity(edges[k]) != PRMRoadmap::Blocked)
+                        next.push_back(std::make_pair(neighbors[k], std::make_pair(roadmap.getWeight(edges[k]), (boost::int64_t)edges[k])));
+                }
+                const int link = goalLinks[node];
+                if (link >= 0 && links[link].validity != PRMRoadmap::Blocked)
+                    next.push_back(std::make_pair(nGoal, std::make_pair(links[link].weight, -1 - (boost::int64_t)link)));
+            }
+
+            for (std::size_t k = 0; k < next.size(); k++) {
+                const PRMRoadmap::NodeIndex neighbor = next[k].first;
+                if (closed[neighbor] || (neighbor < n && roadmap.getNodeValidity(neighbor) == PRMRoadmap::Blocked))
+                    continue;
+                const double c = cost[node] + next[k].second.first;
+                if (c >= cost[neighbor])
+                    continue;
+                cost[neighbor] = c;
+                parent[neighbor] = node;
+                parentEdge[neighbor] = next[k].second.second;
+                if (heuristic[neighbor] < 0)
+                    heuristic[neighbor] = neighbor < n ? _metric->distance(roadmap.getQ(neighbor), qGoal) : 0;
+                queue.push(QueueEntry(c + heuristic[neighbor], neighbor));
+            }
+        }
+        shortestPathTimer.pause();
+        if (!found)
+            return false;
+
+        std::vector<PRMRoadmap::NodeIndex> nodes;
+        std::vector<boost::int64_t> edges;
+        for (PRMRoadmap::NodeIndex node = nGoal; node != nInit; node = parent[node]) {
+            nodes.push_back(node);
+            edges.push_back(parentEdge[node]);
+        }
+        nodes.push_back(nInit);
+        std::reverse(nodes.begin(), nodes.end());
+        std::reverse(edges.begin(), edges.end());
+
+        // Validate the unknown nodes and edges on the path, starting from the ends
+        collisionTimer.resume();
+        bool valid = true;
+        for (std::size_t i = 0; i < nodes.size() && valid; i++) {
+            const std::size_t idx = i % 2 == 0 ? i/2 : nodes.size() - 1 - i/2;
+            const PRMRoadmap::NodeIndex node = nodes[idx];
+            if (node >= n || roadmap.getNodeValidity(node) != PRMRoadmap::Unknown)
+                continue;
+            valid = !_constraint->inCollision(roadmap.getQ(node));
+            roadmap.setNodeValidity(node, valid ? PRMRoadmap::Free : PRMRoadmap::Blocked);
+        }
+        for (std::size_t i = 0; i < edges.size() && valid; i++) {
+            const std::size_t idx = i % 2 == 0 ? i/2 : edges.size() - 1 - i/2;
+            const Q q1 = nodes[idx] < n ? roadmap.getQ(nodes[idx]) : qInit;
+            const Q q2 = nodes[idx + 1] < n ? roadmap.getQ(nodes[idx + 1]) : qGoal;
+            if (edges[idx] >= 0) {
+                const PRMRoadmap::EdgeIndex edge = (PRMRoadmap::EdgeIndex)edges[idx];
+                if (roadmap.getEdgeValidity(edge) != PRMRoadmap::Unknown)
+                    continue;
+                valid = !_edge->inCollision(q1, q2);
+                roadmap.setEdgeValidity(edge, valid ? PRMRoadmap::Free : PRMRoadmap::Blocked);
+            } else {
+                QueryLink& link = links[(std::size_t)(-1 - edges[idx])];
+                if (link.validity != PRMRoadmap::Unknown)
+                    continue;
+                valid = !_edge->inCollision(q1, q2);
+                link.validity = valid ? PRMRoadmap::Free : PRMRoadmap::Blocked;
+            }
+        }
+        collisionTimer.pause();
+
+        if (valid) {
+            BOOST_FOREACH(const PRMRoadmap::NodeIndex node, nodes) {
+                if (node == nInit)
+                    path.push_back(qInit);
+                else if (node == nGoal)
+                    path.push_back(qGoal);
+                else
+                    path.push_back(roadmap.getQ(node));
+            }
+            return true;
+        }
+    }
+    return false;
+}
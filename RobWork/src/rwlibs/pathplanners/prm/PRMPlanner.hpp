@@ -35,6 +35,7 @@
 
 
 #include "PartialIndexTable.hpp"
+#include "PRMRoadmap.hpp"
 
 namespace rw { namespace kinematics { class State; } }
 namespace rw { namespace pathplanning { class QConstraint; } }
@@ -239,6 +240,37 @@ namespace rwlibs { namespace pathplanners {
          */
         void printTimeStats();
 
+        /**
+         * @brief Save the roadmap to a file that can be memory-mapped with
+         * loadRoadmap().
+         *
+         * Nodes and edges that have already been checked for collisions are
+         * saved as free, all other nodes and edges are saved as unknown.
+         *
+         * @param filename [in] the file to write.
+         */
+        void saveRoadmap(const std::string& filename) const;
+
+        /**
+         * @brief Memory-map a roadmap saved with saveRoadmap().
+         *
+         * Following queries are answered on the loaded roadmap, until
+         * buildRoadmap() is called. The start and goal configurations are
+         * connected to the nodes within the radius of the roadmap. Nodes and
+         * edges are validated lazily, only along the shortest path candidates
+         * found by A*, and the results are stored in the roadmap such that
+         * they are reused by later queries. The loaded roadmap is never
+         * extended, so a query fails if the roadmap has no free path.
+         *
+         * The roadmap must have been built for the same device, and with the
+         * same obstacles if it is loaded as writable.
+         *
+         * @param filename [in] the file to map.
+         * @param writable [in] if true, the validation results are written
+         * back to the file.
+         */
+        void loadRoadmap(const std::string& filename, bool writable = false);
+
     private:
         bool doQuery(
             const rw::math::Q& qInit,
@@ -246,8 +278,17 @@ namespace rwlibs { namespace pathplanners {
             rw::trajectory::QPath& path,
             const rw::pathplanning::StopCriteria& stop);
 
+        bool doRoadmapQuery(
+            const rw::math::Q& qInit,
+            const rw::math::Q& qGoal,
+            rw::trajectory::QPath& path,
+            const rw::pathplanning::StopCriteria& stop);
+
     private:
         bool _roadmap_initialized;
+
+        //! Memory-mapped roadmap used for queries if loaded
+        prm::PRMRoadmap::Ptr _roadmap;
         rw::common::Ptr<rw::pathplanning::QConstraint> _constraint;
 		rw::common::Ptr<rw::pathplanning::QSampler> _sampler;
         double _resolution;
@@ -0,0 +1,218 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#include "PRMRoadmap.hpp"
+
+#include <rw/common/macros.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <fstream>
+
+using namespace rwlibs::pathplanners::prm;
+using namespace rw::common;
+using namespace rw::math;
+
+namespace {
+    const char MAGIC[8] = { 'R', 'W', 'P', 'R', 'M', 'M', 'A', 'P' };
+    const boost::uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[8];
+        boost::uint32_t version;
+        boost::uint32_t dof;
+        boost::uint64_t nodeCount;
+        boost::uint64_t edgeCount;
+        double radius;
+    };
+
+    // Byte offsets of the sections of the file. The sections are ordered such
+    // that every section is aligned to the size of its elements.
+    struct Layout {
+        Layout(std::size_t dof, std::size_t n, std::size_t e) {
+            qs = sizeof(Header);
+            offsets = qs + n*dof*sizeof(double);
+            targets = offsets + (n + 1)*sizeof(boost::uint64_t);
+            edges = targets + 2*e*sizeof(boost::uint32_t);
+            weights = edges + 2*e*sizeof(boost::uint32_t);
+            nodeValidity = weights + e*sizeof(double);
+            edgeValidity = nodeValidity + n;
+            size = edgeValidity + e;
+        }
+        std::size_t qs, offsets, targets, edges, weights, nodeValidity, edgeValidity, size;
+    };
+
+    template<class T>
+    void writeArray(std::ostream& out, const std::vector<T>& values) {
+        if (!values.empty())
+            out.write(reinterpret_cast<const char*>(&values[0]), values.size()*sizeof(T));
+    }
+}
+
+PRMRoadmap::PRMRoadmap():
+    _dof(0),
+    _nodeCount(0),
+    _edgeCount(0),
+    _radius(0),
+    _qs(NULL),
+    _offsets(NULL),
+    _targets(NULL),
+    _edges(NULL),
+    _weights(NULL),
+    _nodeValidity(NULL),
+    _edgeValidity(NULL)
+{
+}
+
+PRMRoadmap::~PRMRoadmap()
+{
+}
+
+void PRMRoadmap::write(const std::string& filename,
+                       const std::vector<Q>& nodes,
+                       const std::vector<Validity>& nodeValidity,
+                       const std::vector<Edge>& edges,
+                       double radius)
+{
+    const std::size_t n = nodes.size();
+    const std::size_t dof = n > 0 ? nodes[0].size() : 0;
+    if (nodeValidity.size() != n)
+        RW_THROW("PRMRoadmap: " << nodeValidity.size() << " node validities given for " << n << " nodes.");
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.dof = (boost::uint32_t)dof;
+    header.nodeCount = n;
+    header.edgeCount = edges.size();
+    header.radius = radius;
+
+    std::vector<double> qs(n*dof);
+    std::vector<boost::uint8_t> nodeStates(n);
+    for (std::size_t i = 0; i < n; i++) {
+        if (nodes[i].size() != dof)
+            RW_THROW("PRMRoadmap: node " << i << " has dimension " << nodes[i].size() << " instead of " << dof << ".");
+        for (std::size_t j = 0; j < dof; j++)
+            qs[i*dof + j] = nodes[i](j);
+        nodeStates[i] = (boost::uint8_t)nodeValidity[i];
+    }
+
+    // Build the compressed sparse row adjacency with both directions of each edge
+    std::vector<boost::uint64_t> offsets(n + 1, 0);
+    std::vector<double> weights(edges.size());
+    std::vector<boost::uint8_t> edgeStates(edges.size());
+    for (std::size_t e = 0; e < edges.size(); e++) {
+        const Edge& edge = edges[e];
+        if (edge.a >= n || edge.b >= n || edge.a == edge.b)
+            RW_THROW("PRMRoadmap: invalid edge between node " << edge.a << " and node " << edge.b << ".");
+        offsets[edge.a + 1]++;
+        offsets[edge.b + 1]++;
+        weights[e] = edge.weight;
+        edgeStates[e] = (boost::uint8_t)edge.validity;
+    }
+    for (std::size_t i = 0; i < n; i++)
+        offsets[i + 1] += offsets[i];
+
+    std::vector<NodeIndex> targets(2*edges.size());
+    std::vector<EdgeIndex> edgeIds(2*edges.size());
+    std::vector<boost::uint64_t> next(offsets.begin(), offsets.end() - 1);
+    for (std::size_t e = 0; e < edges.size(); e++) {
+        const Edge& edge = edges[e];
+        targets[next[edge.a]] = edge.b;
+        edgeIds[next[edge.a]++] = (EdgeIndex)e;
+        targets[next[edge.b]] = edge.a;
+        edgeIds[next[edge.b]++] = (EdgeIndex)e;
+    }
+
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        RW_THROW("PRMRoadmap: could not open \"" << filename << "\" for writing.");
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    writeArray(out, qs);
+    writeArray(out, offsets);
+    writeArray(out, targets);
+    writeArray(out, edgeIds);
+    writeArray(out, weights);
+    writeArray(out, nodeStates);
+    writeArray(out, edgeStates);
+    out.close();
+    if (out.fail())
+        RW_THROW("PRMRoadmap: failed to write \"" << filename << "\".");
+}
+
+PRMRoadmap::Ptr PRMRoadmap::load(const std::string& filename, bool writable)
+{
+    using namespace boost::interprocess;
+
+    const PRMRoadmap::Ptr roadmap = ownedPtr(new PRMRoadmap());
+    try {
+        const file_mapping file(filename.c_str(), writable ? read_write : read_only);
+        roadmap->_region.reset(new mapped_region(file, writable ? read_write : copy_on_write));
+    } catch (const interprocess_exception& e) {
+        RW_THROW("PRMRoadmap: could not map \"" << filename << "\": " << e.what());
+    }
+
+    char* const data = static_cast<char*>(roadmap->_region->get_address());
+    const std::size_t size = roadmap->_region->get_size();
+    if (size < sizeof(Header))
+        RW_THROW("PRMRoadmap: \"" << filename << "\" is not a roadmap file.");
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        RW_THROW("PRMRoadmap: \"" << filename << "\" is not a roadmap file.");
+    if (header.version != VERSION)
+        RW_THROW("PRMRoadmap: \"" << filename << "\" has unsupported version " << header.version << ".");
+
+    // Every node and edge takes at least one byte, so larger counts are corrupt
+    // and would overflow the layout computation
+    if (header.nodeCount > size || header.edgeCount > size
+        || (header.nodeCount > 0 && header.dof > size/sizeof(double)/header.nodeCount))
+        RW_THROW("PRMRoadmap: \"" << filename << "\" has an invalid header.");
+    const Layout layout(header.dof, (std::size_t)header.nodeCount, (std::size_t)header.edgeCount);
+    if (size != layout.size)
+        RW_THROW("PRMRoadmap: \"" << filename << "\" has size " << size << " but " << layout.size << " was expected.");
+
+    roadmap->_dof = header.dof;
+    roadmap->_nodeCount = (std::size_t)header.nodeCount;
+    roadmap->_edgeCount = (std::size_t)header.edgeCount;
+    roadmap->_radius = header.radius;
+    roadmap->_qs = reinterpret_cast<const double*>(data + layout.qs);
+    roadmap->_offsets = reinterpret_cast<const boost::uint64_t*>(data + layout.offsets);
+    roadmap->_targets = reinterpret_cast<const NodeIndex*>(data + layout.targets);
+    roadmap->_edges = reinterpret_cast<const EdgeIndex*>(data + layout.edges);
+    roadmap->_weights = reinterpret_cast<const double*>(data + layout.weights);
+    roadmap->_nodeValidity = reinterpret_cast<boost::uint8_t*>(data + layout.nodeValidity);
+    roadmap->_edgeValidity = reinterpret_cast<boost::uint8_t*>(data + layout.edgeValidity);
+
+    // The search indexes the sections by the offsets, targets and edge ids
+    // without checks, so they are validated once here
+    if (roadmap->_offsets[0] != 0 || roadmap->_offsets[roadmap->_nodeCount] != 2*header.edgeCount)
+        RW_THROW("PRMRoadmap: \"" << filename << "\" has an inconsistent adjacency.");
+    for (std::size_t i = 0; i < roadmap->_nodeCount; i++) {
+        if (roadmap->_offsets[i] > roadmap->_offsets[i + 1])
+            RW_THROW("PRMRoadmap: \"" << filename << "\" has an inconsistent adjacency at node " << i << ".");
+    }
+    for (std::size_t i = 0; i < 2*roadmap->_edgeCount; i++) {
+        if (roadmap->_targets[i] >= roadmap->_nodeCount || roadmap->_edges[i] >= roadmap->_edgeCount)
+            RW_THROW("PRMRoadmap: \"" << filename << "\" has an invalid adjacency entry " << i << ".");
+    }
+    return roadmap;
+}
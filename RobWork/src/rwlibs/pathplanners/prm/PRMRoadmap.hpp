@@ -0,0 +1,212 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#ifndef RWLIBS_PATHPLANNERS_PRM_PRMROADMAP_HPP
+#define RWLIBS_PATHPLANNERS_PRM_PRMROADMAP_HPP
+
+/**
+   @file PRMRoadmap.hpp
+*/
+
+#include <rw/common/Ptr.hpp>
+#include <rw/math/Q.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+namespace rwlibs { namespace pathplanners { namespace prm {
+
+    /** @addtogroup pathplanners */
+    /*@{*/
+
+    /**
+     * @brief A roadmap stored in a compact binary file that is memory-mapped
+     * when loaded.
+     *
+     * The file holds the configurations of the nodes in a packed array, the
+     * adjacency of the nodes in compressed sparse row (CSR) format, the weight
+     * of each edge, and the validity of each node and edge. Loading a roadmap
+     * only maps the file, so the startup time does not depend on the size of
+     * the roadmap.
+     *
+     * The validity of nodes and edges can be updated when they are checked
+     * for collisions. If the roadmap is loaded as writable, the updates are
+     * written back to the file, such that later processes can reuse them.
+     * Otherwise the updates are private to the process.
+     *
+     * The file is written in the byte order of the machine, and can only be
+     * loaded on machines with the same byte order.
+     *
+     * This class is implemented as a helper for the PRMPlanner.
+     */
+    class PRMRoadmap
+    {
+    public:
+        //! @brief smart pointer type to this class
+        typedef rw::common::Ptr<PRMRoadmap> Ptr;
+
+        //! @brief Index of a node.
+        typedef boost::uint32_t NodeIndex;
+
+        //! @brief Index of an (undirected) edge.
+        typedef boost::uint32_t EdgeIndex;
+
+        //! @brief The result of collision checking a node or an edge.
+        enum Validity {
+            Unknown = 0, //!< Not checked.
+            Free = 1, //!< Checked and free of collisions.
+            Blocked = 2 //!< Checked and in collision.
+        };
+
+        //! @brief An edge used when writing a roadmap.
+        struct Edge {
+            //! @brief Constructor.
+            Edge(NodeIndex a, NodeIndex b, double weight, Validity validity = Unknown):
+                a(a), b(b), weight(weight), validity(validity) {}
+            //! @brief The first node.
+            NodeIndex a;
+            //! @brief The second node.
+            NodeIndex b;
+            //! @brief The weight (length) of the edge.
+            double weight;
+            //! @brief The validity of the edge.
+            Validity validity;
+        };
+
+        /**
+         * @brief Write a roadmap to a file.
+         * @param filename [in] the file to write.
+         * @param nodes [in] the configurations of the nodes.
+         * @param nodeValidity [in] the validity of each node.
+         * @param edges [in] the edges.
+         * @param radius [in] the distance within which nodes are connected.
+         */
+        static void write(const std::string& filename,
+                          const std::vector<rw::math::Q>& nodes,
+                          const std::vector<Validity>& nodeValidity,
+                          const std::vector<Edge>& edges,
+                          double radius);
+
+        /**
+         * @brief Map a roadmap file.
+         * @param filename [in] the file.
+         * @param writable [in] if true, changes of the validity of nodes and
+         * edges are written to the file.
+         * @return the roadmap.
+         * @throws Exception if the file is not a roadmap file, or if its
+         * adjacency refers to nodes or edges that are not in the file.
+         */
+        static PRMRoadmap::Ptr load(const std::string& filename, bool writable = false);
+
+        //! @brief Destructor.
+        virtual ~PRMRoadmap();
+
+        //! @brief The number of degrees of freedom of the configurations.
+        std::size_t getDOF() const { return _dof; }
+
+        //! @brief The number of nodes.
+        std::size_t getNodeCount() const { return _nodeCount; }
+
+        //! @brief The number of (undirected) edges.
+        std::size_t getEdgeCount() const { return _edgeCount; }
+
+        //! @brief The distance within which nodes are connected.
+        double getRadius() const { return _radius; }
+
+        /**
+         * @brief The configuration of a node.
+         * @param node [in] the node.
+         * @return a pointer to the getDOF() values of the configuration.
+         */
+        const double* getQData(NodeIndex node) const { return _qs + (std::size_t)node*_dof; }
+
+        /**
+         * @brief The configuration of a node.
+         * @param node [in] the node.
+         * @return the configuration.
+         */
+        rw::math::Q getQ(NodeIndex node) const { return rw::math::Q(_dof, getQData(node)); }
+
+        /**
+         * @brief The number of neighbors of a node.
+         * @param node [in] the node.
+         * @return the number of neighbors.
+         */
+        std::size_t getDegree(NodeIndex node) const { return (std::size_t)(_offsets[node + 1] - _offsets[node]); }
+
+        /**
+         * @brief The neighbors of a node.
+         * @param node [in] the node.
+         * @return pointer to getDegree() neighbor nodes.
+         */
+        const NodeIndex* getNeighbors(NodeIndex node) const { return _targets + _offsets[node]; }
+
+        /**
+         * @brief The edges to the neighbors of a node.
+         * @param node [in] the node.
+         * @return pointer to getDegree() edges in the order of getNeighbors().
+         */
+        const EdgeIndex* getNeighborEdges(NodeIndex node) const { return _edges + _offsets[node]; }
+
+        //! @brief The weight of an edge.
+        double getWeight(EdgeIndex edge) const { return _weights[edge]; }
+
+        //! @brief The validity of a node.
+        Validity getNodeValidity(NodeIndex node) const { return (Validity)_nodeValidity[node]; }
+
+        //! @brief Set the validity of a node.
+        void setNodeValidity(NodeIndex node, Validity validity) { _nodeValidity[node] = (boost::uint8_t)validity; }
+
+        //! @brief The validity of an edge.
+        Validity getEdgeValidity(EdgeIndex edge) const { return (Validity)_edgeValidity[edge]; }
+
+        //! @brief Set the validity of an edge.
+        void setEdgeValidity(EdgeIndex edge, Validity validity) { _edgeValidity[edge] = (boost::uint8_t)validity; }
+
+    private:
+        PRMRoadmap();
+
+        boost::shared_ptr<boost::interprocess::mapped_region> _region;
+
+        std::size_t _dof;
+        std::size_t _nodeCount;
+        std::size_t _edgeCount;
+        double _radius;
+
+        const double* _qs;
+        const boost::uint64_t* _offsets;
+        const NodeIndex* _targets;
+        const EdgeIndex* _edges;
+        const double* _weights;
+        boost::uint8_t* _nodeValidity;
+        boost::uint8_t* _edgeValidity;
+
+        PRMRoadmap(const PRMRoadmap&);
+        PRMRoadmap& operator=(const PRMRoadmap&);
+    };
+
+    /* @} */
+}}} // end namespaces
+
+#endif // end include guard
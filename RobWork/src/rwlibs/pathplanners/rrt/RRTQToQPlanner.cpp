@@ -20,15 +20,29 @@
 #include "RRTTree.hpp"
 
 #include <rw/pathplanning/PlannerConstraint.hpp>
+#include <rw/pathplanning/QConstraint.hpp>
+#include <rw/pathplanning/QEdgeConstraintIncremental.hpp>
+#include <rw/pathplanning/QNearestNeighbor.hpp>
 #include <rw/pathplanning/QSampler.hpp>
+#include <rw/common/FunctionTask.hpp>
+#include <rw/common/ThreadPool.hpp>
+#include <rw/math/Random.hpp>
 
-#include <cfloat>
 #include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <utility>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/thread/mutex.hpp>
 
 using namespace rw;
 using namespace rw::math;
 using namespace rw::common;
+using namespace rw::models;
 using namespace rw::pathplanning;
 using namespace rw::trajectory;
 using namespace rwlibs::pathplanners;
@@ -36,11 +50,40 @@ using namespace rwlibs::pathplanners;
 namespace
 {
     typedef RRTNode<rw::math::Q> Node;
-    typedef RRTTree<rw::math::Q> Tree;
     typedef rw::trajectory::QPath Path;
 
     const Q& getQ(Node* node) { return node->getValue(); }
 
+    // Tree with an index of the configurations of the nodes for nearest
+    // neighbor search.
+    class Tree: public RRTTree<rw::math::Q>
+    {
+    public:
+        Tree(const Q& value, QNearestNeighbor::Ptr index) :
+            RRTTree<rw::math::Q>(value),
+            _index(index)
+        {
+            RW_ASSERT(index);
+            _index->add(value);
+        }
+
+        void add(const Q& value, Node* parent)
+        {
+            RRTTree<rw::math::Q>::add(value, parent);
+            _index->add(value);
+        }
+
+        Node* nearest(const Q& q) const
+        {
+            const int idx = _index->nearest(q);
+            RW_ASSERT(idx >= 0);
+            return &getNode(idx);
+        }
+
+    private:
+        QNearestNeighbor::Ptr _index;
+    };
+
     enum ExtendResult { Trapped, Reached, Advanced };
 
     class RRTStruct
@@ -49,12 +92,14 @@ namespace
         RRTStruct(const PlannerConstraint& constraint,
 			QSampler::Ptr sampler,
 			QMetric::Ptr metric,
-            double extend)
+            double extend,
+            QNearestNeighbor::Type nearestNeighbor)
             :
             constraint(constraint),
             sampler(sampler),
             metric(metric),
-            extend(extend)
+            extend(extend),
+            nearestNeighbor(nearestNeighbor)
         {
             RW_ASSERT(sampler);
             RW_ASSERT(metric);
@@ -64,8 +109,14 @@ namespace
 		QSampler::Ptr sampler;
 		QMetric::Ptr metric;
         double extend;
+        QNearestNeighbor::Type nearestNeighbor;
     };
 
+    QNearestNeighbor::Ptr makeIndex(const RRTStruct& rrt)
+    {
+        return QNearestNeighbor::make(rrt.metric, rrt.nearestNeighbor);
+    }
+
     bool inCollision(const RRTStruct& rrt, const Q& q)
     {
         return rrt.constraint.getQConstraint().inCollision(q);
@@ -81,28 +132,6 @@ namespace
             rrt.constraint.getQEdgeConstraint().inCollision(getQ(a), b);
     }
 
-    // Brute-force nearest neighbor search.
-    Node* nearestNeighbor(
-        const RRTStruct& rrt,
-        const Tree& tree,
-        const Q& q)
-    {
-        const QMetric& metric = *rrt.metric;
-        double minLength = DBL_MAX;
-        Node* minNode = NULL;
-
-        BOOST_FOREACH(Node* node, tree.getNodes()) {
-            const double length = metric.distance(q, getQ(node));
-            if (length < minLength) {
-                minLength = length;
-                minNode = node;
-            }
-        }
-
-        RW_ASSERT(minNode);
-        return minNode;
-    }
-
     ExtendResult extend(const RRTStruct& rrt,
                         Tree& tree,
                         const Q& q,
@@ -135,7 +164,7 @@ namespace
         Tree& tree,
         const Q& q)
     {
-        Node* qNearNode = nearestNeighbor(rrt, tree, q);
+        Node* qNearNode = tree.nearest(q);
 
         ExtendResult s = Advanced;
 		bool hasAdvanced = false;
@@ -158,7 +187,7 @@ namespace
         Tree& tree,
         const Q& q)
     {
-        Node* qNearNode = nearestNeighbor(rrt, tree, q);
+        Node* qNearNode = tree.nearest(q);
         return extend(rrt, tree, q, qNearNode);
     }
 
@@ -200,8 +229,8 @@ namespace
 				return true;
 			}
 
-            Tree startTree(start);
-            Tree goalTree(goal);
+            Tree startTree(start, makeIndex(_rrt));
+            Tree goalTree(goal, makeIndex(_rrt));
 
             while (!stop.stop()) {
                 const Q qAttr = _rrt.sampler->sample();
@@ -257,8 +286,8 @@ namespace
 
 
 
-            Tree startTree(start);
-            Tree goalTree(goal);
+            Tree startTree(start, makeIndex(_rrt));
+            Tree goalTree(goal, makeIndex(_rrt));
             Tree* treeA = &startTree;
             Tree* treeB = &goalTree;
 
@@ -318,8 +347,8 @@ namespace
 			}
 
 
-            Tree startTree(start);
-            Tree goalTree(goal);
+            Tree startTree(start, makeIndex(_rrt));
+            Tree goalTree(goal, makeIndex(_rrt));
             Tree* treeA = &startTree;
             Tree* treeB = &goalTree;
 
@@ -347,38 +376,622 @@ namespace
         RRTStruct _rrt;
         bool _balanceTrees;
     };
+
+    // Extension of a tree towards a configuration, computed without
+    // modifying the tree.
+    struct Extension
+    {
+        Extension() : parent(NULL), result(Trapped) {}
+
+        Node* parent;
+        Q q;
+        ExtendResult result;
+    };
+
+    // 'qNear' is known to be collision free.
+    Extension extendTowards(
+        const RRTStruct& rrt,
+        const PlannerConstraint& constraint,
+        const Q& qNear,
+        const Q& q)
+    {
+        Extension ext;
+        const Q delta = q - qNear;
+        const double dist = rrt.metric->distance(delta);
+        if (dist <= rrt.extend) {
+            ext.q = q;
+            ext.result = Reached;
+        } else {
+            ext.q = qNear + (rrt.extend / dist) * delta;
+            ext.result = Advanced;
+        }
+
+        if (constraint.getQConstraint().inCollision(ext.q) ||
+            constraint.getQEdgeConstraint().inCollision(qNear, ext.q))
+        {
+            ext.result = Trapped;
+        }
+        return ext;
+    }
+
+    // The state of a query of the parallel planner shared by the workers.
+    class ParallelQuery
+    {
+    public:
+        ParallelQuery(
+            const RRTStruct& rrt,
+            const Q& start,
+            const Q& goal,
+            const StopCriteria& stop,
+            std::size_t workers)
+            :
+            _stop(stop),
+            _startTree(start, makeIndex(rrt)),
+            _goalTree(goal, makeIndex(rrt)),
+            _found(false),
+            _startNode(NULL),
+            _goalNode(NULL),
+            _generators(workers)
+        {
+            // The seeds are drawn from rw::math::Random, such that the
+            // samples are reproducible with a fixed seed.
+            BOOST_FOREACH(boost::mt19937& generator, _generators) {
+                generator.seed((boost::mt19937::result_type)Random::ranI(0, INT_MAX));
+            }
+            _trees[0] = &_startTree;
+            _trees[1] = &_goalTree;
+        }
+
+        Q sample(std::size_t worker, const Device::QBox& bounds)
+        {
+            boost::mt19937& generator = _generators[worker];
+            Q q(bounds.first.size());
+            for (std::size_t i = 0; i < q.size(); i++)
+                q[i] = bounds.first[i] + (bounds.second[i] - bounds.first[i]) * _distributor(generator);
+            return q;
+        }
+
+        Node* nearest(int tree, const Q& q) const
+        {
+            boost::mutex::scoped_lock lock(_treeMutex[tree]);
+            return _trees[tree]->nearest(q);
+        }
+
+        Node* add(int tree, const Q& q, Node* parent)
+        {
+            boost::mutex::scoped_lock lock(_treeMutex[tree]);
+            _trees[tree]->add(q, parent);
+            return &_trees[tree]->getLast();
+        }
+
+        // The node of tree 'tree' and the node of the other tree have the
+        // same configuration.
+        void setFound(int tree, Node* node, Node* otherNode)
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            if (!_found) {
+                _found = true;
+                _startNode = tree == 0 ? node : otherNode;
+                _goalNode = tree == 0 ? otherNode : node;
+            }
+        }
+
+        bool isFound() const
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            return _found;
+        }
+
+        bool isDone() const
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            return _found || _stop.stop();
+        }
+
+        void getPath(Path& result) const
+        {
+            RW_ASSERT(_found);
+            Path revPart;
+            Tree::getRootPath(*_startNode, revPart);
+            result.insert(result.end(), revPart.rbegin(), revPart.rend());
+            Path goalPart;
+            Tree::getRootPath(*_goalNode, goalPart);
+            result.insert(result.end(), goalPart.begin() + 1, goalPart.end());
+        }
+
+    private:
+        const StopCriteria& _stop;
+        Tree _startTree;
+        Tree _goalTree;
+        Tree* _trees[2];
+        mutable boost::mutex _treeMutex[2];
+
+        // protects _found, _startNode, _goalNode and the stop criteria
+        mutable boost::mutex _mutex;
+        bool _found;
+        Node* _startNode;
+        Node* _goalNode;
+
+        std::vector<boost::mt19937> _generators;
+        boost::uniform_real<> _distributor;
+    };
+
+    class ParallelRRTConnect : public QToQPlanner
+    {
+    public:
+        ParallelRRTConnect(
+            const RRTStruct& rrt,
+            const std::vector<PlannerConstraint>& constraints,
+            const std::vector<QSampler::Ptr>& samplers,
+            const Device::QBox& bounds,
+            ThreadPool::Ptr pool,
+            bool deterministic)
+            :
+            _rrt(rrt),
+            _constraints(constraints),
+            _samplers(samplers),
+            _bounds(bounds),
+            _pool(pool),
+            _deterministic(deterministic)
+        {
+            if (constraints.empty())
+                RW_THROW("The parallel RRT planner needs a constraint for each worker.");
+            if (!samplers.empty() && samplers.size() != constraints.size())
+                RW_THROW("The parallel RRT planner needs a sampler for each worker.");
+            if (bounds.first.size() != bounds.second.size())
+                RW_THROW("The bounds of the configuration space must have the same size.");
+        }
+
+    private:
+        bool doQuery(
+            const Q& start,
+            const Q& goal,
+            Path& result,
+            const StopCriteria& stop)
+        {
+			if (inCollision(_rrt, start)) {
+				std::cout<<"Start is in collision"<<std::endl;
+                return false;
+			}
+
+			if (inCollision(_rrt, goal)) {
+				std::cout<<"Goal is in collision"<<std::endl;
+                return false;
+			}
+
+			if (!_rrt.constraint.getQEdgeConstraint().inCollision(start, goal)) {
+				result.push_back(start);
+				result.push_back(goal);
+				return true;
+			}
+
+            ParallelQuery query(_rrt, start, goal, stop, _constraints.size());
+            if (_deterministic || _pool == NULL || _pool->getNumberOfThreads() == 0)
+                runRounds(query);
+            else
+                runPhase(boost::bind(&ParallelRRTConnect::runWorker, this, boost::ref(query), _1));
+
+            if (!query.isFound())
+                return false;
+            query.getPath(result);
+            return true;
+        }
+
+        // Run work(w) for all workers w and wait for them to finish.
+        void runPhase(const boost::function<void(std::size_t)>& work) const
+        {
+            const std::size_t workers = _constraints.size();
+            if (_pool == NULL || _pool->getNumberOfThreads() == 0) {
+                for (std::size_t w = 0; w < workers; w++)
+                    work(w);
+                return;
+            }
+
+            std::vector<boost::function<void()> > tasks;
+            for (std::size_t w = 0; w < workers; w++)
+                tasks.push_back(boost::bind(work, w));
+            FunctionTask::runAll(_pool, tasks);
+        }
+
+        // The attractor of a worker, from its sampler or else uniformly from
+        // the bounds with the generator of the worker.
+        Q sample(ParallelQuery& query, std::size_t worker) const
+        {
+            if (_samplers.empty())
+                return query.sample(worker, _bounds);
+            const Q q = _samplers[worker]->sample();
+            if (q.empty()) RW_THROW("Sampler must always succeed.");
+            return q;
+        }
+
+        // A worker grows the trees independently of the other workers until
+        // a path is found or the query is stopped.
+        void runWorker(ParallelQuery& query, std::size_t worker) const
+        {
+            const PlannerConstraint& constraint = _constraints[worker];
+            for (std::size_t i = worker; !query.isDone(); i++) {
+                const Q qAttr = sample(query, worker);
+
+                const int a = (int)(i % 2);
+                Node* const near = query.nearest(a, qAttr);
+                const Extension ext = extendTowards(_rrt, constraint, getQ(near), qAttr);
+                if (ext.result == Trapped)
+                    continue;
+                Node* const node = query.add(a, ext.q, near);
+
+                // Connect the other tree to the new node
+                Node* other = query.nearest(1 - a, ext.q);
+                while (!query.isDone()) {
+                    const Extension step = extendTowards(_rrt, constraint, getQ(other), ext.q);
+                    if (step.result == Trapped)
+                        break;
+                    other = query.add(1 - a, step.q, other);
+                    if (step.result == Reached) {
+                        query.setFound(a, node, other);
+                        return;
+                    }
+                }
+            }
+        }
+
+        struct Round
+        {
+            Round(std::size_t workers) :
+                attractors(workers),
+                extensions(workers),
+                nodes(workers),
+                connectParents(workers),
+                chains(workers),
+                reached(workers)
+            {}
+
+            std::size_t round;
+            std::vector<Q> attractors;
+            std::vector<Extension> extensions;
+            std::vector<Node*> nodes;
+            std::vector<Node*> connectParents;
+            std::vector<std::vector<Q> > chains;
+            std::vector<char> reached;
+        };
+
+        // The workers compute extensions of the trees as they are at the
+        // start of a phase, and the extensions are added to the trees by
+        // the calling thread in the order of the workers. The attractors are
+        // sampled by the calling thread too, so the result does not depend on
+        // the scheduling of the threads even for samplers that share a
+        // random generator.
+        void runRounds(ParallelQuery& query) const
+        {
+            const std::size_t workers = _constraints.size();
+            Round round(workers);
+            for (round.round = 0; !query.isDone(); round.round++) {
+                for (std::size_t w = 0; w < workers; w++)
+                    round.attractors[w] = sample(query, w);
+                runPhase(boost::bind(&ParallelRRTConnect::extendPhase, this, boost::ref(query), boost::ref(round), _1));
+                for (std::size_t w = 0; w < workers; w++) {
+                    const Extension& ext = round.extensions[w];
+                    round.nodes[w] = NULL;
+                    if (ext.result != Trapped)
+                        round.nodes[w] = query.add(getTree(round, w), ext.q, ext.parent);
+                }
+
+                runPhase(boost::bind(&ParallelRRTConnect::connectPhase, this, boost::ref(query), boost::ref(round), _1));
+                for (std::size_t w = 0; w < workers; w++) {
+                    if (round.nodes[w] == NULL)
+                        continue;
+                    const int other = 1 - getTree(round, w);
+                    Node* parent = round.connectParents[w];
+                    BOOST_FOREACH(const Q& q, round.chains[w]) {
+                        parent = query.add(other, q, parent);
+                    }
+                    if (round.reached[w]) {
+                        query.setFound(1 - other, round.nodes[w], parent);
+                        return;
+                    }
+                }
+            }
+        }
+
+        static int getTree(const Round& round, std::size_t worker)
+        {
+            return (int)((round.round + worker) % 2);
+        }
+
+        void extendPhase(ParallelQuery& query, Round& round, std::size_t worker) const
+        {
+            const Q& qAttr = round.attractors[worker];
+            Node* const near = query.nearest(getTree(round, worker), qAttr);
+            round.extensions[worker] = extendTowards(_rrt, _constraints[worker], getQ(near), qAttr);
+            round.extensions[worker].parent = near;
+        }
+
+        void connectPhase(ParallelQuery& query, Round& round, std::size_t worker) const
+        {
+            std::vector<Q>& chain = round.chains[worker];
+            chain.clear();
+            round.reached[worker] = false;
+            if (round.nodes[worker] == NULL)
+                return;
+
+            const Q& target = getQ(round.nodes[worker]);
+            Node* const near = query.nearest(1 - getTree(round, worker), target);
+            round.connectParents[worker] = near;
+            Q qNear = getQ(near);
+            for (;;) {
+                const Extension step = extendTowards(_rrt, _constraints[worker], qNear, target);
+                if (step.result == Trapped)
+                    return;
+                chain.push_back(step.q);
+                if (step.result == Reached) {
+                    round.reached[worker] = true;
+                    return;
+                }
+                qNear = step.q;
+            }
+        }
+
+        RRTStruct _rrt;
+        std::vector<PlannerConstraint> _constraints;
+        std::vector<QSampler::Ptr> _samplers;
+        Device::QBox _bounds;
+        ThreadPool::Ptr _pool;
+        bool _deterministic;
+    };
+
+    // Node of the RRT* tree. The parent of a node changes when the tree is
+    // rewired, which RRTTree does not support, so the tree is stored as an
+    // array of nodes in the order that they were added.
+    struct StarNode
+    {
+        StarNode(const Q& q, int parent, double cost) :
+            q(q), parent(parent), cost(cost)
+        {}
+
+        Q q;
+        int parent;
+        // length of the path from the start
+        double cost;
+        std::vector<int> children;
+    };
+
+    class RRTStar : public QToQPlanner
+    {
+    public:
+        RRTStar(
+            QConstraint::Ptr constraint,
+            QEdgeConstraintIncremental::Ptr edge,
+            QSampler::Ptr sampler,
+            QMetric::Ptr metric,
+            double extend,
+            double rewire,
+            QNearestNeighbor::Type nearestNeighbor)
+            :
+            _constraint(constraint),
+            _edge(edge),
+            _sampler(sampler),
+            _metric(metric),
+            _extend(extend),
+            _rewire(rewire),
+            _nearestNeighbor(nearestNeighbor)
+        {
+            RW_ASSERT(constraint);
+            RW_ASSERT(edge);
+            RW_ASSERT(sampler);
+            RW_ASSERT(metric);
+            if (extend <= 0)
+                RW_THROW("The extend distance of the RRT* planner must be positive.");
+            getProperties().add(RRTQToQPlanner::PROP_COST,
+                                "Cost of the best path found by the current or the last query",
+                                -1.0);
+        }
+
+    private:
+        // The edges from the new node to its neighbors are checked at most
+        // once.
+        enum EdgeStatus { Unknown, Free, Blocked };
+
+        bool doQuery(
+            const Q& start,
+            const Q& goal,
+            Path& result,
+            const StopCriteria& stop)
+        {
+            getProperties().set<double>(RRTQToQPlanner::PROP_COST, -1.0);
+
+			if (_constraint->inCollision(start)) {
+				std::cout<<"Start is in collision"<<std::endl;
+                return false;
+			}
+
+			if (_constraint->inCollision(goal)) {
+				std::cout<<"Goal is in collision"<<std::endl;
+                return false;
+			}
+
+            const QEdgeConstraintIncremental::Ptr edge = _edge->instance(start, goal);
+			if (!edge->inCollision()) {
+				result.push_back(start);
+				result.push_back(goal);
+                getProperties().set<double>(RRTQToQPlanner::PROP_COST, _metric->distance(start, goal));
+				return true;
+			}
+
+            std::vector<StarNode> nodes;
+            nodes.push_back(StarNode(start, -1, 0));
+            const QNearestNeighbor::Ptr index = QNearestNeighbor::make(_metric, _nearestNeighbor);
+            index->add(start);
+
+            const double dim = (double)start.size();
+            int goalNode = -1;
+            double bestCost = DBL_MAX;
+
+            std::vector<int> near;
+            std::vector<std::pair<double, int> > candidates;
+            std::vector<EdgeStatus> status;
+
+            while (!stop.stop()) {
+                const Q qRand = _sampler->sample();
+                if (qRand.empty()) RW_THROW("Sampler must always succeed.");
+
+                // Samples that can not be on a path cheaper than the best
+                // path are rejected.
+                if (_metric->distance(start, qRand) + _metric->distance(qRand, goal) >= bestCost)
+                    continue;
+
+                double dist;
+                const int nearest = index->nearest(qRand, &dist);
+                if (dist <= 0)
+                    continue;
+                const Q qNew = dist <= _extend ?
+                    qRand :
+                    Q(nodes[nearest].q + (_extend / dist) * (qRand - nodes[nearest].q));
+                if (_constraint->inCollision(qNew))
+                    continue;
+
+                const double n = (double)nodes.size() + 1;
+                const double radius = std::min(_extend, _rewire * std::pow(std::log(n) / n, 1 / dim));
+                index->nearestWithin(qNew, radius, near);
+                if (std::find(near.begin(), near.end(), nearest) == near.end())
+                    near.push_back(nearest);
+
+                // The candidate parents sorted by the cost of the path
+                // through them.
+                candidates.clear();
+                BOOST_FOREACH(const int i, near) {
+                    candidates.push_back(std::make_pair(nodes[i].cost + _metric->distance(nodes[i].q, qNew), i));
+                }
+                std::sort(candidates.begin(), candidates.end());
+                status.assign(candidates.size(), Unknown);
+
+                // Only the edges up to the first free edge are checked.
+                const double heuristic = _metric->distance(qNew, goal);
+                int parent = -1;
+                double cost = 0;
+                for (std::size_t c = 0; c < candidates.size(); c++) {
+                    if (candidates[c].first + heuristic >= bestCost)
+                        break;
+                    edge->reset(nodes[candidates[c].second].q, qNew);
+                    status[c] = edge->inCollision() ? Blocked : Free;
+                    if (status[c] == Free) {
+                        parent = candidates[c].second;
+                        cost = candidates[c].first;
+                        break;
+                    }
+                }
+                if (parent < 0)
+                    continue;
+
+                const int id = (int)nodes.size();
+                nodes.push_back(StarNode(qNew, parent, cost));
+                nodes[parent].children.push_back(id);
+                index->add(qNew);
+
+                // Rewire the neighbors whose path becomes cheaper through the
+                // new node. Only those edges are checked.
+                for (std::size_t c = 0; c < candidates.size(); c++) {
+                    const int i = candidates[c].second;
+                    const double newCost = cost + _metric->distance(qNew, nodes[i].q);
+                    if (i == parent || status[c] == Blocked || newCost >= nodes[i].cost)
+                        continue;
+                    if (status[c] == Unknown) {
+                        edge->reset(qNew, nodes[i].q);
+                        if (edge->inCollision())
+                            continue;
+                    }
+                    setParent(nodes, i, id, newCost);
+                }
+
+                if (goalNode < 0 && heuristic <= _extend) {
+                    edge->reset(qNew, goal);
+                    if (!edge->inCollision()) {
+                        goalNode = (int)nodes.size();
+                        nodes.push_back(StarNode(goal, id, cost + heuristic));
+                        nodes[id].children.push_back(goalNode);
+                        index->add(goal);
+                    }
+                }
+
+                if (goalNode >= 0 && nodes[goalNode].cost < bestCost) {
+                    bestCost = nodes[goalNode].cost;
+                    getProperties().set<double>(RRTQToQPlanner::PROP_COST, bestCost);
+                }
+            }
+
+            if (goalNode < 0)
+                return false;
+
+            Path revPath;
+            for (int i = goalNode; i >= 0; i = nodes[i].parent)
+                revPath.push_back(nodes[i].q);
+            result.insert(result.end(), revPath.rbegin(), revPath.rend());
+            return true;
+        }
+
+        // Make 'parent' the parent of 'node' and update the cost of the
+        // subtree of 'node'.
+        static void setParent(std::vector<StarNode>& nodes, int node, int parent, double cost)
+        {
+            std::vector<int>& siblings = nodes[nodes[node].parent].children;
+            siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+            nodes[node].parent = parent;
+            nodes[parent].children.push_back(node);
+
+            const double delta = cost - nodes[node].cost;
+            std::vector<int> stack(1, node);
+            while (!stack.empty()) {
+                const int i = stack.back();
+                stack.pop_back();
+                nodes[i].cost += delta;
+                stack.insert(stack.end(), nodes[i].children.begin(), nodes[i].children.end());
+            }
+        }
+
+        QConstraint::Ptr _constraint;
+        QEdgeConstraintIncremental::Ptr _edge;
+        QSampler::Ptr _sampler;
+        QMetric::Ptr _metric;
+        double _extend;
+        double _rewire;
+        QNearestNeighbor::Type _nearestNeighbor;
+    };
+
 }
 
+const std::string RRTQToQPlanner::PROP_COST = "Cost";
+
 QToQPlanner::Ptr RRTQToQPlanner::makeBasic(const PlannerConstraint& constraint,
 										 QSampler::Ptr sampler,
 										 QMetric::Ptr metric,
-                                         double extend)
+                                         double extend,
+    QNearestNeighbor::Type nearestNeighbor)
 {
     return ownedPtr(
         new RRTBasic(
-            RRTStruct(constraint, sampler, metric, extend)));
+            RRTStruct(constraint, sampler, metric, extend, nearestNeighbor)));
 }
 
 QToQPlanner::Ptr RRTQToQPlanner::makeConnect(
     const PlannerConstraint& constraint,
 	QSampler::Ptr sampler,
 	QMetric::Ptr metric,
-    double extend)
+    double extend,
+    QNearestNeighbor::Type nearestNeighbor)
 {
     return ownedPtr(
         new RRTConnect(
-            RRTStruct(constraint, sampler, metric, extend)));
+            RRTStruct(constraint, sampler, metric, extend, nearestNeighbor)));
 }
 
 QToQPlanner::Ptr RRTQToQPlanner::makeBidirectional(
     const PlannerConstraint& constraint,
 	QSampler::Ptr sampler,
 	QMetric::Ptr metric,
-    double extend)
+    double extend,
+    QNearestNeighbor::Type nearestNeighbor)
 {
     return ownedPtr(
         new RDTBalancedBidirectional(
-            RRTStruct(constraint, sampler, metric, extend),
+            RRTStruct(constraint, sampler, metric, extend, nearestNeighbor),
             true));
 }
 
@@ -386,10 +999,68 @@ QToQPlanner::Ptr RRTQToQPlanner::makeBalancedBidirectional(
     const PlannerConstraint& constraint,
 	QSampler::Ptr sampler,
 	QMetric::Ptr metric,
-    double extend)
+    double extend,
+    QNearestNeighbor::Type nearestNeighbor)
 {
     return ownedPtr(
         new RDTBalancedBidirectional(
-            RRTStruct(constraint, sampler, metric, extend),
+            RRTStruct(constraint, sampler, metric, extend, nearestNeighbor),
             false));
 }
+
+QToQPlanner::Ptr RRTQToQPlanner::makeParallelConnect(
+    const std::vector<PlannerConstraint>& constraints,
+    const Device::QBox& bounds,
+	QMetric::Ptr metric,
+    double extend,
+    ThreadPool::Ptr pool,
+    bool deterministic,
+    QNearestNeighbor::Type nearestNeighbor)
+{
+    if (constraints.empty())
+        RW_THROW("The parallel RRT planner needs a constraint for each worker.");
+    return ownedPtr(
+        new ParallelRRTConnect(
+            RRTStruct(constraints.front(), QSampler::makeUniform(bounds), metric, extend, nearestNeighbor),
+            constraints,
+            std::vector<QSampler::Ptr>(),
+            bounds,
+            pool,
+            deterministic));
+}
+
+QToQPlanner::Ptr RRTQToQPlanner::makeParallelConnect(
+    const std::vector<PlannerConstraint>& constraints,
+    const std::vector<QSampler::Ptr>& samplers,
+	QMetric::Ptr metric,
+    double extend,
+    ThreadPool::Ptr pool,
+    bool deterministic,
+    QNearestNeighbor::Type nearestNeighbor)
+{
+    if (constraints.empty())
+        RW_THROW("The parallel RRT planner needs a constraint for each worker.");
+    if (samplers.size() != constraints.size())
+        RW_THROW("The parallel RRT planner needs a sampler for each worker.");
+    return ownedPtr(
+        new ParallelRRTConnect(
+            RRTStruct(constraints.front(), samplers.front(), metric, extend, nearestNeighbor),
+            constraints,
+            samplers,
+            Device::QBox(),
+            pool,
+            deterministic));
+}
+
+QToQPlanner::Ptr RRTQToQPlanner::makeStar(
+    QConstraint::Ptr constraint,
+    QEdgeConstraintIncremental::Ptr edge,
+	QSampler::Ptr sampler,
+	QMetric::Ptr metric,
+    double extend,
+    double rewire,
+    QNearestNeighbor::Type nearestNeighbor)
+{
+    return ownedPtr(
+        new RRTStar(constraint, edge, sampler, metric, extend, rewire, nearestNeighbor));
+}
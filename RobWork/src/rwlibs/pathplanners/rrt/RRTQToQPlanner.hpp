@@ -23,10 +23,18 @@
    @file RRTQToQPlanner.hpp
 */
 
+#include <rw/pathplanning/QNearestNeighbor.hpp>
 #include <rw/pathplanning/QToQPlanner.hpp>
 #include <rw/math/Metric.hpp>
+#include <rw/models/Device.hpp>
 
+#include <string>
+#include <vector>
+
+namespace rw { namespace common { class ThreadPool; } }
 namespace rw { namespace pathplanning { class PlannerConstraint; } }
+namespace rw { namespace pathplanning { class QConstraint; } }
+namespace rw { namespace pathplanning { class QEdgeConstraintIncremental; } }
 namespace rw { namespace pathplanning { class QSampler; } }
 
 namespace rwlibs { namespace pathplanners {
@@ -38,6 +46,11 @@ namespace rwlibs { namespace pathplanners {
        @brief Rapidly Expanding Random Tree based planners for the QToQPlanner
        type of planning problem.
 
+       The nearest node of a tree is found with a
+       rw::pathplanning::QNearestNeighbor index. By default a k-d tree is used
+       for the metrics that support it, such as the weighted infinity metric
+       of rw::pathplanning::PlannerUtil::normalizingInfinityMetric().
+
        @relates QToQPlanner
     */
     class RRTQToQPlanner
@@ -60,12 +73,16 @@ namespace rwlibs { namespace pathplanners {
 
            @param extend [in] Distance measured by \b metric by which to extend
            the tree towards an attractor configuration.
+
+           @param nearestNeighbor [in] The index used for nearest neighbor
+           search in the trees.
         */
         static rw::pathplanning::QToQPlanner::Ptr makeBasic(
             const rw::pathplanning::PlannerConstraint& constraint,
 			rw::common::Ptr<rw::pathplanning::QSampler> sampler,
 			rw::math::QMetric::Ptr metric,
-            double extend);
+            double extend,
+            rw::pathplanning::QNearestNeighbor::Type nearestNeighbor = rw::pathplanning::QNearestNeighbor::Auto);
 
         /**
            @brief RRT-Connect planner.
@@ -82,13 +99,17 @@ namespace rwlibs { namespace pathplanners {
 
            @param extend [in] Distance measured by \b metric by which to extend
            the tree towards an attractor configuration.
+
+           @param nearestNeighbor [in] The index used for nearest neighbor
+           search in the trees.
         */
         static
 			rw::pathplanning::QToQPlanner::Ptr makeConnect(
             const rw::pathplanning::PlannerConstraint& constraint,
 			rw::common::Ptr<rw::pathplanning::QSampler> sampler,
 			rw::math::QMetric::Ptr metric,
-            double extend);
+            double extend,
+            rw::pathplanning::QNearestNeighbor::Type nearestNeighbor = rw::pathplanning::QNearestNeighbor::Auto);
 
         /**
            @brief Bidirectional RRT planner.
@@ -106,13 +127,17 @@ namespace rwlibs { namespace pathplanners {
 
            @param extend [in] Distance measured by \b metric by which to extend
            the tree towards an attractor configuration.
+
+           @param nearestNeighbor [in] The index used for nearest neighbor
+           search in the trees.
         */
         static
 			rw::pathplanning::QToQPlanner::Ptr makeBidirectional(
             const rw::pathplanning::PlannerConstraint& constraint,
 			rw::common::Ptr<rw::pathplanning::QSampler> sampler,
 			rw::math::QMetric::Ptr metric,
-            double extend);
+            double extend,
+            rw::pathplanning::QNearestNeighbor::Type nearestNeighbor = rw::pathplanning::QNearestNeighbor::Auto);
 
         /**
            @brief Balanced, bidirectional RRT planner.
@@ -129,13 +154,185 @@ namespace rwlibs { namespace pathplanners {
 
            @param extend [in] Distance measured by \b metric by which to extend
            the tree towards an attractor configuration.
+
+           @param nearestNeighbor [in] The index used for nearest neighbor
+           search in the trees.
         */
         static
 			rw::pathplanning::QToQPlanner::Ptr makeBalancedBidirectional(
             const rw::pathplanning::PlannerConstraint& constraint,
 			rw::common::Ptr<rw::pathplanning::QSampler> sampler,
 			rw::math::QMetric::Ptr metric,
-            double extend);
+            double extend,
+            rw::pathplanning::QNearestNeighbor::Type nearestNeighbor = rw::pathplanning::QNearestNeighbor::Auto);
+
+        /**
+           @brief Parallel RRT-Connect planner.
+
+           RRT-Connect planner where several workers grow the trees
+           concurrently. A worker samples a configuration, extends one of the
+           trees towards it, and connects the other tree to the new node.
+           Each worker checks its extensions with its own constraint and
+           samples uniformly from \b bounds with its own random generator,
+           which is seeded from rw::math::Random at the start of each query.
+           Use the overload with a sampler per worker to sample other
+           distributions.
+           The stop criteria is shared by the workers.
+
+           By default the workers run freely on the threads of \b pool and
+           add nodes to the trees as they go. In deterministic mode, or if no
+           pool is given, the workers proceed in rounds: they compute their
+           extensions of the trees as they were at the start of the round,
+           and the extensions are added in the order of the workers. The path
+           found is then the same for the same seed of rw::math::Random
+           regardless of the number of threads in the pool.
+
+           @param constraints [in] Constraint for configurations and edges for
+           each worker. The number of workers is the number of constraints.
+           The constraints are used concurrently, so they must not share state
+           such as a collision detector or a work state.
+
+           @param bounds [in] The configuration space to sample.
+
+           @param metric [in] Metric for nearest neighbor search.
+
+           @param extend [in] Distance measured by \b metric by which to extend
+           the tree towards an attractor configuration.
+
+           @param pool [in] The pool to run the workers in, or NULL to run
+           them in the calling thread.
+
+           @param deterministic [in] Synchronize the workers in rounds to make
+           the result reproducible.
+
+           @param nearestNeighbor [in] The index used for nearest neighbor
+           search in the trees.
+        */
+        static
+			rw::pathplanning::QToQPlanner::Ptr makeParallelConnect(
+            const std::vector<rw::pathplanning::PlannerConstraint>& constraints,
+            const rw::models::Device::QBox& bounds,
+			rw::math::QMetric::Ptr metric,
+            double extend,
+            rw::common::Ptr<rw::common::ThreadPool> pool,
+            bool deterministic = false,
+            rw::pathplanning::QNearestNeighbor::Type nearestNeighbor = rw::pathplanning::QNearestNeighbor::Auto);
+
+        /**
+           @brief Parallel RRT-Connect planner with a sampler per worker.
+
+           The planner works as makeParallelConnect() with bounds, except each
+           worker draws its attractor configurations from its own sampler.
+           This allows constrained, biased or task space samplers.
+
+           In deterministic mode, or if no pool is given, the samplers are
+           called by the calling thread in the order of the workers, so
+           samplers that draw from rw::math::Random give the same path for the
+           same seed. Otherwise the samplers are called concurrently by the
+           workers, and they must not share state, including the generator of
+           rw::math::Random.
+
+           @param constraints [in] Constraint for configurations and edges for
+           each worker. The number of workers is the number of constraints.
+
+           @param samplers [in] Sampler of the configuration space for each
+           worker.
+
+           @param metric [in] Metric for nearest neighbor search.
+
+           @param extend [in] Distance measured by \b metric by which to extend
+           the tree towards an attractor configuration.
+
+           @param pool [in] The pool to run the workers in, or NULL to run
+           them in the calling thread.
+
+           @param deterministic [in] Synchronize the workers in rounds to make
+           the result reproducible.
+
+           @param nearestNeighbor [in] The index used for nearest neighbor
+           search in the trees.
+        */
+        static
+			rw::pathplanning::QToQPlanner::Ptr makeParallelConnect(
+            const std::vector<rw::pathplanning::PlannerConstraint>& constraints,
+            const std::vector<rw::common::Ptr<rw::pathplanning::QSampler> >& samplers,
+			rw::math::QMetric::Ptr metric,
+            double extend,
+            rw::common::Ptr<rw::common::ThreadPool> pool,
+            bool deterministic = false,
+            rw::pathplanning::QNearestNeighbor::Type nearestNeighbor = rw::pathplanning::QNearestNeighbor::Auto);
+
+        /**
+           @brief Anytime, asymptotically optimal RRT* planner.
+
+           The planner grows a single tree from the start configuration as in
+           RRT* by Karaman and Frazzoli: a new configuration is connected to
+           the neighbor that gives the cheapest path from the start, and the
+           neighbors are rewired through the new configuration if that makes
+           their paths cheaper. The cost of a path is its length measured by
+           \b metric. The neighbors are the configurations within the radius
+           \f$ \min(\gamma (\log n / n)^{1/d}, \mathrm{extend}) \f$ of the
+           new configuration, where \f$ n \f$ is the number of nodes and
+           \f$ d \f$ is the dimension of the configuration space.
+
+           Once the goal is reached, the planner keeps refining the path until
+           \b stop is satisfied. The cost of the best path found so far is
+           available in the PROP_COST property of the planner. Samples that
+           can not lead to a cheaper path (by the lower bound of the metric
+           distance through them) are rejected.
+
+           Edges are checked lazily by \b edge: candidate parents are tried
+           in order of increasing cost until the first edge that is free,
+           and an edge to a neighbor is only checked when rewiring the
+           neighbor would make its path cheaper. The edge constraint must be
+           symmetric in the start and end configuration.
+
+           A query fails if the stop criteria is satisfied before the goal has
+           been reached.
+
+           @param constraint [in] Constraint for configurations.
+
+           @param edge [in] Constraint for edges, for example
+           rw::pathplanning::QEdgeConstraintIncremental::make() or
+           rw::pathplanning::QEdgeConstraintIncremental::makeCached().
+
+           @param sampler [in] Sampler of the configuration space.
+
+           @param metric [in] Metric for nearest neighbor search and for the
+           cost of paths.
+
+           @param extend [in] Distance measured by \b metric by which to extend
+           the tree towards an attractor configuration. This is also the
+           largest radius of the neighborhood.
+
+           @param rewire [in] The constant \f$ \gamma \f$ of the radius of
+           the neighborhood. For the planner to be asymptotically optimal it
+           must be larger than
+           \f$ 2 (1 + 1/d)^{1/d} (\mu(X_{free}) / \zeta_d)^{1/d} \f$, where
+           \f$ \mu(X_{free}) \f$ is the volume of the free configuration space
+           and \f$ \zeta_d \f$ is the volume of the unit ball, both measured by
+           \b metric.
+
+           @param nearestNeighbor [in] The index used for nearest neighbor
+           and neighborhood search in the tree.
+        */
+        static
+			rw::pathplanning::QToQPlanner::Ptr makeStar(
+            rw::common::Ptr<rw::pathplanning::QConstraint> constraint,
+            rw::common::Ptr<rw::pathplanning::QEdgeConstraintIncremental> edge,
+			rw::common::Ptr<rw::pathplanning::QSampler> sampler,
+			rw::math::QMetric::Ptr metric,
+            double extend,
+            double rewire,
+            rw::pathplanning::QNearestNeighbor::Type nearestNeighbor = rw::pathplanning::QNearestNeighbor::Auto);
+
+        /**
+           @brief Property of the planners of makeStar() with the cost of the
+           best path found by the current or the last query.
+
+           The cost is negative if no path has been found.
+        */
+        static const std::string PROP_COST;
 
     private:
         RRTQToQPlanner(const RRTQToQPlanner&);
@@ -65,6 +65,13 @@ namespace rwlibs { namespace pathplanners {
          */
         node_type& getLast() const { return *_nodes.back(); }
 
+        /**
+         * @brief Get a node by the order in which it was added.
+         * @param idx [in] the index of the node (the root node has index 0).
+         * @return the node.
+         */
+        node_type& getNode(std::size_t idx) const { return *_nodes[idx]; }
+
         /**
          * @brief Create a new node.
          * @param value [in] value of the node.
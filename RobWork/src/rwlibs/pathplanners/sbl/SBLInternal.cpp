@@ -19,6 +19,7 @@
 #include "SBLInternal.hpp"
 
 #include <rw/pathplanning/QEdgeConstraintIncremental.hpp>
+#include <rw/pathplanning/QNearestNeighbor.hpp>
 #include <rw/common/macros.hpp>
 #include <rw/math/Random.hpp>
 #include <rw/pathplanning/QSampler.hpp>
@@ -30,8 +31,9 @@
 #include <algorithm>
 #include <utility>
 #include <iterator>
-#include <map>
+#include <deque>
 #include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
 
 #define NS rwlibs::pathplanners::SBLInternal
 typedef NS::Motion Motion;
@@ -134,15 +136,18 @@ namespace
 			Random::ranI(0, dim));
     }
 
+    // The nodes of a tree are indexed in two ways: A sparse grid over two
+    // (randomly chosen) coordinates, stored in a hash map, gives the density
+    // of the nodes for the expansion step, and a nearest neighbor index gives
+    // the node nearest to a node of the other tree.
     class SpatialIndex
     {
         int mappingSize;
-        int nodeCount;
         SBLOptions options;
 
         typedef std::vector<Node*> Cell;
 
-        typedef std::map<IndexPair, Cell> TreeMapping;
+        typedef boost::unordered_map<IndexPair, Cell> TreeMapping;
         TreeMapping treeMap;
 
         std::pair<double, double> xrange;
@@ -151,14 +156,19 @@ namespace
         int xindex;
         int yindex;
 
+        // The cells of the hash map are not moved by a rehash.
         std::vector<Cell*> cellsInUse;
 
+        // The nodes of the tree in the order of the nearest neighbor index.
+        std::vector<Node*> treeNodes;
+        QNearestNeighbor::Ptr nearest;
+
     public:
         SpatialIndex(const SBLOptions& options)
             :
             mappingSize(1),
-            nodeCount(0),
-            options(options)
+            options(options),
+            nearest(QNearestNeighbor::make(options.metric))
         {
             // No good default values exist here.
             xindex = -1;
@@ -167,7 +177,7 @@ namespace
             yrange = std::make_pair(0, 1);
         }
 
-        int size() const { return nodeCount; }
+        int size() const { return (int)treeNodes.size(); }
 
     private:
         int arraySize(int tree_size) const
@@ -182,24 +192,37 @@ namespace
         typedef NodeVector::const_iterator NI;
 
     public:
+        // Replace the nodes of the tree and rebuild both indexes.
         void reset(
             const NodeVector& nodes,
             const IndexPair& pair)
+        {
+            treeNodes.clear();
+            nearest->clear();
+            for (NI p = nodes.begin(); p != nodes.end(); ++p) {
+                treeNodes.push_back(*p);
+                nearest->add((*p)->q);
+            }
+            resetGrid(pair);
+        }
+
+        // Rebuild the grid for the coordinates of \b pair. The nodes of the tree
+        // and the nearest neighbor index are kept.
+        void resetGrid(const IndexPair& pair)
         {
             cellsInUse.clear();
 
-            mappingSize = arraySize((int)nodes.size());
+            mappingSize = arraySize((int)treeNodes.size());
 
             clearMap();
 
             xindex = pair.first;
             yindex = pair.second;
 
-            setXYRanges(nodes);
+            setXYRanges(treeNodes);
 
-            nodeCount = 0;
-            for (NI p = nodes.begin(); p != nodes.end(); ++p)
-                addNode(*p);
+            for (NI p = treeNodes.begin(); p != treeNodes.end(); ++p)
+                addToGrid(*p);
         }
 
     private:
@@ -236,10 +259,17 @@ namespace
     public:
         void addNode(Node* node)
         {
-            Cell& cell = cellOfNode(node);
+            treeNodes.push_back(node);
+            nearest->add(node->q);
+            addToGrid(node);
+        }
+
+    private:
+        void addToGrid(Node* node)
+        {
+            Cell& cell = treeMap[indexPairOf(node)];
             if (cell.empty()) cellsInUse.push_back(&cell);
             cell.push_back(node);
-            nodeCount++;
         }
 
     private:
@@ -262,15 +292,13 @@ namespace
         }
 
     private:
-        Cell& cellOfNode(Node* node)
+        // The cell of a node, or NULL if the cell is empty.
+        const Cell* findCellOfNode(Node* node) const
         {
-            return getCell(indexPairOf(node));
-        }
-
-    private:
-        Cell& getCell(const IndexPair& pair)
-        {
-            return treeMap[pair];
+            const TreeMapping::const_iterator it = treeMap.find(indexPairOf(node));
+            if (it == treeMap.end() || it->second.empty())
+                return NULL;
+            return &it->second;
         }
 
     private:
@@ -300,6 +328,7 @@ namespace
 
             const double pos = Random::ran(0, 1);
             const int cellCount = (int)cellsInUse.size();
+            const int nodeCount = size();
 
             if (cellCount == 1)
                 return randomNodeFromCell(*cellsInUse.at(0));
@@ -321,17 +350,7 @@ namespace
     private:
         Node* randomNodeUniform() const
         {
-            int choice = Random::ranI(0, nodeCount);
-
-            int acc = 0;
-            for (int i = 0; i < (int)cellsInUse.size(); i++) {
-                acc += (int)cellsInUse[i]->size();
-                if (acc > choice) {
-                    return cellsInUse[i]->at(acc - choice - 1);
-                }
-            }
-            RW_ASSERT(0);
-            return 0;
+            return treeNodes.at(Random::ranI(0, size()));
         }
 
     public:
@@ -367,41 +386,30 @@ namespace
     private:
         Node* nearestNode(Node* node) const
         {
-            Node* minNode = 0;
-            double min = 1e9;
-            for (int i = 0; i < (int)cellsInUse.size(); i++) {
-                const Cell& cell = *cellsInUse[i];
-                for (NI p = cell.begin(); p != cell.end(); ++p) {
-                    double d = nodeDistance(*options.metric, *node, **p);
-                    if (d < min) {
-                        min = d;
-                        minNode = *p;
-                    }
-                }
-            }
-            RW_ASSERT(minNode);
-            return minNode;
+            const int idx = nearest->nearest(node->q);
+            RW_ASSERT(idx >= 0);
+            return treeNodes[idx];
         }
 
     public:
-        Node* nodeNearTo(Node* node)
+        Node* nodeNearTo(Node* node) const
         {
             switch (options.nearNodeSelection) {
             case SBLOptions::UniformSelect:
                 return randomNodeUniform();
             case SBLOptions::UniformFromCell: {
-                Cell& cell = cellOfNode(node);
-                if (cell.empty())
+                const Cell* cell = findCellOfNode(node);
+                if (cell == NULL)
                     return randomNodeUniform();
                 else
-                    return randomNodeFromCell(cell);
+                    return randomNodeFromCell(*cell);
             }
             case SBLOptions::NearestFromCell: {
-                Cell& cell = cellOfNode(node);
-                if (cell.empty())
+                const Cell* cell = findCellOfNode(node);
+                if (cell == NULL)
                     return randomNodeUniform();
                 else
-                    return nearestNodeFromCell(cell, node);
+                    return nearestNodeFromCell(*cell, node);
             }
             case SBLOptions::NearestNode:
                 return nearestNode(node);
@@ -430,8 +438,10 @@ namespace
 
         SBLOptions options;
 
-        // The nodes of both of the trees.
-        NodeVector nodes;
+        // The nodes of both of the trees. The nodes are allocated in blocks
+        // and are never moved.
+        std::deque<Node> nodes;
+        typedef std::deque<Node>::iterator NodeIterator;
 
         // A spatial index for each tree.
         SpatialIndex start_index;
@@ -444,6 +454,10 @@ namespace
         // Set once at reset().
         bool _isReset;
 
+        // Set when nodes have been moved between the trees since the last
+        // reset() such that the nearest neighbor indexes must be rebuilt.
+        bool _treesChanged;
+
     public:
         SBL(const Q& from,
             const Q& to,
@@ -452,7 +466,8 @@ namespace
             options(options),
             start_index(options),
             goal_index(options),
-            _isReset(true)
+            _isReset(true),
+            _treesChanged(true)
         {
             RW_ASSERT(0 < options.connectRadius && options.connectRadius <= 1);
 
@@ -477,7 +492,14 @@ namespace
     public:
         void reset()
         {
-            rebuildSpatialIndexes(randomIndexPair((int)start_nodes.at(0)->q.size()));
+            const IndexPair pair = randomIndexPair((int)start_nodes.at(0)->q.size());
+            if (_treesChanged) {
+                rebuildSpatialIndexes(pair);
+                _treesChanged = false;
+            } else {
+                start_index.resetGrid(pair);
+                goal_index.resetGrid(pair);
+            }
             _isReset = true;
         }
 
@@ -612,9 +634,8 @@ namespace
     private:
         void rebuildSpatialIndexes(const IndexPair& pair)
         {
-            for (NI p = nodes.begin(); p != nodes.end(); ++p) {
-                RW_ASSERT(*p);
-                (*p)->type = UnknownTree;
+            for (NodeIterator p = nodes.begin(); p != nodes.end(); ++p) {
+                p->type = UnknownTree;
             }
 
             setNodeType(start_nodes, StartTree);
@@ -623,8 +644,8 @@ namespace
             NodeVector start_index_nodes = start_nodes;
             NodeVector goal_index_nodes = goal_nodes;
 
-            for (NI p = nodes.begin(); p != nodes.end(); ++p) {
-                addNodeAndParents(*p, start_index_nodes, goal_index_nodes);
+            for (NodeIterator p = nodes.begin(); p != nodes.end(); ++p) {
+                addNodeAndParents(&*p, start_index_nodes, goal_index_nodes);
             }
 
             start_index.reset(start_index_nodes, pair);
@@ -660,9 +681,8 @@ namespace
     private:
         Node* newNode(const Q& q, Node* parent)
         {
-			Node* node = new Node(q, parent, options.constraint.getEdgeConstraint());
-            nodes.push_back(node);
-            return node;
+            nodes.emplace_back(q, parent, options.constraint.getEdgeConstraint());
+            return &nodes.back();
         }
 
     private:
@@ -764,6 +784,7 @@ namespace
 
             // std::cout << "-- delete --\n";
 
+            _treesChanged = true;
             reset();
 
             RW_ASSERT(ok);
@@ -796,13 +817,6 @@ namespace
             return ok;
         }
 
-    public:
-        ~SBL()
-        {
-            for (NI p = nodes.begin(); p != nodes.end(); ++p)
-                delete *p;
-        }
-
     private:
         SBL(const SBL& other);
         SBL& operator=(const SBL& other);
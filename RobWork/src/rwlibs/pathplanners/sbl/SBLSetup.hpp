@@ -52,9 +52,10 @@ class SBLExpand;
         /**
            @brief Constructor
 
-           The SBL planner for this setup performs brute force search for the
-           nearest neighbor of the other tree, and attempts to connect the trees
-           if the distance to the neighbor is below a given threshold.
+           The SBL planner for this setup searches for the nearest neighbor of
+           the other tree (see rw::pathplanning::QNearestNeighbor::make() for
+           the search structure used for \b metric), and attempts to connect
+           the trees if the distance to the neighbor is below a given threshold.
 
            @param constraint [in] Planning constraint.
 
@@ -34,11 +34,16 @@
 #include "ProximityStrategyBullet.hpp"
 #endif
 
+#ifdef RW_HAVE_FCL
+#include "ProximityStrategyFCL.hpp"
+#endif
+
 namespace {
     const std::string RWStr("RWPROX");
     const std::string PQPStr("PQP");
     const std::string YAOBIStr("YAOBI");
     const std::string BulletStr("BULLET");
+    const std::string FCLStr("FCL");
 }
 
 using namespace rwlibs::proximitystrategies;
@@ -85,6 +90,12 @@ rw::proximity::CollisionStrategy::Ptr ProximityStrategyFactory::makeCollisionStr
     }
 #endif
 
+#ifdef RW_HAVE_FCL
+    if(id==FCLStr){
+        return rw::common::ownedPtr( new ProximityStrategyFCL() );
+    }
+#endif
+
     RW_THROW("No support for collision strategy with ID=" << StringUtil::quote(id));
     return NULL;
 }
@@ -104,6 +115,10 @@ std::vector<std::string> ProximityStrategyFactory::getCollisionStrategyIDs(){
     IDs.push_back(BulletStr);
 #endif
 
+#ifdef RW_HAVE_FCL
+    IDs.push_back(FCLStr);
+#endif
+
     IDs.push_back(RWStr);
 
     return IDs;
@@ -138,6 +138,37 @@ namespace
         PQP_Distance(&result, ra, ta, ma, rb, tb, mb, (PQP_REAL)rel_err, (PQP_REAL)abs_err);
     }
 
+    /*
+     * PQP starts a distance query from the closest triangles of the last
+     * query, which are given in the result. The triangles are kept for each
+     * pair of geometries in the cache of the query, and never in the models,
+     * as a model is shared by many pairs and by queries in other threads.
+     */
+    void setLastTris(const std::vector<std::pair<int,int> >& lastTris, std::size_t idx,
+                     PQP_Model* ma, PQP_Model* mb, PQP_DistanceResult& result)
+    {
+        result.last_tri1 = NULL;
+        result.last_tri2 = NULL;
+        if (idx >= lastTris.size())
+            return;
+        const std::pair<int,int>& last = lastTris[idx];
+        if (last.first >= 0 && last.first < ma->num_tris && last.second >= 0 && last.second < mb->num_tris) {
+            result.last_tri1 = &ma->tris[last.first];
+            result.last_tri2 = &mb->tris[last.second];
+        }
+    }
+
+    void storeLastTris(std::vector<std::pair<int,int> >& lastTris, std::size_t idx,
+                       const PQP_Model* ma, const PQP_Model* mb, const PQP_DistanceResult& result)
+    {
+        if (idx >= lastTris.size())
+            lastTris.resize(idx + 1, std::make_pair(-1,-1));
+        if (result.last_tri1 == NULL || result.last_tri2 == NULL)
+            lastTris[idx] = std::make_pair(-1,-1);
+        else
+            lastTris[idx] = std::make_pair((int)(result.last_tri1 - ma->tris), (int)(result.last_tri2 - mb->tris));
+    }
+
     void pqpMultiDistance(
         double threshold,
         PQP_Model* ma, const Transform3D<>& wTa,
@@ -392,9 +423,6 @@ bool ProximityStrategyPQP::doInCollision(ProximityModel::Ptr aModel,
             data._nrBVTests += qdata.cache->_collideResult.NumBVTests();
             data._nrPrimTests += qdata.cache->_collideResult.NumTriTests();
 
-            _numBVTests += qdata.cache->_collideResult.NumBVTests();
-            _numTriTests += qdata.cache->_collideResult.NumTriTests();
-
             if (qdata.cache->_collideResult.Colliding() != 0){
             	//data._aTb = fromRapidTransform(qdata.cache->_collideResult.R,qdata.cache->_collideResult.T);
 
@@ -417,8 +445,10 @@ bool ProximityStrategyPQP::doInCollision(ProximityModel::Ptr aModel,
             		data._geomPrimIds[startIdx+j].first = qdata.cache->_collideResult.pairs[j].id1;
             		data._geomPrimIds[startIdx+j].second= qdata.cache->_collideResult.pairs[j].id2;
             	}
-                if(firstContact)
+                if(firstContact) {
+                    addStats(data._nrBVTests, data._nrPrimTests);
                     return true;
+                }
 
             	col_res = true;
             }
@@ -426,9 +456,17 @@ bool ProximityStrategyPQP::doInCollision(ProximityModel::Ptr aModel,
         }
         geoIdxA++;
     }
+    addStats(data._nrBVTests, data._nrPrimTests);
     return col_res;
 }
 
+void ProximityStrategyPQP::addStats(int bvTests, int triTests)
+{
+    boost::mutex::scoped_lock lock(_statsMutex);
+    _numBVTests += bvTests;
+    _numTriTests += triTests;
+}
+
 
 DistanceResult& ProximityStrategyPQP::doDistance(
 										ProximityModel::Ptr aModel,
@@ -448,14 +486,17 @@ DistanceResult& ProximityStrategyPQP::doDistance(
 
     int geoA = -1;
     int geoB = -1;
+    std::size_t pairIdx = 0;
     BOOST_FOREACH(const RWPQPModel& ma, qdata.a->models) {
     	geoA++;
         BOOST_FOREACH(const RWPQPModel& mb, qdata.b->models) {
         	geoB++;
+        	setLastTris(qdata.cache->_lastTris, pairIdx, ma.pqpmodel.get(), mb.pqpmodel.get(), qdata.cache->_distResult);
             pqpDistance(
                 ma.pqpmodel.get(), wTa * ma.t3d,
                 mb.pqpmodel.get(), wTb * mb.t3d,
                 data.rel_err, data.abs_err, qdata.cache->_distResult);
+            storeLastTris(qdata.cache->_lastTris, pairIdx++, ma.pqpmodel.get(), mb.pqpmodel.get(), qdata.cache->_distResult);
 
             if(rwresult.distance>qdata.cache->_distResult.distance){
                 rwresult.distance = qdata.cache->_distResult.distance;
@@ -464,8 +505,8 @@ DistanceResult& ProximityStrategyPQP::doDistance(
 
                 rwresult.geoIdxA = geoA;
                 rwresult.geoIdxB = geoB;
-                rwresult.idx1 = ma.pqpmodel->last_tri->id;
-                rwresult.idx2 = mb.pqpmodel->last_tri->id;
+                rwresult.idx1 = qdata.cache->_distResult.last_tri1->id;
+                rwresult.idx2 = qdata.cache->_distResult.last_tri2->id;
             }
         }
     }
@@ -629,8 +670,9 @@ DistanceResult& ProximityStrategyPQP::doDistanceThreshold(
     //RW_ASSERT(aModel->owner==this);
     //RW_ASSERT(bModel->owner==this);
 
-    PQPProximityModel *a = (PQPProximityModel*)aModel.get();
-    PQPProximityModel *b = (PQPProximityModel*)bModel.get();
+    QueryData qdata = initQuery(aModel,bModel,data);
+    PQPProximityModel *a = qdata.a;
+    PQPProximityModel *b = qdata.b;
 
     DistanceResult &rwresult = data.getDistanceData();
     rwresult.distance = DBL_MAX;
@@ -641,15 +683,18 @@ DistanceResult& ProximityStrategyPQP::doDistanceThreshold(
 
     int geoA = -1;
     int geoB = -1;
+    std::size_t pairIdx = 0;
     BOOST_FOREACH(const RWPQPModel& ma, a->models) {
     	geoA++;
         BOOST_FOREACH(const RWPQPModel& mb, b->models) {
         	geoB++;
+        	setLastTris(qdata.cache->_lastTris, pairIdx, ma.pqpmodel.get(), mb.pqpmodel.get(), distResult);
         	pqpDistanceThreshold(
                 ma.pqpmodel.get(), wTa * ma.t3d,
                 mb.pqpmodel.get(), wTb * mb.t3d,
                 threshold,
                 data.rel_err, data.abs_err, distResult);
+            storeLastTris(qdata.cache->_lastTris, pairIdx++, ma.pqpmodel.get(), mb.pqpmodel.get(), distResult);
 
             if(rwresult.distance>distResult.distance){
                 rwresult.distance = distResult.distance;
@@ -661,8 +706,8 @@ DistanceResult& ProximityStrategyPQP::doDistanceThreshold(
 
                 rwresult.geoIdxA = geoA;
                 rwresult.geoIdxB = geoB;
-                rwresult.idx1 = ma.pqpmodel->last_tri->id;
-                rwresult.idx2 = mb.pqpmodel->last_tri->id;
+                rwresult.idx1 = distResult.last_tri1->id;
+                rwresult.idx2 = distResult.last_tri2->id;
             }
         }
     }
@@ -38,6 +38,8 @@
 
 #include <PQP/PQP.h>
 
+#include <boost/thread/mutex.hpp>
+
 namespace rw { namespace geometry { class GeometryData; } }
 
 namespace PQP { class PQP_Model; }
@@ -96,6 +98,9 @@ namespace rwlibs { namespace proximitystrategies {
             PQP::PQP_CollideResult _collideResult;
             PQP::PQP_DistanceResult _distResult;
             PQP::PQP_MultiDistanceResult _multiDistResult;
+
+            //! @brief the closest triangles of the last distance query for each pair of geometries
+            std::vector<std::pair<int,int> > _lastTris;
         };
 
         //! @brief
@@ -239,18 +244,18 @@ namespace rwlibs { namespace proximitystrategies {
          * @brief returns the number of bounding volume tests performed
          * since the last call to clearStats
          */
-        int getNrOfBVTests(){return _numBVTests;};
+        int getNrOfBVTests(){ boost::mutex::scoped_lock lock(_statsMutex); return _numBVTests; };
 
         /**
          * @brief returns the number of ptriangle tests performed
          * since the last call to clearStats
          */
-        int getNrOfTriTests(){return _numTriTests;};
+        int getNrOfTriTests(){ boost::mutex::scoped_lock lock(_statsMutex); return _numTriTests; };
 
         /**
          * @brief clears the bounding volume and triangle test counters.
          */
-        void clearStats(){ _numBVTests = 0; _numTriTests = 0;};
+        void clearStats(){ boost::mutex::scoped_lock lock(_statsMutex); _numBVTests = 0; _numTriTests = 0; };
 
 		void setThreshold(double threshold);
 
@@ -268,7 +273,11 @@ namespace rwlibs { namespace proximitystrategies {
                             rw::proximity::ProximityModel::Ptr& bModel,
                             rw::proximity::ProximityStrategyData &data);
     private:
+    	// the counters are shared by queries that run in parallel
+    	void addStats(int bvTests, int triTests);
+
     	int _numBVTests,_numTriTests;
+    	boost::mutex _statsMutex;
 
     	std::vector<RWPQPModel> _allmodels;
     	std::map<std::string, std::vector<int> > _geoIdToModelIdx;
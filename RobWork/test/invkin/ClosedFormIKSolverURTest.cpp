@@ -18,9 +18,11 @@
 #include "../TestSuiteConfig.hpp"
 
 #include <rw/loaders/WorkCellLoader.hpp>
+#include <rw/models/JointDeviceBatchFK.hpp>
 #include <rw/models/SerialDevice.hpp>
 #include <rw/models/WorkCell.hpp>
 #include <rw/invkin/ClosedFormIKSolverUR.hpp>
+#include <rw/math/Math.hpp>
 
 using rw::kinematics::State;
 using rw::loaders::WorkCellLoader;
@@ -61,3 +63,48 @@ BOOST_AUTO_TEST_CASE( ClosedFormIKSolverURTest ){
 		BOOST_CHECK(found);
 	}
 }
+
+BOOST_AUTO_TEST_CASE( ClosedFormIKSolverURBatchTest ){
+	static const std::size_t N = 100;
+
+    BOOST_TEST_MESSAGE("- Testing ClosedFormIKSolverUR::solveBatch");
+	const WorkCell::Ptr wc = WorkCellLoader::Factory::load(testFilePath() + "devices/UR6855A/UR6855A.wc.xml");
+	BOOST_REQUIRE(wc != NULL);
+	SerialDevice::Ptr device = wc->findDevice<SerialDevice>("UR-6-85-5-A");
+	BOOST_REQUIRE(device != NULL);
+	const ClosedFormIKSolverUR solver(device,wc->getDefaultState());
+
+	State state = wc->getDefaultState();
+	Math::seed(1);
+	ClosedFormIKSolverUR::TransformArray targets(N, 12);
+	for (std::size_t i = 0; i < N; i++) {
+		device->setQ(Math::ranQ(device->getBounds()),state);
+		const Transform3D<> T = device->baseTend(state);
+		for (std::size_t r = 0; r < 3; r++) {
+			for (std::size_t c = 0; c < 3; c++)
+				targets(i,3*r+c) = T.R()(r,c);
+			targets(i,9+r) = T.P()[r];
+		}
+	}
+
+	Eigen::ArrayXXd solutions;
+	ClosedFormIKSolverUR::BranchArray valid;
+	state = wc->getDefaultState();
+	solver.solveBatch(targets, state, solutions, valid);
+	BOOST_REQUIRE_EQUAL(solutions.rows(), (Eigen::Index)N);
+	BOOST_REQUIRE_EQUAL(solutions.cols(), 48);
+	BOOST_REQUIRE_EQUAL(valid.cols(), 8);
+
+	// The valid branches must be the solutions of the scalar solver, in the same order
+	for (std::size_t i = 0; i < N; i++) {
+		const std::vector<Q> expected = solver.solve(JointDeviceBatchFK::getTransform(targets, i), state);
+		std::vector<Q> found;
+		for (int b = 0; b < 8; b++) {
+			if (valid(i,b))
+				found.push_back(Q(solutions.row(i).segment(6*b,6).transpose().matrix()));
+		}
+		BOOST_REQUIRE_EQUAL(found.size(), expected.size());
+		for (std::size_t k = 0; k < found.size(); k++)
+			BOOST_CHECK_SMALL((found[k]-expected[k]).normInf(), 1e-9);
+	}
+}
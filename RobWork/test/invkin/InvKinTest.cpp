@@ -17,20 +17,27 @@
 
 #include "../TestSuiteConfig.hpp"
 
+#include <rw/common/ThreadPool.hpp>
 #include <rw/invkin.hpp>
 #include <rw/loaders/WorkCellLoader.hpp>
 #include <rw/models/DHParameterSet.hpp>
 #include <rw/models/SerialDevice.hpp>
 #include <rw/models/TreeDevice.hpp>
+#include <rw/proximity/CollisionDetector.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 
 #include <string>
 
 using rw::common::ownedPtr;
+using rw::common::ThreadPool;
 using namespace rw::invkin;
 using rw::kinematics::State;
 using rw::loaders::WorkCellLoader;
 using namespace rw::math;
 using namespace rw::models;
+using rw::proximity::CollisionDetector;
 
 typedef IterativeIK::Ptr (* MakeIKSolver)(SerialDevice*, State&);
 typedef IterativeMultiIK::Ptr (* MakeMultiIKSolver)(TreeDevice*, State&);
@@ -381,3 +388,106 @@ BOOST_AUTO_TEST_CASE( testClosedFormInverseKinematics ) {
     BOOST_CHECK(cnt == 4);
     // std::cout<<"PieperSolver Tested"<<std::endl;
 }
+
+BOOST_AUTO_TEST_CASE( testJacobianIKSolverFixedSize )
+{
+    Math::seed(0);
+    const std::string files[] = { "PA10/pa10.xml", "devices/UR6855A/UR6855A.wc.xml" };
+    for (int f = 0; f < 2; f++) {
+        BOOST_TEST_MESSAGE("- Testing fixed size DLS for " << files[f]);
+        WorkCell::Ptr workcell = WorkCellLoader::Factory::load(testFilePath() + files[f]);
+        BOOST_REQUIRE(workcell != NULL);
+        const Device::Ptr device = workcell->getDevices().at(0);
+        State state = workcell->getDefaultState();
+
+        // The fixed size iteration takes the same steps as the general one
+        JacobianIKSolver fixed(device, state);
+        fixed.setSolverType(JacobianIKSolver::DLS);
+        fixed.setMaxIterations(1000);
+        fixed.setMaxError(1e-5);
+        JacobianIKSolver general(device, state);
+        general.setSolverType(JacobianIKSolver::DLS);
+        general.setMaxIterations(1000);
+        general.setMaxError(1e-5);
+        general.setEnableFixedSize(false);
+        BOOST_CHECK(fixed.isFixedSize());
+        BOOST_CHECK(!general.isFixedSize());
+
+        const std::pair<Q, Q> bounds = device->getBounds();
+        // start away from the singular zero configuration of the PA10, and keep
+        // the targets close as DLS with a fixed damping converges slowly
+        const Q q_zero = bounds.first + 0.4 * (bounds.second - bounds.first);
+        const Q displacements = 0.02 * (bounds.second - bounds.first);
+        int solved = 0;
+        for (int i = 0; i < 10; i++) {
+            Q q = q_zero;
+            for (std::size_t j = 0; j < q.size(); j++)
+                q(j) += Math::ran(-displacements(j), displacements(j));
+            device->setQ(q, state);
+            const Transform3D<> target = device->baseTend(state);
+
+            device->setQ(q_zero, state);
+            const std::vector<Q> a = fixed.solve(target, state);
+            const std::vector<Q> b = general.solve(target, state);
+            // both fail or both succeed, as they take the same steps
+            BOOST_REQUIRE_EQUAL(a.size(), b.size());
+            if (a.empty())
+                continue;
+            solved++;
+            BOOST_CHECK_SMALL((a[0] - b[0]).normInf(), 1e-4);
+
+            State check = state;
+            device->setQ(a[0], check);
+            BOOST_CHECK(device->baseTend(check).equal(target, 1e-4));
+        }
+        BOOST_CHECK_GT(solved, 5);
+    }
+}
+
+namespace {
+    bool collectSolution(std::vector<Q>* solutions, const Q& q)
+    {
+        solutions->push_back(q);
+        return true;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testIKMetaSolverParallel )
+{
+    Math::seed(0);
+    WorkCell::Ptr workcell = WorkCellLoader::Factory::load(testFilePath() + "PA10/pa10.xml");
+    const SerialDevice::Ptr device = workcell->getDevices().at(0).cast<SerialDevice>();
+    BOOST_REQUIRE(device);
+
+    State state = workcell->getDefaultState();
+    const std::pair<Q, Q> bounds = device->getBounds();
+    device->setQ(0.45 * (bounds.first + bounds.second), state);
+    const Transform3D<> target = device->baseTend(state);
+    device->setQ(0.3 * (bounds.first + bounds.second), state);
+
+    // One solver for each worker
+    std::vector<IterativeIK::Ptr> solvers;
+    for (int i = 0; i < 3; i++)
+        solvers.push_back(ownedPtr(new JacobianIKSolver(device, state)));
+    const IKMetaSolver solver(solvers, device, std::vector<CollisionDetector::Ptr>(), ownedPtr(new ThreadPool(2)));
+
+    // All distinct solutions are streamed in the order of the result
+    std::vector<Q> streamed;
+    const std::vector<Q> result = solver.solve(target, state, 30, false, boost::bind(&collectSolution, &streamed, _1));
+    BOOST_REQUIRE(!result.empty());
+    BOOST_CHECK(streamed == result);
+    State check = state;
+    BOOST_FOREACH(const Q& q, result) {
+        device->setQ(q, check);
+        BOOST_CHECK(device->baseTend(check).equal(target, 1e-4));
+        for (std::size_t i = 0; i < q.size(); i++) {
+            BOOST_CHECK(bounds.first[i] <= q[i] && q[i] <= bounds.second[i]);
+        }
+    }
+
+    // The search is cancelled by the first solution
+    streamed.clear();
+    const std::vector<Q> first = solver.solve(target, state, 30, true, boost::bind(&collectSolution, &streamed, _1));
+    BOOST_CHECK_EQUAL(first.size(), 1u);
+    BOOST_CHECK(streamed == first);
+}
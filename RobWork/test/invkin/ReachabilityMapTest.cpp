@@ -0,0 +1,172 @@
+/********************************************************************************
+ * Copyright 2017 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include "../TestSuiteConfig.hpp"
+
+#include <rw/common/ThreadPool.hpp>
+#include <rw/invkin/ClosedFormIKSolverUR.hpp>
+#include <rw/invkin/JacobianIKSolver.hpp>
+#include <rw/invkin/ReachabilityMap.hpp>
+#include <rw/loaders/WorkCellLoader.hpp>
+#include <rw/models/SerialDevice.hpp>
+#include <rw/models/WorkCell.hpp>
+#include <rw/pathplanning/QConstraint.hpp>
+#include <rw/pathplanning/QIKSampler.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+using rw::common::ownedPtr;
+using rw::common::ThreadPool;
+using rw::kinematics::State;
+using rw::loaders::WorkCellLoader;
+using namespace rw::invkin;
+using namespace rw::math;
+using namespace rw::models;
+using namespace rw::pathplanning;
+
+namespace {
+    void checkSameMap(const ReachabilityMap& a, const ReachabilityMap& b) {
+        BOOST_REQUIRE_EQUAL(a.getVoxelCount(), b.getVoxelCount());
+        BOOST_REQUIRE_EQUAL(a.getReachableCount(), b.getReachableCount());
+        for (std::size_t v = 0; v < a.getVoxelCount(); v++) {
+            const std::vector<std::size_t> bins = a.getReachableBins(v);
+            BOOST_REQUIRE(bins == b.getReachableBins(v));
+            for (std::size_t k = 0; k < bins.size(); k++) {
+                Q qa, qb;
+                const Transform3D<> T = a.getCellTransform(v, bins[k]);
+                BOOST_REQUIRE(a.getSeed(T, qa));
+                BOOST_REQUIRE(b.getSeed(T, qb));
+                BOOST_CHECK(qa == qb);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( ReachabilityMapTest ){
+    BOOST_TEST_MESSAGE("- Testing ReachabilityMap");
+	const WorkCell::Ptr wc = WorkCellLoader::Factory::load(testFilePath() + "devices/UR6855A/UR6855A.wc.xml");
+	BOOST_REQUIRE(wc != NULL);
+	const SerialDevice::Ptr device = wc->findDevice<SerialDevice>("UR-6-85-5-A");
+	BOOST_REQUIRE(device != NULL);
+	State state = wc->getDefaultState();
+	const ClosedFormIKSolverUR::Ptr solver = ownedPtr(new ClosedFormIKSolverUR(device, state));
+
+	ReachabilityMap::Grid grid;
+	grid.radius = 1.0;
+	grid.resolution = 0.25;
+	grid.directionResolution = 1;
+	grid.rollBins = 4;
+	const ReachabilityMap::Ptr map = ReachabilityMap::build(device, solver, state, grid);
+	BOOST_REQUIRE_EQUAL(map->getVoxelCount(), 512u);
+	BOOST_REQUIRE_EQUAL(map->getBinCount(), 24u);
+	BOOST_CHECK_EQUAL(map->getDOF(), 6u);
+	BOOST_CHECK(map->getReachableCount() > 0);
+	BOOST_CHECK(map->getReachableCount() < map->getVoxelCount()*map->getBinCount());
+
+	// The cells of the poses at the cell centers, and the seeds reaching the cell centers
+	for (std::size_t v = 0; v < map->getVoxelCount(); v++) {
+		const std::vector<std::size_t> bins = map->getReachableBins(v);
+		BOOST_CHECK_CLOSE(map->getReachabilityIndex(map->getCellTransform(v, 0).P()), (double)bins.size()/24, 1e-9);
+		for (std::size_t bin = 0; bin < map->getBinCount(); bin++) {
+			const Transform3D<> T = map->getCellTransform(v, bin);
+			std::size_t voxel, cellBin;
+			BOOST_REQUIRE(map->getCell(T, voxel, cellBin));
+			BOOST_CHECK_EQUAL(voxel, v);
+			BOOST_CHECK_EQUAL(cellBin, bin);
+			const bool reachable = std::find(bins.begin(), bins.end(), bin) != bins.end();
+			BOOST_CHECK_EQUAL(map->isReachable(T), reachable);
+			Q seed;
+			if (map->getSeed(T, seed)) {
+				device->setQ(seed, state);
+				BOOST_CHECK(device->baseTend(state).equal(T, 1e-5));
+			}
+		}
+	}
+	BOOST_CHECK(!map->isReachable(Transform3D<>(Vector3D<>(0, 0, 2))));
+	BOOST_CHECK_EQUAL(map->getReachabilityIndex(Vector3D<>(0, 0, 2)), 0.);
+
+	// Building in parallel gives the same map
+	const ThreadPool::Ptr pool = ownedPtr(new ThreadPool(2));
+	checkSameMap(*map, *ReachabilityMap::build(device, solver, state, grid, std::vector<QConstraint::Ptr>(), pool));
+
+	// Solutions are checked by the constraints of the workers
+	Device::QBox bounds = device->getBounds();
+	bounds.second[0] = 0;
+	std::vector<QConstraint::Ptr> constraints;
+	constraints.push_back(QConstraint::makeBounds(bounds));
+	constraints.push_back(QConstraint::makeBounds(bounds));
+	const ReachabilityMap::Ptr constrained = ReachabilityMap::build(device, solver, state, grid, constraints, pool);
+	BOOST_CHECK(constrained->getReachableCount() > 0);
+	BOOST_CHECK(constrained->getReachableCount() < map->getReachableCount());
+	for (std::size_t v = 0; v < constrained->getVoxelCount(); v++) {
+		const std::vector<std::size_t> bins = constrained->getReachableBins(v);
+		for (std::size_t k = 0; k < bins.size(); k++) {
+			Q seed;
+			BOOST_REQUIRE(constrained->getSeed(constrained->getCellTransform(v, bins[k]), seed));
+			BOOST_CHECK(seed[0] <= 0);
+		}
+	}
+
+	// The memory mapped file gives the same map
+	const std::string filename = "testReachabilityMap.rwrm";
+	map->write(filename);
+	{
+		const ReachabilityMap::Ptr loaded = ReachabilityMap::load(filename);
+		BOOST_CHECK_EQUAL(loaded->getGrid().radius, grid.radius);
+		BOOST_CHECK_EQUAL(loaded->getGrid().resolution, grid.resolution);
+		checkSameMap(*map, *loaded);
+	}
+	// A corrupt file is rejected instead of being read out of bounds by the queries
+	{
+		// the bins follow the 56 byte header and the offsets of the 512 voxels
+		std::fstream file(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(56 + 513*sizeof(boost::uint64_t));
+		const boost::uint32_t bin = 24;
+		file.write(reinterpret_cast<const char*>(&bin), sizeof(bin));
+	}
+	BOOST_CHECK_THROW(ReachabilityMap::load(filename), rw::common::Exception);
+	{
+		// the resolution of the grid
+		std::fstream file(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(40);
+		const double resolution = 0;
+		file.write(reinterpret_cast<const char*>(&resolution), sizeof(resolution));
+	}
+	BOOST_CHECK_THROW(ReachabilityMap::load(filename), rw::common::Exception);
+	std::remove(filename.c_str());
+
+	// Seeding of an iterative solver
+	const JacobianIKSolver::Ptr iksolver = ownedPtr(new JacobianIKSolver(device, state));
+	const QIKSampler::Ptr sampler = QIKSampler::makeSeeded(map, device, state, iksolver, 1);
+	std::size_t found = 0;
+	for (std::size_t v = 0; v < map->getVoxelCount(); v += 7) {
+		const std::vector<std::size_t> bins = map->getReachableBins(v);
+		if (bins.empty())
+			continue;
+		const Transform3D<> T = map->getCellTransform(v, bins[0]);
+		const Q q = sampler->sample(T);
+		if (!q.empty()) {
+			found++;
+			device->setQ(q, state);
+			BOOST_CHECK(device->baseTend(state).equal(T, 1e-5));
+		}
+	}
+	BOOST_CHECK(found > 0);
+	BOOST_CHECK(sampler->sample(Transform3D<>(Vector3D<>(0, 0, 2))).empty());
+}
@@ -18,21 +18,40 @@
 
 #include "../TestSuiteConfig.hpp"
 
+#include <rw/common/ThreadPool.hpp>
+#include <rw/math/Random.hpp>
 #include <rw/pathplanning/QToQPlanner.hpp>
 #include <rw/pathplanning/QSampler.hpp>
 #include <rw/pathplanning/PlannerUtil.hpp>
+#include <rw/pathplanning/QEdgeCache.hpp>
+#include <rw/pathplanning/QEdgeConstraintContinuous.hpp>
+#include <rw/pathplanning/QEdgeConstraintIncremental.hpp>
+#include <rw/pathplanning/QNearestNeighbor.hpp>
 #include <rw/trajectory/Path.hpp>
 #include <rwlibs/pathplanners/arw/ARWPlanner.hpp>
 #include <rwlibs/pathplanners/rrt/RRTPlanner.hpp>
+#include <rwlibs/pathplanners/rrt/RRTQToQPlanner.hpp>
 #include <rwlibs/pathplanners/sbl/SBLPlanner.hpp>
 #include <rwlibs/pathplanners/prm/PartialIndexTable.hpp>
 #include <rwlibs/pathplanners/prm/PRMPlanner.hpp>
+#include <rwlibs/pathplanners/prm/PRMRoadmap.hpp>
 
+#include <rw/kinematics/Kinematics.hpp>
 #include <rw/loaders/WorkCellLoader.hpp>
+#include <rw/models/Joint.hpp>
+#include <rw/models/JointDevice.hpp>
+#include <rw/models/Object.hpp>
 #include <rw/models/WorkCell.hpp>
 #include <rw/math/MetricFactory.hpp>
+#include <rw/proximity/CollisionDetector.hpp>
+#include <rw/proximity/DistanceCalculator.hpp>
+#include <rw/proximity/DynamicAABBTreeFilterStrategy.hpp>
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
 #if RW_HAVE_PQP == 1
 #include <rwlibs/proximitystrategies/ProximityStrategyPQP.hpp>
 using rwlibs::proximitystrategies::ProximityStrategyPQP;
@@ -43,6 +62,10 @@ using rwlibs::proximitystrategies::ProximityStrategyYaobi;
 #endif
 
 using namespace rw::common;
+using rw::kinematics::Frame;
+using rw::kinematics::FramePair;
+using rw::kinematics::FramePairList;
+using rw::kinematics::Kinematics;
 using rw::kinematics::State;
 using rw::loaders::WorkCellLoader;
 using namespace rw::math;
@@ -101,6 +124,337 @@ BOOST_AUTO_TEST_CASE( testPartialIndexTable )
     BOOST_CHECK(ok);
 }
 
+BOOST_AUTO_TEST_CASE( testQNearestNeighbor )
+{
+    Q lower(7); Q upper(7);
+    for (std::size_t i = 0; i < 7; i++) {
+        lower(i) = -(double)i - 1;
+        upper(i) = 2*(double)i + 1;
+    }
+    const Device::QBox bounds(lower, upper);
+    QSampler::Ptr anyQ = QSampler::makeUniform(bounds);
+
+    std::vector<QMetric::Ptr> metrics;
+    metrics.push_back(PlannerUtil::normalizingInfinityMetric(bounds));
+    metrics.push_back(MetricFactory::makeWeightedEuclidean<Q>(upper - lower));
+    metrics.push_back(MetricFactory::makeManhattan<Q>());
+
+    BOOST_FOREACH(const QMetric::Ptr& metric, metrics) {
+        QNearestNeighbor::Ptr linear = QNearestNeighbor::make(metric, QNearestNeighbor::Linear);
+        QNearestNeighbor::Ptr kdtree = QNearestNeighbor::make(metric, QNearestNeighbor::KDTree);
+        BOOST_CHECK_EQUAL(kdtree->nearest(lower), -1);
+
+        std::vector<Q> qs;
+        for (int i = 0; i < 2000; i++) {
+            // Some duplicates to test splitting of identical configurations
+            const Q q = i % 100 == 99 ? qs.back() : anyQ->sample();
+            qs.push_back(q);
+            linear->add(q);
+            kdtree->add(q);
+        }
+        BOOST_CHECK_EQUAL(kdtree->size(), qs.size());
+
+        for (int i = 0; i < 200; i++) {
+            const Q q = anyQ->sample();
+            double linearDist, kdtreeDist;
+            const int linearIdx = linear->nearest(q, &linearDist);
+            const int kdtreeIdx = kdtree->nearest(q, &kdtreeDist);
+            BOOST_CHECK_CLOSE(linearDist, kdtreeDist, 1e-8);
+            BOOST_CHECK_CLOSE(metric->distance(q, qs[kdtreeIdx]), linearDist, 1e-8);
+            BOOST_CHECK(linearIdx >= 0);
+
+            std::vector<int> linearNear, kdtreeNear;
+            linear->nearestWithin(q, 3*linearDist, linearNear);
+            kdtree->nearestWithin(q, 3*linearDist, kdtreeNear);
+            std::sort(linearNear.begin(), linearNear.end());
+            std::sort(kdtreeNear.begin(), kdtreeNear.end());
+            BOOST_CHECK(!kdtreeNear.empty());
+            BOOST_CHECK(linearNear == kdtreeNear);
+        }
+    }
+}
+
+namespace {
+    // Free configuration constraint that counts the configurations checked
+    class CountingConstraint: public QConstraint
+    {
+    public:
+        CountingConstraint(): count(0) {}
+        mutable int count;
+
+    protected:
+        bool doInCollision(const Q& q) const
+        {
+            count++;
+            return q[0] > 2;
+        }
+
+        void doSetLog(Log::Ptr) {}
+    };
+}
+
+BOOST_AUTO_TEST_CASE( testQEdgeCache )
+{
+    const rw::common::Ptr<CountingConstraint> constraint = ownedPtr(new CountingConstraint());
+    const QMetric::Ptr metric = MetricFactory::makeEuclidean<Q>();
+    const QEdgeCache::Ptr cache = ownedPtr(new QEdgeCache(2));
+    const boost::uint64_t setup = QEdgeCache::makeSetupId();
+    const Q a(2, 0.0, 0.0);
+    const Q b(2, 1.0, 0.0);
+    const Q c(2, 3.0, 0.0);
+    // 64 configurations are checked on the edge from a to b
+    const double res = 1.0/64;
+
+    // The second check of an edge is answered by the cache
+    const QEdgeConstraint::Ptr edge = QEdgeConstraint::makeCached(constraint, metric, res, setup, cache);
+    BOOST_CHECK(!edge->inCollision(a, b));
+    BOOST_CHECK_EQUAL(constraint->count, 64);
+    BOOST_CHECK(!edge->inCollision(a, b));
+    BOOST_CHECK_EQUAL(constraint->count, 64);
+    BOOST_CHECK(edge->inCollision(a, c));
+    const int count = constraint->count;
+    BOOST_CHECK(edge->inCollision(a, c));
+    BOOST_CHECK_EQUAL(constraint->count, count);
+    BOOST_CHECK_EQUAL(cache->size(), 2u);
+
+    // An incremental check resumes from the partial check of another instance
+    // (the first two levels check one configuration each)
+    const QEdgeConstraintIncremental::Ptr incremental =
+        QEdgeConstraintIncremental::makeCached(constraint, metric, res, setup, cache);
+    const QEdgeConstraintIncremental::Ptr first = incremental->instance(b, a);
+    BOOST_CHECK(!first->inCollisionPartialCheck());
+    BOOST_CHECK(!first->inCollisionPartialCheck());
+    const QEdgeConstraintIncremental::Ptr second = incremental->instance(b, a);
+    BOOST_CHECK_EQUAL(second->inCollisionCost(), first->inCollisionCost());
+    constraint->count = 0;
+    BOOST_CHECK(!second->inCollision());
+    BOOST_CHECK_EQUAL(constraint->count, 64 - 2);
+
+    // The least recently used edge is removed, and other setups are separate
+    BOOST_CHECK_EQUAL(cache->size(), 2u);
+    double resolution = 0;
+    BOOST_CHECK_EQUAL(cache->get(setup, b, a, &resolution), QEdgeCache::Free);
+    BOOST_CHECK_EQUAL(resolution, res);
+    BOOST_CHECK_EQUAL(cache->get(setup, a, b), QEdgeCache::Unknown);
+    BOOST_CHECK_EQUAL(cache->get(setup, a, c), QEdgeCache::Blocked);
+    BOOST_CHECK_EQUAL(cache->get(QEdgeCache::makeSetupId(), a, c), QEdgeCache::Unknown);
+}
+
+namespace {
+    // Free configuration constraint that records the batches checked
+    class RecordingConstraint: public QConstraint
+    {
+    public:
+        mutable std::vector<std::vector<Q> > batches;
+
+    protected:
+        bool doInCollision(const Q&) const
+        {
+            return false;
+        }
+
+        boost::dynamic_bitset<> doInCollisionBatch(const std::vector<Q>& qs, bool) const
+        {
+            batches.push_back(qs);
+            return boost::dynamic_bitset<>(qs.size());
+        }
+
+        void doSetLog(Log::Ptr) {}
+    };
+}
+
+BOOST_AUTO_TEST_CASE( testQEdgeBisection )
+{
+    const rw::common::Ptr<RecordingConstraint> constraint = ownedPtr(new RecordingConstraint());
+    const QMetric::Ptr metric = MetricFactory::makeEuclidean<Q>();
+    const Q a(1, 0.0);
+    const Q b(1, 1.0);
+
+    // Positions 1 ... 6 of 8 steps are checked in van der Corput order
+    const QEdgeConstraint::Ptr edge = QEdgeConstraint::makeBisection(constraint, metric, 0.125, 4);
+    BOOST_CHECK(!edge->inCollision(a, Q(1, 0.8)));
+    BOOST_REQUIRE_EQUAL(constraint->batches.size(), 2u);
+    BOOST_REQUIRE_EQUAL(constraint->batches[0].size(), 4u);
+    BOOST_REQUIRE_EQUAL(constraint->batches[1].size(), 2u);
+    const double positions[] = { 4, 2, 6, 1, 5, 3 };
+    for (std::size_t i = 0; i < 6; i++)
+        BOOST_CHECK_CLOSE(constraint->batches[i / 4][i % 4][0], positions[i]*0.125, 1e-9);
+
+    // The checking stops at the first collision, which is found at the third
+    // position in bisection order
+    const rw::common::Ptr<CountingConstraint> counting = ownedPtr(new CountingConstraint());
+    const QEdgeConstraint::Ptr blocked = QEdgeConstraint::makeBisection(counting, metric, 1.0/64, 8);
+    BOOST_CHECK(blocked->inCollision(a, Q(1, 3.0)));
+    BOOST_CHECK_EQUAL(counting->count, 3);
+    BOOST_CHECK(!blocked->inCollision(a, b));
+    BOOST_CHECK_EQUAL(counting->count, 3 + 64);
+}
+
+BOOST_AUTO_TEST_CASE( testPRMRoadmap )
+{
+    const std::string filename = "testPRMRoadmap.rwprm";
+    std::vector<Q> nodes;
+    for (int i = 0; i < 4; i++)
+        nodes.push_back(Q(2, 0.1*i, 0.2*i));
+    std::vector<PRMRoadmap::Validity> nodeValidity(4, PRMRoadmap::Unknown);
+    nodeValidity[1] = PRMRoadmap::Free;
+    std::vector<PRMRoadmap::Edge> edges;
+    edges.push_back(PRMRoadmap::Edge(0, 1, 1.0));
+    edges.push_back(PRMRoadmap::Edge(1, 2, 2.0, PRMRoadmap::Blocked));
+    edges.push_back(PRMRoadmap::Edge(3, 1, 3.0));
+    PRMRoadmap::write(filename, nodes, nodeValidity, edges, 0.5);
+
+    {
+        const PRMRoadmap::Ptr roadmap = PRMRoadmap::load(filename);
+        BOOST_REQUIRE_EQUAL(roadmap->getNodeCount(), 4u);
+        BOOST_REQUIRE_EQUAL(roadmap->getEdgeCount(), 3u);
+        BOOST_CHECK_EQUAL(roadmap->getDOF(), 2u);
+        BOOST_CHECK_EQUAL(roadmap->getRadius(), 0.5);
+        BOOST_CHECK(roadmap->getQ(3) == nodes[3]);
+        BOOST_CHECK_EQUAL(roadmap->getNodeValidity(1), PRMRoadmap::Free);
+        BOOST_CHECK_EQUAL(roadmap->getEdgeValidity(1), PRMRoadmap::Blocked);
+
+        // node 1 is connected to all other nodes
+        BOOST_REQUIRE_EQUAL(roadmap->getDegree(1), 3u);
+        double weights = 0;
+        for (std::size_t k = 0; k < roadmap->getDegree(1); k++) {
+            BOOST_CHECK(roadmap->getNeighbors(1)[k] != 1);
+            weights += roadmap->getWeight(roadmap->getNeighborEdges(1)[k]);
+        }
+        BOOST_CHECK_EQUAL(weights, 6.0);
+        BOOST_CHECK_EQUAL(roadmap->getDegree(3), 1u);
+        BOOST_CHECK_EQUAL(roadmap->getNeighbors(3)[0], 1u);
+
+        // changes are private unless the roadmap is writable
+        roadmap->setNodeValidity(0, PRMRoadmap::Blocked);
+    }
+    {
+        const PRMRoadmap::Ptr roadmap = PRMRoadmap::load(filename, true);
+        BOOST_CHECK_EQUAL(roadmap->getNodeValidity(0), PRMRoadmap::Unknown);
+        roadmap->setEdgeValidity(0, PRMRoadmap::Free);
+    }
+    BOOST_CHECK_EQUAL(PRMRoadmap::load(filename)->getEdgeValidity(0), PRMRoadmap::Free);
+
+    // a target out of range is rejected instead of being read by the search
+    {
+        std::fstream file(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        // the targets follow the 40 byte header, the 4x2 configurations and the 5 offsets
+        file.seekp(40 + 4*2*sizeof(double) + 5*sizeof(boost::uint64_t));
+        const PRMRoadmap::NodeIndex target = 4;
+        file.write(reinterpret_cast<const char*>(&target), sizeof(target));
+    }
+    BOOST_CHECK_THROW(PRMRoadmap::load(filename), Exception);
+    std::remove(filename.c_str());
+}
+
+namespace {
+    // Wall at x = 0.5 with a narrow gap at y = 0.5
+    class WallConstraint: public QConstraint
+    {
+    protected:
+        bool doInCollision(const Q& q) const
+        {
+            return std::fabs(q[0] - 0.5) < 0.05 && std::fabs(q[1] - 0.5) > 0.05;
+        }
+
+        void doSetLog(Log::Ptr) {}
+    };
+
+    PlannerConstraint makeWallConstraint()
+    {
+        const QConstraint::Ptr constraint = ownedPtr(new WallConstraint());
+        return PlannerConstraint::make(
+            constraint, QEdgeConstraint::make(constraint, MetricFactory::makeInfinity<Q>(), 0.01));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testParallelRRTConnect )
+{
+    const Device::QBox bounds(Q(2, 0.0, 0.0), Q(2, 1.0, 1.0));
+    const Q start(2, 0.1, 0.1);
+    Q goal(2, 0.9, 0.9);
+    const QMetric::Ptr metric = MetricFactory::makeEuclidean<Q>();
+    const ThreadPool::Ptr pool = ownedPtr(new ThreadPool(3));
+
+    // One constraint for each worker
+    std::vector<PlannerConstraint> constraints;
+    for (int i = 0; i < 4; i++)
+        constraints.push_back(makeWallConstraint());
+
+    // The same path is found with and without the pool in deterministic mode
+    QPath paths[3];
+    for (int i = 0; i < 3; i++) {
+        Random::seed(42);
+        const QToQPlanner::Ptr planner = RRTQToQPlanner::makeParallelConnect(
+            constraints, bounds, metric, 0.05, i == 0 ? NULL : pool, true);
+        BOOST_REQUIRE(planner->query(start, goal, paths[i], 60.0));
+    }
+    BOOST_CHECK(paths[0] == paths[1]);
+    BOOST_CHECK(paths[1] == paths[2]);
+
+    QPath path;
+    const QToQPlanner::Ptr planner = RRTQToQPlanner::makeParallelConnect(constraints, bounds, metric, 0.05, pool);
+    BOOST_REQUIRE(planner->query(start, goal, path, 60.0));
+    BOOST_CHECK(path.front() == start);
+    BOOST_CHECK(path.back() == goal);
+    for (std::size_t i = 1; i < path.size(); i++)
+        BOOST_CHECK(!constraints[0].inCollision(path[i-1], path[i]));
+
+    // A sampler for each worker. In deterministic mode the samplers are
+    // called by the calling thread, so samplers using rw::math::Random give
+    // the same path with and without the pool.
+    std::vector<QSampler::Ptr> samplers;
+    for (int i = 0; i < 4; i++)
+        samplers.push_back(QSampler::makeUniform(bounds));
+    for (int i = 0; i < 3; i++) {
+        Random::seed(42);
+        paths[i].clear();
+        const QToQPlanner::Ptr samplerPlanner = RRTQToQPlanner::makeParallelConnect(
+            constraints, samplers, metric, 0.05, i == 0 ? NULL : pool, true);
+        BOOST_REQUIRE(samplerPlanner->query(start, goal, paths[i], 60.0));
+        for (std::size_t k = 1; k < paths[i].size(); k++)
+            BOOST_CHECK(!constraints[0].inCollision(paths[i][k-1], paths[i][k]));
+    }
+    BOOST_CHECK(paths[0] == paths[1]);
+    BOOST_CHECK(paths[1] == paths[2]);
+    samplers.pop_back();
+    BOOST_CHECK_THROW(RRTQToQPlanner::makeParallelConnect(constraints, samplers, metric, 0.05, pool), Exception);
+}
+
+BOOST_AUTO_TEST_CASE( testRRTStar )
+{
+    const Device::QBox bounds(Q(2, 0.0, 0.0), Q(2, 1.0, 1.0));
+    const Q start(2, 0.1, 0.1);
+    const Q goal(2, 0.9, 0.1);
+    const QMetric::Ptr metric = MetricFactory::makeEuclidean<Q>();
+    const QConstraint::Ptr constraint = ownedPtr(new WallConstraint());
+    const QEdgeConstraintIncremental::Ptr edge = QEdgeConstraintIncremental::make(constraint, metric, 0.01);
+    PlannerConstraint check = makeWallConstraint();
+
+    // The same query refined for longer gives a path that is no longer
+    double costs[2];
+    for (int i = 0; i < 2; i++) {
+        Random::seed(42);
+        const QToQPlanner::Ptr planner = RRTQToQPlanner::makeStar(
+            constraint, edge, QSampler::makeUniform(bounds), metric, 0.1, 1.5);
+        QPath path;
+        BOOST_REQUIRE(planner->query(start, goal, path, *StopCriteria::stopCnt(2000 + 4000*i)));
+        BOOST_CHECK(path.front() == start);
+        BOOST_CHECK(path.back() == goal);
+        for (std::size_t j = 1; j < path.size(); j++)
+            BOOST_CHECK(!check.inCollision(path[j-1], path[j]));
+
+        double length = 0;
+        for (std::size_t j = 1; j < path.size(); j++)
+            length += metric->distance(path[j-1], path[j]);
+        costs[i] = planner->getProperties().get<double>(RRTQToQPlanner::PROP_COST);
+        BOOST_CHECK_CLOSE(costs[i], length, 1e-8);
+    }
+    BOOST_CHECK(costs[1] <= costs[0]);
+    // The shortest path through the gap has length 1.09
+    BOOST_CHECK(costs[1] < 1.25);
+}
+
 void testPathPlanning(const CollisionStrategy::Ptr& strategy)
 {
     BOOST_TEST_MESSAGE("PathPlanningTestSuite");
@@ -132,6 +486,42 @@ void testPathPlanning(const CollisionStrategy::Ptr& strategy)
         // test wrong inputs
     }
 
+    ////////////////////// test batched constraints
+    {
+        const rw::proximity::CollisionDetector::Ptr detector =
+            ownedPtr(new rw::proximity::CollisionDetector(workcell, strategy));
+        const QConstraint::Ptr batched = QConstraint::makeBatched(
+            detector, workcell, device.cast<JointDevice>(), state);
+
+        // The same configurations are in collision as for the plain constraint
+        QSampler::Ptr sampler = QSampler::makeUniform(device);
+        std::vector<Q> qs;
+        for (int i = 0; i < 100; i++)
+            qs.push_back(sampler->sample());
+        const boost::dynamic_bitset<> expected = constraint.getQConstraint().inCollisionBatch(qs);
+        BOOST_CHECK(batched->inCollisionBatch(qs) == expected);
+        BOOST_CHECK_EQUAL(batched->inCollision(qs[0]), expected.test(0));
+        if (expected.any()) {
+            const boost::dynamic_bitset<> first = batched->inCollisionBatch(qs, true);
+            BOOST_CHECK_EQUAL(first.count(), 1u);
+            BOOST_CHECK_EQUAL(first.find_first(), expected.find_first());
+        }
+
+        // Edges checked in bisection order with the batched constraint
+        const QEdgeConstraint::Ptr edge = QEdgeConstraint::makeBisection(
+            batched, PlannerUtil::normalizingInfinityMetric(device->getBounds()), 0.01);
+        const Q good(7,0.854336,1.28309,-1.58383,-0.822832,-0.362664,-0.989248,-0.376991);
+        // The arm passes through the obstacles on the way to this configuration
+        const Q bad(7,0.0,1.2,0.0,2.0,0.0,0.0,0.0);
+        BOOST_CHECK(!edge->inCollision(from, good));
+        BOOST_CHECK(edge->inCollision(from, bad));
+
+        // A filter that depends on the state can not give the pairs for all configurations
+        const rw::proximity::CollisionDetector::Ptr treeDetector = ownedPtr(new rw::proximity::CollisionDetector(
+            workcell, strategy, ownedPtr(new rw::proximity::DynamicAABBTreeFilterStrategy(workcell))));
+        BOOST_CHECK_THROW(QConstraint::makeBatched(treeDetector, workcell, device.cast<JointDevice>(), state), rw::common::Exception);
+    }
+
     //////////////////// test global planners
 
     QToQPlanner::Ptr rrtplanner = RRTPlanner::makeQToQPlanner(constraint, device);
@@ -210,6 +600,20 @@ void testPathPlanning(const CollisionStrategy::Ptr& strategy)
             }
         	std::cout << " time:" << time.getTimeMs() << "ms" << std::endl;
         }
+
+        // Query a memory-mapped copy of a roadmap that has been used (and
+        // thereby extended) by the previous queries
+        const std::string roadmapFile = "testPathPlanning.rwprm";
+        prmplanner_lazy_astar->saveRoadmap(roadmapFile);
+        PRMPlanner::Ptr prmplanner_mapped = ownedPtr( new PRMPlanner(constraint.getQConstraintPtr(), QSampler::makeUniform(*device), 0.01, *device, state) );
+        prmplanner_mapped->loadRoadmap(roadmapFile);
+        BOOST_FOREACH(Q to, samples){
+            QPath path;
+            res = prmplanner_mapped->query(from, to, path, 15);
+            BOOST_CHECK(res);
+            BOOST_CHECK(!PlannerUtil::inCollision(constraint, path));
+        }
+        std::remove(roadmapFile.c_str());
     }
 }
 
@@ -230,6 +634,63 @@ namespace
 
 BOOST_AUTO_TEST_CASE( testPathPlanningMain )
 {
+    // Other test cases reseed the generator, so start from its default seed
+    // to plan the same paths regardless of the order of the test cases
+    Random::seed(5489);
     CollisionStrategy::Ptr strategy = getCollisionStrategy();
 	testPathPlanning(strategy);
 }
+
+#if RW_HAVE_PQP == 1
+BOOST_AUTO_TEST_CASE( testQEdgeConstraintContinuous )
+{
+    const WorkCell::Ptr workcell = WorkCellLoader::Factory::load(testFilePath() + "simple/workcell.wc.xml");
+    const Device::Ptr device = workcell->findDevice("PA10");
+    const State state = workcell->getDefaultState();
+    PlannerConstraint constraint = PlannerConstraint::make(ProximityStrategyPQP::make(), workcell, device, state);
+
+    // The collision setup of this workcell refers to frames that no longer
+    // exist, so the links of the arm are paired with the obstacles explicitly.
+    // As in the collision setup, the link resting on the floor is left out.
+    const rw::proximity::DistanceStrategy::Ptr strategy = ownedPtr(new ProximityStrategyPQP());
+    const std::vector<Frame*> robot = Kinematics::findAllFrames(device->getBase(), state);
+    const std::vector<Frame*> arm = Kinematics::findAllFrames(device.cast<JointDevice>()->getJoints()[1], state);
+    std::vector<Frame*> links, obstacles;
+    BOOST_FOREACH(const Object::Ptr& object, workcell->getObjects()) {
+        BOOST_FOREACH(const rw::geometry::Geometry::Ptr& geom, object->getGeometry(state)) {
+            Frame* const frame = geom->getFrame();
+            strategy->addModel(frame, geom);
+            if (std::find(arm.begin(), arm.end(), frame) != arm.end())
+                links.push_back(frame);
+            else if (std::find(robot.begin(), robot.end(), frame) == robot.end())
+                obstacles.push_back(frame);
+        }
+    }
+    FramePairList pairs;
+    BOOST_FOREACH(Frame* link, links) {
+        BOOST_FOREACH(Frame* obstacle, obstacles)
+            pairs.push_back(FramePair(link, obstacle));
+    }
+    const rw::proximity::DistanceCalculator::Ptr distance =
+        ownedPtr(new rw::proximity::DistanceCalculator(pairs, strategy));
+    const QEdgeConstraintContinuous::Ptr edge =
+        QEdgeConstraintContinuous::make(distance, workcell, device.cast<JointDevice>(), state);
+
+    const Q from = device->getQ(state);
+    const Q good(7,0.854336,1.28309,-1.58383,-0.822832,-0.362664,-0.989248,-0.376991);
+    const Q bad(7,0.0,1.2,0.0,2.0,0.0,0.0,0.0);
+
+    // A free edge is verified in fewer steps than a discrete check at resolution 0.01
+    BOOST_CHECK(!edge->inCollision(from, good));
+    BOOST_CHECK(edge->getNumberOfSteps() > 1);
+    BOOST_CHECK(edge->getNumberOfSteps() < 100);
+
+    // The edge is free up to the contact
+    double time = -1;
+    BOOST_REQUIRE(edge->findContact(from, bad, &time));
+    BOOST_CHECK(time > 0);
+    BOOST_CHECK(time <= 1);
+    const Q contact = from + (time * 0.99) * (bad - from);
+    BOOST_CHECK(!constraint.inCollision(from, contact));
+}
+#endif
@@ -0,0 +1,40 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#ifndef RW_TEST_PERFORMANCE_ALLOCATIONCOUNT_HPP
+#define RW_TEST_PERFORMANCE_ALLOCATIONCOUNT_HPP
+
+#include <cstddef>
+
+// Counters for the allocations made with the global operator new, which is
+// replaced in stateAllocation.cpp. The counters are only updated while
+// enabled is true.
+namespace allocationcount {
+    extern bool enabled;
+    extern unsigned long allocations;
+    extern std::size_t bytes;
+
+    //! Reset the counters and start counting.
+    inline void start() { allocations = 0; bytes = 0; enabled = true; }
+
+    //! Stop counting.
+    inline void stop() { enabled = false; }
+}
+
+#endif
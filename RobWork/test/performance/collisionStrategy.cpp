@@ -23,6 +23,8 @@
 #include <rw/math/Math.hpp>
 #include <rw/proximity/CollisionStrategy.hpp>
 #include <rw/proximity/ProximityStrategyData.hpp>
+#include <rw/proximity/rwstrategy/BVTreeColliderFactory.hpp>
+#include <rw/proximity/rwstrategy/BVTreeFactory.hpp>
 
 #include <rwlibs/proximitystrategies/ProximityStrategyFactory.hpp>
 
@@ -329,3 +331,62 @@ BOOST_AUTO_TEST_CASE( testCollisionQueryPerformance )
 
 
 }
+
+namespace {
+    template<class BVTREE>
+    double timeTreeCollider(const BVTREE& tree, const std::vector<Transform3D<> >& transforms,
+                            std::vector<bool>& results, long& nrOfBVTests)
+    {
+        const rw::common::Ptr<BVTreeCollider<BVTREE> > collider =
+            ownedPtr(BVTreeColliderFactory::makeBalancedDFSColliderOBB<BVTREE>());
+        collider->setQueryType(CollisionStrategy::FirstContact);
+        results.clear();
+        nrOfBVTests = 0;
+        Timer time;
+        for(size_t i=0;i<transforms.size();i++){
+            results.push_back(collider->collides(Transform3D<>::identity(), tree, transforms[i], tree));
+            nrOfBVTests += collider->getNrOfTestedBVs();
+        }
+        time.pause();
+        return time.getTime();
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testBVTreeLayoutPerformance )
+{
+    BOOST_TEST_MESSAGE("BV tree layout performance test.");
+    // Compare the pointer based tree with the flat tree used by ProximityStrategyRW
+    Math::seed(0);
+    Geometry::Ptr geom = GeometryFactory::load( testFilePath().append( "geoms/performance/CoarseModel.stl" ) );
+    rw::geometry::TriMesh::Ptr mesh = geom->getGeometryData()->getTriMesh(false);
+
+    BVTreeFactory factory;
+    Timer time;
+    BinaryOBBPtrTreeD::Ptr ptrTree = ownedPtr(factory.makeTopDownOBBTreeCovarMedian<BinaryOBBPtrTreeD>(mesh,1));
+    const double ptrBuild = time.getTime();
+    time.resetAndResume();
+    BinaryOBBIdxTreeD::Ptr idxTree = ownedPtr(factory.makeTopDownOBBIdxTreeCovarMedian<BinaryOBBIdxTreeD>(mesh,1));
+    const double idxBuild = time.getTime();
+
+    std::vector<Transform3D<> > transforms;
+    for(int i=0;i<2000;i++){
+        Vector3D<> v(Math::ran(0,0.3),Math::ran(0,0.3),Math::ran(0,0.3));
+        RPY<> r(Math::ran(-Pi,Pi),Math::ran(-Pi,Pi),Math::ran(-Pi,Pi));
+        transforms.push_back( Transform3D<>(v,r.toRotation3D()) );
+    }
+
+    std::vector<bool> ptrResults, idxResults;
+    long ptrBVTests, idxBVTests;
+    const double ptrTime = timeTreeCollider(*ptrTree, transforms, ptrResults, ptrBVTests);
+    const double idxTime = timeTreeCollider(*idxTree, transforms, idxResults, idxBVTests);
+
+    // both layouts must visit the same nodes
+    BOOST_CHECK(ptrResults == idxResults);
+    BOOST_CHECK_EQUAL(ptrBVTests, idxBVTests);
+
+    std::cout << "--------- Performancetest - BV tree layout ----------" << std::endl;
+    std::cout << "- Queries: " << transforms.size() << ", nodes: " << idxTree->getNrOfNodes() << std::endl;
+    std::cout << " - pointer tree build: " << ptrBuild << "s, queries: " << ptrTime << "s" << std::endl;
+    std::cout << " - flat tree build:    " << idxBuild << "s, queries: " << idxTime << "s" << std::endl;
+    std::cout << "-------------------------------------------------------------" << std::endl;
+}
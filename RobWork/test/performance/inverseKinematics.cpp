@@ -0,0 +1,242 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+#include "../TestSuiteConfig.hpp"
+#include "allocationCount.hpp"
+
+#include <rw/common/ThreadPool.hpp>
+#include <rw/common/Timer.hpp>
+#include <rw/invkin/ClosedFormIK.hpp>
+#include <rw/invkin/ClosedFormIKSolverKukaIIWA.hpp>
+#include <rw/invkin/ClosedFormIKSolverUR.hpp>
+#include <rw/invkin/JacobianIKSolver.hpp>
+#include <rw/invkin/ReachabilityMap.hpp>
+#include <rw/kinematics/FixedFrame.hpp>
+#include <rw/kinematics/StateStructure.hpp>
+#include <rw/loaders/WorkCellLoader.hpp>
+#include <rw/math/Math.hpp>
+#include <rw/math/RPY.hpp>
+#include <rw/models/RevoluteJoint.hpp>
+#include <rw/models/SerialDevice.hpp>
+#include <rw/models/WorkCell.hpp>
+#include <rw/pathplanning/QConstraint.hpp>
+
+#include <vector>
+
+using namespace rw::common;
+using namespace rw::invkin;
+using namespace rw::kinematics;
+using rw::loaders::WorkCellLoader;
+using namespace rw::math;
+using namespace rw::models;
+
+namespace {
+    // The KUKA LBR iiwa 7 R800 as used for ClosedFormIKSolverKukaIIWA.
+    SerialDevice::Ptr makeKukaIIWA(StateStructure& stateStructure)
+    {
+        const Frame::Ptr base = ownedPtr(new FixedFrame("Base", Transform3D<>::identity()));
+        const Joint::Ptr joint1 = ownedPtr(new RevoluteJoint("Joint1", Transform3D<>(Vector3D<>(0, 0, 0.158))));
+        const Joint::Ptr joint2 = ownedPtr(new RevoluteJoint("Joint2", Transform3D<>(Vector3D<>(0, 0, 0.182), RPY<>(0, 0, -Pi/2.))));
+        const Joint::Ptr joint3 = ownedPtr(new RevoluteJoint("Joint3", Transform3D<>(Vector3D<>(0, -0.182, 0), RPY<>(0, 0, Pi/2.))));
+        const Joint::Ptr joint4 = ownedPtr(new RevoluteJoint("Joint4", Transform3D<>(Vector3D<>(0, 0, 0.218), RPY<>(0, 0, Pi/2.))));
+        const Joint::Ptr joint5 = ownedPtr(new RevoluteJoint("Joint5", Transform3D<>(Vector3D<>(0, 0.182, 0), RPY<>(0, 0, -Pi/2.))));
+        const Joint::Ptr joint6 = ownedPtr(new RevoluteJoint("Joint6", Transform3D<>(Vector3D<>(0, 0, 0.218), RPY<>(0, 0, -Pi/2.))));
+        const Joint::Ptr joint7 = ownedPtr(new RevoluteJoint("Joint7", Transform3D<>(Vector3D<>::zero(), RPY<>(0, 0, Pi/2.))));
+        const Frame::Ptr end = ownedPtr(new FixedFrame("TCP", Transform3D<>(Vector3D<>(0, 0, 0.126))));
+
+        stateStructure.addFrame(base);
+        stateStructure.addFrame(joint1, base);
+        stateStructure.addFrame(joint2, joint1);
+        stateStructure.addFrame(joint3, joint2);
+        stateStructure.addFrame(joint4, joint3);
+        stateStructure.addFrame(joint5, joint4);
+        stateStructure.addFrame(joint6, joint5);
+        stateStructure.addFrame(joint7, joint6);
+        stateStructure.addFrame(end, joint7);
+
+        const State state = stateStructure.getDefaultState();
+        const SerialDevice::Ptr device = ownedPtr(new SerialDevice(base.get(), end.get(), "KukaIIWA", state));
+        std::pair<Q, Q> bounds;
+        bounds.first = Q(7, -170*Deg2Rad, -120*Deg2Rad, -170*Deg2Rad, -120*Deg2Rad, -170*Deg2Rad, -120*Deg2Rad, -175*Deg2Rad);
+        bounds.second = -bounds.first;
+        device->setBounds(bounds);
+        return device;
+    }
+
+    // Targets reached by small displacements of a configuration in the
+    // middle of the joint ranges.
+    std::vector<Transform3D<> > makeTargets(const Device& device, State state, const Q& qStart, int count)
+    {
+        const std::pair<Q, Q> bounds = device.getBounds();
+        const Q displacements = 0.1 * (bounds.second - bounds.first);
+        std::vector<Transform3D<> > targets;
+        for (int i = 0; i < count; i++) {
+            Q q = qStart;
+            for (std::size_t j = 0; j < q.size(); j++)
+                q(j) += Math::ran(-displacements(j), displacements(j));
+            device.setQ(q, state);
+            targets.push_back(device.baseTend(state));
+        }
+        return targets;
+    }
+
+    // Run a fixed number of iterations per target, such that the rate does
+    // not depend on convergence.
+    void testIterations(const JacobianIKSolver& solver,
+                        const Device& device,
+                        const State& initial,
+                        const Q& qStart,
+                        const std::vector<Transform3D<> >& targets,
+                        const std::string& name)
+    {
+        const int iterations = 20;
+        State state = initial;
+        device.setQ(qStart, state);
+        solver.solveLocal(targets[0], 0, state, iterations); // warm up
+
+        Timer time;
+        allocationcount::start();
+        for (std::size_t i = 0; i < targets.size(); i++) {
+            device.setQ(qStart, state);
+            solver.solveLocal(targets[i], 0, state, iterations);
+        }
+        allocationcount::stop();
+        time.pause();
+
+        const double total = (double)targets.size() * iterations;
+        std::cout << " - " << name << ": " << total/time.getTime() << " iterations/s, "
+                  << allocationcount::allocations/total << " allocations per iteration" << std::endl;
+    }
+
+    void testSolves(const InvKinSolver& solver,
+                    const Device& device,
+                    const State& initial,
+                    const Q& qStart,
+                    const std::vector<Transform3D<> >& targets,
+                    const std::string& name)
+    {
+        State state = initial;
+        std::size_t solutions = 0;
+        Timer time;
+        for (std::size_t i = 0; i < targets.size(); i++) {
+            device.setQ(qStart, state);
+            solutions += solver.solve(targets[i], state).size();
+        }
+        time.pause();
+
+        std::cout << " - " << name << ": " << targets.size()/time.getTime() << " solves/s, "
+                  << solutions/(double)targets.size() << " solutions per solve" << std::endl;
+    }
+
+    // Solve all targets with a single call to the batch solver of a closed form solver.
+    template<class Solver>
+    void testBatch(const Solver& solver, const State& state, const std::vector<Transform3D<> >& targets, const std::string& name)
+    {
+        ClosedFormIK::TransformArray transforms(targets.size(), 12);
+        for (std::size_t i = 0; i < targets.size(); i++) {
+            for (std::size_t r = 0; r < 3; r++) {
+                for (std::size_t c = 0; c < 3; c++)
+                    transforms(i, 3*r+c) = targets[i].R()(r, c);
+                transforms(i, 9+r) = targets[i].P()[r];
+            }
+        }
+        Eigen::ArrayXXd solutions;
+        ClosedFormIK::BranchArray valid;
+        solver.solveBatch(transforms, state, solutions, valid); // allocate the buffers
+
+        Timer time;
+        solver.solveBatch(transforms, state, solutions, valid);
+        time.pause();
+
+        std::cout << " - " << name << ": " << targets.size()/time.getTime() << " solves/s, "
+                  << valid.count()/(double)targets.size() << " solutions per solve" << std::endl;
+    }
+
+    // Build a reachability map on all cores and query it for the targets.
+    void testReachabilityMap(Device::Ptr device, rw::common::Ptr<const ClosedFormIK> solver, const State& state, const std::vector<Transform3D<> >& targets)
+    {
+        ReachabilityMap::Grid grid;
+        grid.radius = 1.0;
+        grid.resolution = 0.1;
+        Timer time;
+        const ReachabilityMap::Ptr map = ReachabilityMap::build(device, solver, state, grid,
+            std::vector<rw::pathplanning::QConstraint::Ptr>(), ownedPtr(new ThreadPool()));
+        time.pause();
+        const double cells = (double)map->getVoxelCount()*map->getBinCount();
+        std::cout << " - ReachabilityMap build: " << cells/time.getTime() << " cells/s, "
+                  << map->getReachableCount()/cells << " reachable" << std::endl;
+
+        std::size_t reachable = 0;
+        Q seed;
+        time.resetAndResume();
+        for (int k = 0; k < 50; k++) {
+            for (std::size_t i = 0; i < targets.size(); i++) {
+                if (map->getSeed(targets[i], seed))
+                    reachable++;
+            }
+        }
+        time.pause();
+        std::cout << " - ReachabilityMap query: " << 1e6*time.getTime()/(50.*targets.size()) << " us per query, "
+                  << reachable/(50.*targets.size()) << " reachable" << std::endl;
+    }
+
+    template<class ClosedFormSolver>
+    void testDevice(Device::Ptr device, const State& state, const ClosedFormSolver& closedForm, const std::string& name)
+    {
+        const std::pair<Q, Q> bounds = device->getBounds();
+        const Q qStart = 0.45 * (bounds.first + bounds.second);
+        const std::vector<Transform3D<> > targets = makeTargets(*device, state, qStart, 2000);
+
+        JacobianIKSolver fixed(device, state);
+        fixed.setSolverType(JacobianIKSolver::DLS);
+        fixed.setMaxIterations(50);
+        JacobianIKSolver general(device, state);
+        general.setSolverType(JacobianIKSolver::DLS);
+        general.setMaxIterations(50);
+        general.setEnableFixedSize(false);
+        BOOST_CHECK(fixed.isFixedSize());
+
+        std::cout << "--------- Performancetest - inverse kinematics ----------" << std::endl;
+        std::cout << "- Device: " << name << " (" << device->getDOF() << " DOF)" << std::endl;
+        testIterations(general, *device, state, qStart, targets, "JacobianIKSolver DLS, general");
+        testIterations(fixed, *device, state, qStart, targets, "JacobianIKSolver DLS, fixed size");
+        testSolves(general, *device, state, qStart, targets, "JacobianIKSolver DLS, general");
+        testSolves(fixed, *device, state, qStart, targets, "JacobianIKSolver DLS, fixed size");
+        testSolves(closedForm, *device, state, qStart, targets, "Closed form");
+        testBatch(closedForm, state, targets, "Closed form, batch");
+        testReachabilityMap(device, &closedForm, state, targets);
+        std::cout << "-------------------------------------------------------------" << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testInverseKinematicsPerformance )
+{
+    BOOST_TEST_MESSAGE("Inverse Kinematics Performance Tests.");
+    Math::seed(0);
+
+    const WorkCell::Ptr workcell = WorkCellLoader::Factory::load(testFilePath() + "devices/UR6855A/UR6855A.wc.xml");
+    BOOST_REQUIRE(workcell != NULL);
+    const SerialDevice::Ptr ur = workcell->findDevice<SerialDevice>("UR-6-85-5-A");
+    BOOST_REQUIRE(ur != NULL);
+    const ClosedFormIKSolverUR urSolver(ur, workcell->getDefaultState());
+    testDevice(ur, workcell->getDefaultState(), urSolver, "UR-6-85-5-A");
+
+    StateStructure stateStructure;
+    const SerialDevice::Ptr iiwa = makeKukaIIWA(stateStructure);
+    const ClosedFormIKSolverKukaIIWA iiwaSolver(iiwa, stateStructure.getDefaultState());
+    testDevice(iiwa, stateStructure.getDefaultState(), iiwaSolver, "KukaIIWA");
+}
@@ -0,0 +1,91 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+
+#include "../TestSuiteConfig.hpp"
+#include "allocationCount.hpp"
+
+#include <rw/common/Timer.hpp>
+#include <rw/loaders/WorkCellLoader.hpp>
+#include <rw/math/Math.hpp>
+#include <rw/models/Device.hpp>
+#include <rw/models/WorkCell.hpp>
+#include <rw/pathplanning/PlannerConstraint.hpp>
+#include <rw/pathplanning/QSampler.hpp>
+#include <rw/pathplanning/StopCriteria.hpp>
+
+#include <rwlibs/pathplanners/sbl/SBLInternal.hpp>
+#include <rwlibs/proximitystrategies/ProximityStrategyFactory.hpp>
+
+using namespace rw::common;
+using rw::loaders::WorkCellLoader;
+using namespace rw::math;
+using namespace rw::models;
+using namespace rw::pathplanning;
+using namespace rwlibs::pathplanners;
+using rwlibs::proximitystrategies::ProximityStrategyFactory;
+
+namespace {
+    // Grow the SBL trees by a fixed number of expansions. The connection
+    // radius is so small that the trees are never connected, so every
+    // iteration of the planner adds one node.
+    void testExpansions(QConstraint::Ptr constraint, Device::Ptr device, const Q& from, const Q& to,
+                        int expansions, const std::string& name)
+    {
+        QEdgeConstraintIncremental::Ptr edge = QEdgeConstraintIncremental::makeDefault(constraint, device);
+        SBLOptions options = SBLInternal::getOptions(SBLSetup::make(constraint, edge, device));
+        options.connectRadius = 1e-9;
+
+        Math::seed(0);
+        Timer time;
+        allocationcount::start();
+        const SBLInternal::Motion path = SBLInternal::findPath(from, to, options, *StopCriteria::stopCnt(expansions));
+        allocationcount::stop();
+        time.pause();
+        BOOST_CHECK(path.empty());
+
+        std::cout << "--------- Performancetest - SBL expansions ----------" << std::endl;
+        std::cout << "- Constraint: " << name << std::endl;
+        std::cout << " - expansions: " << expansions << std::endl;
+        std::cout << " - expansions per second: " << expansions/time.getTime() << std::endl;
+        std::cout << " - allocations per node: " << allocationcount::allocations/((double)expansions) << std::endl;
+        std::cout << " - bytes allocated per node: " << allocationcount::bytes/((double)expansions) << std::endl;
+        std::cout << "-------------------------------------------------------------" << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testSBLExpansionPerformance )
+{
+    BOOST_TEST_MESSAGE("SBL Expansion Performance Tests.");
+
+    const WorkCell::Ptr workcell = WorkCellLoader::Factory::load(testFilePath() + "simple/workcell.wc.xml");
+    BOOST_REQUIRE(workcell != NULL);
+    const Device::Ptr device = workcell->findDevice("PA10");
+    BOOST_REQUIRE(device != NULL);
+    const PlannerConstraint constraint = PlannerConstraint::make(
+        ProximityStrategyFactory::makeDefaultCollisionStrategy(), workcell, device, workcell->getDefaultState());
+
+    const Q from = device->getQ(workcell->getDefaultState());
+    Math::seed(0);
+    const Q to = QSampler::makeConstrained(QSampler::makeUniform(device), constraint.getQConstraintPtr(), 1000)->sample();
+    BOOST_REQUIRE(!to.empty());
+
+    // Without obstacles the time is spent in the tree data structures
+    testExpansions(QConstraint::makeFixed(false), device, from, to, 20000, "Free space");
+    testExpansions(constraint.getQConstraintPtr(), device, from, to, 2000, "simple/workcell.wc.xml (PA10)");
+}
@@ -0,0 +1,119 @@
+/********************************************************************************
+ * Copyright 2009 The Robotics Group, The Maersk Mc-Kinney Moller Institute,
+ * Faculty of Engineering, University of Southern Denmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ********************************************************************************/
+
+
+#include "../TestSuiteConfig.hpp"
+#include "allocationCount.hpp"
+
+#include <rw/common/Timer.hpp>
+#include <rw/kinematics/StateStructure.hpp>
+#include <rw/loaders/WorkCellLoader.hpp>
+#include <rw/math/Math.hpp>
+#include <rw/models/Device.hpp>
+#include <rw/models/WorkCell.hpp>
+#include <rw/pathplanning/PlannerConstraint.hpp>
+
+#include <rwlibs/proximitystrategies/ProximityStrategyFactory.hpp>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace rw::common;
+using namespace rw::kinematics;
+using rw::loaders::WorkCellLoader;
+using namespace rw::math;
+using namespace rw::models;
+using namespace rw::pathplanning;
+using rwlibs::proximitystrategies::ProximityStrategyFactory;
+
+// Count the allocations made with the global operator new while enabled.
+namespace allocationcount {
+    bool enabled = false;
+    unsigned long allocations = 0;
+    std::size_t bytes = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    if (allocationcount::enabled) {
+        allocationcount::allocations++;
+        allocationcount::bytes += size;
+    }
+    void* const p = std::malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    std::free(p);
+}
+
+namespace {
+    void testAllocationsPerQuery(const QConstraint& constraint, const std::vector<Q>& qs, const std::string& name)
+    {
+        int nrCollisions = 0;
+        Timer time;
+        allocationcount::start();
+        for (const Q& q : qs) {
+            if (constraint.inCollision(q))
+                nrCollisions++;
+        }
+        allocationcount::stop();
+        time.pause();
+
+        std::cout << "--------- Performancetest - allocations per inCollision(Q) ----------" << std::endl;
+        std::cout << "- State copies: " << name << std::endl;
+        std::cout << " - nrCollissions: " << nrCollisions/((double)qs.size()) << std::endl;
+        std::cout << " - allocations per query: " << allocationcount::allocations/((double)qs.size()) << std::endl;
+        std::cout << " - avg time per query: " << time.getTime()/qs.size() << "s" << std::endl;
+        std::cout << "-------------------------------------------------------------" << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testStateAllocationPerformance )
+{
+    BOOST_TEST_MESSAGE("State Allocation Performance Tests.");
+    Math::seed(0);
+
+    const WorkCell::Ptr workcell = WorkCellLoader::Factory::load(testFilePath() + "simple/workcell.wc.xml");
+    BOOST_REQUIRE(workcell != NULL);
+    const Device::Ptr device = workcell->findDevice("PA10");
+    BOOST_REQUIRE(device != NULL);
+    const PlannerConstraint constraint = PlannerConstraint::make(
+        ProximityStrategyFactory::makeDefaultCollisionStrategy(), workcell, device, workcell->getDefaultState());
+
+    std::vector<Q> qs;
+    for (int i = 0; i < 1000; i++)
+        qs.push_back(Math::ranQ(device->getBounds()));
+
+    // warm up, such that the pools hold the blocks needed
+    for (int i = 0; i < 10; i++)
+        constraint.getQConstraint().inCollision(qs[i]);
+
+    testAllocationsPerQuery(constraint.getQConstraint(), qs, "Deep copy (pooled)");
+    workcell->getStateStructure()->setCopyOnWrite(true);
+    testAllocationsPerQuery(constraint.getQConstraint(), qs, "Copy-on-write");
+    workcell->getStateStructure()->setCopyOnWrite(false);
+
+    // baseline: every state copy allocates its values on the heap
+    workcell->getStateStructure()->setStatePooling(false);
+    testAllocationsPerQuery(constraint.getQConstraint(), qs, "Deep copy (pool bypassed)");
+    workcell->getStateStructure()->setStatePooling(true);
+}